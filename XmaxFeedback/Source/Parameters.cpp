@@ -20,6 +20,31 @@ const std::map<juce::String, LoudspeakerModel> Parameters::speakerModelData = {
     { "SB 10PGC21-4",       LoudspeakerModel(   89.0f,  3.4f,  0.15e-3f, 11.2f,  1.01f,   0.92f,  2.8e-3f, 1.14e-3f,   2.3f,  1.2e-3f,    27e-4f) }
 };
 
+// Same order as the choices of the speaker model parameter
+const std::vector<const LoudspeakerModel*> Parameters::speakerModelsByIndex = [] {
+    std::vector<const LoudspeakerModel*> models;
+    for (const auto& name : SpeakerModels::modelNames)
+        models.push_back(&speakerModelData.at(name));
+    return models;
+}();
+
+static void getRawValue(juce::AudioProcessorValueTreeState& apvts,
+    const juce::ParameterID& id, std::atomic<float>*& destination)
+{
+    destination = apvts.getRawParameterValue(id.getParamID());
+    jassert(destination);  // parameter does not exist
+}
+
+// Converts a parameter in decibels to a linear gain, only when it changed since the last block
+static void updateGain(const std::atomic<float>* value, float& lastDecibels, float& gain) noexcept
+{
+    float decibels = value->load(std::memory_order_relaxed);
+    if (decibels != lastDecibels) {
+        lastDecibels = decibels;
+        gain = juce::Decibels::decibelsToGain(decibels);
+    }
+}
+
 template<typename T>
 static void castParameter(juce::AudioProcessorValueTreeState& apvts,
     const juce::ParameterID& id, T& destination)
@@ -67,20 +92,22 @@ static juce::String stringFromVoltage(float value, int)
 
 Parameters::Parameters(juce::AudioProcessorValueTreeState& apvts)
 {
-    castParameter(apvts, inputGainParamID, inputGainParam);
-    castParameter(apvts, stereoParamID, stereoParam);
+    getRawValue(apvts, inputGainParamID, inputGainValue);
+    getRawValue(apvts, stereoParamID, stereoValue);
 
     castParameter(apvts, speakerModelParamID, speakerModelParam);
-    castParameter(apvts, speakerGainParamID, speakerGainParam);
+    getRawValue(apvts, speakerModelParamID, speakerModelValue);
+    getRawValue(apvts, speakerGainParamID, speakerGainValue);
 
-    castParameter(apvts, attackTimeParamID, attackTimeParam);
-    castParameter(apvts, releaseTimeParamID, releaseTimeParam);
+    getRawValue(apvts, attackTimeParamID, attackTimeValue);
+    getRawValue(apvts, releaseTimeParamID, releaseTimeValue);
 
-    castParameter(apvts, thresholdDisplacementParamID, thresholdDisplacementParam);
-    castParameter(apvts, lookAheadTimeParamID, lookAheadTimeParam);
+    getRawValue(apvts, thresholdDisplacementParamID, thresholdDisplacementValue);
+    getRawValue(apvts, lookAheadTimeParamID, lookAheadTimeValue);
+    getRawValue(apvts, fixedLatencyParamID, fixedLatencyValue);
 
-    castParameter(apvts, mixParamID, mixParam);
-    castParameter(apvts, gainParamID, gainParam);
+    getRawValue(apvts, mixParamID, mixValue);
+    getRawValue(apvts, gainParamID, gainValue);
 }
 
 juce::AudioProcessorValueTreeState::ParameterLayout Parameters::createParameterLayout()
@@ -101,8 +128,10 @@ juce::AudioProcessorValueTreeState::ParameterLayout Parameters::createParameterL
 
     //==============================================================================
 
+    auto speakerModelNames = SpeakerModels::modelNames;
+    speakerModelNames.add(SpeakerModels::customModelName);
     layout.add(std::make_unique<juce::AudioParameterChoice>(
-        speakerModelParamID, "Speaker Model", SpeakerModels::modelNames, 0));
+        speakerModelParamID, "Speaker Model", speakerModelNames, 0));
 
     layout.add(std::make_unique<juce::AudioParameterFloat>(
         speakerGainParamID,
@@ -148,6 +177,9 @@ juce::AudioProcessorValueTreeState::ParameterLayout Parameters::createParameterL
         juce::AudioParameterFloatAttributes().withStringFromValueFunction(stringFromMilliseconds)
     ));
 
+    layout.add(std::make_unique<juce::AudioParameterBool>(
+        fixedLatencyParamID, "Fixed Latency", false));
+
     //==============================================================================
     layout.add(std::make_unique<juce::AudioParameterFloat>(
         gainParamID,
@@ -168,63 +200,92 @@ juce::AudioProcessorValueTreeState::ParameterLayout Parameters::createParameterL
     return layout;
 }
 
-void Parameters::prepareToPlay(double sampleRate) noexcept
+void Parameters::prepareToPlay(double newSampleRate) noexcept
 {
     double duration = 0.02;
+    sampleRate = float(newSampleRate);
 
-    inputGainSmoother.reset(sampleRate, duration);
-    speakerGainSmoother.reset(sampleRate, duration);
-    thresholdDisplacementSmoother.reset(sampleRate, duration);
-    gainSmoother.reset(sampleRate, duration);
-    mixSmoother.reset(sampleRate, duration);
+    inputGainSmoother.reset(newSampleRate, duration);
+    speakerGainSmoother.reset(newSampleRate, duration);
+    thresholdDisplacementSmoother.reset(newSampleRate, duration);
+    gainSmoother.reset(newSampleRate, duration);
+    mixSmoother.reset(newSampleRate, duration);
 
-    smoothingCoeff = 1.0f - std::exp(-1.0f / (0.1f * float(sampleRate)));
+    smoothingCoeff = 1.0f - std::exp(-1.0f / (0.1f * sampleRate));
+
+    //the attack and release coefficients depend on the sample rate
+    lastAttackTime = std::numeric_limits<float>::quiet_NaN();
+    lastReleaseTime = std::numeric_limits<float>::quiet_NaN();
 }
 
 void Parameters::reset() noexcept
 {
+    update();
+
     inputGain = 0.0f;
-    inputGainSmoother.setCurrentAndTargetValue(juce::Decibels::decibelsToGain(inputGainParam->get()));
+    inputGainSmoother.setCurrentAndTargetValue(snapshot.inputGain);
 
     speakerGain = 0.0f;
-    speakerGainSmoother.setCurrentAndTargetValue(juce::Decibels::decibelsToGain(speakerGainParam->get()));
+    speakerGainSmoother.setCurrentAndTargetValue(snapshot.speakerGain);
 
     thresholdDisplacement = 1.0f;
-    thresholdDisplacementSmoother.setCurrentAndTargetValue(thresholdDisplacementParam->get());
+    thresholdDisplacementSmoother.setCurrentAndTargetValue(snapshot.thresholdDisplacement);
 
     attackTime = 0.0f;
     releaseTime = 0.0f;
     lookAheadTime = 0.0f;
 
     gain = 0.0f;
-    gainSmoother.setCurrentAndTargetValue(juce::Decibels::decibelsToGain(gainParam->get()));
+    gainSmoother.setCurrentAndTargetValue(snapshot.gain);
     mix = 1.0f;
-    mixSmoother.setCurrentAndTargetValue(mixParam->get() * 0.01f);
+    mixSmoother.setCurrentAndTargetValue(snapshot.mix);
 }
 
-void Parameters::update() noexcept
+ParameterSnapshot Parameters::update() noexcept
 {
+    //read every parameter once for this block
+    updateGain(inputGainValue, lastInputGain, snapshot.inputGain);
+    updateGain(speakerGainValue, lastSpeakerGain, snapshot.speakerGain);
+    updateGain(gainValue, lastGain, snapshot.gain);
+
+    snapshot.thresholdDisplacement = thresholdDisplacementValue->load(std::memory_order_relaxed);
+    snapshot.mix = mixValue->load(std::memory_order_relaxed) * 0.01f;
+
+    snapshot.attackTime = attackTimeValue->load(std::memory_order_relaxed);
+    snapshot.releaseTime = releaseTimeValue->load(std::memory_order_relaxed);
+    snapshot.lookAheadTime = lookAheadTimeValue->load(std::memory_order_relaxed);
 
-    inputGainSmoother.setTargetValue(juce::Decibels::decibelsToGain(inputGainParam->get()));
-    speakerGainSmoother.setTargetValue(juce::Decibels::decibelsToGain(speakerGainParam->get()));
-    thresholdDisplacementSmoother.setTargetValue(thresholdDisplacementParam->get());
-    gainSmoother.setTargetValue(juce::Decibels::decibelsToGain(gainParam->get()));
-    mixSmoother.setTargetValue(mixParam->get() * 0.01f);
+    snapshot.speakerModel = int(speakerModelValue->load(std::memory_order_relaxed));
+    snapshot.stereo = stereoValue->load(std::memory_order_relaxed) >= 0.5f;
+    snapshot.fixedLatency = fixedLatencyValue->load(std::memory_order_relaxed) >= 0.5f;
+
+    inputGainSmoother.setTargetValue(snapshot.inputGain);
+    speakerGainSmoother.setTargetValue(snapshot.speakerGain);
+    thresholdDisplacementSmoother.setTargetValue(snapshot.thresholdDisplacement);
+    gainSmoother.setTargetValue(snapshot.gain);
+    mixSmoother.setTargetValue(snapshot.mix);
 
-    targetAttackTime = attackTimeParam->get();
     if (attackTime == 0.0f) {
-        attackTime = targetAttackTime;
+        attackTime = snapshot.attackTime;
     }
-    targetReleaseTime = releaseTimeParam->get();
     if (releaseTime == 0.0f) {
-        releaseTime = targetReleaseTime;
+        releaseTime = snapshot.releaseTime;
     }
-    targetLookAheadTime = lookAheadTimeParam->get();
     if (lookAheadTime == 0.0f) {
-        lookAheadTime = targetLookAheadTime;
+        lookAheadTime = snapshot.lookAheadTime;
 	}
 
-    speakerModel = speakerModelParam->getIndex();
+    //the times are smoothed, so the coefficients only change while they move
+    if (attackTime != lastAttackTime) {
+        lastAttackTime = attackTime;
+        snapshot.attackCoeff = 1 - std::exp(-2.2f / (attackTime * 1e-3f * sampleRate));
+    }
+    if (releaseTime != lastReleaseTime) {
+        lastReleaseTime = releaseTime;
+        snapshot.releaseCoeff = 1 - std::exp(-2.2f / (releaseTime * 1e-3f * sampleRate));
+    }
+
+    return snapshot;
 }
 
 void Parameters::smoothen() noexcept
@@ -238,7 +299,7 @@ void Parameters::smoothen() noexcept
     gain = gainSmoother.getNextValue();
     mix = mixSmoother.getNextValue();
 
-    attackTime += (targetAttackTime - attackTime) * smoothingCoeff;
-    lookAheadTime += (targetLookAheadTime - lookAheadTime) * smoothingCoeff;
-    releaseTime += (targetReleaseTime - releaseTime) * smoothingCoeff;
+    attackTime += (snapshot.attackTime - attackTime) * smoothingCoeff;
+    lookAheadTime += (snapshot.lookAheadTime - lookAheadTime) * smoothingCoeff;
+    releaseTime += (snapshot.releaseTime - releaseTime) * smoothingCoeff;
 }
@@ -15,6 +15,9 @@
 #include "LookAndFeel.h"
 #include "LevelMeter.h"
 #include "DisplacementMeter.h"
+#include "LoadMeter.h"
+#include "PipelineOverlay.h"
+#include "CustomDriverPanel.h"
 
 //==============================================================================
 /**
@@ -29,7 +32,12 @@ public:
     void paint (juce::Graphics&) override;
     void resized() override;
 
+   #if XMAX_PIPELINE_TIMING
+    void mouseDown(const juce::MouseEvent& event) override;
+   #endif
+
 private:
+    void showCustomDriverPanel();
 
     //void parameterGestureChanged(int, bool) override { }
 
@@ -53,11 +61,17 @@ private:
     audioProcessor.apvts, stereoParamID.getParamID(), stereoButton
     };
 
+    juce::TextButton latencyButton;
+    juce::AudioProcessorValueTreeState::ButtonAttachment latencyButtonAttachment{
+    audioProcessor.apvts, fixedLatencyParamID.getParamID(), latencyButton
+    };
+
     juce::Label speakerComboBoxLabel;
     juce::ComboBox speakerModelComboBox;
     juce::AudioProcessorValueTreeState::ComboBoxAttachment speakerModelComboBoxAttachment{
     audioProcessor.apvts, speakerModelParamID.getParamID(), speakerModelComboBox
     };
+    juce::TextButton customDriverButton;
 
     juce::HyperlinkButton websiteLinkButton{
         "Eliot Deschang, Florian Marie",
@@ -70,5 +84,10 @@ private:
 
     LevelMeter meter;
     DisplacementMeter displacementMeter;
+    LoadMeter loadMeter;
+
+   #if XMAX_PIPELINE_TIMING
+    PipelineOverlay pipelineOverlay{ audioProcessor.pipelineTimes };
+   #endif
     
 };
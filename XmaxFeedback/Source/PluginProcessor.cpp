@@ -16,9 +16,13 @@ XmaxFeedbackAudioProcessor::XmaxFeedbackAudioProcessor()
         .withInput("Input", juce::AudioChannelSet::stereo(), true)
         .withOutput("Output", juce::AudioChannelSet::stereo(), true)
     ),
-    params(apvts)
+    params(apvts),
+    customModel(Parameters::getSpeakerModel(0)),
+    customMailbox({ customModel, {}, 0.0 }),
+    customSpeaker({ customModel, {}, 0.0 }) //designed in prepareToPlay
 {
-    //do nothing
+    //allocate the DSP state once, large enough for every supported sample rate
+    arena.reserve(getArenaSize(Parameters::maxSampleRate));
 }
 
 XmaxFeedbackAudioProcessor::~XmaxFeedbackAudioProcessor()
@@ -88,23 +92,177 @@ void XmaxFeedbackAudioProcessor::changeProgramName (int index, const juce::Strin
 }
 
 //==============================================================================
-void XmaxFeedbackAudioProcessor::setXuFiltersAndComputation(const LoudspeakerModel& model, float sampleRate)
+static int getDelayInSamples(float timeInMs, double sampleRate)
 {
+    return int(std::ceil(timeInMs * 0.001f * sampleRate));
+}
+
+// Bytes of DSP state of one instance at this sample rate, with the largest dry block.
+// Must follow the buffers carved in prepareToPlay.
+size_t XmaxFeedbackAudioProcessor::getArenaSize(double sampleRate)
+{
+    int maxDelayInSamples = getDelayInSamples(Parameters::maxLookAheadTime, sampleRate);
+
+    size_t channelSize = DspArena::getAlignedSize<float>(size_t(DelayLine::getStorageSize(maxDelayInSamples)))
+                       + DspArena::getAlignedSize<float>(size_t(DelayLine::getStorageSize(maxDelayInSamples))) * 4 // CmsComp and RmsComp padding of both speaker chains
+                       + DspArena::getAlignedSize<float>(size_t(DelayLine::getStorageSize(maxDelayInSamples + maxDryBlockSize)))
+                       + DspArena::getAlignedSize<float>(size_t(maxDryBlockSize));
+
+    return 2 * channelSize;
+}
+
+size_t XmaxFeedbackAudioProcessor::getMemoryFootprint() const noexcept
+{
+    return sizeof(*this) + arena.getCapacity();
+}
+
+void XmaxFeedbackAudioProcessor::setXuFiltersAndComputation(SpeakerChain& chain, const SpeakerCoefficients& coeffs)
+{
+    const auto& model = *coeffs.model;
+    chain.model = coeffs.model;
+
     // Set voltage to displacement conversion
-    auto doubleCoeffs = getXUFilterCoefficients(model, sampleRate);
-    xuFilterL.setCoefficients(doubleCoeffs.first, doubleCoeffs.second);
-    xuFilterR.setCoefficients(doubleCoeffs.first, doubleCoeffs.second);
-    xuFilterOutL.setCoefficients(doubleCoeffs.first, doubleCoeffs.second);
-    xuFilterOutR.setCoefficients(doubleCoeffs.first, doubleCoeffs.second);
+    chain.xuFilterL.setCoefficients(coeffs.bXu, coeffs.aXu);
+    chain.xuFilterR.setCoefficients(coeffs.bXu, coeffs.aXu);
+    chain.xuFilterOutL.setCoefficients(coeffs.bXu, coeffs.aXu);
+    chain.xuFilterOutR.setCoefficients(coeffs.bXu, coeffs.aXu);
 
     // Determine which Rms computation function to use based on the Qs value
     if (model.Qs <= Q0) {
-        computeRmsComp = computeRmsComp1;
+        chain.computeRmsComp = computeRmsComp1;
     }
     else {
-        gamma = (model.Qs - Q0) / (1 - Cthreshold);
-        computeRmsComp = computeRmsComp2;
+        chain.gamma = (model.Qs - Q0) / (1 - Cthreshold);
+        chain.computeRmsComp = computeRmsComp2;
+    }
+}
+
+void XmaxFeedbackAudioProcessor::setXuFiltersAndComputation(SpeakerChain& chain, int modelIndex, double sampleRate)
+{
+    if (Parameters::isCustomModel(modelIndex)) {
+        chain.customModel = customSpeaker.model;
+        auto coeffs = customSpeaker.coeffs;
+        coeffs.model = &chain.customModel;
+        setXuFiltersAndComputation(chain, coeffs);
+    }
+    else if (auto* coeffs = coefficientCache.find(modelIndex, sampleRate)) {
+        setXuFiltersAndComputation(chain, *coeffs);
+    }
+    else {
+        // the background design is not finished yet, design this model only
+        const auto& model = Parameters::getSpeakerModel(modelIndex);
+        setXuFiltersAndComputation(chain, designSpeakerCoefficients(model, float(sampleRate)));
+    }
+}
+
+XmaxFeedbackAudioProcessor::CustomSpeaker XmaxFeedbackAudioProcessor::designCustomSpeaker(const LoudspeakerModel& model, double sampleRate)
+{
+    CustomSpeaker speaker{ model, designSpeakerCoefficients(model, float(sampleRate)), sampleRate };
+    speaker.coeffs.model = nullptr;
+    return speaker;
+}
+
+// Message thread: the design takes a few microseconds, the audio thread only pulls the result
+void XmaxFeedbackAudioProcessor::setCustomModel(const LoudspeakerModel& model)
+{
+    std::lock_guard<std::mutex> lock(customModelLock);
+    customModel = model;
+
+    //before prepareToPlay, the model is designed there
+    double sampleRate = getSampleRate();
+    if (sampleRate > 0.0)
+        customMailbox.push(designCustomSpeaker(model, sampleRate));
+}
+
+LoudspeakerModel XmaxFeedbackAudioProcessor::getCustomModel() const
+{
+    std::lock_guard<std::mutex> lock(customModelLock);
+    return customModel;
+}
+
+// Clears the feedback loop of a chain, starting from an uncompensated speaker
+void XmaxFeedbackAudioProcessor::resetChain(SpeakerChain& chain)
+{
+    chain.xuFilterL.reset();
+    chain.xuFilterR.reset();
+    chain.xuFilterOutL.reset();
+    chain.xuFilterOutR.reset();
+    chain.compFilterL.reset();
+    chain.compFilterR.reset();
+    chain.compDelayFilterL.reset();
+    chain.compDelayFilterR.reset();
+
+    chain.uOutL = 0.0f;
+    chain.uOutR = 0.0f;
+    chain.uOutDelayedL = 0.0f;
+    chain.uOutDelayedR = 0.0f;
+    chain.xOutL = 0.0f;
+    chain.xOutR = 0.0f;
+
+    chain.CmsCompL = chain.model->Cms;
+    chain.CmsCompR = chain.model->Cms;
+    chain.RmsCompL = chain.model->Rms;
+    chain.RmsCompR = chain.model->Rms;
+
+    resetCompensationPadding(chain);
+}
+
+void XmaxFeedbackAudioProcessor::resetCompensationPadding(SpeakerChain& chain)
+{
+    chain.CmsCompDelayLineL.reset(chain.CmsCompL);
+    chain.CmsCompDelayLineR.reset(chain.CmsCompR);
+    chain.RmsCompDelayLineL.reset(chain.RmsCompL);
+    chain.RmsCompDelayLineR.reset(chain.RmsCompR);
+}
+
+// Reports the constant look-ahead to the host in fixed latency mode, and restarts
+// the padding delays from the current compensation and a silent dry signal
+void XmaxFeedbackAudioProcessor::updateLatency(bool fixedLatency)
+{
+    lastFixedLatency = fixedLatency;
+    setLatencySamples(lastFixedLatency ? fixedLatencySamples : 0);
+
+    for (auto& chain : chains) {
+        if (chain.model != nullptr)
+            resetCompensationPadding(chain);
     }
+    dryDelayLineL.reset();
+    dryDelayLineR.reset();
+}
+
+// Delays the next numSamples (at most dryBlockSize) dry samples by the fixed latency,
+// as two block copies per channel
+void XmaxFeedbackAudioProcessor::delayDryPath(const float* inputL, const float* inputR, int numSamples)
+{
+    dryDelayLineL.write(inputL, numSamples);
+    dryDelayLineR.write(inputR, numSamples);
+    dryDelayLineL.read(dryBufferL, numSamples, fixedLatencySamples);
+    dryDelayLineR.read(dryBufferR, numSamples, fixedLatencySamples);
+}
+
+// Loads the new model in the spare chain, and let it warm up before it is
+// crossfaded with the current one in processBlock
+void XmaxFeedbackAudioProcessor::startModelSwitch(int modelIndex)
+{
+    auto& nextChain = chains[size_t(1 - activeChain)];
+
+    setXuFiltersAndComputation(nextChain, modelIndex, getSampleRate());
+    resetChain(nextChain);
+
+    modelSwitch.start();
+}
+
+// Publishes the time of this block relative to its duration, for the load meter of the editor
+void XmaxFeedbackAudioProcessor::updateDspLoad(std::chrono::steady_clock::time_point blockStart, int numSamples) noexcept
+{
+    if (numSamples <= 0)
+        return;
+
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - blockStart;
+    auto load = float(elapsed.count() * getSampleRate() / double(numSamples));
+
+    dspLoadPeak.updateIfGreater(load);
+    dspLoadAverage.add(load);
 }
 
 //==============================================================================
@@ -112,6 +270,7 @@ void XmaxFeedbackAudioProcessor::prepareToPlay (double sampleRate, int samplesPe
 {
     params.prepareToPlay(sampleRate);
     params.reset();
+    auto snapshot = params.update();
 
 
     // Initialize delay line (circular buffer)
@@ -121,27 +280,61 @@ void XmaxFeedbackAudioProcessor::prepareToPlay (double sampleRate, int samplesPe
     spec.numChannels = 2;
 
 
-    int maxDelayInSamples = int(std::ceil(Parameters::maxLookAheadTime * 0.001f * sampleRate));
+    int maxDelayInSamples = getDelayInSamples(Parameters::maxLookAheadTime, sampleRate);
 
-    delayLineL.setMaximumDelayInSamples(maxDelayInSamples);
-    delayLineR.setMaximumDelayInSamples(maxDelayInSamples);
-    delayLineL.reset();
-    delayLineR.reset();
+    //the fixed latency is the longest look-ahead, so it does not depend on the look-ahead time
+    fixedLatencySamples = maxDelayInSamples;
+    dryBlockSize = juce::jlimit(1, maxDryBlockSize, samplesPerBlock);
 
+    //carve every buffer from the arena, which was allocated for maxSampleRate in the constructor,
+    //left channel first then right channel, so that the state of one channel is contiguous
+    arena.reserve(getArenaSize(sampleRate));
+    arena.clear();
 
-    //get speaker model to set the coefficients
-    currentSpeakerModel = SpeakerModels::modelNames[params.speakerModel];
-    lastSpeakerModel = currentSpeakerModel;
-    const auto& model = Parameters::speakerModelData.at(currentSpeakerModel);
-    setXuFiltersAndComputation(model, sampleRate);
+    auto carve = [this](int numSamples) { return arena.allocate<float>(size_t(numSamples)); };
 
-    CmsCompL = model.Cms;
-    CmsCompR = model.Cms;
+    delayLineL.setStorage(carve(DelayLine::getStorageSize(maxDelayInSamples)), maxDelayInSamples);
+    for (auto& chain : chains) {
+        chain.CmsCompDelayLineL.setStorage(carve(DelayLine::getStorageSize(fixedLatencySamples)), fixedLatencySamples);
+        chain.RmsCompDelayLineL.setStorage(carve(DelayLine::getStorageSize(fixedLatencySamples)), fixedLatencySamples);
+    }
+    dryDelayLineL.setStorage(carve(DelayLine::getStorageSize(fixedLatencySamples + dryBlockSize)), fixedLatencySamples + dryBlockSize);
+    dryBufferL = carve(dryBlockSize);
+
+    delayLineR.setStorage(carve(DelayLine::getStorageSize(maxDelayInSamples)), maxDelayInSamples);
+    for (auto& chain : chains) {
+        chain.CmsCompDelayLineR.setStorage(carve(DelayLine::getStorageSize(fixedLatencySamples)), fixedLatencySamples);
+        chain.RmsCompDelayLineR.setStorage(carve(DelayLine::getStorageSize(fixedLatencySamples)), fixedLatencySamples);
+    }
+    dryDelayLineR.setStorage(carve(DelayLine::getStorageSize(fixedLatencySamples + dryBlockSize)), fixedLatencySamples + dryBlockSize);
+    dryBufferR = carve(dryBlockSize);
+
+    delayLineL.reset();
+    delayLineR.reset();
+
+    //design the coefficients of every speaker model in the background,
+    //and only the current one right now
+    coefficientCache.prepare(sampleRate);
+    customSpeaker = designCustomSpeaker(getCustomModel(), sampleRate);
+    lastSpeakerModel = snapshot.speakerModel;
+    activeChain = 0;
+    setXuFiltersAndComputation(chains[0], lastSpeakerModel, sampleRate);
+    resetChain(chains[0]);
+    modelSwitch.prepare(sampleRate);
+    updateLatency(snapshot.fixedLatency);
 
     levelL.reset();
     levelR.reset();
     displacementLevelL.reset();
     displacementLevelR.reset();
+    gainReductionL.reset();
+    gainReductionR.reset();
+    dspLoadPeak.reset();
+    dspLoadAverage.reset();
+
+   #if XMAX_PIPELINE_TIMING
+    pipelineTimes.prepare();
+   #endif
 }
 
 void XmaxFeedbackAudioProcessor::releaseResources()
@@ -178,6 +371,7 @@ bool XmaxFeedbackAudioProcessor::isBusesLayoutSupported (const BusesLayout& layo
 
 void XmaxFeedbackAudioProcessor::processBlock(juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
 {
+    auto blockStart = std::chrono::steady_clock::now();
     juce::ScopedNoDenormals noDenormals;
     auto totalNumInputChannels  = getTotalNumInputChannels();
     auto totalNumOutputChannels = getTotalNumOutputChannels();
@@ -185,35 +379,71 @@ void XmaxFeedbackAudioProcessor::processBlock(juce::AudioBuffer<float>& buffer,
     for (auto i = totalNumInputChannels; i < totalNumOutputChannels; ++i)
         buffer.clear (i, 0, buffer.getNumSamples());
 
-    //variables for the level and "displacement" meter
-    float uMaxL = 0.0f;
-    float uMaxR = 0.0f;
-    float xMaxL = 0.0f;
-    float xMaxR = 0.0f;
-
-    float sampleRate = float(getSampleRate());
-    params.update();
+    XMAX_STAGE_START(stageTimes);
 
-    float attackCoeff  = 1 - std::exp(-2.2f / (params.attackTime * 1e-3f * sampleRate));
-    float releaseCoeff = 1 - std::exp(-2.2f / (params.releaseTime * 1e-3f * sampleRate));
+    //read every parameter once, the kernel only sees this copy
+    auto snapshot = params.update();
+    XMAX_STAGE_LAP(stageTimes, parameters);
 
-    currentSpeakerModel = SpeakerModels::modelNames[params.speakerModel];
-    const auto& model = Parameters::speakerModelData.at(currentSpeakerModel);
+    //a new custom driver is switched to like another model, if it was designed for this rate
+    CustomSpeaker received = customSpeaker;
+    if (customMailbox.pull(received) && received.sampleRate == getSampleRate()) {
+        customSpeaker = received;
+        if (Parameters::isCustomModel(lastSpeakerModel))
+            lastSpeakerModel = -1;
+    }
 
-    if (lastSpeakerModel != currentSpeakerModel) {
-        setXuFiltersAndComputation(model, sampleRate);
-        lastSpeakerModel = currentSpeakerModel;
+    //a model change waits for the end of the current crossfade, if any
+    if (lastSpeakerModel != snapshot.speakerModel && !modelSwitch.isActive()) {
+        startModelSwitch(snapshot.speakerModel);
+        lastSpeakerModel = snapshot.speakerModel;
 	}
+    XMAX_STAGE_LAP(stageTimes, modelSwitch);
 
 
-    float* channelDataL = buffer.getWritePointer(0);
-    float* channelDataR = buffer.getWritePointer(1);
+    if (snapshot.fixedLatency != lastFixedLatency) {
+        updateLatency(snapshot.fixedLatency);
+    }
+    XMAX_STAGE_LAP(stageTimes, latency);
 
+    XMAX_PIPELINE_START(pipelineTimes);
+    auto levels = processSamples(snapshot, buffer.getWritePointer(0), buffer.getWritePointer(1), buffer.getNumSamples());
+    XMAX_PIPELINE_FINISH(pipelineTimes);
+    XMAX_STAGE_LAP(stageTimes, samples);
 
-    for (int sample = 0; sample < buffer.getNumSamples(); ++sample) {
+    levelL.updateIfGreater(levels.maxL);
+    levelR.updateIfGreater(levels.maxR);
+
+    displacementLevelL.updateIfGreater(levels.maxDispL);
+    displacementLevelR.updateIfGreater(levels.maxDispR);
+
+    gainReductionL.updateIfGreater(-juce::Decibels::gainToDecibels(levels.minGainL));
+    gainReductionR.updateIfGreater(-juce::Decibels::gainToDecibels(levels.minGainR));
+    XMAX_STAGE_LAP(stageTimes, meters);
+
+    updateDspLoad(blockStart, buffer.getNumSamples());
+}
+
+// Per-sample feedback limiter, with the parameters of this block
+XmaxFeedbackAudioProcessor::BlockLevels XmaxFeedbackAudioProcessor::processSamples(
+    ParameterSnapshot snapshot, float* channelDataL, float* channelDataR, int numSamples) noexcept
+{
+    //variables for the level and "displacement" meter
+    BlockLevels levels;
+    float sampleRate = float(getSampleRate());
+
+    for (int sample = 0; sample < numSamples; ++sample) {
 
         params.smoothen();
+
+        //the dry path is delayed one chunk ahead, before these samples are overwritten
+        if (snapshot.fixedLatency && sample % dryBlockSize == 0) {
+            delayDryPath(channelDataL + sample, channelDataR + sample, std::min(dryBlockSize, numSamples - sample));
+        }
+
         int nLookAhead = int(std::ceil(params.lookAheadTime * 1e-3f * sampleRate));
+        int nDelay = snapshot.fixedLatency ? fixedLatencySamples : nLookAhead;
+        int nPadding = snapshot.fixedLatency ? std::max(0, fixedLatencySamples - nLookAhead) : 0;
 
         // take the input signal
         float dryL = channelDataL[sample];
@@ -222,47 +452,47 @@ void XmaxFeedbackAudioProcessor::processBlock(juce::AudioBuffer<float>& buffer,
         // apply the input gain
         uInL = dryL * params.inputGain;
         uInR = dryR * params.inputGain;
+        XMAX_PIPELINE_LAP(pipelineTimes, inputGain);
 
         delayLineL.write(uInL);
         delayLineR.write(uInR);
 
-        //displacement estimation
-        xL = xuFilterL.processSample(uOutL);
-        xR = xuFilterR.processSample(uOutR);
-        xL *= params.speakerGain;
-        xR *= params.speakerGain;
+        float delayedL = delayLineL.read(nDelay);
+        float delayedR = delayLineR.read(nDelay);
+        XMAX_PIPELINE_LAP(pipelineTimes, delay);
 
-        //cmsTarget Computation  
-        float Xmax = params.thresholdDisplacement * 1e-3f;  
-        CmsMin = margin * Xmax * model.Rec / (params.speakerGain * params.inputGain * model.Bl);
+        auto& chain = chains[size_t(activeChain)];
+        processChain(chain, snapshot, delayedL, delayedR, nPadding, sampleRate);
 
-        if (std::abs(xL) <= Xmax) CmsTargetL = model.Cms; else CmsTargetL = CmsMin;
-        if (std::abs(xR) <= Xmax) CmsTargetR = model.Cms; else CmsTargetR = CmsMin;
+        float uOutDelayedL = chain.uOutDelayedL;
+        float uOutDelayedR = chain.uOutDelayedR;
+        float xOutL = chain.xOutL;
+        float xOutR = chain.xOutR;
 
-        //cmsComp Computation
-        CmsCompL = smoothing(CmsTargetL, CmsCompL, attackCoeff, releaseCoeff);
-        CmsCompR = smoothing(CmsTargetR, CmsCompR, attackCoeff, releaseCoeff);
+        if (modelSwitch.isActive()) {
+            XMAX_STAGE_COUNT(stageTimes, crossfadeSamples, 1);
 
-        //rmsComp Computation
-        RmsCompL = computeRmsComp(CmsCompL, model, Q0, Cthreshold, gamma);
-        RmsCompR = computeRmsComp(CmsCompL, model, Q0, Cthreshold, gamma);
-        
-        //compensation filter update
-		auto doubleCoeffsL = getCompFilterCoeffs(model, CmsCompL, RmsCompL, sampleRate);
-        auto doubleCoeffsR = getCompFilterCoeffs(model, CmsCompR, RmsCompR, sampleRate);
+            auto& nextChain = chains[size_t(1 - activeChain)];
+            processChain(nextChain, snapshot, delayedL, delayedR, nPadding, sampleRate);
 
-        compFilterL.setCoefficients(doubleCoeffsL.first, doubleCoeffsL.second);
-        compFilterR.setCoefficients(doubleCoeffsR.first, doubleCoeffsR.second);
-        compDelayFilterL.setCoefficients(doubleCoeffsL.first, doubleCoeffsL.second);
-        compDelayFilterR.setCoefficients(doubleCoeffsR.first, doubleCoeffsR.second);
+            float fade = modelSwitch.getNextWeight();
+            uOutDelayedL += fade * (nextChain.uOutDelayedL - uOutDelayedL);
+            uOutDelayedR += fade * (nextChain.uOutDelayedR - uOutDelayedR);
+            xOutL += fade * (nextChain.xOutL - xOutL);
+            xOutR += fade * (nextChain.xOutR - xOutR);
 
-        //apply the compensation filter on primary path and delayed path
-        uOutL = compFilterL.processSample(uInL);
-        uOutR = compFilterR.processSample(uInR);
-
-        uOutDelayedL = compDelayFilterL.processSample(delayLineL.read(nLookAhead));
-        uOutDelayedR = compDelayFilterR.processSample(delayLineR.read(nLookAhead));
+            //the new chain is fully faded in, retire the old one
+            if (modelSwitch.isFinished()) {
+                activeChain = 1 - activeChain;
+                modelSwitch.reset();
+            }
+        }
 
+        //keep the dry signal aligned with the wet one
+        if (snapshot.fixedLatency) {
+            dryL = dryBufferL[size_t(sample % dryBlockSize)];
+            dryR = dryBufferR[size_t(sample % dryBlockSize)];
+        }
 
         // output processing - not part of the limiter
         float mixL = params.mix * uOutDelayedL + (1.0f - params.mix) * dryL;
@@ -274,21 +504,91 @@ void XmaxFeedbackAudioProcessor::processBlock(juce::AudioBuffer<float>& buffer,
         channelDataR[sample] = outR;
 
         // update the level meters
-        uMaxL = std::max(uMaxL, std::abs(outL));
-        uMaxR = std::max(uMaxR, std::abs(outR));
+        levels.maxL = std::max(levels.maxL, std::abs(outL));
+        levels.maxR = std::max(levels.maxR, std::abs(outR));
 
         // update the displacement meters
-        xOutL = xuFilterOutL.processSample(uOutDelayedL);
-        xOutR = xuFilterOutR.processSample(uOutDelayedR);
-        xMaxL = std::max(xMaxL, std::abs(xOutL * 1e3f * params.speakerGain));
-        xMaxR = std::max(xMaxR, std::abs(xOutR * 1e3f * params.speakerGain));
+        levels.maxDispL = std::max(levels.maxDispL, std::abs(xOutL * 1e3f * params.speakerGain));
+        levels.maxDispR = std::max(levels.maxDispR, std::abs(xOutR * 1e3f * params.speakerGain));
+
+        // update the gain reduction, the compliance of the active chain relative to the speaker
+        levels.minGainL = std::min(levels.minGainL, chain.CmsCompL / chain.model->Cms);
+        levels.minGainR = std::min(levels.minGainR, chain.CmsCompR / chain.model->Cms);
+        XMAX_PIPELINE_LAP(pipelineTimes, output);
     }
 
-    levelL.updateIfGreater(uMaxL);
-    levelR.updateIfGreater(uMaxR);
+    return levels;
+}
 
-    displacementLevelL.updateIfGreater(xMaxL);
-    displacementLevelR.updateIfGreater(xMaxR);
+// Runs the feedback loop of one speaker chain for the current sample: the input is
+// uInL/uInR, the delayed input comes from the look-ahead delay line. In fixed latency
+// mode, the delayed path uses the compensation computed nPadding samples earlier.
+void XmaxFeedbackAudioProcessor::processChain(SpeakerChain& chain, const ParameterSnapshot& snapshot, float delayedL, float delayedR, int nPadding, float sampleRate)
+{
+    const auto& model = *chain.model;
+
+    //displacement estimation
+    xL = chain.xuFilterL.processSample(chain.uOutL);
+    xR = chain.xuFilterR.processSample(chain.uOutR);
+    xL *= params.speakerGain;
+    xR *= params.speakerGain;
+    XMAX_PIPELINE_LAP(pipelineTimes, xuFilter);
+
+    //cmsTarget Computation  
+    float Xmax = params.thresholdDisplacement * 1e-3f;  
+    CmsMin = margin * Xmax * model.Rec / (params.speakerGain * params.inputGain * model.Bl);
+
+    if (std::abs(xL) <= Xmax) CmsTargetL = model.Cms; else CmsTargetL = CmsMin;
+    if (std::abs(xR) <= Xmax) CmsTargetR = model.Cms; else CmsTargetR = CmsMin;
+
+    //cmsComp Computation
+    chain.CmsCompL = smoothing(CmsTargetL, chain.CmsCompL, snapshot.attackCoeff, snapshot.releaseCoeff);
+    chain.CmsCompR = smoothing(CmsTargetR, chain.CmsCompR, snapshot.attackCoeff, snapshot.releaseCoeff);
+
+    //rmsComp Computation
+    chain.RmsCompL = chain.computeRmsComp(chain.CmsCompL, model, Q0, Cthreshold, chain.gamma);
+    chain.RmsCompR = chain.computeRmsComp(chain.CmsCompL, model, Q0, Cthreshold, chain.gamma);
+    XMAX_PIPELINE_LAP(pipelineTimes, gainComputer);
+
+    //compensation filter update
+    auto doubleCoeffsL = getCompFilterCoeffs(model, chain.CmsCompL, chain.RmsCompL, sampleRate);
+    auto doubleCoeffsR = getCompFilterCoeffs(model, chain.CmsCompR, chain.RmsCompR, sampleRate);
+    XMAX_STAGE_COUNT(stageTimes, compDesigns, 2);
+
+    chain.compFilterL.setCoefficients(doubleCoeffsL.first, doubleCoeffsL.second);
+    chain.compFilterR.setCoefficients(doubleCoeffsR.first, doubleCoeffsR.second);
+
+    if (snapshot.fixedLatency) {
+        chain.CmsCompDelayLineL.write(chain.CmsCompL);
+        chain.CmsCompDelayLineR.write(chain.CmsCompR);
+        chain.RmsCompDelayLineL.write(chain.RmsCompL);
+        chain.RmsCompDelayLineR.write(chain.RmsCompR);
+
+        auto paddedCoeffsL = getCompFilterCoeffs(model, chain.CmsCompDelayLineL.read(nPadding), chain.RmsCompDelayLineL.read(nPadding), sampleRate);
+        auto paddedCoeffsR = getCompFilterCoeffs(model, chain.CmsCompDelayLineR.read(nPadding), chain.RmsCompDelayLineR.read(nPadding), sampleRate);
+        XMAX_STAGE_COUNT(stageTimes, compDesigns, 2);
+
+        chain.compDelayFilterL.setCoefficients(paddedCoeffsL.first, paddedCoeffsL.second);
+        chain.compDelayFilterR.setCoefficients(paddedCoeffsR.first, paddedCoeffsR.second);
+    }
+    else {
+        chain.compDelayFilterL.setCoefficients(doubleCoeffsL.first, doubleCoeffsL.second);
+        chain.compDelayFilterR.setCoefficients(doubleCoeffsR.first, doubleCoeffsR.second);
+    }
+    XMAX_PIPELINE_LAP(pipelineTimes, compDesign);
+
+    //apply the compensation filter on primary path and delayed path
+    chain.uOutL = chain.compFilterL.processSample(uInL);
+    chain.uOutR = chain.compFilterR.processSample(uInR);
+
+    chain.uOutDelayedL = chain.compDelayFilterL.processSample(delayedL);
+    chain.uOutDelayedR = chain.compDelayFilterR.processSample(delayedR);
+    XMAX_PIPELINE_LAP(pipelineTimes, compFilter);
+
+    //displacement of the output, for the meters
+    chain.xOutL = chain.xuFilterOutL.processSample(chain.uOutDelayedL);
+    chain.xOutR = chain.xuFilterOutR.processSample(chain.uOutDelayedR);
+    XMAX_PIPELINE_LAP(pipelineTimes, displacementMeter);
 }
 
 //==============================================================================
@@ -305,7 +605,21 @@ juce::AudioProcessorEditor* XmaxFeedbackAudioProcessor::createEditor()
 //==============================================================================
 void XmaxFeedbackAudioProcessor::getStateInformation (juce::MemoryBlock& destData)
 {
-    copyXmlToBinary(*apvts.state.createXml(), destData);
+    auto state = apvts.copyState();
+
+    auto model = getCustomModel();
+    auto driver = state.getOrCreateChildWithName(customDriverID, nullptr);
+    driver.setProperty("fs", model.fs, nullptr);
+    driver.setProperty("Rec", model.Rec, nullptr);
+    driver.setProperty("Lec", model.Lec, nullptr);
+    driver.setProperty("Qms", model.Qms, nullptr);
+    driver.setProperty("Qes", model.Qes, nullptr);
+    driver.setProperty("Mms", model.Mms, nullptr);
+    driver.setProperty("Cms", model.Cms, nullptr);
+    driver.setProperty("Bl", model.Bl, nullptr);
+    driver.setProperty("Sd", model.Sd, nullptr);
+
+    copyXmlToBinary(*state.createXml(), destData);
 }
 
 void XmaxFeedbackAudioProcessor::setStateInformation (const void* data, int sizeInBytes)
@@ -314,6 +628,12 @@ void XmaxFeedbackAudioProcessor::setStateInformation (const void* data, int size
     if (xml.get() != nullptr && xml->hasTagName(apvts.state.getType()))
     {
         apvts.replaceState(juce::ValueTree::fromXml(*xml));
+
+        auto driver = apvts.state.getChildWithName(customDriverID);
+        if (driver.isValid() && float(driver["fs"]) > 0.0f) {
+            setCustomModel(makeLoudspeakerModel(driver["fs"], driver["Rec"], driver["Lec"], driver["Qms"], driver["Qes"],
+                                                driver["Mms"], driver["Cms"], driver["Bl"], driver["Sd"]));
+        }
     }
 }
 
@@ -9,11 +9,17 @@
 #pragma once
 
 #include <JuceHeader.h>
+#include <mutex>
 #include "Parameters.h"
+#include "DspArena.h"
 #include "DelayLine.h"
 #include "BiquadFilter.h"
 #include "FilterDesign.h"
+#include "CoefficientCache.h"
+#include "Mailbox.h"
+#include "ModelCrossfade.h"
 #include "Measurement.h"
+#include "StageTimer.h"
 
 
 //==============================================================================
@@ -68,63 +74,152 @@ public:
 
     Measurement levelL, levelR;
     Measurement displacementLevelL, displacementLevelR;
+    Measurement gainReductionL, gainReductionR; // dB
+
+    // Time spent in processBlock over the duration of the block (1 is the real-time deadline)
+    Measurement dspLoadPeak;
+    AverageMeasurement dspLoadAverage;
+
+    StageTimes stageTimes; // filled by processBlock when built with XMAX_STAGE_TIMING
+
+   #if XMAX_PIPELINE_TIMING
+    PipelineTimes pipelineTimes; // time of each stage of the sample loop, shown by PipelineOverlay
+   #endif
+
+    // Driver of the custom speaker model, entered in the editor. Its X/U filter is designed
+    // here, on the message thread, and handed to the audio thread through a mailbox.
+    void setCustomModel(const LoudspeakerModel& model);
+    LoudspeakerModel getCustomModel() const;
+
+    // Memory used by this instance, including all of its DSP state, in bytes
+    size_t getMemoryFootprint() const noexcept;
+
+    static constexpr int maxDryBlockSize = 2048; // longer blocks are delayed in several chunks
+
+    // Peak levels of one processed block, for the meters
+    struct BlockLevels
+    {
+        float maxL = 0.0f;
+        float maxR = 0.0f;
+        float maxDispL = 0.0f; // mm
+        float maxDispR = 0.0f;
+        float minGainL = 1.0f; // CmsComp / Cms, the gain below the resonance
+        float minGainR = 1.0f;
+    };
+
+    // Processes numSamples stereo samples in place, with the parameters read for this block
+    BlockLevels processSamples(ParameterSnapshot snapshot, float* channelDataL, float* channelDataR, int numSamples) noexcept;
+
 
 private:
-    void setXuFiltersAndComputation(const LoudspeakerModel& model, float sampleRate);
+    static size_t getArenaSize(double sampleRate);
+
+    // Everything that depends on the speaker model, including the state of the
+    // feedback loop. Two chains are kept, so that a new model can be faded in
+    // next to the current one.
+    struct SpeakerChain
+    {
+        const LoudspeakerModel* model = nullptr; // points into Parameters::speakerModelData, or to customModel
+        LoudspeakerModel customModel = Parameters::getSpeakerModel(0); // copy of the custom driver, which may be replaced while this chain uses it
+
+        BiquadFilterDF1<float> xuFilterL; // tension to displacement
+        BiquadFilterDF1<float> xuFilterR;
+        BiquadFilterDF1<float> xuFilterOutL; // tension to displacement
+        BiquadFilterDF1<float> xuFilterOutR;
+
+        BiquadFilterTDF2<float> compFilterL; //adaptive low shelf filter
+        BiquadFilterTDF2<float> compFilterR;
+
+        BiquadFilterTDF2<float> compDelayFilterL; //adaptive low shelf filter
+        BiquadFilterTDF2<float> compDelayFilterR;
+
+        float (*computeRmsComp)(float, LoudspeakerModel, float, float, float) = computeRmsComp1; // set on the audio thread by a model switch
+        float gamma = 1.0f;
+
+        float uOutL = 0.0f;
+        float uOutR = 0.0f;
+        float uOutDelayedL = 0.0f;
+        float uOutDelayedR = 0.0f;
+        float xOutL = 0.0f;
+        float xOutR = 0.0f;
+
+        float CmsCompL = 0.0f;
+        float CmsCompR = 0.0f;
+        float RmsCompL = 0.0f;
+        float RmsCompR = 0.0f;
+
+        // fixed latency mode: pads the compensation of the delayed path
+        DelayLine CmsCompDelayLineL, CmsCompDelayLineR;
+        DelayLine RmsCompDelayLineL, RmsCompDelayLineR;
+    };
 
-    DelayLine delayLineL, delayLineR;
-    BiquadFilterDF1<float> xuFilterL; // tension to displacement
-    BiquadFilterDF1<float> xuFilterR;
-    BiquadFilterDF1<float> xuFilterOutL; // tension to displacement
-    BiquadFilterDF1<float> xuFilterOutR;
+    // The custom driver with its coefficients for one sample rate
+    struct CustomSpeaker
+    {
+        LoudspeakerModel model;
+        SpeakerCoefficients coeffs; // without model, set to the copy of the chain that uses them
+        double sampleRate;
+    };
+
+    static CustomSpeaker designCustomSpeaker(const LoudspeakerModel& model, double sampleRate);
+
+    void setXuFiltersAndComputation(SpeakerChain& chain, const SpeakerCoefficients& coeffs);
+    void setXuFiltersAndComputation(SpeakerChain& chain, int modelIndex, double sampleRate);
+    void resetChain(SpeakerChain& chain);
+    void startModelSwitch(int modelIndex);
+    void processChain(SpeakerChain& chain, const ParameterSnapshot& snapshot, float delayedL, float delayedR, int nPadding, float sampleRate);
+    void resetCompensationPadding(SpeakerChain& chain);
+    void updateLatency(bool fixedLatency);
+    void updateDspLoad(std::chrono::steady_clock::time_point blockStart, int numSamples) noexcept;
+    void delayDryPath(const float* inputL, const float* inputR, int numSamples);
 
+    CoefficientCache coefficientCache;
 
-    BiquadFilterTDF2<float> compFilterL; //adaptive low shelf filter
-    BiquadFilterTDF2<float> compFilterR;
+    mutable std::mutex customModelLock; // message thread and state only, never taken by the audio thread
+    LoudspeakerModel customModel;
+    Mailbox<CustomSpeaker> customMailbox;
+    CustomSpeaker customSpeaker; // audio thread copy, used by setXuFiltersAndComputation
+    DspArena arena; // holds the buffers of every delay line
 
-    BiquadFilterTDF2<float> compDelayFilterL; //adaptive low shelf filter
-    BiquadFilterTDF2<float> compDelayFilterR;
+    DelayLine delayLineL, delayLineR;
+
+    // Fixed latency mode: the look-ahead is always fixedLatencySamples long, the
+    // compensation is padded to stay aligned with it, and the dry path is delayed to match
+    DelayLine dryDelayLineL, dryDelayLineR;
+    float* dryBufferL = nullptr;
+    float* dryBufferR = nullptr;
+    int dryBlockSize = 1;
+    int fixedLatencySamples = 0;
+    bool lastFixedLatency = false;
+
+    std::array<SpeakerChain, 2> chains;
+    int activeChain = 0;
+    ModelCrossfade modelSwitch;
 
-    std::function<float(float, LoudspeakerModel, float, float, float)> computeRmsComp;
- 
     float Q0 = 0.707f;
 
     float uInL = 0.0f;
     float uInR = 0.0f;
-    float uOutL = 0.0f;
-    float uOutR = 0.0f;
-    float uOutDelayedL = 0.0f;
-    float uOutDelayedR = 0.0f;
 
     float xL = 0.0f;
     float xR = 0.0f;
-    float xOutL = 0.0f;
-    float xOutR = 0.0f;
 
     float CmsTargetL = 0.0f;
     float CmsTargetR = 0.0f;
 
     float Cthreshold = 0.5f; // CmsComp/Cms threshold ratio, used for resonant speaker RmsComp computation
-    float gamma = 1.0f;
 
     float CmsMin = 0.0f;
-    float CmsCompL = 0.0f;
-    float CmsCompR = 0.0f;
     float lastCmsCompL = 0.0f;
     float lastCmsCompR = 0.0f;
 
-    
-    float RmsCompL = 0.0f;
-    float RmsCompR = 0.0f;
-
     float wetL = 0.0f;
     float wetR = 0.0f;
 
     float threshold = 1.0f;
     float margin = 0.9f;
 
-    juce::String currentSpeakerModel;
-    juce::String lastSpeakerModel;
+    int lastSpeakerModel = -1;
     //==============================================================================
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (XmaxFeedbackAudioProcessor)
 };
@@ -20,17 +20,34 @@ public:
         resize(maxLength);
     }
 
+    BoxSum(const BoxSum&) = delete;
+    BoxSum& operator=(const BoxSum&) = delete;
+
     void resize(int maxLength) {
         bufferLength = maxLength + 1;
-        buffer.resize(bufferLength);
-        if (maxLength != 0) buffer.shrink_to_fit();
+        ownedBuffer.resize(bufferLength);
+        if (maxLength != 0) ownedBuffer.shrink_to_fit();
+        buffer = ownedBuffer.data();
+        reset();
+    }
+
+    // Number of samples of memory needed for a maximum length of maxLength samples
+    static int getStorageSize(int maxLength) noexcept {
+        return maxLength + 1;
+    }
+
+    // Uses external memory (e.g. carved from a DspArena) of getStorageSize(maxLength) samples
+    void setStorage(Sample* data, int maxLength) {
+        bufferLength = maxLength + 1;
+        ownedBuffer.clear();
+        buffer = data;
         reset();
     }
 
     void reset(Sample value = Sample()) {
         index = 0;
         sum = 0;
-        for (size_t i = 0; i < buffer.size(); ++i) {
+        for (size_t i = 0; i < size_t(bufferLength); ++i) {
             buffer[i] = sum;
             sum += value;
         }
@@ -66,7 +83,8 @@ public:
 
 private:
     int bufferLength, index;
-    std::vector<Sample> buffer;
+    std::vector<Sample> ownedBuffer; // unused when the memory is external
+    Sample* buffer = nullptr;
     Sample sum = 0, wrapJump = 0;
     
 };
@@ -84,6 +102,17 @@ public:
         set(maxLength);
     }
 
+    static int getStorageSize(int maxLength) noexcept {
+        return BoxSum<Sample>::getStorageSize(maxLength);
+    }
+
+    // Uses external memory (e.g. carved from a DspArena) of getStorageSize(maxLength) samples
+    void setStorage(Sample* data, int maxLength) {
+        _maxLength = maxLength;
+        boxSum.setStorage(data, maxLength);
+        set(maxLength);
+    }
+
     void set(int length) {
         // Only update if the length actually changes
         if (length != _length) {
@@ -0,0 +1,118 @@
+/*
+  ==============================================================================
+
+    CoefficientCache.h
+    Created: 19 Oct 2026 9:41:12am
+    Author:  eliot
+
+    Designing the X/U filter (bilinear transform, root finding and zero
+    mirroring) is far too heavy to be done on the audio thread each time the
+    speaker model changes. This cache designs the coefficients of every
+    speaker model for the current sample rate on a background thread, and
+    publishes the finished table with an atomic pointer, so that a model
+    switch in processBlock is only a pointer load and a copy.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <atomic>
+#include <vector>
+#include "Parameters.h"
+#include "FilterDesign.h"
+
+// Coefficients of the tension to displacement filter and of its inverse, one biquad
+// for a driver in a sealed box, two for a vented box or a passive radiator
+struct SpeakerCoefficients
+{
+    SosCoefficients xu; // tension to displacement
+    SosCoefficients ux; // displacement to tension
+};
+
+inline SpeakerCoefficients designSpeakerCoefficients(const LoudspeakerModel& model, float sampleRate)
+{
+    SpeakerCoefficients coeffs;
+
+    coeffs.xu = getXUSections(model, sampleRate, 0.95f);
+    coeffs.ux = invertSections(coeffs.xu);
+
+    return coeffs;
+}
+
+class CoefficientCache : private juce::Thread
+{
+public:
+    CoefficientCache() : juce::Thread("Xmax coefficient cache") {}
+
+    ~CoefficientCache() override
+    {
+        stopThread(1000);
+    }
+
+    // Called from prepareToPlay: starts the design of every speaker model for this sample rate.
+    // The audio thread is not running at this point, so the table can safely be rewritten.
+    void prepare(double sampleRate)
+    {
+        if (published.load(std::memory_order_acquire) != nullptr && table.sampleRate == sampleRate)
+            return;
+
+        if (isThreadRunning() && pendingSampleRate == sampleRate)
+            return;
+
+        stopThread(1000);
+        published.store(nullptr, std::memory_order_release);
+        pendingSampleRate = sampleRate;
+        startThread(juce::Thread::Priority::low);
+    }
+
+    // Audio thread: returns nullptr while the table for this sample rate is not ready yet
+    const SpeakerCoefficients* find(int modelIndex, double sampleRate) const noexcept
+    {
+        const auto* current = published.load(std::memory_order_acquire);
+
+        if (current == nullptr || current->sampleRate != sampleRate)
+            return nullptr;
+
+        if (modelIndex < 0 || modelIndex >= int(current->models.size()))
+            return nullptr;
+
+        return &current->models[size_t(modelIndex)];
+    }
+
+    bool isReady() const noexcept
+    {
+        return published.load(std::memory_order_acquire) != nullptr;
+    }
+
+private:
+    struct Table
+    {
+        double sampleRate = 0.0;
+        std::vector<SpeakerCoefficients> models; // same order as Parameters::getSpeakerModelNames
+    };
+
+    void run() override
+    {
+        table.sampleRate = pendingSampleRate;
+        int numModels = Parameters::getNumSpeakerModels();
+        table.models.resize(size_t(numModels));
+
+        for (int i = 0; i < numModels; ++i) {
+            if (threadShouldExit())
+                return;
+
+            const auto& model = Parameters::getSpeakerModel(i);
+            table.models[size_t(i)] = designSpeakerCoefficients(model, float(table.sampleRate));
+        }
+
+        published.store(&table, std::memory_order_release);
+    }
+
+    Table table;
+    double pendingSampleRate = 0.0;
+    std::atomic<const Table*> published{ nullptr };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(CoefficientCache)
+};
@@ -0,0 +1,127 @@
+/*
+  ==============================================================================
+
+    Crossover.h
+    Created: 19 Oct 2026 8:46:37pm
+    Author:  eliot
+
+    Linkwitz-Riley crossover of 4th order, 2 to 4 ways, for both channels.
+    Rather than a tree of splits, each band is its own cascade applied to
+    the input: the high-pass of every crossover point below the band, the
+    low-pass of the point above it, and the allpass of each point further
+    up, which has the phase of the split the other bands went through:
+
+        band 0 of 3 ways:  LP(f1) AP(f2)
+        band 1:            HP(f1) LP(f2)
+        band 2:            HP(f1) HP(f2)
+
+    so that the bands sum to an allpass. The low-pass and high-pass of
+    Linkwitz-Riley are two Butterworth biquads, the allpass is one biquad.
+
+    Both channels of every band are the lanes of one SosLanes, 8 lanes for
+    4 ways, so all the bands are filtered together in one vector register.
+    The bands of a crossover with fewer ways are silent.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <array>
+#include <algorithm>
+#include <cmath>
+#include "SosFilter.h"
+
+class Crossover
+{
+public:
+    static constexpr int maxWays = 4;
+    static constexpr int numLanes = 2 * maxWays; // channel 0 and 1 of band 0, then of band 1...
+    static constexpr int maxSections = 6;        // HP(f1) HP(f2) LP(f3) of band 2 of 4 ways
+
+    enum class Shape { lowPass, highPass, allPass };
+
+    // Butterworth biquad at f (Hz), with the frequency prewarped for the bilinear transform
+    static SosSection designSection(Shape shape, double f, double sampleRate)
+    {
+        //s / w of the analog prototype, mapped to c (z - 1) / (z + 1)
+        double c = 1.0 / std::tan(Sos::twoPi * 0.5 * std::min(f, 0.49 * sampleRate) / sampleRate);
+        double c2 = c * c;
+        double q = std::sqrt(2.0);
+
+        //numerator b0 s^2 + b1 s + b2, denominator s^2 + q s + 1
+        double b0 = shape == Shape::lowPass ? 0.0 : 1.0;
+        double b1 = shape == Shape::allPass ? -q : 0.0;
+        double b2 = shape == Shape::highPass ? 0.0 : 1.0;
+
+        double a0 = c2 + q * c + 1.0;
+        SosSection section;
+        section.b0 = float((b0 * c2 + b1 * c + b2) / a0);
+        section.b1 = float(2.0 * (b2 - b0 * c2) / a0);
+        section.b2 = float((b0 * c2 - b1 * c + b2) / a0);
+        section.a1 = float(2.0 * (1.0 - c2) / a0);
+        section.a2 = float((c2 - q * c + 1.0) / a0);
+        return section;
+    }
+
+    // Sections of one band, of a crossover at numWays - 1 increasing frequencies
+    static int designBand(int band, int numWays, const float* frequencies, double sampleRate, SosSection* sections)
+    {
+        int count = 0;
+        for (int point = 0; point < numWays - 1; ++point) {
+            double f = frequencies[point];
+            if (point < band) {
+                sections[count++] = designSection(Shape::highPass, f, sampleRate);
+                sections[count++] = designSection(Shape::highPass, f, sampleRate);
+            }
+            else if (point == band) {
+                sections[count++] = designSection(Shape::lowPass, f, sampleRate);
+                sections[count++] = designSection(Shape::lowPass, f, sampleRate);
+            }
+            else {
+                sections[count++] = designSection(Shape::allPass, f, sampleRate);
+            }
+        }
+        return count;
+    }
+
+    // numWays from 2 to maxWays, and the frequencies of its numWays - 1 crossover points,
+    // sorted here. The state is kept, so the frequencies can move while playing.
+    void setFrequencies(int numWays, std::array<float, maxWays - 1> frequencies, double sampleRate)
+    {
+        numWays = std::clamp(numWays, 2, maxWays);
+        std::sort(frequencies.begin(), frequencies.begin() + numWays - 1);
+
+        for (int band = 0; band < maxWays; ++band) {
+            std::array<SosSection, maxSections> sections;
+            int count = 0;
+            if (band < numWays) {
+                count = designBand(band, numWays, frequencies.data(), sampleRate, sections.data());
+            }
+            else {
+                sections[0].b0 = 0.0f; //silent
+                count = 1;
+            }
+            filters.setCoefficients(2 * band, sections.data(), count);
+            filters.setCoefficients(2 * band + 1, sections.data(), count);
+        }
+    }
+
+    void reset()
+    {
+        filters.reset();
+    }
+
+    // Splits one stereo sample into bands[2 * band + channel]
+    void processSample(float sampleL, float sampleR, float* bands) noexcept
+    {
+        for (int band = 0; band < maxWays; ++band) {
+            bands[2 * band] = sampleL;
+            bands[2 * band + 1] = sampleR;
+        }
+        filters.processSample(bands);
+    }
+
+private:
+    SosLanes<float, numLanes, maxSections> filters;
+};
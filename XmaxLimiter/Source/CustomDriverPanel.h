@@ -0,0 +1,59 @@
+/*
+  ==============================================================================
+
+    CustomDriverPanel.h
+    Created: 19 Oct 2026 3:12:37pm
+    Author:  eliot
+
+    Thiele/Small parameters of a driver that is not in the list, as found on
+    a datasheet or measured, in the units of the datasheets. Mms or Cms may
+    be left empty, and Bl too: they are derived from the other parameters.
+    Shown in a call-out box by the editor; Apply hands the model over.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <array>
+#include <functional>
+#include "Parameters.h"
+
+class CustomDriverPanel : public juce::Component
+{
+public:
+    CustomDriverPanel(const LoudspeakerModel& model, std::function<void(const LoudspeakerModel&)> onApply);
+    ~CustomDriverPanel() override;
+
+    void paint(juce::Graphics&) override;
+    void resized() override;
+
+private:
+    // A parameter of LoudspeakerModel, entered as value / scale
+    struct Field
+    {
+        const char* name;
+        const char* unit;
+        float scale;
+        bool optional;
+    };
+
+    enum FieldIndex { fs, Rec, Lec, Qms, Qes, Mms, Cms, Bl, Sd, numFields };
+    static const std::array<Field, numFields> fields;
+
+    void apply();
+
+    std::array<juce::Label, numFields> labels;
+    std::array<juce::TextEditor, numFields> editors;
+    juce::TextButton applyButton{ "Apply" };
+    juce::Label errorLabel;
+
+    std::function<void(const LoudspeakerModel&)> onApply;
+
+    static constexpr int rowHeight = 24;
+    static constexpr int labelWidth = 90;
+    static constexpr int editorWidth = 80;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(CustomDriverPanel)
+};
@@ -11,6 +11,7 @@
 #pragma once
 
 #include <memory>
+#include <algorithm>
 #include <JuceHeader.h>
 
 class DelayLine
@@ -20,20 +21,34 @@ public:
     void setMaximumDelayInSamples(int maxLengthInSamples) {
         jassert(maxLengthInSamples > 0);
 
+        int paddedLength = getStorageSize(maxLengthInSamples);
+        if (ownedLength < paddedLength) {
+            ownedLength = paddedLength;
+            ownedBuffer.reset(new float[size_t(ownedLength)]);
+        }
+        buffer = ownedBuffer.get();
+        bufferLength = ownedLength;
+    }
+
+    // Number of samples of memory needed for a maximum delay of maxLengthInSamples
+    static int getStorageSize(int maxLengthInSamples) noexcept {
         //Add 2 samples for future possible interpolation...
         //But here I don't interpolate, so I could remove it
-        int paddedLength = maxLengthInSamples + 2;
-        if (bufferLength < paddedLength) {
-            bufferLength = paddedLength;
-            buffer.reset(new float[size_t(bufferLength)]);
-        }
+        return maxLengthInSamples + 2;
     }
 
-    // Resets the delay line
-    void reset() noexcept {
+    // Uses external memory (e.g. carved from a DspArena) of getStorageSize(maxLengthInSamples) samples
+    void setStorage(float* data, int maxLengthInSamples) noexcept {
+        jassert(maxLengthInSamples > 0);
+        buffer = data;
+        bufferLength = getStorageSize(maxLengthInSamples);
+    }
+
+    // Resets the delay line, filled with initialValue
+    void reset(float initialValue = 0.0f) noexcept {
         writeIndex = bufferLength - 1;
         for (size_t i = 0; i < size_t(bufferLength); ++i) {
-            buffer[i] = 0.0f;
+            buffer[i] = initialValue;
         }
     }
 
@@ -62,13 +77,50 @@ public:
         return buffer[size_t(readIndex)];
     }
 
+    // Writes a block of samples to the delay line, in at most two contiguous copies
+    void write(const float* input, int numSamples) noexcept {
+        jassert(numSamples <= bufferLength);
+
+        int start = writeIndex + 1;
+        if (start >= bufferLength) {
+            start = 0;
+        }
+
+        int firstPart = std::min(numSamples, bufferLength - start);
+        std::copy(input, input + firstPart, buffer + start);
+        std::copy(input + firstPart, input + numSamples, buffer);
+
+        writeIndex = start + numSamples - 1;
+        if (writeIndex >= bufferLength) {
+            writeIndex -= bufferLength;
+        }
+    }
+
+    // Reads the last block of numSamples samples written, delayed by a constant number of samples.
+    // The buffer must hold at least delayInSamples + numSamples samples.
+    void read(float* output, int numSamples, int delayInSamples) const noexcept {
+        jassert(delayInSamples >= 0);
+        jassert(delayInSamples + numSamples <= bufferLength);
+
+        int start = writeIndex - delayInSamples - numSamples + 1;
+        if (start < 0) {
+            start += bufferLength;
+        }
+
+        int firstPart = std::min(numSamples, bufferLength - start);
+        std::copy(buffer + start, buffer + start + firstPart, output);
+        std::copy(buffer, buffer + numSamples - firstPart, output + firstPart);
+    }
+
     // Returns the length of the buffer
     int getBufferLength() const noexcept {
         return bufferLength;
     }
 
 private:
-    std::unique_ptr<float[]> buffer;
+    std::unique_ptr<float[]> ownedBuffer; // unused when the memory is external
+    int ownedLength = 0;
+    float* buffer = nullptr;
     int bufferLength = 0;
     int writeIndex = 0;   // Index of the most recent value written
 };
\ No newline at end of file
@@ -0,0 +1,202 @@
+/*
+  ==============================================================================
+
+    DriverArray.h
+    Created: 19 Oct 2026 7:58:14pm
+    Author:  eliot
+
+    The displacement limiter for an array of different drivers, one per
+    channel of a multichannel bus, in one instance. Every driver has its own
+    X/U and U/X filters, threshold and speaker gain; the envelope times, the
+    knee, the mix and the gains of the plugin are shared.
+
+    The drivers are grouped by numLanes: the X/U and U/X filters of a group
+    are one SosLanes each, whose lanes fill a vector register, so the filters
+    of 8 drivers cost about as much as those of one. The look-ahead delay,
+    the minimum filter, the release and the averaging filter stay per driver,
+    as in processSamples.
+
+    A driver which is not limited, as the tweeter after a crossover, is only
+    delayed by the look-ahead, so that it stays aligned with the others.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <array>
+#include <algorithm>
+#include "DspArena.h"
+#include "SosFilter.h"
+#include "CoefficientCache.h"
+#include "DelayLine.h"
+#include "MinFilter.h"
+#include "BoxFilter.h"
+#include "LimiterUtils.h"
+
+class DriverArray
+{
+public:
+    static constexpr int numLanes = 8; // floats in an AVX register
+    static constexpr int maxDrivers = 32;
+    static constexpr int maxGroups = maxDrivers / numLanes;
+
+    // The smoothed parameters of one sample, shared by every driver
+    struct Envelope
+    {
+        int nAttack = 1;
+        int nAttackHold = 1;
+        float releaseCoeff = 0.0f;
+        float knee = 0.0f;
+        float threshold = 1e-3f;   // m, of the drivers which follow the parameter
+        float speakerGain = 1.0f;  // linear, of the drivers which follow the parameter
+        float inputGain = 1.0f;
+        float mix = 1.0f;
+        float gain = 1.0f;
+    };
+
+    // Peak levels of the drivers since the last call, for the meters
+    struct Levels
+    {
+        float maxLevel = 0.0f;
+        float maxDisplacement = 0.0f; // mm
+        float minGain = 1.0f;
+    };
+
+    // Bytes of the arena taken by one driver, for these look-ahead lengths
+    static size_t getStorageSize(int maxDelaySignal, int maxDelayMinFilter) noexcept
+    {
+        return DspArena::getAlignedSize<float>(size_t(MinFilter<float>::getStorageSize(maxDelayMinFilter)))
+             + DspArena::getAlignedSize<float>(size_t(BoxFilter<float>::getStorageSize(maxDelaySignal)))
+             + DspArena::getAlignedSize<float>(size_t(DelayLine::getStorageSize(maxDelaySignal)));
+    }
+
+    // Carves the buffers of numDrivers drivers, one driver after the other, and resets them
+    template<typename Carve>
+    void setStorage(int newNumDrivers, Carve&& carve, int maxDelaySignal, int maxDelayMinFilter)
+    {
+        numDrivers = std::min(newNumDrivers, maxDrivers);
+        for (int i = 0; i < numDrivers; ++i) {
+            auto& driver = drivers[size_t(i)];
+            driver.minFilter.setStorage(carve(MinFilter<float>::getStorageSize(maxDelayMinFilter)), maxDelayMinFilter);
+            driver.boxFilter.setStorage(carve(BoxFilter<float>::getStorageSize(maxDelaySignal)), maxDelaySignal);
+            driver.delayLine.setStorage(carve(DelayLine::getStorageSize(maxDelaySignal)), maxDelaySignal);
+        }
+        reset();
+    }
+
+    void reset()
+    {
+        for (auto& group : groups) {
+            group.xuFilter.reset();
+            group.uxFilter.reset();
+        }
+        for (int i = 0; i < numDrivers; ++i) {
+            auto& driver = drivers[size_t(i)];
+            driver.minFilter.reset();
+            driver.boxFilter.reset(1.0f);
+            driver.delayLine.reset();
+            driver.release = 0.0f;
+        }
+    }
+
+    int getNumDrivers() const noexcept { return numDrivers; }
+
+    // New filters of one driver, which start again from rest
+    void setCoefficients(int index, const SpeakerCoefficients& coeffs)
+    {
+        auto& group = groups[size_t(index / numLanes)];
+        group.xuFilter.setCoefficients(index % numLanes, coeffs.xu);
+        group.uxFilter.setCoefficients(index % numLanes, coeffs.ux);
+        group.xuFilter.reset(index % numLanes);
+        group.uxFilter.reset(index % numLanes);
+    }
+
+    // Threshold (m) and speaker gain (linear) of one driver; negative to follow the Envelope
+    void setLimits(int index, float threshold, float speakerGain) noexcept
+    {
+        drivers[size_t(index)].threshold = threshold;
+        drivers[size_t(index)].speakerGain = speakerGain;
+    }
+
+    // A driver which is not limited passes through with the latency of the others
+    void setLimited(int index, bool shouldBeLimited) noexcept
+    {
+        drivers[size_t(index)].limited = shouldBeLimited;
+    }
+
+    // One sample of every channel in place
+    void processFrame(float* frame, const Envelope& envelope, Levels& levels) noexcept
+    {
+        for (int first = 0; first < numDrivers; first += numLanes) {
+            auto& group = groups[size_t(first / numLanes)];
+            int numInGroup = std::min(numLanes, numDrivers - first);
+
+            alignas(32) std::array<float, numLanes> dry{}, var{}, bypass{};
+            for (int lane = 0; lane < numInGroup; ++lane) {
+                dry[size_t(lane)] = frame[first + lane];
+                var[size_t(lane)] = dry[size_t(lane)] * envelope.inputGain;
+            }
+            group.xuFilter.processSample(var.data());
+
+            for (int lane = 0; lane < numInGroup; ++lane) {
+                auto& driver = drivers[size_t(first + lane)];
+                float threshold = driver.threshold < 0.0f ? envelope.threshold : driver.threshold;
+                float speakerGain = driver.speakerGain < 0.0f ? envelope.speakerGain : driver.speakerGain;
+                float displacement = var[size_t(lane)];
+
+                if (!driver.limited) {
+                    driver.delayLine.write(dry[size_t(lane)] * envelope.inputGain);
+                    bypass[size_t(lane)] = driver.delayLine.read(envelope.nAttack);
+                    continue;
+                }
+
+                driver.minFilter.set(envelope.nAttackHold);
+                driver.boxFilter.set(envelope.nAttack);
+                driver.minFilter.add(computeGain(std::abs(displacement * speakerGain), threshold, envelope.knee));
+                float minGain = driver.minFilter.getMinimum();
+
+                driver.release = std::min(minGain, (1.0f - envelope.releaseCoeff) * driver.release + envelope.releaseCoeff * minGain);
+                if (driver.release > 0.999f) driver.release = 1.0f;
+                float g = driver.boxFilter(driver.release);
+
+                driver.delayLine.write(displacement);
+                float lim = g * driver.delayLine.read(envelope.nAttack);
+                var[size_t(lane)] = lim;
+
+                levels.minGain = std::min(levels.minGain, g);
+                levels.maxDisplacement = std::max(levels.maxDisplacement, std::abs(lim * speakerGain * 1e3f));
+            }
+            group.uxFilter.processSample(var.data());
+
+            for (int lane = 0; lane < numInGroup; ++lane) {
+                float wet = drivers[size_t(first + lane)].limited ? var[size_t(lane)] : bypass[size_t(lane)];
+                float out = (envelope.mix * wet + (1.0f - envelope.mix) * dry[size_t(lane)]) * envelope.gain;
+                frame[first + lane] = out;
+                levels.maxLevel = std::max(levels.maxLevel, std::abs(out));
+            }
+        }
+    }
+
+private:
+    struct Group
+    {
+        SosLanes<float, numLanes> xuFilter; // tension to displacement of every driver of the group
+        SosLanes<float, numLanes> uxFilter; // displacement to tension
+    };
+
+    struct Driver
+    {
+        DelayLine delayLine;
+        MinFilter<float> minFilter{0};
+        BoxFilter<float> boxFilter{0};
+        float release = 0.0f;
+        float threshold = -1.0f;
+        float speakerGain = -1.0f;
+        bool limited = true;
+    };
+
+    std::array<Group, maxGroups> groups;
+    std::array<Driver, maxDrivers> drivers;
+    int numDrivers = 0;
+};
@@ -0,0 +1,82 @@
+/*
+  ==============================================================================
+
+    DspArena.h
+    Created: 19 Oct 2026 2:14:37pm
+    Author:  eliot
+
+    One block of memory holding every DSP buffer of a processor instance.
+    It is allocated once, for the largest supported sample rate, and the
+    buffers are carved from it in prepareToPlay, each one starting on a
+    cache line. Preparing again at another sample rate or block size only
+    carves the buffers again, without any allocation.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <memory>
+#include <cstdint>
+
+class DspArena
+{
+public:
+    static constexpr size_t alignment = 64; // cache line size
+
+    // Bytes taken in the arena by a buffer of count elements
+    template<typename T>
+    static constexpr size_t getAlignedSize(size_t count) noexcept
+    {
+        return (count * sizeof(T) + alignment - 1) / alignment * alignment;
+    }
+
+    // Allocates the arena, only if it is smaller than numBytes. Every buffer carved
+    // before is lost, so the buffers must be carved again after calling this.
+    void reserve(size_t numBytes)
+    {
+        if (numBytes <= capacity)
+            return;
+
+        storage.reset(new char[numBytes + alignment]);
+        auto address = reinterpret_cast<std::uintptr_t>(storage.get());
+        base = storage.get() + (alignment - address % alignment) % alignment;
+        capacity = numBytes;
+        used = 0;
+    }
+
+    // Forgets every buffer carved, the memory is kept for the next ones
+    void clear() noexcept
+    {
+        used = 0;
+    }
+
+    // Carves a buffer of count elements, aligned on a cache line
+    template<typename T>
+    T* allocate(size_t count) noexcept
+    {
+        size_t numBytes = getAlignedSize<T>(count);
+        jassert(used + numBytes <= capacity); // the arena was not reserved for this sample rate
+
+        T* data = reinterpret_cast<T*>(base + used);
+        used += numBytes;
+        return data;
+    }
+
+    size_t getCapacity() const noexcept
+    {
+        return capacity;
+    }
+
+    size_t getUsedSize() const noexcept
+    {
+        return used;
+    }
+
+private:
+    std::unique_ptr<char[]> storage;
+    char* base = nullptr;
+    size_t capacity = 0;
+    size_t used = 0;
+};
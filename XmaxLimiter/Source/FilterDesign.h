@@ -16,6 +16,7 @@
 #include <tuple>
 #include <algorithm>
 #include "Parameters.h"
+#include "SosFilter.h"
 
 // Normalize two arrays of coefficients by dividing each element by the first element of `a`
 inline void normalize(std::array<float, 3>& a, std::array<float, 3>& b) {
@@ -151,3 +152,45 @@ inline std::pair<std::array<float, 3>, std::array<float, 3>> getXUFilterCoeffici
 
     return uxCoeffs;
 }
+
+// Analog X/U transfer function of a loudspeaker in its enclosure, in m/V. The air of the box is a
+// spring Kb on the cone; a port or a passive radiator is a second mass on the same spring
+// (referred to the area of the cone), tuned to fb, with its own suspension tuned to fp:
+// X/U = Bl/Rec * P(s) / (A(s) P(s) - Kb^2), with A(s) the cone and P(s) the radiator.
+inline AnalogTransferFunction getXUTransferFunction(const LoudspeakerModel& model) {
+    double Rec = model.Rec;
+    double Bl = model.Bl;
+    double Sd = model.Sd;
+    const auto& box = model.enclosure;
+    double Kb = box.type != Enclosure::infiniteBaffle && box.Vb > 0 ? rhoC2 * Sd * Sd / box.Vb : 0.0;
+
+    std::array<double, 3> cone = { model.Mms, model.Rms + Bl * Bl / Rec, 1 / double(model.Cms) + Kb };
+
+    AnalogTransferFunction h;
+    if (box.type != Enclosure::vented && box.type != Enclosure::passiveRadiator) {
+        h.order = 2;
+        h.b = { 0.0, 0.0, Bl / Rec };
+        std::copy(cone.begin(), cone.end(), h.a.begin());
+        return h;
+    }
+
+    double wb = 2 * pi * box.fb;
+    double wp = box.type == Enclosure::passiveRadiator ? 2 * pi * box.fp : 0.0;
+    double Mp = Kb / (wb * wb - wp * wp);
+    std::array<double, 3> radiator = { Mp, wb * Mp / box.Ql, wp * wp * Mp + Kb };
+
+    h.order = 4;
+    for (size_t i = 0; i < 3; ++i) {
+        h.b[i + 2] = Bl / Rec * radiator[i];
+        for (size_t j = 0; j < 3; ++j)
+            h.a[i + j] += cone[i] * radiator[j];
+    }
+    h.a[4] -= Kb * Kb;
+    return h;
+}
+
+// X/U filter of any enclosure as a cascade of biquads, stabilized as getXUFilterCoefficients
+// so that the inverse U/X cascade (invertSections) is stable
+inline SosCoefficients getXUSections(const LoudspeakerModel& model, float Fs, float alpha) {
+    return designSections(getXUTransferFunction(model), Fs, alpha);
+}
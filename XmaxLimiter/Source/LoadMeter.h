@@ -0,0 +1,44 @@
+/*
+  ==============================================================================
+
+    LoadMeter.h
+    Created: 19 Oct 2026 9:41:50pm
+    Author:  eliot
+
+    Share of the real-time budget used by processBlock: a bar for the average
+    load and a marker for the peak, which is held for a while so that a single
+    slow block can be seen.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "Measurement.h"
+
+class LoadMeter : public juce::Component, private juce::Timer
+{
+public:
+    LoadMeter(Measurement& peakMeasurement, AverageMeasurement& averageMeasurement);
+    ~LoadMeter() override;
+
+    void paint(juce::Graphics&) override;
+
+private:
+    void timerCallback() override;
+
+    Measurement& peakMeasurement;
+    AverageMeasurement& averageMeasurement;
+
+    static constexpr int refreshRate = 30;
+    static constexpr float holdTime = 2.0f;    // seconds
+    static constexpr float warningLoad = 0.7f; // above this share of the budget, the bar turns red
+
+    float decay = 0.0f;
+    float average = 0.0f;
+    float heldPeak = 0.0f;
+    int holdCounter = 0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(LoadMeter)
+};
@@ -0,0 +1,108 @@
+/*
+  ==============================================================================
+
+    ModelAdapter.h
+    Created: 19 Oct 2026 5:40:03pm
+    Author:  eliot
+
+    Designs the coefficients of the models estimated on the audio thread by
+    ParameterEstimator, on a background thread, as the coefficient cache
+    does for the built-in models. The estimates and the designed speakers
+    go through two mailboxes, so the audio thread neither waits nor wakes
+    the thread up: the thread looks for a new estimate a few times per
+    estimation interval.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <mutex>
+#include "Parameters.h"
+#include "CoefficientCache.h"
+#include "Mailbox.h"
+
+// A model estimated from the sense inputs, in place of the model at modelIndex
+struct AdaptedSpeaker
+{
+    LoudspeakerModel model;
+    SpeakerCoefficients coeffs;
+    int modelIndex;
+    double sampleRate;
+};
+
+class ModelAdapter : private juce::Thread
+{
+public:
+    static constexpr int pollInterval = 50; // ms
+
+    ModelAdapter()
+        : juce::Thread("Xmax model adapter"),
+          estimates(getEmptySpeaker()),
+          designed(getEmptySpeaker()),
+          latest(getEmptySpeaker())
+    {
+    }
+
+    ~ModelAdapter() override
+    {
+        stopThread(1000);
+    }
+
+    // Called from prepareToPlay
+    void start()
+    {
+        if (!isThreadRunning())
+            startThread(juce::Thread::Priority::low);
+    }
+
+    // Audio thread: hands an estimate over to the background thread
+    void post(const LoudspeakerModel& model, int modelIndex, double sampleRate) noexcept
+    {
+        estimates.push({ model, {}, modelIndex, sampleRate });
+    }
+
+    // Audio thread: the last estimate whose coefficients were designed since the previous call
+    bool pull(AdaptedSpeaker& speaker) noexcept
+    {
+        return designed.pull(speaker);
+    }
+
+    // Any other thread: the last estimate designed, for the display
+    AdaptedSpeaker getLatest() const
+    {
+        std::lock_guard<std::mutex> lock(latestLock);
+        return latest;
+    }
+
+    static AdaptedSpeaker getEmptySpeaker()
+    {
+        return { Parameters::getSpeakerModel(0), {}, -1, 0.0 };
+    }
+
+private:
+    void run() override
+    {
+        auto speaker = getEmptySpeaker();
+
+        while (!threadShouldExit()) {
+            if (estimates.pull(speaker)) {
+                speaker.coeffs = designSpeakerCoefficients(speaker.model, float(speaker.sampleRate));
+                designed.push(speaker);
+
+                std::lock_guard<std::mutex> lock(latestLock);
+                latest = speaker;
+            }
+            wait(pollInterval);
+        }
+    }
+
+    Mailbox<AdaptedSpeaker> estimates; // audio thread to this thread
+    Mailbox<AdaptedSpeaker> designed;  // this thread to the audio thread
+
+    mutable std::mutex latestLock; // never taken by the audio thread
+    AdaptedSpeaker latest;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(ModelAdapter)
+};
@@ -0,0 +1,90 @@
+/*
+  ==============================================================================
+
+    ModelCrossfade.h
+    Created: 19 Oct 2026 11:08:50am
+    Author:  eliot
+
+    Schedules a speaker model switch without replacing the filters coefficients
+    in the middle of the stream. The filter chain of the new model is started
+    from a clean state and runs in parallel with the old one:
+
+    - during the warm-up, only the old chain is heard, while the new chain fills
+      its delay line and its X/U filter settles,
+    - then the output of both chains is linearly crossfaded,
+    - at the end, the old chain is retired and becomes the spare chain for the
+      next switch.
+
+    Both the warm-up and the fade have a fixed length, so a switch costs at most
+    getLength() samples of a second filter chain, which must be taken into
+    account in the worst-case CPU budget of the processor.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <cmath>
+#include <algorithm>
+
+class ModelCrossfade
+{
+public:
+    // covers the maximum attack time (delay line fill) plus about 5 time constants of
+    // the slowest X/U pole of the built-in models (~22 ms for the B&C 15FW76-4)
+    static constexpr float warmUpTime = 120.0f; // ms
+    static constexpr float fadeTime = 20.0f;    // ms
+
+    void prepare(double sampleRate) noexcept
+    {
+        warmUpLength = int(std::ceil(warmUpTime * 0.001 * sampleRate));
+        fadeLength = std::max(1, int(std::ceil(fadeTime * 0.001 * sampleRate)));
+        reset();
+    }
+
+    void reset() noexcept
+    {
+        position = 0;
+        active = false;
+    }
+
+    void start() noexcept
+    {
+        position = 0;
+        active = true;
+    }
+
+    bool isActive() const noexcept
+    {
+        return active;
+    }
+
+    // Returns the weight of the new chain for the current sample and moves to the next one
+    float getNextWeight() noexcept
+    {
+        float weight = 0.0f;
+        if (position >= warmUpLength) {
+            weight = float(position - warmUpLength + 1) / float(fadeLength);
+        }
+        ++position;
+        return std::min(weight, 1.0f);
+    }
+
+    // True once the new chain is fully faded in and the old one can be retired
+    bool isFinished() const noexcept
+    {
+        return active && position >= warmUpLength + fadeLength;
+    }
+
+    // Number of samples during which two filter chains run for one switch
+    int getLength() const noexcept
+    {
+        return warmUpLength + fadeLength;
+    }
+
+private:
+    int warmUpLength = 0;
+    int fadeLength = 1;
+    int position = 0;
+    bool active = false;
+};
@@ -0,0 +1,165 @@
+/*
+  ==============================================================================
+
+    NonlinearPredictor.h
+    Created: 19 Oct 2026 6:24:51pm
+    Author:  eliot
+
+    Displacement of the driver for the gain computer, with the force factor
+    and the stiffness of the suspension varying with the excursion. The X/U
+    filter is exact for small signals only: near Xmax, Bl falls and the
+    suspension stiffens, and the linear prediction is wrong exactly when the
+    protection matters. Le is neglected, as in the X/U filter:
+
+        Mms dv/dt = Bl(x)/Re (u - Bl(x) v) - Rms v - Kms(x) x - Kb (x + y)
+        Mp dw/dt = -Rp w - Kp y - Kb (x + y)
+
+    with y and w the port or the passive radiator, as in getXUTransferFunction.
+    Bl(x) and Kms(x) are evaluated in Horner form at the displacement of the
+    previous sample, then the equations are stepped by the trapezoidal rule:
+    with constant Bl and Kms, the prediction is the one of the bilinear X/U
+    filter. A step solves a 2x2 system, with one division.
+
+    The channels are processed together, the state of each variable stored
+    channel by channel, so that they are computed by the same vector
+    instructions, as in SosCascade.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include "Parameters.h"
+
+template<typename Sample = float, int numChannels = 2>
+class NonlinearPredictor {
+public:
+    // Relative variation with the displacement x in mm, without the constant term:
+    // Bl(x) = Bl (1 + bl[0] x + bl[1] x^2 + bl[2] x^3 + bl[3] x^4), and Kms(x) as well
+    static constexpr int order = 4;
+    using Polynomial = std::array<Sample, order>;
+
+    // The driver and its box, at this sample rate. Real-time safe.
+    void prepare(const LoudspeakerModel& model, double sampleRate) noexcept
+    {
+        double Mms = model.Mms;
+        double Sd = model.Sd;
+        const auto& box = model.enclosure;
+        double Kb = box.type != Enclosure::infiniteBaffle && box.Vb > 0 ? rhoC2 * Sd * Sd / box.Vb : 0.0;
+        double h = 0.5 / sampleRate;
+
+        //per unit of mass, times the half step
+        force = Sample(h * model.Bl / (model.Rec * Mms));
+        electricalDamping = Sample(h * model.Bl * model.Bl / (model.Rec * Mms));
+        mechanicalDamping = Sample(h * model.Rms / Mms);
+        stiffness = Sample(h * h / (model.Cms * Mms));
+        coneBox = Sample(h * h * Kb / Mms);
+        halfStep = Sample(h);
+        twoPerHalfStep = Sample(2 / h);
+
+        //the radiator is linear: its row of the system is constant
+        radiatorBox = 0;
+        radiatorDiagonal = 1;
+        radiatorDamping = 0;
+        radiatorStiffness = 0;
+        if ((box.type == Enclosure::vented || box.type == Enclosure::passiveRadiator) && Kb > 0.0) {
+            double wb = 2 * pi * box.fb;
+            double wp = box.type == Enclosure::passiveRadiator ? 2 * pi * box.fp : 0.0;
+            double Mp = Kb / (wb * wb - wp * wp);
+
+            radiatorBox = Sample(h * h * Kb / Mp);
+            radiatorDamping = Sample(h * wb / box.Ql);
+            radiatorStiffness = Sample(h * h * wp * wp);
+            radiatorDiagonal = 1 + radiatorDamping + radiatorStiffness + radiatorBox;
+        }
+    }
+
+    // Typical curves of a driver of this Xmax (mm), as defined by Klippel: Bl falls to 82 %
+    // and the compliance to 75 % at Xmax, a little more outwards than inwards. Linear if 0.
+    void setXmax(float xmax) noexcept
+    {
+        if (xmax <= 0.0f) {
+            setNonlinearity({}, {});
+            return;
+        }
+        Sample x2 = Sample(xmax) * Sample(xmax);
+        setNonlinearity({ Sample(-0.02) / Sample(xmax), Sample(-0.18) / x2, 0, 0 },
+                        { 0, Sample(1 / 0.75 - 1) / x2, 0, 0 });
+    }
+
+    void setNonlinearity(const Polynomial& newBl, const Polynomial& newKms) noexcept
+    {
+        bl = newBl;
+        kms = newKms;
+    }
+
+    void reset() noexcept
+    {
+        state = State();
+    }
+
+    // Tension at the terminals in V to displacement in m, one sample of every channel in place
+    void processSample(Sample* frame) noexcept
+    {
+        auto& s = state;
+
+        for (int channel = 0; channel < numChannels; ++channel) {
+            Sample u = frame[channel];
+            Sample x = s.x[channel], v = s.v[channel], y = s.y[channel], w = s.w[channel];
+
+            Sample mm = x * Sample(1e3);
+            Sample blFactor = std::max(Sample(1) + mm * (bl[0] + mm * (bl[1] + mm * (bl[2] + mm * bl[3]))), minFactor);
+            Sample kmsFactor = std::max(Sample(1) + mm * (kms[0] + mm * (kms[1] + mm * (kms[2] + mm * kms[3]))), minFactor);
+
+            //unknowns: the sums of the velocities at both ends of the step, S for the cone, Q for the radiator
+            Sample k = stiffness * kmsFactor + coneBox;
+            Sample a11 = 1 + mechanicalDamping + electricalDamping * blFactor * blFactor + k;
+            Sample b1 = 2 * v + force * blFactor * (u + s.u[channel]) - twoPerHalfStep * (k * x + coneBox * y);
+            Sample b2 = 2 * w - twoPerHalfStep * ((radiatorStiffness + radiatorBox) * y + radiatorBox * x);
+
+            Sample S = (b1 * radiatorDiagonal - coneBox * b2) / (a11 * radiatorDiagonal - coneBox * radiatorBox);
+            Sample Q = (b2 - radiatorBox * S) / radiatorDiagonal;
+
+            s.x[channel] = x + halfStep * S;
+            s.v[channel] = S - v;
+            s.y[channel] = y + halfStep * Q;
+            s.w[channel] = Q - w;
+            s.u[channel] = u;
+            frame[channel] = s.x[channel];
+        }
+    }
+
+    void processSample(Sample& sampleL, Sample& sampleR) noexcept
+    {
+        static_assert(numChannels == 2, "stereo predictor only");
+        Sample frame[2] = { sampleL, sampleR };
+        processSample(frame);
+        sampleL = frame[0];
+        sampleR = frame[1];
+    }
+
+    Sample processSample(Sample x) noexcept
+    {
+        static_assert(numChannels == 1, "mono predictor only");
+        processSample(&x);
+        return x;
+    }
+
+private:
+    static constexpr Sample minFactor = Sample(0.05); // Bl and Kms kept positive far beyond Xmax
+
+    struct State {
+        std::array<Sample, numChannels> x{}, v{}, y{}, w{}, u{};
+    };
+
+    Polynomial bl{}, kms{};
+
+    Sample force = 0, electricalDamping = 0, mechanicalDamping = 0, stiffness = 0, coneBox = 0;
+    Sample radiatorBox = 0, radiatorDiagonal = 1, radiatorDamping = 0, radiatorStiffness = 0;
+    Sample halfStep = 1, twoPerHalfStep = 2;
+
+    State state;
+};
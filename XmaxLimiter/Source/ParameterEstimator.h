@@ -0,0 +1,269 @@
+/*
+  ==============================================================================
+
+    ParameterEstimator.h
+    Created: 19 Oct 2026 5:12:37pm
+    Author:  eliot
+
+    Tracks the drift of the driver (the voice coil heating up, the suspension
+    softening) from the tension and the current sensed at its terminals. In
+    a sealed box or on a baffle, once the tension across the inductance,
+    Le di/dt, is removed with the Le of the model (which hardly drifts):
+
+        u (s^2 + s Rms/Mms + w^2) = i (Re s^2 + s (Re Rms + Bl^2)/Mms + Re w^2)
+
+    Both sides are filtered by the same 2nd order state-variable filter,
+    tuned on the resonance of the model, whose low-pass, band-pass and
+    high-pass outputs stand for the derivatives: the equation becomes linear
+    in five coefficients at every sample, and is fitted by recursive least
+    squares with a forgetting factor, on one sample out of several (the
+    control rate, about 2 kHz). Fitting the differential equation rather
+    than a discrete model keeps the regression well conditioned, however
+    high the sample rate. The coefficients give the resonance, Rms, Re and
+    Bl, with the Mms of the model, which cannot be told apart from Cms by an
+    electrical measurement and does not drift.
+
+    The cost is a fixed handful of operations per sample, without any
+    allocation, so that the estimator runs on the audio thread; the model is
+    only updated with estimates of plausible parameters, and nothing is
+    learned while the tension is too low to tell the noise from the driver.
+    Vented boxes and passive radiators, whose admittance is of the 4th
+    order, are not tracked.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <array>
+#include <cmath>
+#include "Parameters.h"
+
+class ParameterEstimator
+{
+public:
+    static constexpr double controlRate = 2000.0;   // Hz, rate of the least squares updates
+    static constexpr double memoryTime = 2.0;       // s, time constant of the forgetting factor
+    static constexpr double publishInterval = 0.25; // s, between two estimates
+    static constexpr double minTension = 0.05;      // V RMS, below which nothing is learned
+
+    static bool supports(const LoudspeakerModel& model) noexcept
+    {
+        return model.enclosure.type == Enclosure::infiniteBaffle || model.enclosure.type == Enclosure::sealed;
+    }
+
+    // Starts again from this model, whose Le, Mms, Sd and box are kept. Real-time safe.
+    void prepare(const LoudspeakerModel& model, double sampleRate) noexcept
+    {
+        nominal = model;
+        supported = supports(model);
+        decimation = std::max(1, int(std::round(sampleRate / controlRate)));
+        double rate = sampleRate / decimation;
+        inductance = model.Lec * sampleRate;
+        forgetting = 1.0 - 1.0 / (memoryTime * rate);
+        publishLength = int(publishInterval * rate);
+        powerCoeff = 1.0 - std::exp(-1.0 / (0.1 * sampleRate));
+
+        const auto& box = model.enclosure;
+        boxStiffness = box.type == Enclosure::sealed && box.Vb > 0 ? rhoC2 * model.Sd * model.Sd / box.Vb : 0.0;
+
+        //the filters weight the band around the resonance in the box
+        filterW = std::sqrt((1 / double(model.Cms) + boxStiffness) / model.Mms);
+        filterU.prepare(filterW, sampleRate);
+        filterI.prepare(filterW, sampleRate);
+
+        reset();
+    }
+
+    void reset() noexcept
+    {
+        theta = getNominalCoefficients();
+        for (size_t r = 0; r < numCoefficients; ++r)
+            for (size_t c = 0; c < numCoefficients; ++c)
+                P[r][c] = r == c ? initialCovariance : 0.0;
+
+        filterU.reset();
+        filterI.reset();
+        lastU = lastI = 0.0;
+        power = 0.0;
+        phase = 0;
+        numUpdates = 0;
+        sincePublished = 0;
+    }
+
+    bool isSupported() const noexcept { return supported; }
+
+    // Tension (V) and current (A) at the terminals, as sensed: sample * scale
+    void process(const float* tension, const float* current, int numSamples, float tensionScale, float currentScale) noexcept
+    {
+        if (!supported)
+            return;
+
+        for (int n = 0; n < numSamples; ++n) {
+            double u = tension[n] * tensionScale;
+            double i = current[n] * currentScale;
+
+            //the difference is centred between the samples, so is the average of the rest
+            double ui = 0.5 * (u + lastU) - inductance * (i - lastI);
+            double ic = 0.5 * (i + lastI);
+            lastU = u;
+            lastI = i;
+
+            power += powerCoeff * (u * u - power);
+            filterU.process(ui);
+            filterI.process(ic);
+
+            if (++phase < decimation)
+                continue;
+            phase = 0;
+            if (power >= minTension * minTension)
+                update();
+        }
+    }
+
+    // Model of the last estimate, at most once per publishInterval and only if its parameters
+    // are plausible for this driver
+    bool takeModel(LoudspeakerModel& model) noexcept
+    {
+        if (sincePublished < publishLength || numUpdates < publishLength)
+            return false;
+
+        sincePublished = 0;
+        return getModel(model);
+    }
+
+private:
+    static constexpr size_t numCoefficients = 5;
+    static constexpr double initialCovariance = 1.0;
+    static constexpr double maxCovariance = 1e4; // the trace of P, against the windup without excitation
+
+    using Vector = std::array<double, numCoefficients>;
+
+    // Trapezoidal state-variable filter, Q = 0.7: with s normalized by its frequency,
+    // lp = x / D(s), bp = s x / D(s) and hp = s^2 x / D(s)
+    struct StateVariableFilter
+    {
+        void prepare(double w, double sampleRate) noexcept
+        {
+            double g = std::tan(0.5 * w / sampleRate);
+            a1 = 1 / (1 + g * (g + k));
+            a2 = g * a1;
+            a3 = g * a2;
+        }
+
+        void reset() noexcept
+        {
+            ic1 = ic2 = lp = bp = hp = 0.0;
+        }
+
+        void process(double x) noexcept
+        {
+            double v3 = x - ic2;
+            double v1 = a1 * ic1 + a2 * v3;
+            double v2 = ic2 + a2 * ic1 + a3 * v3;
+            ic1 = 2 * v1 - ic1;
+            ic2 = 2 * v2 - ic2;
+            lp = v2;
+            bp = v1;
+            hp = x - k * v1 - v2;
+        }
+
+        static constexpr double k = 1.4;
+        double a1 = 0.0, a2 = 0.0, a3 = 0.0;
+        double ic1 = 0.0, ic2 = 0.0;
+        double lp = 0.0, bp = 0.0, hp = 0.0;
+    };
+
+    // With s normalized by filterW: u (s^2 + theta[0] s + theta[1]) = i (theta[2] s^2 + theta[3] s + theta[4])
+    Vector getNominalCoefficients() const noexcept
+    {
+        double w2 = (1 / double(nominal.Cms) + boxStiffness) / nominal.Mms;
+        double Re = nominal.Rec;
+        double damping = nominal.Rms / nominal.Mms;
+        double electricalDamping = nominal.Bl * nominal.Bl / (nominal.Mms * Re);
+        double W = filterW;
+
+        return { damping / W, w2 / (W * W), Re, Re * (damping + electricalDamping) / W, Re * w2 / (W * W) };
+    }
+
+    void update() noexcept
+    {
+        const auto& u = filterU;
+        const auto& i = filterI;
+        Vector phi = { -u.bp, -u.lp, i.hp, i.bp, i.lp };
+
+        Vector Pphi{};
+        double denominator = forgetting;
+        for (size_t r = 0; r < numCoefficients; ++r) {
+            for (size_t c = 0; c < numCoefficients; ++c)
+                Pphi[r] += P[r][c] * phi[c];
+            denominator += phi[r] * Pphi[r];
+        }
+
+        double error = u.hp;
+        for (size_t r = 0; r < numCoefficients; ++r)
+            error -= theta[r] * phi[r];
+
+        //P stops growing once it is large, when the excitation is poor in some direction
+        double trace = 0.0;
+        for (size_t r = 0; r < numCoefficients; ++r)
+            trace += P[r][r];
+        double scale = trace < maxCovariance ? 1.0 / forgetting : 1.0;
+
+        for (size_t r = 0; r < numCoefficients; ++r) {
+            double gain = Pphi[r] / denominator;
+            theta[r] += gain * error;
+            for (size_t c = 0; c < numCoefficients; ++c)
+                P[r][c] = (P[r][c] - gain * Pphi[c]) * scale;
+        }
+
+        ++numUpdates;
+        ++sincePublished;
+    }
+
+    bool getModel(LoudspeakerModel& model) const noexcept
+    {
+        double W = filterW;
+        double Mms = nominal.Mms;
+        double Re = theta[2];
+        double Rms = Mms * theta[0] * W;
+        double Kms = Mms * theta[1] * W * W - boxStiffness;
+        double BlSquared = Mms * W * theta[3] - Re * Rms;
+
+        //what heating and aging can do, no more
+        double nominalW = 2 * pi * nominal.fs;
+        double ws = std::sqrt(std::max(Kms, 0.0) / Mms);
+        bool plausible = Re > 0.5 * nominal.Rec && Re < 2.5 * nominal.Rec
+                      && ws > 0.5 * nominalW && ws < 2.0 * nominalW
+                      && Rms > 0.0 && BlSquared > 0.0;
+        if (!plausible)
+            return false;
+
+        model = makeLoudspeakerModel(float(ws / (2 * pi)), float(Re), nominal.Lec, float(ws * Mms / Rms),
+                                     float(ws * Mms * Re / BlSquared), float(Mms), float(1 / Kms),
+                                     float(std::sqrt(BlSquared)), nominal.Sd)
+                    .withEnclosure(nominal.enclosure);
+        return true;
+    }
+
+    LoudspeakerModel nominal = Parameters::getSpeakerModel(0);
+    bool supported = false;
+    int decimation = 1;
+    double inductance = 0.0; // Le times the sample rate
+    double forgetting = 1.0;
+    double boxStiffness = 0.0;
+    double filterW = 1.0;
+    double powerCoeff = 0.0;
+    int publishLength = 1;
+
+    StateVariableFilter filterU, filterI;
+    double lastU = 0.0, lastI = 0.0;
+    double power = 0.0; // of the tension, V^2
+    int phase = 0;
+
+    Vector theta{};
+    std::array<Vector, numCoefficients> P{};
+    int numUpdates = 0;
+    int sincePublished = 0;
+};
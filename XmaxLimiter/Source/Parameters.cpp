@@ -9,6 +9,7 @@
 */
 
 #include "Parameters.h"
+#include "SpeakerDatabase.h"
 
 const std::map<juce::String, LoudspeakerModel> Parameters::speakerModelData = {  
                                               //fs,    Rec,       Lec,    Qms,    Qes,     Qts,      Mms,      Cms,     Bl,      Vas,       Sd
@@ -18,9 +19,105 @@ const std::map<juce::String, LoudspeakerModel> Parameters::speakerModelData = {
     { "Dayton HARB252-8",    LoudspeakerModel(172.11f, 7.2f,  0.09e-3f, 4.23f,  2.98f,   1.74f,  3.2e-3f,  0.3e-3f,  3.04f, 0.19e-3f,  21.2e-4f)},
     { "Dayton DCS165-4",     LoudspeakerModel(35.7f,   3.4f,  1.43e-3f, 6.62f,  0.36f,   0.34f, 39.5e-3f,  0.5e-3f,  9.15f, 12.1e-3f, 124.7e-4f)},
     { "B&C 15FW76-4",        LoudspeakerModel(42.0f,   3.0f,  1.04e-3f, 3.20f,  0.18f,   0.17f,  113e-3f,  131e-6f, 22.44f,   0.135f,   855e-4f)},
-    { "SB 10PGC21-4",       LoudspeakerModel(89.0f,    3.4f,  0.15e-3f, 11.2f,  1.01f,   0.92f,  2.8e-3f, 1.14e-3f,   2.3f,  1.2e-3f,    27e-4f)}
+    { "SB 10PGC21-4",       LoudspeakerModel(89.0f,    3.4f,  0.15e-3f, 11.2f,  1.01f,   0.92f,  2.8e-3f, 1.14e-3f,   2.3f,  1.2e-3f,    27e-4f)},
+    //the same drivers in a box (type, Vb, fb, fp)
+    { "Dayton RS150-4 vented",
+        LoudspeakerModel(45.1f,   3.1f,  0.34e-3f, 1.96f,  0.40f,   0.33f,  7.7e-3f, 1.62e-3f,   4.1f, 16.4e-3f,  85.0e-4f).withEnclosure({ Enclosure::vented, 10e-3f, 48.0f })},
+    { "SB 10PGC21-4 passive radiator",
+        LoudspeakerModel(89.0f,    3.4f,  0.15e-3f, 11.2f,  1.01f,   0.92f,  2.8e-3f, 1.14e-3f,   2.3f,  1.2e-3f,    27e-4f).withEnclosure({ Enclosure::passiveRadiator, 1.5e-3f, 70.0f, 40.0f })}
 };
 
+// Same order as the choices of the speaker model parameter
+const std::vector<const LoudspeakerModel*> Parameters::speakerModelsByIndex = [] {
+    std::vector<const LoudspeakerModel*> models;
+    for (const auto& name : SpeakerModels::modelNames)
+        models.push_back(&speakerModelData.at(name));
+    return models;
+}();
+
+// The database of the user, loaded once with the result of its compilation. Without any file,
+// there are only the built-in models and nothing to report; a file that does not compile is
+// logged and shown in the editor, rather than dropping every driver silently.
+static const std::pair<SpeakerDatabase, juce::Result>& getLoadedSpeakerDatabase()
+{
+    static const std::pair<SpeakerDatabase, juce::Result> loaded = [] {
+        std::pair<SpeakerDatabase, juce::Result> database{ SpeakerDatabase(), juce::Result::ok() };
+        auto source = SpeakerDatabase::getDefaultSource();
+        if (source.existsAsFile() || SpeakerDatabase::getCacheFile(source).existsAsFile()) {
+            database.second = database.first.load(source);
+            if (database.second.failed())
+                juce::Logger::writeToLog("Speaker database: " + database.second.getErrorMessage());
+        }
+        return database;
+    }();
+    return loaded;
+}
+
+const SpeakerDatabase& Parameters::getSpeakerDatabase()
+{
+    return getLoadedSpeakerDatabase().first;
+}
+
+juce::Result Parameters::getSpeakerDatabaseResult()
+{
+    return getLoadedSpeakerDatabase().second;
+}
+
+int Parameters::getNumSpeakerModels() noexcept
+{
+    return SpeakerModels::modelNames.size() + getSpeakerDatabase().getNumModels();
+}
+
+juce::StringArray Parameters::getSpeakerModelNames()
+{
+    auto names = SpeakerModels::modelNames;
+    const auto& database = getSpeakerDatabase();
+    for (int i = 0; i < database.getNumModels(); ++i)
+        names.add(database.getName(i));
+    return names;
+}
+
+LoudspeakerModel Parameters::getSpeakerModel(int modelIndex) noexcept
+{
+    int numBuiltIn = int(speakerModelsByIndex.size());
+    if (modelIndex < numBuiltIn)
+        return *speakerModelsByIndex[size_t(modelIndex)];
+
+    return getSpeakerDatabase().getModel(modelIndex - numBuiltIn);
+}
+
+juce::Array<int> Parameters::searchSpeakerModels(const juce::String& text, int maxResults)
+{
+    juce::Array<int> results;
+
+    //the built-in models are few, and not in the index
+    for (int i = 0; i < SpeakerModels::modelNames.size() && results.size() < maxResults; ++i) {
+        if (SpeakerDatabase::matches(SpeakerModels::modelNames[i], text))
+            results.add(i);
+    }
+
+    for (auto index : getSpeakerDatabase().search(text, maxResults - results.size()))
+        results.add(SpeakerModels::modelNames.size() + index);
+    return results;
+}
+
+static void getRawValue(juce::AudioProcessorValueTreeState& apvts,
+    const juce::ParameterID& id, std::atomic<float>*& destination)
+{
+    destination = apvts.getRawParameterValue(id.getParamID());
+    jassert(destination);  // parameter does not exist
+}
+
+// Converts a parameter in decibels to a linear gain, only when it changed since the last block
+static void updateGain(const std::atomic<float>* value, float& lastDecibels, float& gain) noexcept
+{
+    float decibels = value->load(std::memory_order_relaxed);
+    if (decibels != lastDecibels) {
+        lastDecibels = decibels;
+        gain = juce::Decibels::decibelsToGain(decibels);
+    }
+}
+
 template<typename T>
 static void castParameter(juce::AudioProcessorValueTreeState& apvts,
     const juce::ParameterID& id, T& destination)
@@ -66,25 +163,68 @@ static juce::String stringFromVoltage(float value, int)
     return juce::String(value, 2) + " V";
 }
 
+static juce::String stringFromCurrent(float value, int)
+{
+    return juce::String(value, 2) + " A";
+}
+
+static juce::String stringFromHertz(float value, int)
+{
+    if (value >= 1000.0f)
+        return juce::String(value * 0.001f, 2) + " kHz";
+    return juce::String(int(value)) + " Hz";
+}
+
+static juce::String stringFromWatts(float value, int)
+{
+    return juce::String(int(value)) + " W";
+}
+
+static juce::String stringFromCelsius(float value, int)
+{
+    return juce::String(int(value)) + juce::String::fromUTF8(" \xc2\xb0" "C");
+}
+
 Parameters::Parameters(juce::AudioProcessorValueTreeState& apvts)
 {
-    castParameter(apvts, inputGainParamID, inputGainParam);
-    castParameter(apvts, stereoParamID, stereoParam);
+    getRawValue(apvts, inputGainParamID, inputGainValue);
+    getRawValue(apvts, stereoParamID, stereoValue);
 
     castParameter(apvts, speakerModelParamID, speakerModelParam);
-	castParameter(apvts, speakerGainParamID, speakerGainParam);
+    getRawValue(apvts, speakerModelParamID, speakerModelValue);
+    getRawValue(apvts, speakerGainParamID, speakerGainValue);
 
-    castParameter(apvts, attackTimeParamID, attackTimeParam);
-    castParameter(apvts, holdTimeParamID, holdTimeParam);
-    castParameter(apvts, releaseTimeParamID, releaseTimeParam);
+    getRawValue(apvts, attackTimeParamID, attackTimeValue);
+    getRawValue(apvts, holdTimeParamID, holdTimeValue);
+    getRawValue(apvts, releaseTimeParamID, releaseTimeValue);
+    getRawValue(apvts, fixedLatencyParamID, fixedLatencyValue);
 
     castParameter(apvts, limiterModeParamID, limiterModeParam);
-    castParameter(apvts, thresholdTensionParamID, thresholdTensionParam);
-    castParameter(apvts, thresholdDisplacementParamID, thresholdDisplacementParam);
-    castParameter(apvts, kneeParamID, kneeParam);
-
-    castParameter(apvts, mixParamID, mixParam);
-    castParameter(apvts, gainParamID, gainParam);
+    getRawValue(apvts, limiterModeParamID, limiterModeValue);
+    getRawValue(apvts, thresholdTensionParamID, thresholdTensionValue);
+    getRawValue(apvts, thresholdDisplacementParamID, thresholdDisplacementValue);
+    getRawValue(apvts, kneeParamID, kneeValue);
+    getRawValue(apvts, nonlinearPredictionParamID, nonlinearPredictionValue);
+    getRawValue(apvts, xmaxParamID, xmaxValue);
+
+    getRawValue(apvts, adaptiveParamID, adaptiveValue);
+    getRawValue(apvts, senseVoltageParamID, senseVoltageValue);
+    getRawValue(apvts, senseCurrentParamID, senseCurrentValue);
+
+    getRawValue(apvts, thermalProtectionParamID, thermalProtectionValue);
+    getRawValue(apvts, ratedPowerParamID, ratedPowerValue);
+    getRawValue(apvts, maxCoilTemperatureParamID, maxCoilTemperatureValue);
+
+    getRawValue(apvts, crossoverParamID, crossoverValue);
+    getRawValue(apvts, crossoverFrequency1ParamID, crossoverFrequency1Value);
+    getRawValue(apvts, crossoverFrequency2ParamID, crossoverFrequency2Value);
+    getRawValue(apvts, crossoverFrequency3ParamID, crossoverFrequency3Value);
+    getRawValue(apvts, limitedBandsParamID, limitedBandsValue);
+    getRawValue(apvts, multibandParamID, multibandValue);
+    getRawValue(apvts, splitFrequencyParamID, splitFrequencyValue);
+
+    getRawValue(apvts, mixParamID, mixValue);
+    getRawValue(apvts, gainParamID, gainValue);
 }
 
 juce::AudioProcessorValueTreeState::ParameterLayout Parameters::createParameterLayout()
@@ -105,13 +245,15 @@ juce::AudioProcessorValueTreeState::ParameterLayout Parameters::createParameterL
 
     //==============================================================================
     
+    auto speakerModelNames = getSpeakerModelNames();
+    speakerModelNames.add(SpeakerModels::customModelName);
     layout.add(std::make_unique<juce::AudioParameterChoice>(
-        speakerModelParamID, "Speaker Model", SpeakerModels::modelNames, 0));
+        speakerModelParamID, "Speaker Model", speakerModelNames, 0));
     
     layout.add(std::make_unique<juce::AudioParameterFloat>(
         speakerGainParamID,
         "Speaker Gain",
-        juce::NormalisableRange<float> {0.0f, 60.0f },
+        juce::NormalisableRange<float> {0.0f, maxSpeakerGain },
         0.0f,
         juce::AudioParameterFloatAttributes().withStringFromValueFunction(stringFromDecibels)
     ));
@@ -141,6 +283,9 @@ juce::AudioProcessorValueTreeState::ParameterLayout Parameters::createParameterL
         juce::AudioParameterFloatAttributes().withStringFromValueFunction(stringFromMilliseconds)
     ));
 
+    layout.add(std::make_unique<juce::AudioParameterBool>(
+        fixedLatencyParamID, "Fixed Latency", false));
+
     //==============================================================================
     
     layout.add(std::make_unique<juce::AudioParameterChoice>(
@@ -171,6 +316,99 @@ juce::AudioProcessorValueTreeState::ParameterLayout Parameters::createParameterL
         juce::AudioParameterFloatAttributes().withStringFromValueFunction(stringFromPercent)
     ));
 
+    layout.add(std::make_unique<juce::AudioParameterBool>(
+        nonlinearPredictionParamID, "Nonlinear Prediction", false));
+
+    layout.add(std::make_unique<juce::AudioParameterFloat>(
+        xmaxParamID,
+        "Xmax",
+        juce::NormalisableRange<float> { minDisplacementThreshold, maxDisplacementThreshold, 0.01f, 0.25f },
+        3.0f,
+        juce::AudioParameterFloatAttributes().withStringFromValueFunction(stringFromMillimeters)
+    ));
+
+    //==============================================================================
+    layout.add(std::make_unique<juce::AudioParameterBool>(
+        adaptiveParamID, "Adaptive Model", false));
+
+    layout.add(std::make_unique<juce::AudioParameterFloat>(
+        senseVoltageParamID,
+        "Sense Voltage",
+        juce::NormalisableRange<float> { 1.0f, maxSenseVoltage, 0.01f, 0.3f },
+        20.0f,
+        juce::AudioParameterFloatAttributes().withStringFromValueFunction(stringFromVoltage)
+    ));
+
+    layout.add(std::make_unique<juce::AudioParameterFloat>(
+        senseCurrentParamID,
+        "Sense Current",
+        juce::NormalisableRange<float> { 0.1f, maxSenseCurrent, 0.01f, 0.3f },
+        10.0f,
+        juce::AudioParameterFloatAttributes().withStringFromValueFunction(stringFromCurrent)
+    ));
+
+    //==============================================================================
+    layout.add(std::make_unique<juce::AudioParameterBool>(
+        thermalProtectionParamID, "Thermal Protection", false));
+
+    layout.add(std::make_unique<juce::AudioParameterFloat>(
+        ratedPowerParamID,
+        "Rated Power",
+        juce::NormalisableRange<float> { 1.0f, 2000.0f, 1.0f, 0.3f },
+        100.0f,
+        juce::AudioParameterFloatAttributes().withStringFromValueFunction(stringFromWatts)
+    ));
+
+    layout.add(std::make_unique<juce::AudioParameterFloat>(
+        maxCoilTemperatureParamID,
+        "Max Coil Temperature",
+        juce::NormalisableRange<float> { minCoilTemperature, maxCoilTemperature, 1.0f },
+        150.0f,
+        juce::AudioParameterFloatAttributes().withStringFromValueFunction(stringFromCelsius)
+    ));
+
+    //==============================================================================
+    layout.add(std::make_unique<juce::AudioParameterChoice>(
+        crossoverParamID, "Crossover", CrossoverModes::modeNames, 0));
+
+    layout.add(std::make_unique<juce::AudioParameterFloat>(
+        crossoverFrequency1ParamID,
+        "Crossover 1",
+        juce::NormalisableRange<float> { minCrossoverFrequency, maxCrossoverFrequency, 1.0f, 0.25f },
+        300.0f,
+        juce::AudioParameterFloatAttributes().withStringFromValueFunction(stringFromHertz)
+    ));
+
+    layout.add(std::make_unique<juce::AudioParameterFloat>(
+        crossoverFrequency2ParamID,
+        "Crossover 2",
+        juce::NormalisableRange<float> { minCrossoverFrequency, maxCrossoverFrequency, 1.0f, 0.25f },
+        3000.0f,
+        juce::AudioParameterFloatAttributes().withStringFromValueFunction(stringFromHertz)
+    ));
+
+    layout.add(std::make_unique<juce::AudioParameterFloat>(
+        crossoverFrequency3ParamID,
+        "Crossover 3",
+        juce::NormalisableRange<float> { minCrossoverFrequency, maxCrossoverFrequency, 1.0f, 0.25f },
+        10000.0f,
+        juce::AudioParameterFloatAttributes().withStringFromValueFunction(stringFromHertz)
+    ));
+
+    layout.add(std::make_unique<juce::AudioParameterChoice>(
+        limitedBandsParamID, "Limited Bands", CrossoverModes::limitedBandNames, 0));
+
+    layout.add(std::make_unique<juce::AudioParameterBool>(
+        multibandParamID, "Multiband", false));
+
+    layout.add(std::make_unique<juce::AudioParameterFloat>(
+        splitFrequencyParamID,
+        "Split Frequency",
+        juce::NormalisableRange<float> { minCrossoverFrequency, maxSplitFrequency, 1.0f, 0.3f },
+        200.0f,
+        juce::AudioParameterFloatAttributes().withStringFromValueFunction(stringFromHertz)
+    ));
+
     //==============================================================================
     layout.add(std::make_unique<juce::AudioParameterFloat>(
         gainParamID,
@@ -191,37 +429,41 @@ juce::AudioProcessorValueTreeState::ParameterLayout Parameters::createParameterL
     return layout;
 }
 
-void Parameters::prepareToPlay(double sampleRate) noexcept
+void Parameters::prepareToPlay(double newSampleRate) noexcept
 {
     double duration = 0.02;
+    sampleRate = float(newSampleRate);
     
-    inputGainSmoother.reset(sampleRate, duration);
-    speakerGainSmoother.reset(sampleRate, duration);
-    thresholdTensionSmoother.reset(sampleRate, duration);
-    thresholdDisplacementSmoother.reset(sampleRate, duration);
-    kneeSmoother.reset(sampleRate, duration);
-    gainSmoother.reset(sampleRate, duration);
-    mixSmoother.reset(sampleRate, duration);
+    inputGainSmoother.reset(newSampleRate, duration);
+    speakerGainSmoother.reset(newSampleRate, duration);
+    thresholdTensionSmoother.reset(newSampleRate, duration);
+    thresholdDisplacementSmoother.reset(newSampleRate, duration);
+    kneeSmoother.reset(newSampleRate, duration);
+    gainSmoother.reset(newSampleRate, duration);
+    mixSmoother.reset(newSampleRate, duration);
 
 
-    smoothingCoeff = 1.0f - std::exp(-1.0f / (0.1f * float(sampleRate)));
+    smoothingCoeff = 1.0f - std::exp(-1.0f / (0.1f * sampleRate));
+    lastReleaseTime = std::numeric_limits<float>::quiet_NaN(); //the release coefficient depends on the sample rate
 }
 
 void Parameters::reset() noexcept
 {
+    update();
+
     inputGain = 0.0f;
-    inputGainSmoother.setCurrentAndTargetValue(juce::Decibels::decibelsToGain(inputGainParam->get()));
+    inputGainSmoother.setCurrentAndTargetValue(snapshot.inputGain);
 
     speakerGain = 0.0f;
-    speakerGainSmoother.setCurrentAndTargetValue(juce::Decibels::decibelsToGain(speakerGainParam->get()));
+    speakerGainSmoother.setCurrentAndTargetValue(snapshot.speakerGain);
 
 
     thresholdTension = 1.0f;
-    thresholdTensionSmoother.setCurrentAndTargetValue(thresholdTensionParam->get());
+    thresholdTensionSmoother.setCurrentAndTargetValue(snapshot.thresholdTension);
     thresholdDisplacement = 1.0f;
-    thresholdDisplacementSmoother.setCurrentAndTargetValue(thresholdDisplacementParam->get());
+    thresholdDisplacementSmoother.setCurrentAndTargetValue(snapshot.thresholdDisplacement);
     knee = 0.0f;
-    kneeSmoother.setCurrentAndTargetValue(kneeParam->get());
+    kneeSmoother.setCurrentAndTargetValue(snapshot.knee);
 
 
     attackTime = 0.0f;
@@ -229,37 +471,75 @@ void Parameters::reset() noexcept
     releaseTime = 0.0f;
 
     gain = 0.0f;
-    gainSmoother.setCurrentAndTargetValue(juce::Decibels::decibelsToGain(gainParam->get()));
+    gainSmoother.setCurrentAndTargetValue(snapshot.gain);
     mix = 1.0f;
-    mixSmoother.setCurrentAndTargetValue(mixParam->get() * 0.01f);
+    mixSmoother.setCurrentAndTargetValue(snapshot.mix);
 }
 
-void Parameters::update() noexcept
+ParameterSnapshot Parameters::update() noexcept
 {
+    //read every parameter once for this block
+    updateGain(inputGainValue, lastInputGain, snapshot.inputGain);
+    updateGain(speakerGainValue, lastSpeakerGain, snapshot.speakerGain);
+    updateGain(gainValue, lastGain, snapshot.gain);
+
+    snapshot.thresholdTension = thresholdTensionValue->load(std::memory_order_relaxed);
+    snapshot.thresholdDisplacement = thresholdDisplacementValue->load(std::memory_order_relaxed);
+    snapshot.knee = kneeValue->load(std::memory_order_relaxed) * 0.01f;
+    snapshot.nonlinearPrediction = nonlinearPredictionValue->load(std::memory_order_relaxed) >= 0.5f;
+    snapshot.xmax = xmaxValue->load(std::memory_order_relaxed);
+    snapshot.mix = mixValue->load(std::memory_order_relaxed) * 0.01f;
+
+    snapshot.attackTime = attackTimeValue->load(std::memory_order_relaxed);
+    snapshot.holdTime = holdTimeValue->load(std::memory_order_relaxed);
+    snapshot.releaseTime = releaseTimeValue->load(std::memory_order_relaxed);
+
+    snapshot.limiterMode = int(limiterModeValue->load(std::memory_order_relaxed));
+    snapshot.speakerModel = int(speakerModelValue->load(std::memory_order_relaxed));
+    snapshot.stereo = stereoValue->load(std::memory_order_relaxed) >= 0.5f;
+    snapshot.fixedLatency = fixedLatencyValue->load(std::memory_order_relaxed) >= 0.5f;
+
+    snapshot.adaptive = adaptiveValue->load(std::memory_order_relaxed) >= 0.5f;
+    snapshot.senseVoltage = senseVoltageValue->load(std::memory_order_relaxed);
+    snapshot.senseCurrent = senseCurrentValue->load(std::memory_order_relaxed);
+
+    snapshot.thermalProtection = thermalProtectionValue->load(std::memory_order_relaxed) >= 0.5f;
+    snapshot.ratedPower = ratedPowerValue->load(std::memory_order_relaxed);
+    snapshot.maxCoilTemperature = maxCoilTemperatureValue->load(std::memory_order_relaxed);
+
+    snapshot.crossover = int(crossoverValue->load(std::memory_order_relaxed));
+    snapshot.crossoverFrequency1 = crossoverFrequency1Value->load(std::memory_order_relaxed);
+    snapshot.crossoverFrequency2 = crossoverFrequency2Value->load(std::memory_order_relaxed);
+    snapshot.crossoverFrequency3 = crossoverFrequency3Value->load(std::memory_order_relaxed);
+    snapshot.limitedBands = int(limitedBandsValue->load(std::memory_order_relaxed));
+    snapshot.multiband = multibandValue->load(std::memory_order_relaxed) >= 0.5f;
+    snapshot.splitFrequency = splitFrequencyValue->load(std::memory_order_relaxed);
+
+    inputGainSmoother.setTargetValue(snapshot.inputGain);
+    speakerGainSmoother.setTargetValue(snapshot.speakerGain);
+    thresholdTensionSmoother.setTargetValue(snapshot.thresholdTension);
+    thresholdDisplacementSmoother.setTargetValue(snapshot.thresholdDisplacement);
+    kneeSmoother.setTargetValue(snapshot.knee);
+    gainSmoother.setTargetValue(snapshot.gain);
+    mixSmoother.setTargetValue(snapshot.mix);
 
-    inputGainSmoother.setTargetValue(juce::Decibels::decibelsToGain(inputGainParam->get()));
-    speakerGainSmoother.setTargetValue(juce::Decibels::decibelsToGain(speakerGainParam->get()));
-    thresholdTensionSmoother.setTargetValue(thresholdTensionParam->get());
-    thresholdDisplacementSmoother.setTargetValue(thresholdDisplacementParam->get());
-    kneeSmoother.setTargetValue(kneeParam->get() * 0.01f);
-    gainSmoother.setTargetValue(juce::Decibels::decibelsToGain(gainParam->get()));
-    mixSmoother.setTargetValue(mixParam->get() * 0.01f);
-
-    targetAttackTime = attackTimeParam->get();
     if (attackTime == 0.0f) {
-        attackTime = targetAttackTime;
+        attackTime = snapshot.attackTime;
     }
-    targetHoldTime = holdTimeParam->get();
     if (holdTime == 0.0f) {
-		holdTime = targetHoldTime;
+		holdTime = snapshot.holdTime;
 	}
-    targetReleaseTime = releaseTimeParam->get();
     if (releaseTime == 0.0f) {
-        releaseTime = targetReleaseTime;
+        releaseTime = snapshot.releaseTime;
     }
 
-    limiterMode = limiterModeParam->getIndex();
-    speakerModel = speakerModelParam->getIndex();
+    //the release time is smoothed, so the coefficient only changes while it moves
+    if (releaseTime != lastReleaseTime) {
+        lastReleaseTime = releaseTime;
+        snapshot.releaseCoeff = 1 - std::exp(-2.2f / (sampleRate * releaseTime * 0.001f));
+    }
+
+    return snapshot;
 }
 
 void Parameters::smoothen() noexcept
@@ -275,7 +555,7 @@ void Parameters::smoothen() noexcept
     gain = gainSmoother.getNextValue();
     mix = mixSmoother.getNextValue();
 
-    attackTime += (targetAttackTime - attackTime) * smoothingCoeff;
-    holdTime += (targetHoldTime - holdTime) * smoothingCoeff;
-    releaseTime += (targetReleaseTime - releaseTime) * smoothingCoeff;
-}
\ No newline at end of file
+    attackTime += (snapshot.attackTime - attackTime) * smoothingCoeff;
+    holdTime += (snapshot.holdTime - holdTime) * smoothingCoeff;
+    releaseTime += (snapshot.releaseTime - releaseTime) * smoothingCoeff;
+}
@@ -11,12 +11,31 @@
 #pragma once
 
 #include <JuceHeader.h>
+#include <atomic>
+#include <limits>
+#include <vector>
 
+class SpeakerDatabase;
 
 static constexpr double pi = juce::MathConstants<double>::pi;
+static constexpr double rhoC2 = 1.18 * 345.0 * 345.0; // air density times the speed of sound squared, Pa
+
+// Box of a driver. On an infinite baffle or in a sealed box, the X/U model is of the 2nd order;
+// vented or with a passive radiator, the air of the box couples the cone to a second resonator
+// and the model is of the 4th order.
+struct Enclosure {
+    enum Type { infiniteBaffle, sealed, vented, passiveRadiator };
+
+    Type type = infiniteBaffle;
+    float Vb = 0.0f; // m^3
+    float fb = 0.0f; // Hz, tuning of the port, or of the passive radiator in the box
+    float fp = 0.0f; // Hz, free-air resonance of the passive radiator, below fb
+    float Ql = 7.0f; // losses of the port or of the passive radiator
+};
 
 struct LoudspeakerModel {
     float fs, Rec, Lec, Qs, Qms, Qes, Qts, Mms, Cms, Rms, Bl, Vas, Sd;
+    Enclosure enclosure;
 
     LoudspeakerModel(float fs, float Rec, float Lec, float Qms, float Qes, float Qts,
         float Mms, float Cms, float Bl, float Vas, float Sd)
@@ -26,8 +45,30 @@ struct LoudspeakerModel {
         Rms = 1 / (2 * pi * fs * Cms * Qms);
         Qs = std::sqrt(Mms / Cms) / (Rms + (Bl * Bl) / Rec);
     }
+
+    LoudspeakerModel withEnclosure(const Enclosure& box) const {
+        LoudspeakerModel model = *this;
+        model.enclosure = box;
+        return model;
+    }
 };
 
+// Model from the parameters of a datasheet or a measurement: Mms or Cms may be zero, and is
+// then derived from the other one and fs; Bl is derived from Qes if zero, Qts and Vas always
+inline LoudspeakerModel makeLoudspeakerModel(float fs, float Rec, float Lec, float Qms, float Qes, float Mms, float Cms, float Bl, float Sd) {
+    double w = 2 * pi * fs;
+    if (Cms <= 0)
+        Cms = float(1 / (w * w * Mms));
+    if (Mms <= 0)
+        Mms = float(1 / (w * w * Cms));
+    if (Bl <= 0)
+        Bl = float(std::sqrt(w * Mms * Rec / Qes));
+
+    float Qts = Qms * Qes / (Qms + Qes);
+    float Vas = float(rhoC2 * Sd * Sd * Cms);
+    return LoudspeakerModel(fs, Rec, Lec, Qms, Qes, Qts, Mms, Cms, Bl, Vas, Sd);
+}
+
 //input section
 const juce::ParameterID inputGainParamID{ "inputGain", 1 };
 const juce::ParameterID stereoParamID{ "stereo", 1 };
@@ -38,14 +79,37 @@ const juce::ParameterID speakerGainParamID{ "speakerGain", 1 };
 const juce::ParameterID attackTimeParamID{ "attackTime", 1 };
 const juce::ParameterID holdTimeParamID{ "holdTime", 1 };
 const juce::ParameterID releaseTimeParamID{ "releaseTime", 1 };
+const juce::ParameterID fixedLatencyParamID{ "fixedLatency", 1 };
 //gain computer section
 const juce::ParameterID limiterModeParamID{ "limiterMode", 1 };
 const juce::ParameterID thresholdTensionParamID{ "thresholdTension", 1 };
 const juce::ParameterID thresholdDisplacementParamID{ "thresholdDisplacement", 1 };
 const juce::ParameterID kneeParamID{ "knee", 1 };
+const juce::ParameterID nonlinearPredictionParamID{ "nonlinearPrediction", 1 };
+const juce::ParameterID xmaxParamID{ "xmax", 1 };
+//adaptive model section, from the sense inputs
+const juce::ParameterID adaptiveParamID{ "adaptive", 1 };
+const juce::ParameterID senseVoltageParamID{ "senseVoltage", 1 };
+const juce::ParameterID senseCurrentParamID{ "senseCurrent", 1 };
+//thermal protection section
+const juce::ParameterID thermalProtectionParamID{ "thermalProtection", 1 };
+const juce::ParameterID ratedPowerParamID{ "ratedPower", 1 };
+const juce::ParameterID maxCoilTemperatureParamID{ "maxCoilTemperature", 1 };
+//crossover section
+const juce::ParameterID crossoverParamID{ "crossover", 1 };
+const juce::ParameterID crossoverFrequency1ParamID{ "crossoverFrequency1", 1 };
+const juce::ParameterID crossoverFrequency2ParamID{ "crossoverFrequency2", 1 };
+const juce::ParameterID crossoverFrequency3ParamID{ "crossoverFrequency3", 1 };
+const juce::ParameterID limitedBandsParamID{ "limitedBands", 1 };
+const juce::ParameterID multibandParamID{ "multiband", 1 };
+const juce::ParameterID splitFrequencyParamID{ "splitFrequency", 1 };
 //output section
 const juce::ParameterID gainParamID{ "gain", 1 };
 const juce::ParameterID mixParamID{ "mix", 1 };
+//saved with the state, besides the parameters
+const juce::Identifier speakerModelNameID{ "speakerModelName" };
+const juce::Identifier customDriverID{ "CustomDriver" };
+const juce::Identifier driverArrayID{ "DriverArray" };
 
 namespace SpeakerModels
 {
@@ -55,12 +119,67 @@ namespace SpeakerModels
                                             "Dayton HARB252-8",
                                             "Dayton DCS165-4",
                                             "B&C 15FW76-4",
-                                            "SB 10PGC21-4" };
+                                            "SB 10PGC21-4",
+                                            "Dayton RS150-4 vented",
+                                            "SB 10PGC21-4 passive radiator" };
+
+    // Last choice of the parameter, after the database: the model entered in the editor
+    const juce::String customModelName = "Custom driver";
 }
 namespace LimiterModes
 {
 	const juce::StringArray modeNames = {"Level", "Displacement" };
 }
+namespace CrossoverModes
+{
+    const juce::StringArray modeNames = { "Off", "2-Way", "3-Way", "4-Way" };
+    const juce::StringArray limitedBandNames = { "Band 1", "Bands 1-2", "Bands 1-3", "All Bands" };
+}
+
+// Values of the parameters for one block, read once from the APVTS atomics and passed
+// by value to the processing kernel. Derived values (linear gains, release coefficient)
+// are only computed again when their source parameter changed.
+struct ParameterSnapshot
+{
+    float inputGain = 1.0f;             // linear gain
+    float speakerGain = 1.0f;           // linear gain
+
+    float attackTime = 0.0f;            // targets of the smoothed times, in ms
+    float holdTime = 0.0f;
+    float releaseTime = 0.0f;
+    float releaseCoeff = 0.0f;          // one-pole coefficient of the smoothed release time
+
+    int limiterMode = 1;
+    float thresholdTension = 1.0f;
+    float thresholdDisplacement = 1.0f; // mm
+    float knee = 0.0f;                  // 0 to 1
+    bool nonlinearPrediction = false;   // the gain computer follows the excursion of a nonlinear driver
+    float xmax = 3.0f;                  // mm, of the typical nonlinear curves
+
+    float gain = 1.0f;                  // linear gain
+    float mix = 1.0f;                   // 0 to 1
+
+    int speakerModel = 0;
+    bool stereo = true;
+    bool fixedLatency = false;
+
+    bool adaptive = false;              // the model follows the drift measured on the sense inputs
+    float senseVoltage = 20.0f;         // V at full scale of the sense inputs
+    float senseCurrent = 10.0f;         // A
+
+    bool thermalProtection = false;     // the gain is also reduced to keep the voice coil below maxCoilTemperature
+    float ratedPower = 100.0f;          // W
+    float maxCoilTemperature = 150.0f;  // degrees Celsius
+
+    int crossover = 0;                  // number of ways - 1, 0 without crossover
+    float crossoverFrequency1 = 300.0f; // Hz, sorted by the crossover
+    float crossoverFrequency2 = 3000.0f;
+    float crossoverFrequency3 = 10000.0f;
+    int limitedBands = 0;               // number of limited bands from the lowest - 1
+
+    bool multiband = false;             // only the band below splitFrequency is limited, on the main bus
+    float splitFrequency = 200.0f;      // Hz
+};
 
 class Parameters
 {
@@ -71,22 +190,37 @@ public:
 
     void prepareToPlay(double sampleRate) noexcept;
     void reset() noexcept;
-    void update() noexcept;
+    ParameterSnapshot update() noexcept;
     void smoothen() noexcept;
 
     static const std::map<juce::String, LoudspeakerModel> speakerModelData;
 
+    // The models of the speaker model parameter: SpeakerModels::modelNames, then the drivers
+    // of the user database (SpeakerDatabase::getDefaultSource), loaded with the first instance.
+    // The parameter has one more choice, SpeakerModels::customModelName.
+    static const SpeakerDatabase& getSpeakerDatabase();
+    static juce::Result getSpeakerDatabaseResult(); // failed if the file of the user did not compile
+    static int getNumSpeakerModels() noexcept;
+    static juce::StringArray getSpeakerModelNames();
+
+    // Model at this index of the parameter, without any string copy or lookup (audio thread)
+    static LoudspeakerModel getSpeakerModel(int modelIndex) noexcept;
+
+    // The custom driver, whose model is not here but in the processor (see setCustomModel)
+    static bool isCustomModel(int modelIndex) noexcept { return modelIndex >= getNumSpeakerModels(); }
+
+    // Indices of the models whose name matches the text, as SpeakerDatabase::search does
+    static juce::Array<int> searchSpeakerModels(const juce::String& text, int maxResults);
+
+    // smoothed values, updated for each sample by smoothen()
     float inputGain = 0.0f;
-    bool stereo = true;
 
-    int speakerModel = 0;
     float speakerGain = 0.0f;
     
     float attackTime = 0.02f;
     float holdTime = 0.0f;
     float releaseTime = 0.0f;
 
-    int limiterMode = 1;
     float knee = 0.0f;
     float thresholdTension = 1.0f;
     float thresholdDisplacement = 1.0f;
@@ -101,42 +235,76 @@ public:
     static constexpr float minReleaseTime = 0.0f;
     static constexpr float maxReleaseTime = 4000.0f;
 
+    static constexpr double maxSampleRate = 384000.0; //the DSP state is allocated once for this rate
+
     static constexpr float minTensionThreshold = 0.01f; //not zero to avoid division by zero when computing the gain reduction
     static constexpr float maxTensionThreshold = 2.0f;
 
     static constexpr float minDisplacementThreshold = 0.11f; //displacement in mm.
     static constexpr float maxDisplacementThreshold = 30.0f;
 
+    static constexpr float maxSpeakerGain = 60.0f; // dB
+
+    static constexpr float minCrossoverFrequency = 20.0f; // Hz
+    static constexpr float maxCrossoverFrequency = 20000.0f;
+    static constexpr float maxSplitFrequency = 2000.0f;   // Hz, far above the resonance of a woofer
+
+    static constexpr float maxSenseVoltage = 200.0f; // V at full scale
+    static constexpr float maxSenseCurrent = 50.0f;  // A at full scale
+
+    static constexpr float minCoilTemperature = 60.0f;  // degrees Celsius, range of the maximum temperature
+    static constexpr float maxCoilTemperature = 300.0f;
+
     juce::AudioParameterChoice* speakerModelParam;
     juce::AudioParameterChoice* limiterModeParam;
 private:
+    static const std::vector<const LoudspeakerModel*> speakerModelsByIndex;
 
-    juce::AudioParameterFloat* inputGainParam;
-    juce::LinearSmoothedValue<float> inputGainSmoother;
-    juce::AudioParameterBool* stereoParam;
-
-    
-    juce::AudioParameterFloat* speakerGainParam;
-	juce::LinearSmoothedValue<float> speakerGainSmoother;
+    // raw values of the parameters, in their own units (dB, ms, %, index)
+    std::atomic<float>* inputGainValue;
+    std::atomic<float>* stereoValue;
+    std::atomic<float>* speakerModelValue;
+    std::atomic<float>* speakerGainValue;
+    std::atomic<float>* attackTimeValue;
+    std::atomic<float>* holdTimeValue;
+    std::atomic<float>* releaseTimeValue;
+    std::atomic<float>* fixedLatencyValue;
+    std::atomic<float>* limiterModeValue;
+    std::atomic<float>* thresholdTensionValue;
+    std::atomic<float>* thresholdDisplacementValue;
+    std::atomic<float>* kneeValue;
+    std::atomic<float>* nonlinearPredictionValue;
+    std::atomic<float>* xmaxValue;
+    std::atomic<float>* adaptiveValue;
+    std::atomic<float>* senseVoltageValue;
+    std::atomic<float>* senseCurrentValue;
+    std::atomic<float>* thermalProtectionValue;
+    std::atomic<float>* ratedPowerValue;
+    std::atomic<float>* maxCoilTemperatureValue;
+    std::atomic<float>* crossoverValue;
+    std::atomic<float>* crossoverFrequency1Value;
+    std::atomic<float>* crossoverFrequency2Value;
+    std::atomic<float>* crossoverFrequency3Value;
+    std::atomic<float>* limitedBandsValue;
+    std::atomic<float>* multibandValue;
+    std::atomic<float>* splitFrequencyValue;
+    std::atomic<float>* gainValue;
+    std::atomic<float>* mixValue;
 
-    juce::AudioParameterFloat* thresholdDisplacementParam;
+    juce::LinearSmoothedValue<float> inputGainSmoother;
+    juce::LinearSmoothedValue<float> speakerGainSmoother;
     juce::LinearSmoothedValue<float> thresholdDisplacementSmoother;
-    juce::AudioParameterFloat* thresholdTensionParam;
     juce::LinearSmoothedValue<float> thresholdTensionSmoother;
-    juce::AudioParameterFloat* kneeParam;
     juce::LinearSmoothedValue<float> kneeSmoother;
-
-    juce::AudioParameterFloat* gainParam;
     juce::LinearSmoothedValue<float> gainSmoother;
-    juce::AudioParameterFloat* mixParam;
     juce::LinearSmoothedValue<float> mixSmoother;
 
-    juce::AudioParameterFloat* attackTimeParam;
-    juce::AudioParameterFloat* holdTimeParam;
-    juce::AudioParameterFloat* releaseTimeParam;
+    ParameterSnapshot snapshot;
+    float lastInputGain = std::numeric_limits<float>::quiet_NaN(); //in dB, to detect the changes
+    float lastSpeakerGain = std::numeric_limits<float>::quiet_NaN();
+    float lastGain = std::numeric_limits<float>::quiet_NaN();
+    float lastReleaseTime = std::numeric_limits<float>::quiet_NaN();
+    float sampleRate = 44100.0f;
 
-    float targetAttackTime = 0.0f;
-    float targetHoldTime = 0.0f;
-    float targetReleaseTime = 0.0f;
     float smoothingCoeff = 0.0f;  // one-pole smoothing
 };
\ No newline at end of file
@@ -0,0 +1,84 @@
+/*
+  ==============================================================================
+
+    PipelineOverlay.cpp
+    Created: 19 Oct 2026 9:02:17pm
+    Author:  eliot
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "PipelineOverlay.h"
+#include "LookAndFeel.h"
+
+#if XMAX_PIPELINE_TIMING
+PipelineOverlay::PipelineOverlay(PipelineTimes& times_)
+    : times(times_)
+{
+    //the knobs below stay usable
+    setInterceptsMouseClicks(false, false);
+    startTimerHz(refreshRate);
+}
+
+PipelineOverlay::~PipelineOverlay()
+{
+}
+
+void PipelineOverlay::paint(juce::Graphics& g)
+{
+    g.fillAll(Colors::header.withAlpha(0.85f));
+
+    float total = 0.0f;
+    for (const auto& summary : summaries)
+        total += summary.mean;
+
+    auto area = getLocalBounds().reduced(10);
+    int nameWidth = 130;
+    int valueWidth = 70;
+
+    auto drawRow = [&](juce::Rectangle<int> row, const juce::String& name, const juce::String& minimum,
+                       const juce::String& mean, const juce::String& maximum, const juce::String& share) {
+        g.drawText(name, row.removeFromLeft(nameWidth), juce::Justification::centredLeft);
+        g.drawText(minimum, row.removeFromLeft(valueWidth), juce::Justification::centredRight);
+        g.drawText(mean, row.removeFromLeft(valueWidth), juce::Justification::centredRight);
+        g.drawText(maximum, row.removeFromLeft(valueWidth), juce::Justification::centredRight);
+        g.drawText(share, row.removeFromLeft(valueWidth), juce::Justification::centredRight);
+    };
+
+    g.setFont(Fonts::getFont(13.0f));
+    g.setColour(Colors::Group::label);
+    drawRow(area.removeFromTop(rowHeight), "us per block", "min", "mean", "max", "share");
+
+    for (int stage = 0; stage < PipelineTimes::numStages; ++stage) {
+        const auto& summary = summaries[size_t(stage)];
+        float share = total > 0.0f ? summary.mean / total : 0.0f;
+        auto row = area.removeFromTop(rowHeight);
+
+        //bar of the share of this stage, behind the numbers
+        auto bar = row.withTrimmedLeft(nameWidth + 4 * valueWidth + 10).reduced(0, 4);
+        g.setColour(Colors::Knob::trackActive);
+        g.fillRect(bar.withWidth(juce::roundToInt(share * float(bar.getWidth()))));
+
+        g.setColour(Colors::background);
+        drawRow(row, PipelineTimes::getStageName(stage),
+                juce::String(summary.minimum, 2), juce::String(summary.mean, 2), juce::String(summary.maximum, 2),
+                juce::String(juce::roundToInt(share * 100.0f)) + " %");
+    }
+
+    g.setColour(Colors::Group::label);
+    drawRow(area.removeFromTop(rowHeight), "samples loop", "", juce::String(total, 2), "", "");
+}
+
+void PipelineOverlay::timerCallback()
+{
+    //keep the last values while the host does not call processBlock
+    for (size_t stage = 0; stage < summaries.size(); ++stage) {
+        auto summary = times.measurements[stage].readAndReset();
+        if (summary.numBlocks > 0)
+            summaries[stage] = summary;
+    }
+
+    repaint();
+}
+#endif
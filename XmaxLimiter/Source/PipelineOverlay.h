@@ -0,0 +1,42 @@
+/*
+  ==============================================================================
+
+    PipelineOverlay.h
+    Created: 19 Oct 2026 9:02:17pm
+    Author:  eliot
+
+    Table drawn over the editor with the time per block of each stage of the
+    sample loop (see PipelineTimes in StageTimer.h), as the minimum, mean and
+    maximum of the blocks processed since the previous refresh, and the share
+    of each stage in the total. Only built with XMAX_PIPELINE_TIMING; a click
+    on the header of the editor shows or hides it.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "StageTimer.h"
+
+#if XMAX_PIPELINE_TIMING
+class PipelineOverlay : public juce::Component, private juce::Timer
+{
+public:
+    PipelineOverlay(PipelineTimes& times);
+    ~PipelineOverlay() override;
+
+    void paint(juce::Graphics&) override;
+
+private:
+    void timerCallback() override;
+
+    PipelineTimes& times;
+    std::array<StageMeasurement::Summary, PipelineTimes::numStages> summaries;
+
+    static constexpr int refreshRate = 4;
+    static constexpr int rowHeight = 18;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(PipelineOverlay)
+};
+#endif
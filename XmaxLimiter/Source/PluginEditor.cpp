@@ -14,7 +14,9 @@ XmaxLimiterAudioProcessorEditor::XmaxLimiterAudioProcessorEditor (XmaxLimiterAud
     : AudioProcessorEditor (&p), 
     audioProcessor (p), 
     meter(p.levelL, p.levelR), 
-    displacementMeter(p.displacementLevelL, p.displacementLevelR, p.params.thresholdDisplacement)
+    displacementMeter(p.displacementLevelL, p.displacementLevelR, p.params.thresholdDisplacement),
+    loadMeter(p.dspLoadPeak, p.dspLoadAverage),
+    temperatureMeter(p.coilTemperatureL, p.coilTemperatureR, *p.apvts.getRawParameterValue(maxCoilTemperatureParamID.getParamID()))
 {
 
     inputGroup.setText("Input");
@@ -29,6 +31,15 @@ XmaxLimiterAudioProcessorEditor::XmaxLimiterAudioProcessorEditor (XmaxLimiterAud
     };
     stereoButton.setLookAndFeel(ButtonLookAndFeel::get());
     inputGroup.addAndMakeVisible(stereoButton);
+    latencyButton.setClickingTogglesState(true);
+    latencyButton.setBounds(0, 0, 70, 27);
+    latencyButton.onClick = [this]() {
+        if (latencyButton.getToggleState()) { latencyButton.setButtonText("Fixed Lat."); }
+        else { latencyButton.setButtonText("Min. Lat."); }
+    };
+    latencyButton.onClick();
+    latencyButton.setLookAndFeel(ButtonLookAndFeel::get());
+    inputGroup.addAndMakeVisible(latencyButton);
     addAndMakeVisible(inputGroup);
 
 
@@ -36,10 +47,31 @@ XmaxLimiterAudioProcessorEditor::XmaxLimiterAudioProcessorEditor (XmaxLimiterAud
     speakerGroup.setTextLabelPosition(juce::Justification::horizontallyCentred);
     speakerGroup.addAndMakeVisible(speakerGainKnob);
     speakerModelComboBox.setBounds(0, 0, 70, 27);
-    speakerModelComboBox.addItemList(SpeakerModels::modelNames, 1);
-    speakerModelComboBox.setSelectedItemIndex(audioProcessor.params.speakerModelParam->getIndex(), juce::dontSendNotification);
+    updateSpeakerModelList();
+    speakerModelComboBox.onChange = [this]() {
+        if (speakerModelComboBox.getSelectedId() > 0)
+            speakerModelAttachment.setValueAsCompleteGesture(float(speakerModelComboBox.getSelectedId() - 1));
+    };
+    speakerModelAttachment.sendInitialUpdate();
     speakerModelComboBox.setLookAndFeel(ComboBoxLookAndFeel::get());
     speakerGroup.addAndMakeVisible(speakerModelComboBox);
+    speakerSearchBox.setBounds(0, 0, 70, 20);
+    speakerSearchBox.setTextToShowWhenEmpty("Search...", Colors::Button::text);
+    speakerSearchBox.onTextChange = [this]() { updateSpeakerModelList(); };
+    speakerGroup.addAndMakeVisible(speakerSearchBox);
+    customDriverButton.setButtonText("Custom...");
+    customDriverButton.setBounds(0, 0, 70, 20);
+    customDriverButton.onClick = [this]() { showCustomDriverPanel(); };
+    customDriverButton.setLookAndFeel(ButtonLookAndFeel::get());
+    speakerGroup.addAndMakeVisible(customDriverButton);
+    auto databaseResult = Parameters::getSpeakerDatabaseResult();
+    if (databaseResult.failed()) {
+        speakerDatabaseLabel.setText(databaseResult.getErrorMessage(), juce::dontSendNotification);
+        speakerDatabaseLabel.setColour(juce::Label::textColourId, juce::Colours::darkred);
+        speakerDatabaseLabel.setFont(Fonts::getFont(11.0f));
+        speakerDatabaseLabel.setMinimumHorizontalScale(0.5f);
+        speakerGroup.addAndMakeVisible(speakerDatabaseLabel);
+    }
     speakerComboBoxLabel.setText("Driver Model", juce::dontSendNotification);
     speakerComboBoxLabel.setColour(juce::Label::textColourId, Colors::Button::text);
     speakerComboBoxLabel.setJustificationType(juce::Justification::centred);
@@ -96,6 +128,12 @@ XmaxLimiterAudioProcessorEditor::XmaxLimiterAudioProcessorEditor (XmaxLimiterAud
     websiteLinkButton.setFont(juce::Font(15.0f, 0), false, juce::Justification::centredRight);
     websiteLinkButton.setColour(juce::HyperlinkButton::textColourId, Colors::background);
     addAndMakeVisible(websiteLinkButton);
+    addAndMakeVisible(loadMeter);
+    addAndMakeVisible(temperatureMeter);
+
+   #if XMAX_PIPELINE_TIMING
+    addAndMakeVisible(pipelineOverlay);
+   #endif
 }
 
 XmaxLimiterAudioProcessorEditor::~XmaxLimiterAudioProcessorEditor()
@@ -143,9 +181,13 @@ void XmaxLimiterAudioProcessorEditor::resized()
     // Position the knobs inside the groups
     inputGainKnob.setTopLeftPosition(20, 20);
     stereoButton.setTopLeftPosition(20, inputGainKnob.getBottom() + 70);
+    latencyButton.setTopLeftPosition(20, stereoButton.getBottom() + 10);
 
     speakerGainKnob.setTopLeftPosition(20, 20);
     speakerModelComboBox.setTopLeftPosition(20, speakerGainKnob.getBottom() + 70);
+    speakerSearchBox.setTopLeftPosition(20, speakerModelComboBox.getBottom() + 5);
+    customDriverButton.setTopLeftPosition(20, speakerSearchBox.getBottom() + 5);
+    speakerDatabaseLabel.setBounds(15, customDriverButton.getBottom() + 2, 80, 36);
     displacementMeter.setBounds(outputGroup.getWidth() - 45, 30, 35, speakerModelComboBox.getBottom() + 3);
 
     attackTimeKnob.setTopLeftPosition(20, 15);
@@ -163,6 +205,12 @@ void XmaxLimiterAudioProcessorEditor::resized()
 
 
     websiteLinkButton.setBounds(520, 25, 200, 15);
+    loadMeter.setBounds(websiteLinkButton.getX() - 120, 27, 110, 14);
+    temperatureMeter.setBounds(loadMeter.getX() - 120, 27, 110, 14);
+
+   #if XMAX_PIPELINE_TIMING
+    pipelineOverlay.setBounds(getLocalBounds().withTrimmedTop(50).reduced(60, 15));
+   #endif
 }
 
 
@@ -184,4 +232,51 @@ void XmaxLimiterAudioProcessorEditor::updateThresholdKnobs(bool displacement)
 {
         thresholdDisplacementKnob.setVisible(displacement);
         thresholdTensionKnob.setVisible(!displacement);
-}
\ No newline at end of file
+}
+
+// Lists the models matching the search text, the current one even if it does not match, and the custom driver
+void XmaxLimiterAudioProcessorEditor::updateSpeakerModelList()
+{
+    const auto& names = audioProcessor.params.speakerModelParam->choices;
+    int current = audioProcessor.params.speakerModelParam->getIndex();
+
+    auto matches = Parameters::searchSpeakerModels(speakerSearchBox.getText(), maxListedModels);
+    if (!matches.contains(current))
+        matches.insert(0, current);
+    if (current != names.size() - 1)
+        matches.add(names.size() - 1); //the custom driver is always listed
+
+    speakerModelComboBox.clear(juce::dontSendNotification);
+    for (auto index : matches)
+        speakerModelComboBox.addItem(names[index], index + 1);
+    speakerModelComboBox.setSelectedId(current + 1, juce::dontSendNotification);
+}
+
+void XmaxLimiterAudioProcessorEditor::showSpeakerModel(int modelIndex)
+{
+    if (speakerModelComboBox.indexOfItemId(modelIndex + 1) < 0)
+        updateSpeakerModelList();
+    else
+        speakerModelComboBox.setSelectedId(modelIndex + 1, juce::dontSendNotification);
+}
+
+// Edits the custom driver in a call-out box, which selects it when applied
+void XmaxLimiterAudioProcessorEditor::showCustomDriverPanel()
+{
+    auto panel = std::make_unique<CustomDriverPanel>(audioProcessor.getCustomModel(), [this](const LoudspeakerModel& model) {
+        audioProcessor.setCustomModel(model);
+        speakerModelAttachment.setValueAsCompleteGesture(float(audioProcessor.params.speakerModelParam->choices.size() - 1));
+    });
+
+    //a child of the editor, so that it is closed with it
+    juce::CallOutBox::launchAsynchronously(std::move(panel), getLocalArea(&customDriverButton, customDriverButton.getLocalBounds()), this);
+}
+
+#if XMAX_PIPELINE_TIMING
+void XmaxLimiterAudioProcessorEditor::mouseDown(const juce::MouseEvent& event)
+{
+    //a click on the header shows or hides the stage timings
+    if (event.y < 50)
+        pipelineOverlay.setVisible(!pipelineOverlay.isVisible());
+}
+#endif
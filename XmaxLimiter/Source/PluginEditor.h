@@ -15,6 +15,10 @@
 #include "LookAndFeel.h"
 #include "LevelMeter.h"
 #include "DisplacementMeter.h"
+#include "LoadMeter.h"
+#include "TemperatureMeter.h"
+#include "PipelineOverlay.h"
+#include "CustomDriverPanel.h"
 
 
 //==============================================================================
@@ -31,10 +35,17 @@ public:
     void paint (juce::Graphics&) override;
     void resized() override;
 
+   #if XMAX_PIPELINE_TIMING
+    void mouseDown(const juce::MouseEvent& event) override;
+   #endif
+
 private:
     void parameterValueChanged(int, float) override;
     void parameterGestureChanged(int, bool) override { }
     void updateThresholdKnobs(bool displacement);
+    void updateSpeakerModelList();
+    void showSpeakerModel(int modelIndex);
+    void showCustomDriverPanel();
 
     // This reference is provided as a quick way for your editor to
     // access the processor object that created it.
@@ -59,11 +70,21 @@ private:
     audioProcessor.apvts, stereoParamID.getParamID(), stereoButton
     };
 
+    juce::TextButton latencyButton;
+    juce::AudioProcessorValueTreeState::ButtonAttachment latencyButtonAttachment{
+    audioProcessor.apvts, fixedLatencyParamID.getParamID(), latencyButton
+    };
+
     juce::Label speakerComboBoxLabel;
     juce::ComboBox speakerModelComboBox;
-    juce::AudioProcessorValueTreeState::ComboBoxAttachment speakerModelComboBoxAttachment{
-    audioProcessor.apvts, speakerModelParamID.getParamID(), speakerModelComboBox
-	};
+    juce::TextEditor speakerSearchBox;
+    //not a ComboBoxAttachment: the box only lists the models matching the search, by model index + 1
+    juce::ParameterAttachment speakerModelAttachment{
+    *audioProcessor.params.speakerModelParam, [this](float value) { showSpeakerModel(int(value)); }
+    };
+    static constexpr int maxListedModels = 200;
+    juce::TextButton customDriverButton;
+    juce::Label speakerDatabaseLabel; // why the drivers of the user are missing, if they are
 
     juce::Label limiterComboBoxLabel;
     juce::ComboBox limiterModeComboBox;
@@ -82,4 +103,10 @@ private:
 
     LevelMeter meter;
     DisplacementMeter displacementMeter;
+    LoadMeter loadMeter;
+    TemperatureMeter temperatureMeter;
+
+   #if XMAX_PIPELINE_TIMING
+    PipelineOverlay pipelineOverlay{ audioProcessor.pipelineTimes };
+   #endif
 };
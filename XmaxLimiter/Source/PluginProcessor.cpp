@@ -8,6 +8,7 @@
 
 #include "PluginProcessor.h"
 #include "PluginEditor.h"
+#include "SpeakerDatabase.h"
 
 //==============================================================================
 XmaxLimiterAudioProcessor::XmaxLimiterAudioProcessor()
@@ -15,10 +16,25 @@ XmaxLimiterAudioProcessor::XmaxLimiterAudioProcessor()
          BusesProperties()
             .withInput  ("Input",  juce::AudioChannelSet::stereo(), true)
             .withOutput ("Output", juce::AudioChannelSet::stereo(), true)
+            .withInput  ("Sense",  juce::AudioChannelSet::stereo(), false) //tension and current of the driver
+            .withOutput ("Band 2", juce::AudioChannelSet::stereo(), false) //the upper bands of the crossover
+            .withOutput ("Band 3", juce::AudioChannelSet::stereo(), false)
+            .withOutput ("Band 4", juce::AudioChannelSet::stereo(), false)
     ),
-    params(apvts)
+    params(apvts),
+    customModel(Parameters::getSpeakerModel(0)),
+    customMailbox({ customModel, {}, 0.0 }),
+    customSpeaker({ customModel, {}, 0.0 }), //designed in prepareToPlay
+    adaptedSpeaker(ModelAdapter::getEmptySpeaker()),
+    arrayMailbox(ArrayLayout{})
 {
-    //do nothing
+    //allocate the DSP state once, large enough for every supported sample rate
+    arena.reserve(getArenaSize(Parameters::maxSampleRate, 0));
+    arrayModels.fill(-1);
+
+    ArrayLayout layout;
+    if (getDefaultArrayFile().existsAsFile() && loadArrayLayout(getDefaultArrayFile(), layout).wasOk())
+        setArrayLayout(layout);
 }
 
 XmaxLimiterAudioProcessor::~XmaxLimiterAudioProcessor()
@@ -88,25 +104,329 @@ void XmaxLimiterAudioProcessor::changeProgramName (int index, const juce::String
 }
 //==============================================================================
 
-void XmaxLimiterAudioProcessor::setFiltersCoeffs(const LoudspeakerModel& model, float sampleRate)
+static int getDelayInSamples(float timeInMs, double sampleRate)
+{
+    return int(std::ceil(timeInMs * 0.001f * sampleRate));
+}
+
+// Bytes of DSP state of one instance at this sample rate, with the largest dry block and
+// the drivers of the array mode or of the crossover. Must follow the buffers carved in prepareToPlay.
+size_t XmaxLimiterAudioProcessor::getArenaSize(double sampleRate, int numDrivers)
+{
+    int maxDelayInSamplesMinFilter = getDelayInSamples(Parameters::maxAttackTime + Parameters::maxHoldTime, sampleRate);
+    int maxDelayInSamplesSignal = getDelayInSamples(Parameters::maxAttackTime, sampleRate);
+
+    size_t channelSize = DspArena::getAlignedSize<float>(size_t(MinFilter<float>::getStorageSize(maxDelayInSamplesMinFilter)))
+                       + DspArena::getAlignedSize<float>(size_t(BoxFilter<float>::getStorageSize(maxDelayInSamplesSignal)))
+                       + DspArena::getAlignedSize<float>(size_t(DelayLine::getStorageSize(maxDelayInSamplesSignal))) * 2 // one per speaker chain
+                       + DspArena::getAlignedSize<float>(size_t(DelayLine::getStorageSize(maxDelayInSamplesSignal))) // gain padding
+                       + DspArena::getAlignedSize<float>(size_t(DelayLine::getStorageSize(maxDelayInSamplesSignal + maxDryBlockSize)))
+                       + DspArena::getAlignedSize<float>(size_t(maxDryBlockSize))
+                       + DspArena::getAlignedSize<float>(size_t(DelayLine::getStorageSize(maxDelayInSamplesSignal))) // high band
+                       + DspArena::getAlignedSize<float>(size_t(maxDryBlockSize));
+
+    return 2 * channelSize + size_t(numDrivers) * DriverArray::getStorageSize(maxDelayInSamplesSignal, maxDelayInSamplesMinFilter);
+}
+
+size_t XmaxLimiterAudioProcessor::getMemoryFootprint() const noexcept
+{
+    return sizeof(*this) + arena.getCapacity();
+}
+
+void XmaxLimiterAudioProcessor::setFiltersCoeffs(SpeakerChain& chain, const SpeakerCoefficients& coeffs)
+{
+    chain.xuFilter.setCoefficients(coeffs.xu);
+    chain.uxFilter.setCoefficients(coeffs.ux);
+}
+
+LoudspeakerModel XmaxLimiterAudioProcessor::getNominalModel(int modelIndex) const noexcept
+{
+    return Parameters::isCustomModel(modelIndex) ? customSpeaker.model : Parameters::getSpeakerModel(modelIndex);
+}
+
+void XmaxLimiterAudioProcessor::setFiltersCoeffs(SpeakerChain& chain, int modelIndex, double sampleRate)
+{
+    bool adapted = lastAdaptive && adaptedSpeaker.modelIndex == modelIndex && adaptedSpeaker.sampleRate == sampleRate;
+
+    //the nonlinear prediction follows the same driver as the filters
+    chain.predictor.prepare(adapted ? adaptedSpeaker.model : getNominalModel(modelIndex), sampleRate);
+    chain.predictor.setXmax(lastXmax);
+
+    setFiltersCoeffs(chain, adapted ? adaptedSpeaker.coeffs : getSpeakerCoefficients(modelIndex, sampleRate));
+}
+
+SpeakerCoefficients XmaxLimiterAudioProcessor::getSpeakerCoefficients(int modelIndex, double sampleRate) noexcept
+{
+    if (Parameters::isCustomModel(modelIndex))
+        return customSpeaker.coeffs;
+    if (auto* coeffs = coefficientCache.find(modelIndex, sampleRate))
+        return *coeffs;
+
+    // the background design is not finished yet, design this model only
+    return designSpeakerCoefficients(Parameters::getSpeakerModel(modelIndex), float(sampleRate));
+}
+
+XmaxLimiterAudioProcessor::CustomSpeaker XmaxLimiterAudioProcessor::designCustomSpeaker(const LoudspeakerModel& model, double sampleRate)
+{
+    return { model, designSpeakerCoefficients(model, float(sampleRate)), sampleRate };
+}
+
+// Message thread: the design takes a few microseconds, the audio thread only pulls the result
+void XmaxLimiterAudioProcessor::setCustomModel(const LoudspeakerModel& model)
+{
+    std::lock_guard<std::mutex> lock(customModelLock);
+    customModel = model;
+
+    //before prepareToPlay, the model is designed there
+    double sampleRate = getSampleRate();
+    if (sampleRate > 0.0)
+        customMailbox.push(designCustomSpeaker(model, sampleRate));
+}
+
+LoudspeakerModel XmaxLimiterAudioProcessor::getCustomModel() const
+{
+    std::lock_guard<std::mutex> lock(customModelLock);
+    return customModel;
+}
+
+void XmaxLimiterAudioProcessor::setArrayLayout(const ArrayLayout& layout)
+{
+    std::lock_guard<std::mutex> lock(arrayLayoutLock);
+    arrayLayout = layout;
+    arrayMailbox.push(layout);
+}
+
+XmaxLimiterAudioProcessor::ArrayLayout XmaxLimiterAudioProcessor::getArrayLayout() const
+{
+    std::lock_guard<std::mutex> lock(arrayLayoutLock);
+    return arrayLayout;
+}
+
+juce::File XmaxLimiterAudioProcessor::getDefaultArrayFile()
+{
+    return SpeakerDatabase::getDefaultSource().getSiblingFile("Array.json");
+}
+
+juce::Result XmaxLimiterAudioProcessor::loadArrayLayout(const juce::File& file, ArrayLayout& layout)
+{
+    juce::var json;
+    auto result = juce::JSON::parse(file.loadFileAsString(), json);
+    if (result.failed())
+        return juce::Result::fail(file.getFileName() + ": " + result.getErrorMessage());
+
+    auto* channels = json.getArray();
+    if (channels == nullptr)
+        return juce::Result::fail(file.getFileName() + ": expected an array of channels");
+    if (channels->size() > DriverArray::maxDrivers)
+        return juce::Result::fail(file.getFileName() + ": more than " + juce::String(DriverArray::maxDrivers) + " channels");
+
+    auto modelNames = Parameters::getSpeakerModelNames();
+    modelNames.add(SpeakerModels::customModelName);
+
+    layout = ArrayLayout();
+    for (int i = 0; i < channels->size(); ++i) {
+        auto* object = channels->getReference(i).getDynamicObject();
+        if (object == nullptr)
+            return juce::Result::fail(file.getFileName() + ": channel " + juce::String(i + 1) + " is not an object");
+
+        const auto& values = object->getProperties();
+        auto& channel = layout[size_t(i)];
+
+        if (const auto* model = values.getVarPointer("model")) {
+            channel.speakerModel = modelNames.indexOf(model->toString());
+            if (channel.speakerModel < 0)
+                return juce::Result::fail(file.getFileName() + ": unknown speaker model " + model->toString());
+        }
+        if (const auto* threshold = values.getVarPointer("threshold"))
+            channel.thresholdDisplacement = juce::jlimit(Parameters::minDisplacementThreshold, Parameters::maxDisplacementThreshold, float(*threshold));
+        if (const auto* speakerGain = values.getVarPointer("speakerGain"))
+            channel.speakerGain = juce::jlimit(0.0f, Parameters::maxSpeakerGain, float(*speakerGain));
+    }
+    return juce::Result::ok();
+}
+
+bool XmaxLimiterAudioProcessor::getAdaptedModel(LoudspeakerModel& model) const
+{
+    auto latest = adapter.getLatest();
+    if (latest.modelIndex < 0 || latest.modelIndex != params.speakerModelParam->getIndex())
+        return false;
+
+    model = latest.model;
+    return true;
+}
+
+// Loads the new model in the spare chain from a clean state, and let it warm up
+// before it is crossfaded with the current one in processBlock
+void XmaxLimiterAudioProcessor::startModelSwitch(int modelIndex)
+{
+    auto& nextChain = chains[size_t(1 - activeChain)];
+
+    setFiltersCoeffs(nextChain, modelIndex, getSampleRate());
+    nextChain.xuFilter.reset();
+    nextChain.uxFilter.reset();
+    nextChain.predictor.reset();
+    nextChain.delayLineL.reset();
+    nextChain.delayLineR.reset();
+
+    //the coils keep their temperature, only their resistance changes
+    thermalL.prepare(getNominalModel(modelIndex), getSampleRate());
+    thermalR.prepare(getNominalModel(modelIndex), getSampleRate());
+
+    modelSwitch.start();
+}
+
+// Reports the constant look-ahead to the host in fixed latency mode, and restarts
+// the padding delays with a neutral gain and a silent dry signal
+void XmaxLimiterAudioProcessor::updateLatency(bool fixedLatency)
+{
+    lastFixedLatency = fixedLatency;
+    setLatencySamples(lastFixedLatency && numArrayDrivers == 0 && !isCrossoverActive() ? fixedLatencySamples : 0);
+
+    gainDelayLineL.reset(1.0f);
+    gainDelayLineR.reset(1.0f);
+    dryDelayLineL.reset();
+    dryDelayLineR.reset();
+}
+
+// New curves of the nonlinear prediction, which starts again from rest when it is turned on
+void XmaxLimiterAudioProcessor::updatePrediction(ParameterSnapshot snapshot) noexcept
 {
-    auto doubleCoeffs = getXUFilterCoefficients(model, sampleRate, 0.95f);
-    std::array<float, 3> b_xu = doubleCoeffs.first;
-    std::array<float, 3> a_xu = doubleCoeffs.second;
+    for (auto& chain : chains) {
+        chain.predictor.setXmax(snapshot.xmax);
+        if (snapshot.nonlinearPrediction && !lastNonlinearPrediction)
+            chain.predictor.reset();
+    }
+    lastXmax = snapshot.xmax;
+    lastNonlinearPrediction = snapshot.nonlinearPrediction;
+}
+
+// New limits of the thermal protection. The temperatures are always estimated, for the meters.
+void XmaxLimiterAudioProcessor::updateThermalProtection(ParameterSnapshot snapshot) noexcept
+{
+    thermalL.setLimits(snapshot.ratedPower, snapshot.maxCoilTemperature);
+    thermalR.setLimits(snapshot.ratedPower, snapshot.maxCoilTemperature);
+    thermalL.setEnabled(snapshot.thermalProtection);
+    thermalR.setEnabled(snapshot.thermalProtection);
+    lastThermalProtection = snapshot.thermalProtection;
+    lastRatedPower = snapshot.ratedPower;
+    lastMaxCoilTemperature = snapshot.maxCoilTemperature;
+}
+
+// Filters of the drivers of the array whose model changed, and their limits. A new driver
+// starts from rest in its lanes, without a crossfade. After the crossover, the drivers are
+// the channels of the bands, and only the bands up to limitedBands are limited.
+void XmaxLimiterAudioProcessor::updateArrayDrivers(ParameterSnapshot snapshot) noexcept
+{
+    for (int i = 0; i < driverArray.getNumDrivers(); ++i) {
+        const auto& channel = activeArrayLayout[size_t(i)];
+        int model = channel.speakerModel >= 0 ? channel.speakerModel : snapshot.speakerModel;
+        if (model != arrayModels[size_t(i)]) {
+            driverArray.setCoefficients(i, getSpeakerCoefficients(model, getSampleRate()));
+            arrayModels[size_t(i)] = model;
+        }
+
+        float threshold = channel.thresholdDisplacement > 0.0f ? channel.thresholdDisplacement * 1e-3f : -1.0f; //convert in m
+        float speakerGain = channel.speakerGain >= 0.0f ? juce::Decibels::decibelsToGain(channel.speakerGain) : -1.0f;
+        driverArray.setLimits(i, threshold, speakerGain);
+        driverArray.setLimited(i, numCrossoverBands == 0 || i / 2 <= snapshot.limitedBands);
+    }
+}
+
+// New crossover points. The bands start again from rest when the crossover is turned on,
+// and the bands beyond the enabled outputs are left out.
+void XmaxLimiterAudioProcessor::updateCrossover(ParameterSnapshot snapshot) noexcept
+{
+    bool wasActive = isCrossoverActive();
+    int numWays = std::min(snapshot.crossover + 1, numCrossoverBands);
+    if (numWays > 1) {
+        crossover.setFrequencies(numWays, { snapshot.crossoverFrequency1, snapshot.crossoverFrequency2, snapshot.crossoverFrequency3 }, getSampleRate());
+        if (lastCrossover == 0) {
+            crossover.reset();
+            driverArray.reset();
+        }
+    }
+    lastCrossover = snapshot.crossover;
+    lastCrossoverFrequency1 = snapshot.crossoverFrequency1;
+    lastCrossoverFrequency2 = snapshot.crossoverFrequency2;
+    lastCrossoverFrequency3 = snapshot.crossoverFrequency3;
+
+    //the bands have the minimum latency
+    if (isCrossoverActive() != wasActive)
+        updateLatency(lastFixedLatency);
+}
+
+// New split of the multiband mode. The bands start again from rest when it is turned on.
+void XmaxLimiterAudioProcessor::updateMultiband(ParameterSnapshot snapshot) noexcept
+{
+    float f = snapshot.splitFrequency;
+    bandSplit.setFrequencies(2, { f, f, f }, getSampleRate());
+    if (snapshot.multiband && !lastMultiband) {
+        bandSplit.reset();
+        highDelayLineL.reset();
+        highDelayLineR.reset();
+    }
+    lastMultiband = snapshot.multiband;
+    lastSplitFrequency = snapshot.splitFrequency;
+}
+
+// Delays the next numSamples (at most dryBlockSize) dry samples by the fixed latency,
+// as two block copies per channel
+void XmaxLimiterAudioProcessor::delayDryPath(const float* inputL, const float* inputR, int numSamples)
+{
+    dryDelayLineL.write(inputL, numSamples);
+    dryDelayLineR.write(inputR, numSamples);
+    dryDelayLineL.read(dryBufferL, numSamples, fixedLatencySamples);
+    dryDelayLineR.read(dryBufferR, numSamples, fixedLatencySamples);
+}
+
+// Runs the estimator on the sense inputs, and switches to the models it adapted like to
+// another speaker model. The sense bus carries the tension on its first channel and the
+// current on its second one, both in the scale of the sense parameters.
+void XmaxLimiterAudioProcessor::updateAdaptation(ParameterSnapshot snapshot, juce::AudioBuffer<float>& buffer) noexcept
+{
+    //turned on or off, the filters switch to the adapted or the nominal model
+    if (snapshot.adaptive != lastAdaptive) {
+        lastAdaptive = snapshot.adaptive;
+        lastSpeakerModel = -1;
+        estimatedModel = -1;
+    }
+
+    AdaptedSpeaker received = adaptedSpeaker;
+    if (adapter.pull(received) && received.sampleRate == getSampleRate() && received.modelIndex == snapshot.speakerModel) {
+        adaptedSpeaker = received;
+        if (lastAdaptive)
+            lastSpeakerModel = -1;
+    }
+
+    auto sense = getBusBuffer(buffer, true, 1);
+    if (!lastAdaptive || sense.getNumChannels() < 2)
+        return;
 
-    xuFilterL.setCoefficients(b_xu, a_xu);
-    xuFilterR.setCoefficients(b_xu, a_xu);
+    //a new model, or a new custom driver, starts from its nominal parameters again
+    if (estimatedModel != snapshot.speakerModel) {
+        estimatedModel = snapshot.speakerModel;
+        estimator.prepare(getNominalModel(estimatedModel), getSampleRate());
+    }
+
+    estimator.process(sense.getReadPointer(0), sense.getReadPointer(1), sense.getNumSamples(),
+                      snapshot.senseVoltage, snapshot.senseCurrent);
+
+    auto estimate = customSpeaker.model;
+    if (estimator.takeModel(estimate))
+        adapter.post(estimate, estimatedModel, getSampleRate());
+}
 
-    auto b_ux = a_xu;
-    auto a_ux = b_xu;
-    //normalize the coefficients for the displacement to tension filter
+// Publishes the time of this block relative to its duration, for the load meter of the editor
+void XmaxLimiterAudioProcessor::updateDspLoad(std::chrono::steady_clock::time_point blockStart, int numSamples) noexcept
+{
+    if (numSamples <= 0)
+        return;
 
-    float norm = a_ux[0];
-    for (auto& coef : a_ux) coef /= norm;
-    for (auto& coef : b_ux) coef /= norm;
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - blockStart;
+    auto load = float(elapsed.count() * getSampleRate() / double(numSamples));
 
-    uxFilterL.setCoefficients(b_ux, a_ux);
-    uxFilterR.setCoefficients(b_ux, a_ux);
+    dspLoadPeak.updateIfGreater(load);
+    dspLoadAverage.add(load);
 }
 
 //==============================================================================
@@ -114,6 +434,7 @@ void XmaxLimiterAudioProcessor::prepareToPlay (double sampleRate, int samplesPer
 {
     params.prepareToPlay(sampleRate);
     params.reset();
+    auto snapshot = params.update();
 
 
     // Initialize delay line (circular buffer)
@@ -123,39 +444,127 @@ void XmaxLimiterAudioProcessor::prepareToPlay (double sampleRate, int samplesPer
     spec.numChannels = 2;
 
 
-    float maxDelayTimeSignal = Parameters::maxAttackTime;
-    float maxDelayTimeMinFilter = Parameters::maxAttackTime + Parameters::maxHoldTime;
-    double numSamplesMinFilter = maxDelayTimeMinFilter * 0.001f * sampleRate;
+    int maxDelayInSamplesMinFilter = getDelayInSamples(Parameters::maxAttackTime + Parameters::maxHoldTime, sampleRate);
+    int maxDelayInSamplesSignal = getDelayInSamples(Parameters::maxAttackTime, sampleRate);
+
+    //the fixed latency is the longest look-ahead, so it does not depend on the attack time
+    fixedLatencySamples = maxDelayInSamplesSignal;
+    dryBlockSize = juce::jlimit(1, maxDryBlockSize, samplesPerBlock);
 
-    double numSamplesSignal = maxDelayTimeSignal * 0.001f * sampleRate;
+    //one driver per channel of a main bus wider than stereo
+    int numMainChannels = getMainBusNumOutputChannels();
+    numArrayDrivers = numMainChannels > 2 ? std::min(numMainChannels, DriverArray::maxDrivers) : 0;
 
-    int maxDelayInSamplesMinFilter = int(std::ceil(numSamplesMinFilter));
-    int maxDelayInSamplesSignal = int(std::ceil(numSamplesSignal));
-   
+    //one stereo band on the main bus and one on each enabled band output, in the order of the
+    //buses, whichever of them the host enabled, limited by the drivers of the array
+    int numBands = 1;
+    bandBuses.fill(0);
+    for (int bus = 1; bus < getBusCount(false) && numBands < Crossover::maxWays; ++bus) {
+        if (getChannelCountOfBus(false, bus) == 2)
+            bandBuses[size_t(numBands++)] = bus;
+    }
+    numCrossoverBands = numMainChannels == 2 && numBands > 1 ? numBands : 0;
+    int numDrivers = numArrayDrivers > 0 ? numArrayDrivers : 2 * numCrossoverBands;
+
+    //carve every buffer from the arena, which was allocated for maxSampleRate in the constructor
+    //(and only grows here for the drivers of the array mode), left channel first then right
+    //channel, so that the state of one channel is contiguous
+    arena.reserve(getArenaSize(sampleRate, numDrivers));
+    arena.clear();
+
+    auto carve = [this](int numSamples) { return arena.allocate<float>(size_t(numSamples)); };
 
-    minFilterL = MinFilter<float>(maxDelayInSamplesMinFilter);
-    minFilterR = MinFilter<float>(maxDelayInSamplesMinFilter);
+    minFilterL.setStorage(carve(MinFilter<float>::getStorageSize(maxDelayInSamplesMinFilter)), maxDelayInSamplesMinFilter);
+    rectFilterL.setStorage(carve(BoxFilter<float>::getStorageSize(maxDelayInSamplesSignal)), maxDelayInSamplesSignal);
+    for (auto& chain : chains) {
+        chain.delayLineL.setStorage(carve(DelayLine::getStorageSize(maxDelayInSamplesSignal)), maxDelayInSamplesSignal);
+    }
+    gainDelayLineL.setStorage(carve(DelayLine::getStorageSize(fixedLatencySamples)), fixedLatencySamples);
+    dryDelayLineL.setStorage(carve(DelayLine::getStorageSize(fixedLatencySamples + dryBlockSize)), fixedLatencySamples + dryBlockSize);
+    dryBufferL = carve(dryBlockSize);
+    highDelayLineL.setStorage(carve(DelayLine::getStorageSize(fixedLatencySamples)), fixedLatencySamples);
+    highBufferL = carve(dryBlockSize);
+
+    minFilterR.setStorage(carve(MinFilter<float>::getStorageSize(maxDelayInSamplesMinFilter)), maxDelayInSamplesMinFilter);
+    rectFilterR.setStorage(carve(BoxFilter<float>::getStorageSize(maxDelayInSamplesSignal)), maxDelayInSamplesSignal);
+    for (auto& chain : chains) {
+        chain.delayLineR.setStorage(carve(DelayLine::getStorageSize(maxDelayInSamplesSignal)), maxDelayInSamplesSignal);
+    }
+    gainDelayLineR.setStorage(carve(DelayLine::getStorageSize(fixedLatencySamples)), fixedLatencySamples);
+    dryDelayLineR.setStorage(carve(DelayLine::getStorageSize(fixedLatencySamples + dryBlockSize)), fixedLatencySamples + dryBlockSize);
+    dryBufferR = carve(dryBlockSize);
+    highDelayLineR.setStorage(carve(DelayLine::getStorageSize(fixedLatencySamples)), fixedLatencySamples);
+    highBufferR = carve(dryBlockSize);
+
+    driverArray.setStorage(numDrivers, carve, maxDelayInSamplesSignal, maxDelayInSamplesMinFilter);
+
+    for (auto& chain : chains) {
+        chain.delayLineL.reset();
+        chain.delayLineR.reset();
+        chain.xuFilter.reset();
+        chain.uxFilter.reset();
+        chain.predictor.reset();
+    }
 
-    delayLineL.setMaximumDelayInSamples(maxDelayInSamplesSignal);
-    delayLineR.setMaximumDelayInSamples(maxDelayInSamplesSignal);
-    delayLineL.reset();
-    delayLineR.reset();
-     
-    rectFilterL.resize(maxDelayInSamplesSignal);
-    rectFilterR.resize(maxDelayInSamplesSignal);
     rectFilterL.reset(1);
     rectFilterR.reset(1);
 
-    //get speaker model to set the coefficients
-    currentSpeakerModel = SpeakerModels::modelNames[params.speakerModel];
-    lastSpeakerModel = currentSpeakerModel;
-    const auto& model = Parameters::speakerModelData.at(currentSpeakerModel);
-    setFiltersCoeffs(model, sampleRate);
+    //the release starts again from the state of a new instance, so that nothing
+    //of a previous stream is carried over
+    cL = 0.0f;
+    cR = 0.0f;
+
+    lastCrossover = 0;
+    updateCrossover(snapshot);
+    lastMultiband = false;
+    updateMultiband(snapshot);
+    updateLatency(snapshot.fixedLatency);
+
+    //design the coefficients of every speaker model in the background,
+    //and only the current one right now
+    coefficientCache.prepare(sampleRate);
+    customSpeaker = designCustomSpeaker(getCustomModel(), sampleRate);
+    lastSpeakerModel = snapshot.speakerModel;
+
+    //the adaptation starts again from the nominal model
+    adapter.start();
+    adaptedSpeaker = ModelAdapter::getEmptySpeaker();
+    lastAdaptive = snapshot.adaptive;
+    estimatedModel = lastSpeakerModel;
+    estimator.prepare(getNominalModel(estimatedModel), sampleRate);
+
+    lastXmax = snapshot.xmax;
+    lastNonlinearPrediction = snapshot.nonlinearPrediction;
+
+    //the drivers start cold
+    thermalL.prepare(getNominalModel(lastSpeakerModel), sampleRate);
+    thermalR.prepare(getNominalModel(lastSpeakerModel), sampleRate);
+    thermalL.reset();
+    thermalR.reset();
+    updateThermalProtection(snapshot);
+
+    activeChain = 0;
+    setFiltersCoeffs(chains[0], lastSpeakerModel, sampleRate);
+
+    arrayMailbox.pull(activeArrayLayout);
+    arrayModels.fill(-1);
+    updateArrayDrivers(snapshot);
+    modelSwitch.prepare(sampleRate);
 
     levelL.reset();
     levelR.reset();
     displacementLevelL.reset();
     displacementLevelR.reset();
+    gainReductionL.reset();
+    gainReductionR.reset();
+    coilTemperatureL.reset();
+    coilTemperatureR.reset();
+    dspLoadPeak.reset();
+    dspLoadAverage.reset();
+
+   #if XMAX_PIPELINE_TIMING
+    pipelineTimes.prepare();
+   #endif
 }
 
 void XmaxLimiterAudioProcessor::releaseResources()
@@ -172,11 +581,12 @@ bool XmaxLimiterAudioProcessor::isBusesLayoutSupported (const BusesLayout& layou
     return true;
   #else
     // This is the place where you check if the layout is supported.
-    // In this template code we only support mono or stereo.
+    // Mono or stereo, or one channel per driver of an array.
     // Some plugin hosts, such as certain GarageBand versions, will only
     // load plugins that support stereo bus layouts.
-    if (layouts.getMainOutputChannelSet() != juce::AudioChannelSet::mono()
-     && layouts.getMainOutputChannelSet() != juce::AudioChannelSet::stereo())
+    auto main = layouts.getMainOutputChannelSet();
+    if (main != juce::AudioChannelSet::mono() && main != juce::AudioChannelSet::stereo()
+     && (main.size() <= 2 || main.size() > DriverArray::maxDrivers))
         return false;
 
     // This checks if the input layout matches the output layout
@@ -185,6 +595,18 @@ bool XmaxLimiterAudioProcessor::isBusesLayoutSupported (const BusesLayout& layou
         return false;
    #endif
 
+    //the sense inputs are a tension and a current, or nothing
+    auto sense = layouts.getChannelSet(true, 1);
+    if (!sense.isDisabled() && sense != juce::AudioChannelSet::stereo())
+        return false;
+
+    //the bands of the crossover are stereo, and only split a stereo main bus
+    for (int bus = 1; bus < layouts.outputBuses.size(); ++bus) {
+        auto band = layouts.getChannelSet(false, bus);
+        if (!band.isDisabled() && (band != juce::AudioChannelSet::stereo() || main != juce::AudioChannelSet::stereo()))
+            return false;
+    }
+
     return true;
   #endif
 }
@@ -192,6 +614,7 @@ bool XmaxLimiterAudioProcessor::isBusesLayoutSupported (const BusesLayout& layou
 
 void XmaxLimiterAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::MidiBuffer& /*midiMessages*/)
 {
+    auto blockStart = std::chrono::steady_clock::now();
     juce::ScopedNoDenormals noDenormals;
     auto totalNumInputChannels  = getTotalNumInputChannels();
     auto totalNumOutputChannels = getTotalNumOutputChannels();
@@ -200,33 +623,110 @@ void XmaxLimiterAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer,
         buffer.clear (i, 0, buffer.getNumSamples());
 
 
-    float maxL = 0.0f;
-    float maxR = 0.0f;
-    float maxDispL = 0.0f;
-    float maxDispR = 0.0f;
+    XMAX_STAGE_START(stageTimes);
 
-    float sampleRate = float(getSampleRate());
+    //read every parameter once, the kernel only sees this copy
+    auto snapshot = params.update();
+    XMAX_STAGE_LAP(stageTimes, parameters);
 
-    params.update();
+    //a new custom driver is switched to like another model, if it was designed for this rate
+    CustomSpeaker received = customSpeaker;
+    if (customMailbox.pull(received) && received.sampleRate == getSampleRate()) {
+        customSpeaker = received;
+        if (Parameters::isCustomModel(lastSpeakerModel))
+            lastSpeakerModel = -1;
+        if (Parameters::isCustomModel(estimatedModel))
+            estimatedModel = -1;
+        if (Parameters::isCustomModel(adaptedSpeaker.modelIndex))
+            adaptedSpeaker.modelIndex = -1;
+        arrayModels.fill(-1);
+    }
+    arrayMailbox.pull(activeArrayLayout);
+    updateArrayDrivers(snapshot);
+    updateAdaptation(snapshot, buffer);
+
+    //a model change waits for the end of the current crossfade, if any
+    if (snapshot.speakerModel != lastSpeakerModel && !modelSwitch.isActive()) {
+        startModelSwitch(snapshot.speakerModel);
+        lastSpeakerModel = snapshot.speakerModel;
+    }
+    XMAX_STAGE_LAP(stageTimes, modelSwitch);
 
-    
-    float releaseCoeff = 1 - std::exp(-2.2f / (float(sampleRate) * params.releaseTime * 0.001f));
+    if (snapshot.fixedLatency != lastFixedLatency) {
+        updateLatency(snapshot.fixedLatency);
+    }
+    XMAX_STAGE_LAP(stageTimes, latency);
 
-    currentSpeakerModel = SpeakerModels::modelNames[params.speakerModel];
-    const auto& model = Parameters::speakerModelData.at(currentSpeakerModel);
+    if (snapshot.xmax != lastXmax || snapshot.nonlinearPrediction != lastNonlinearPrediction) {
+        updatePrediction(snapshot);
+    }
 
-    if (currentSpeakerModel != lastSpeakerModel) {
-        setFiltersCoeffs(model, sampleRate);
-        lastSpeakerModel = currentSpeakerModel;
+    if (snapshot.thermalProtection != lastThermalProtection || snapshot.ratedPower != lastRatedPower
+        || snapshot.maxCoilTemperature != lastMaxCoilTemperature) {
+        updateThermalProtection(snapshot);
     }
 
-    float* channelDataL = buffer.getWritePointer(0);
-    float* channelDataR = buffer.getWritePointer(1);
+    if (snapshot.crossover != lastCrossover || snapshot.crossoverFrequency1 != lastCrossoverFrequency1
+        || snapshot.crossoverFrequency2 != lastCrossoverFrequency2 || snapshot.crossoverFrequency3 != lastCrossoverFrequency3) {
+        updateCrossover(snapshot);
+    }
 
-    for (int sample = 0; sample < buffer.getNumSamples(); ++sample) {
+    if (snapshot.multiband != lastMultiband || snapshot.splitFrequency != lastSplitFrequency) {
+        updateMultiband(snapshot);
+    }
+
+    XMAX_PIPELINE_START(pipelineTimes);
+    auto levels = numArrayDrivers > 0 ? processArray(snapshot, buffer)
+                : isCrossoverActive() ? processCrossover(snapshot, buffer)
+                : lastMultiband ? processMultiband(snapshot, buffer.getWritePointer(0), buffer.getWritePointer(1), buffer.getNumSamples())
+                                      : processSamples(snapshot, buffer.getWritePointer(0), buffer.getWritePointer(1), buffer.getNumSamples());
+    XMAX_PIPELINE_FINISH(pipelineTimes);
+
+    //the band outputs are silent without the crossover, not a copy of the sense inputs
+    if (!isCrossoverActive()) {
+        for (int band = 1; band < numCrossoverBands; ++band)
+            getBusBuffer(buffer, false, bandBuses[size_t(band)]).clear();
+    }
+    XMAX_STAGE_COUNT(stageTimes, minFilterScans, minFilterL.takeNumScanned() + minFilterR.takeNumScanned());
+    XMAX_STAGE_LAP(stageTimes, samples);
+
+    levelL.updateIfGreater(levels.maxL);
+    levelR.updateIfGreater(levels.maxR);
+
+    displacementLevelL.updateIfGreater(levels.maxDispL);
+    displacementLevelR.updateIfGreater(levels.maxDispR);
+
+    gainReductionL.updateIfGreater(-juce::Decibels::gainToDecibels(levels.minGainL));
+    gainReductionR.updateIfGreater(-juce::Decibels::gainToDecibels(levels.minGainR));
+
+    coilTemperatureL.updateIfGreater(thermalL.getCoilTemperature());
+    coilTemperatureR.updateIfGreater(thermalR.getCoilTemperature());
+    XMAX_STAGE_LAP(stageTimes, meters);
+
+    updateDspLoad(blockStart, buffer.getNumSamples());
+}
+
+// Per-sample limiter, with the parameters of this block
+XmaxLimiterAudioProcessor::BlockLevels XmaxLimiterAudioProcessor::processSamples(
+    ParameterSnapshot snapshot, float* channelDataL, float* channelDataR, int numSamples,
+    const float* highDataL, const float* highDataR) noexcept
+{
+    BlockLevels levels;
+    float sampleRate = float(getSampleRate());
+    float releaseCoeff = snapshot.releaseCoeff;
+    bool displacementMode = snapshot.limiterMode == 1;
+    bool nonlinearMode = displacementMode && snapshot.nonlinearPrediction;
+
+    for (int sample = 0; sample < numSamples; ++sample) {
         params.smoothen();
 
+        //the dry path is delayed one chunk ahead, before these samples are overwritten
+        if (snapshot.fixedLatency && sample % dryBlockSize == 0) {
+            delayDryPath(channelDataL + sample, channelDataR + sample, std::min(dryBlockSize, numSamples - sample));
+        }
+
         int nAttack = int(std::ceil(params.attackTime * 1e-3f * sampleRate));
+        int nDelay = snapshot.fixedLatency ? fixedLatencySamples : nAttack;
         int nAttackHold = int(std::ceil((params.attackTime + params.holdTime) * 1e-3f * sampleRate));
 
         minFilterL.set(nAttackHold);
@@ -242,36 +742,85 @@ void XmaxLimiterAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer,
         float inputAmpL = dryL * params.inputGain;
         float inputAmpR = dryR * params.inputGain;
 
-        
-        if (params.limiterMode == 1) { //displacement mode.
-            varL = xuFilterL.processSample(inputAmpL);
-            varR = xuFilterR.processSample(inputAmpR);
+        //the amplifier drives the coil with the speaker gain in both modes
+        thermalL.add(inputAmpL * params.speakerGain);
+        thermalR.add(inputAmpR * params.speakerGain);
+        XMAX_PIPELINE_LAP(pipelineTimes, inputGain);
 
+        if (displacementMode) {
             threshold = params.thresholdDisplacement * 1e-3f; //convert in m
             gain = params.speakerGain;
         }
         else { //level mode 
-		    varL = inputAmpL; //keep the tension signal
-		    varR = inputAmpR;
-
             threshold = params.thresholdTension;
             gain = 1.0f;
         }
 
-        
-        delayLineL.write(varL);
-        delayLineR.write(varR);
+        auto& chain = chains[size_t(activeChain)];
+        auto& nextChain = chains[size_t(1 - activeChain)];
+        bool switching = modelSwitch.isActive();
+        float fade = switching ? modelSwitch.getNextWeight() : 0.0f;
+
+        varL = inputAmpL; //keep the tension signal in level mode
+        varR = inputAmpR;
+        if (displacementMode)
+            chain.xuFilter.processSample(varL, varR);
+        XMAX_PIPELINE_LAP(pipelineTimes, xuFilter);
+
+        chain.delayLineL.write(varL);
+        chain.delayLineR.write(varR);
+
+        if (switching) {
+            XMAX_STAGE_COUNT(stageTimes, crossfadeSamples, 1);
+
+            float nextVarL = inputAmpL;
+            float nextVarR = inputAmpR;
+            if (displacementMode)
+                nextChain.xuFilter.processSample(nextVarL, nextVarR);
+
+            nextChain.delayLineL.write(nextVarL);
+            nextChain.delayLineR.write(nextVarR);
+
+            //the output plays each look-ahead sample with the weight of nDelay samples later, so
+            //the gain computer sees the larger of both displacements for the whole switch
+            varL = std::max(std::abs(varL), std::abs(nextVarL));
+            varR = std::max(std::abs(varR), std::abs(nextVarR));
+        }
+        XMAX_PIPELINE_LAP(pipelineTimes, delay);
+
+        //the gain computer sees the excursion of the nonlinear driver, the delay line keeps
+        //the linear displacement, which the U/X filter turns back into the tension
+        float sideL = varL * gain;
+        float sideR = varR * gain;
+        if (nonlinearMode) {
+            sideL = inputAmpL * gain;
+            sideR = inputAmpR * gain;
+            chain.predictor.processSample(sideL, sideR);
+
+            if (switching) {
+                float nextSideL = inputAmpL * gain;
+                float nextSideR = inputAmpR * gain;
+                nextChain.predictor.processSample(nextSideL, nextSideR);
+
+                sideL = std::max(std::abs(sideL), std::abs(nextSideL));
+                sideR = std::max(std::abs(sideR), std::abs(nextSideR));
+            }
+        }
+        XMAX_PIPELINE_LAP(pipelineTimes, xuFilter);
 
         knee = params.knee;
         
-        gcL = computeGain(std::abs(varL) * gain, threshold, knee);
-        gcR = computeGain(std::abs(varR) * gain, threshold, knee);
-        
-        //store the gain computer function  output in the circular buffers for the minimum filter
-        minFilterL.add(gcL);
-        minFilterR.add(gcR);
+        gcL = computeGain(std::abs(sideL), threshold, knee);
+        gcR = computeGain(std::abs(sideR), threshold, knee);
+        XMAX_PIPELINE_LAP(pipelineTimes, gainComputer);
+
+        //store the gain computer function  output in the circular buffers for the minimum filter,
+        //with the slower gain of the thermal protection
+        minFilterL.add(std::min(gcL, thermalL.getGain()));
+        minFilterR.add(std::min(gcR, thermalR.getGain()));
         float minGainL = minFilterL.getMinimum();
         float minGainR = minFilterR.getMinimum();
+        XMAX_PIPELINE_LAP(pipelineTimes, minFilter);
 
         //apply exponential release to the minimum filter output
         cL = std::min(minGainL, (1.0f - releaseCoeff) * cL + releaseCoeff * minGainL);
@@ -282,29 +831,82 @@ void XmaxLimiterAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer,
         // To prevent this:
         if (cL > 0.999f) cL = 1.0f;
         if (cR > 0.999f) cR = 1.0f;
+        XMAX_PIPELINE_LAP(pipelineTimes, release);
 
         //Apply the averaging filter to the minimum filter output.
         gL = rectFilterL(cL);
         gR = rectFilterR(cR);
+        XMAX_PIPELINE_LAP(pipelineTimes, boxFilter);
+
+        //pad the gain envelope so that it stays aligned with the fixed look-ahead
+        if (snapshot.fixedLatency) {
+            gainDelayLineL.write(gL);
+            gainDelayLineR.write(gR);
+            int nPadding = std::max(0, fixedLatencySamples - nAttack);
+            gL = gainDelayLineL.read(nPadding);
+            gR = gainDelayLineR.read(nPadding);
+        }
+        levels.minGainL = std::min(levels.minGainL, gL);
+        levels.minGainR = std::min(levels.minGainR, gR);
 
-        float limL = gL * delayLineL.read(nAttack);
-        float limR = gR * delayLineR.read(nAttack);
-        
-        //convert the displacement signal back to a tension signal if in displacement mode
+        float limL = gL * chain.delayLineL.read(nDelay);
+        float limR = gR * chain.delayLineR.read(nDelay);
+        XMAX_PIPELINE_LAP(pipelineTimes, delay);
 
-        if (params.limiterMode == 1) {
+        //convert the displacement signal back to a tension signal if in displacement mode
 
-            maxDispL = std::max(maxDispL, std::abs(limL * params.speakerGain * 1e3f));
-            maxDispR = std::max(maxDispR, std::abs(limR * params.speakerGain * 1e3f));
+        wetL = limL;
+        wetR = limR;
+        if (displacementMode)
+            chain.uxFilter.processSample(wetL, wetR);
+
+        if (switching) {
+            float nextLimL = gL * nextChain.delayLineL.read(nDelay);
+            float nextLimR = gR * nextChain.delayLineR.read(nDelay);
+
+            float nextWetL = nextLimL;
+            float nextWetR = nextLimR;
+            if (displacementMode)
+                nextChain.uxFilter.processSample(nextWetL, nextWetR);
+
+            limL += fade * (nextLimL - limL);
+            limR += fade * (nextLimR - limR);
+            wetL += fade * (nextWetL - wetL);
+            wetR += fade * (nextWetR - wetR);
+
+            //the new chain is fully faded in, retire the old one
+            if (modelSwitch.isFinished()) {
+                activeChain = 1 - activeChain;
+                modelSwitch.reset();
+            }
+        }
+        XMAX_PIPELINE_LAP(pipelineTimes, uxFilter);
 
-			wetL = uxFilterL.processSample(limL);
-			wetR = uxFilterR.processSample(limR);
-		}
-        else {
-            wetL = limL;
-			wetR = limR;
+        if (displacementMode) {
+            levels.maxDispL = std::max(levels.maxDispL, std::abs(limL * params.speakerGain * 1e3f));
+            levels.maxDispR = std::max(levels.maxDispR, std::abs(limR * params.speakerGain * 1e3f));
         }
         
+        //keep the dry signal aligned with the wet one
+        if (snapshot.fixedLatency) {
+            dryL = dryBufferL[size_t(sample % dryBlockSize)];
+            dryR = dryBufferR[size_t(sample % dryBlockSize)];
+        }
+
+        //the high band of the multiband mode, with the look-ahead of this sample on the wet path
+        //and the dry path of the low band, so that both bands still sum to an allpass
+        if (highDataL != nullptr) {
+            highDelayLineL.write(highDataL[sample]);
+            highDelayLineR.write(highDataR[sample]);
+            float highL = highDelayLineL.read(nDelay);
+            float highR = highDelayLineR.read(nDelay);
+
+            wetL += highL * params.inputGain;
+            wetR += highR * params.inputGain;
+            dryL += snapshot.fixedLatency ? highL : highDataL[sample];
+            dryR += snapshot.fixedLatency ? highR : highDataR[sample];
+        }
+
         // output processing - not part of the limiter
         float mixL = params.mix * wetL + (1.0f - params.mix) * dryL;
         float mixR = params.mix * wetR + (1.0f - params.mix) * dryR;
@@ -316,17 +918,127 @@ void XmaxLimiterAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer,
         channelDataL[sample] = outL;
         channelDataR[sample] = outR;
 
-        maxL = std::max(maxL, std::abs(outL));
-        maxR = std::max(maxR, std::abs(outR));
+        levels.maxL = std::max(levels.maxL, std::abs(outL));
+        levels.maxR = std::max(levels.maxR, std::abs(outR));
+        XMAX_PIPELINE_LAP(pipelineTimes, output);
     }
 
-    levelL.updateIfGreater(maxL);
-    levelR.updateIfGreater(maxR);
+    return levels;
+}
 
-    displacementLevelL.updateIfGreater(maxDispL);
-    displacementLevelR.updateIfGreater(maxDispR);
+// Multiband mode, one chunk of at most dryBlockSize samples at a time: the chunk is split in
+// place, and processSamples limits the low band and adds the high band back, delayed and mixed
+// like the low one sample by sample. The bands are Linkwitz-Riley, so they sum to an allpass
+// where the limiter does nothing. The thermal protection only sees the low band, which carries
+// most of the power.
+XmaxLimiterAudioProcessor::BlockLevels XmaxLimiterAudioProcessor::processMultiband(
+    ParameterSnapshot snapshot, float* channelDataL, float* channelDataR, int numSamples) noexcept
+{
+    BlockLevels levels;
+    alignas(32) std::array<float, Crossover::numLanes> frame{};
+
+    for (int start = 0; start < numSamples; start += dryBlockSize) {
+        int chunkSize = std::min(dryBlockSize, numSamples - start);
+        float* lowL = channelDataL + start;
+        float* lowR = channelDataR + start;
+
+        for (int i = 0; i < chunkSize; ++i) {
+            bandSplit.processSample(lowL[i], lowR[i], frame.data());
+            lowL[i] = frame[0];
+            lowR[i] = frame[1];
+            highBufferL[i] = frame[2];
+            highBufferR[i] = frame[3];
+        }
 
+        auto chunkLevels = processSamples(snapshot, lowL, lowR, chunkSize, highBufferL, highBufferR);
+        levels.maxL = std::max(levels.maxL, chunkLevels.maxL);
+        levels.maxR = std::max(levels.maxR, chunkLevels.maxR);
+        levels.maxDispL = std::max(levels.maxDispL, chunkLevels.maxDispL);
+        levels.maxDispR = std::max(levels.maxDispR, chunkLevels.maxDispR);
+        levels.minGainL = std::min(levels.minGainL, chunkLevels.minGainL);
+        levels.minGainR = std::min(levels.minGainR, chunkLevels.minGainR);
+    }
 
+    return levels;
+}
+
+// Array mode: every channel of the main bus limited for its own driver, in displacement,
+// with the minimum latency. The meters show the loudest channel on both sides.
+XmaxLimiterAudioProcessor::BlockLevels XmaxLimiterAudioProcessor::processArray(ParameterSnapshot snapshot, juce::AudioBuffer<float>& buffer) noexcept
+{
+    float sampleRate = float(getSampleRate());
+    float* const* channels = buffer.getArrayOfWritePointers();
+    std::array<float, DriverArray::maxDrivers> frame{};
+    DriverArray::Levels arrayLevels;
+
+    for (int sample = 0; sample < buffer.getNumSamples(); ++sample) {
+        params.smoothen();
+        auto envelope = getArrayEnvelope(snapshot, sampleRate);
+
+        for (int i = 0; i < numArrayDrivers; ++i)
+            frame[size_t(i)] = channels[i][sample];
+        driverArray.processFrame(frame.data(), envelope, arrayLevels);
+        for (int i = 0; i < numArrayDrivers; ++i)
+            channels[i][sample] = frame[size_t(i)];
+    }
+
+    BlockLevels levels;
+    levels.maxL = levels.maxR = arrayLevels.maxLevel;
+    levels.maxDispL = levels.maxDispR = arrayLevels.maxDisplacement;
+    levels.minGainL = levels.minGainR = arrayLevels.minGain;
+    return levels;
+}
+
+// Crossover mode: the stereo input split in bands, the first one on the main bus and the
+// others on the band outputs, each channel of each band limited for its own driver by the
+// driver array, in one pass. The meters show the loudest band.
+XmaxLimiterAudioProcessor::BlockLevels XmaxLimiterAudioProcessor::processCrossover(ParameterSnapshot snapshot, juce::AudioBuffer<float>& buffer) noexcept
+{
+    float sampleRate = float(getSampleRate());
+    const float* inputL = buffer.getReadPointer(0);
+    const float* inputR = buffer.getReadPointer(1);
+    std::array<float*, Crossover::numLanes> outputs{};
+    for (int band = 0; band < numCrossoverBands; ++band) {
+        auto bus = getBusBuffer(buffer, false, bandBuses[size_t(band)]);
+        outputs[size_t(2 * band)] = bus.getWritePointer(0);
+        outputs[size_t(2 * band + 1)] = bus.getWritePointer(1);
+    }
+
+    alignas(32) std::array<float, Crossover::numLanes> frame{};
+    DriverArray::Levels arrayLevels;
+
+    for (int sample = 0; sample < buffer.getNumSamples(); ++sample) {
+        params.smoothen();
+        auto envelope = getArrayEnvelope(snapshot, sampleRate);
+
+        //the input is read before band 0 overwrites it
+        crossover.processSample(inputL[sample], inputR[sample], frame.data());
+        driverArray.processFrame(frame.data(), envelope, arrayLevels);
+        for (int i = 0; i < 2 * numCrossoverBands; ++i)
+            outputs[size_t(i)][sample] = frame[size_t(i)];
+    }
+
+    BlockLevels levels;
+    levels.maxL = levels.maxR = arrayLevels.maxLevel;
+    levels.maxDispL = levels.maxDispR = arrayLevels.maxDisplacement;
+    levels.minGainL = levels.minGainR = arrayLevels.minGain;
+    return levels;
+}
+
+// The smoothed parameters of this sample, shared by the drivers of the array
+DriverArray::Envelope XmaxLimiterAudioProcessor::getArrayEnvelope(ParameterSnapshot snapshot, float sampleRate) const noexcept
+{
+    DriverArray::Envelope envelope;
+    envelope.nAttack = int(std::ceil(params.attackTime * 1e-3f * sampleRate));
+    envelope.nAttackHold = int(std::ceil((params.attackTime + params.holdTime) * 1e-3f * sampleRate));
+    envelope.releaseCoeff = snapshot.releaseCoeff;
+    envelope.knee = params.knee;
+    envelope.threshold = params.thresholdDisplacement * 1e-3f; //convert in m
+    envelope.speakerGain = params.speakerGain;
+    envelope.inputGain = params.inputGain;
+    envelope.mix = params.mix;
+    envelope.gain = params.gain;
+    return envelope;
 }
 
 //==============================================================================
@@ -343,7 +1055,41 @@ juce::AudioProcessorEditor* XmaxLimiterAudioProcessor::createEditor()
 //==============================================================================
 void XmaxLimiterAudioProcessor::getStateInformation (juce::MemoryBlock& destData)
 {
-    copyXmlToBinary(*apvts.state.createXml(), destData);
+    //the index of a driver of the user database changes when drivers are added, so its name is saved too
+    auto state = apvts.copyState();
+    state.setProperty(speakerModelNameID, params.speakerModelParam->getCurrentChoiceName(), nullptr);
+
+    auto model = getCustomModel();
+    auto driver = state.getOrCreateChildWithName(customDriverID, nullptr);
+    driver.setProperty("fs", model.fs, nullptr);
+    driver.setProperty("Rec", model.Rec, nullptr);
+    driver.setProperty("Lec", model.Lec, nullptr);
+    driver.setProperty("Qms", model.Qms, nullptr);
+    driver.setProperty("Qes", model.Qes, nullptr);
+    driver.setProperty("Mms", model.Mms, nullptr);
+    driver.setProperty("Cms", model.Cms, nullptr);
+    driver.setProperty("Bl", model.Bl, nullptr);
+    driver.setProperty("Sd", model.Sd, nullptr);
+
+    //the drivers of the array by name as well, only the channels which do not follow the parameters
+    auto array = state.getOrCreateChildWithName(driverArrayID, nullptr);
+    array.removeAllChildren(nullptr);
+    auto layout = getArrayLayout();
+    auto modelNames = params.speakerModelParam->choices;
+    for (int i = 0; i < DriverArray::maxDrivers; ++i) {
+        const auto& channel = layout[size_t(i)];
+        if (channel.speakerModel < 0 && channel.thresholdDisplacement < 0.0f && channel.speakerGain < 0.0f)
+            continue;
+
+        juce::ValueTree entry("Channel");
+        entry.setProperty("index", i, nullptr);
+        if (channel.speakerModel >= 0)
+            entry.setProperty("model", modelNames[channel.speakerModel], nullptr);
+        entry.setProperty("threshold", channel.thresholdDisplacement, nullptr);
+        entry.setProperty("speakerGain", channel.speakerGain, nullptr);
+        array.appendChild(entry, nullptr);
+    }
+    copyXmlToBinary(*state.createXml(), destData);
 }
 
 void XmaxLimiterAudioProcessor::setStateInformation (const void* data, int sizeInBytes)
@@ -352,6 +1098,34 @@ void XmaxLimiterAudioProcessor::setStateInformation (const void* data, int sizeI
     if (xml.get() != nullptr && xml->hasTagName(apvts.state.getType()))
     {
 		apvts.replaceState(juce::ValueTree::fromXml(*xml));
+
+        auto driver = apvts.state.getChildWithName(customDriverID);
+        if (driver.isValid() && float(driver["fs"]) > 0.0f) {
+            setCustomModel(makeLoudspeakerModel(driver["fs"], driver["Rec"], driver["Lec"], driver["Qms"], driver["Qes"],
+                                                driver["Mms"], driver["Cms"], driver["Bl"], driver["Sd"]));
+        }
+
+        int modelIndex = params.speakerModelParam->choices.indexOf(apvts.state.getProperty(speakerModelNameID).toString());
+        if (modelIndex >= 0)
+            *params.speakerModelParam = modelIndex;
+
+        //a driver of the array which is not in the speaker list anymore follows the parameter
+        auto array = apvts.state.getChildWithName(driverArrayID);
+        if (array.isValid()) {
+            ArrayLayout layout;
+            for (int i = 0; i < array.getNumChildren(); ++i) {
+                auto entry = array.getChild(i);
+                int index = entry["index"];
+                if (index < 0 || index >= DriverArray::maxDrivers)
+                    continue;
+
+                auto& channel = layout[size_t(index)];
+                channel.speakerModel = entry.hasProperty("model") ? params.speakerModelParam->choices.indexOf(entry["model"].toString()) : -1;
+                channel.thresholdDisplacement = entry["threshold"];
+                channel.speakerGain = entry["speakerGain"];
+            }
+            setArrayLayout(layout);
+        }
 	}
 }
 
@@ -9,13 +9,26 @@
 #pragma once
 
 #include <JuceHeader.h>
+#include <mutex>
 #include "Parameters.h"
+#include "DspArena.h"
 #include "DelayLine.h"
 #include "BoxFilter.h"
 #include "MinFilter.h"
 #include "BiquadFilter.h"
+#include "SosFilter.h"
+#include "NonlinearPredictor.h"
+#include "ThermalModel.h"
+#include "DriverArray.h"
+#include "Crossover.h"
 #include "FilterDesign.h"
+#include "CoefficientCache.h"
+#include "Mailbox.h"
+#include "ParameterEstimator.h"
+#include "ModelAdapter.h"
+#include "ModelCrossfade.h"
 #include "Measurement.h"
+#include "StageTimer.h"
 #include "LimiterUtils.h"
 
 //==============================================================================
@@ -70,19 +83,175 @@ public:
 
     Measurement levelL, levelR;
     Measurement displacementLevelL, displacementLevelR;
+    Measurement gainReductionL, gainReductionR; // dB
+    Measurement coilTemperatureL, coilTemperatureR; // degrees Celsius, estimated by the thermal protection
+
+    // Time spent in processBlock over the duration of the block (1 is the real-time deadline)
+    Measurement dspLoadPeak;
+    AverageMeasurement dspLoadAverage;
+
+    StageTimes stageTimes; // filled by processBlock when built with XMAX_STAGE_TIMING
+
+   #if XMAX_PIPELINE_TIMING
+    PipelineTimes pipelineTimes; // time of each stage of the sample loop, shown by PipelineOverlay
+   #endif
+
+    // Driver of the custom speaker model, entered in the editor. Its coefficients are designed
+    // here, on the message thread, and handed to the audio thread through a mailbox.
+    void setCustomModel(const LoudspeakerModel& model);
+    LoudspeakerModel getCustomModel() const;
+
+    // Driver estimated from the sense inputs in adaptive mode, if one was tracked for the
+    // current speaker model. Any thread but the audio one.
+    bool getAdaptedModel(LoudspeakerModel& model) const;
+
+    // Driver of one channel in array mode, when the main bus has more than two channels.
+    // The fields left negative follow the parameters of the plugin.
+    struct ArrayChannel
+    {
+        int speakerModel = -1;
+        float thresholdDisplacement = -1.0f; // mm
+        float speakerGain = -1.0f;           // dB
+    };
+    using ArrayLayout = std::array<ArrayChannel, DriverArray::maxDrivers>;
+
+    // Drivers of the array, switched to at the next block. Message thread only.
+    void setArrayLayout(const ArrayLayout& layout);
+    ArrayLayout getArrayLayout() const;
+
+    // Reads the drivers of the array from a JSON array with one object per channel, in order:
+    // { "model": name in the speaker list, "threshold": mm, "speakerGain": dB }, each optional
+    static juce::Result loadArrayLayout(const juce::File& file, ArrayLayout& layout);
+
+    // Array.json in the Xmax folder of the user application data, read by the constructor
+    static juce::File getDefaultArrayFile();
+
+    // Memory used by this instance, including all of its DSP state, in bytes
+    size_t getMemoryFootprint() const noexcept;
+
+    static constexpr int maxDryBlockSize = 2048; // longer blocks are delayed in several chunks
+
+    // Peak levels of one processed block, for the meters
+    struct BlockLevels
+    {
+        float maxL = 0.0f;
+        float maxR = 0.0f;
+        float maxDispL = 0.0f; // mm
+        float maxDispR = 0.0f;
+        float minGainL = 1.0f; // lowest gain of the envelope
+        float minGainR = 1.0f;
+    };
+
+    // Processes numSamples stereo samples in place, with the parameters read for this block.
+    // The high band of the multiband mode, if any, is added back unlimited with the same delay and mix.
+    BlockLevels processSamples(ParameterSnapshot snapshot, float* channelDataL, float* channelDataR, int numSamples,
+                               const float* highDataL = nullptr, const float* highDataR = nullptr) noexcept;
+
+    // Same, with only the band below the split frequency limited
+    BlockLevels processMultiband(ParameterSnapshot snapshot, float* channelDataL, float* channelDataR, int numSamples) noexcept;
 
 private:
-    void setFiltersCoeffs(const LoudspeakerModel& model, float sampleRate);
+    static size_t getArenaSize(double sampleRate, int numDrivers);
+
+    // Everything that depends on the speaker model. Two chains are allocated in
+    // prepareToPlay, so that a new model can be faded in next to the current one.
+    struct SpeakerChain
+    {
+        DelayLine delayLineL, delayLineR;
+        SosCascade<float> xuFilter; // tension to displacement, both channels
+        SosCascade<float> uxFilter; // displacement to tensions
+        NonlinearPredictor<float> predictor; // tension to displacement of the nonlinear driver, for the gain computer
+    };
+
+    // The custom driver with its coefficients for one sample rate
+    struct CustomSpeaker
+    {
+        LoudspeakerModel model;
+        SpeakerCoefficients coeffs;
+        double sampleRate;
+    };
+
+    static CustomSpeaker designCustomSpeaker(const LoudspeakerModel& model, double sampleRate);
+
+    LoudspeakerModel getNominalModel(int modelIndex) const noexcept;
+    SpeakerCoefficients getSpeakerCoefficients(int modelIndex, double sampleRate) noexcept;
+    void setFiltersCoeffs(SpeakerChain& chain, const SpeakerCoefficients& coeffs);
+    void setFiltersCoeffs(SpeakerChain& chain, int modelIndex, double sampleRate);
+    void startModelSwitch(int modelIndex);
+    void updateLatency(bool fixedLatency);
+    void updatePrediction(ParameterSnapshot snapshot) noexcept;
+    void updateThermalProtection(ParameterSnapshot snapshot) noexcept;
+    void updateArrayDrivers(ParameterSnapshot snapshot) noexcept;
+    BlockLevels processArray(ParameterSnapshot snapshot, juce::AudioBuffer<float>& buffer) noexcept;
+    void updateCrossover(ParameterSnapshot snapshot) noexcept;
+    BlockLevels processCrossover(ParameterSnapshot snapshot, juce::AudioBuffer<float>& buffer) noexcept;
+    DriverArray::Envelope getArrayEnvelope(ParameterSnapshot snapshot, float sampleRate) const noexcept;
+    bool isCrossoverActive() const noexcept { return numArrayDrivers == 0 && numCrossoverBands > 1 && lastCrossover > 0; }
+    void updateMultiband(ParameterSnapshot snapshot) noexcept;
+    void updateDspLoad(std::chrono::steady_clock::time_point blockStart, int numSamples) noexcept;
+    void delayDryPath(const float* inputL, const float* inputR, int numSamples);
+    void updateAdaptation(ParameterSnapshot snapshot, juce::AudioBuffer<float>& buffer) noexcept;
+
+    CoefficientCache coefficientCache;
+
+    mutable std::mutex customModelLock; // message thread and state only, never taken by the audio thread
+    LoudspeakerModel customModel;
+    Mailbox<CustomSpeaker> customMailbox;
+    CustomSpeaker customSpeaker; // audio thread copy, used by setFiltersCoeffs
+
+    // Adaptive mode: the estimator runs on the audio thread, the adapter designs its models
+    ParameterEstimator estimator;
+    ModelAdapter adapter;
+    AdaptedSpeaker adaptedSpeaker; // audio thread copy, used by setFiltersCoeffs
+    int estimatedModel = -1;       // the model the estimator was started from
+    bool lastAdaptive = false;
+
+    // Array mode: one driver per channel of the main bus, with the filters of 8 drivers in
+    // the lanes of one cascade. The stereo limiter below is left idle.
+    mutable std::mutex arrayLayoutLock; // message thread and state only
+    ArrayLayout arrayLayout;
+    Mailbox<ArrayLayout> arrayMailbox;
+    ArrayLayout activeArrayLayout; // audio thread copy
+    DriverArray driverArray;
+    std::array<int, DriverArray::maxDrivers> arrayModels; // model of the filters of each driver, -1 to design them again
+    int numArrayDrivers = 0;
+
+    // Crossover mode: the stereo input split in bands, the first on the main bus and the
+    // others on the band outputs, whose channels are the drivers of the array above
+    Crossover crossover;
+    int numCrossoverBands = 0; // 0 without any band output
+    std::array<int, Crossover::maxWays> bandBuses{}; // output bus of each band, 0 for the main bus
+
+    DspArena arena; // holds the buffers of every filter and delay line below
+
+    std::array<SpeakerChain, 2> chains;
+    int activeChain = 0;
+    ModelCrossfade modelSwitch;
 
-    DelayLine delayLineL, delayLineR;
     BoxFilter<float> rectFilterL{0};
     BoxFilter<float> rectFilterR{0};
     MinFilter<float> minFilterL{0};
     MinFilter<float> minFilterR{0};
-    BiquadFilterDF1<float> xuFilterL; // tension to displacement
-    BiquadFilterDF1<float> xuFilterR;
-    BiquadFilterDF1<float> uxFilterL; // displacement to tensions
-    BiquadFilterDF1<float> uxFilterR;
+
+    // Voice coil temperatures, from the tension before the limiter, at a decimated rate
+    ThermalModel thermalL, thermalR;
+
+    // Fixed latency mode: the look-ahead is always fixedLatencySamples long, the gain
+    // envelope is padded to stay aligned with it, and the dry path is delayed to match
+    DelayLine gainDelayLineL, gainDelayLineR;
+    DelayLine dryDelayLineL, dryDelayLineR;
+    float* dryBufferL = nullptr;
+    float* dryBufferR = nullptr;
+    int dryBlockSize = 1;
+
+    // Multiband mode: the main bus split in two bands by chunks of the dry path, the limiter
+    // above on the low one only, and the high one delayed like it and added back in its mix
+    Crossover bandSplit;
+    DelayLine highDelayLineL, highDelayLineR;
+    float* highBufferL = nullptr;
+    float* highBufferR = nullptr;
+    int fixedLatencySamples = 0;
+    bool lastFixedLatency = false;
 
     float varL=0.0f;
     float varR=0.0f;
@@ -101,8 +270,22 @@ private:
     float knee = 0.0f;
     float gain = 1.0f;
 
-    juce::String currentSpeakerModel;
-    juce::String lastSpeakerModel;
+    int lastSpeakerModel = -1;
+
+    bool lastNonlinearPrediction = false;
+    float lastXmax = 0.0f;
+
+    bool lastThermalProtection = false;
+    float lastRatedPower = 0.0f;
+    float lastMaxCoilTemperature = 0.0f;
+
+    int lastCrossover = 0;
+    float lastCrossoverFrequency1 = 0.0f;
+    float lastCrossoverFrequency2 = 0.0f;
+    float lastCrossoverFrequency3 = 0.0f;
+
+    bool lastMultiband = false;
+    float lastSplitFrequency = 0.0f;
 
     //==============================================================================
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(XmaxLimiterAudioProcessor)
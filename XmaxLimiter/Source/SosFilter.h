@@ -0,0 +1,431 @@
+/*
+  ==============================================================================
+
+    SosFilter.h
+    Created: 19 Oct 2026 1:12:45pm
+    Author:  eliot
+
+    Filters of any order up to maxOrder, as cascades of second-order sections.
+    The analog transfer function is factored into its poles and zeros, each
+    one is mapped by the bilinear transform, and they are paired into biquads:
+    a direct form of high order would not survive the rounding of float
+    coefficients at low frequencies. The zeros outside the unit circle are
+    mirrored inside, as getXUFilterCoefficients does for the 2nd order, so
+    that the inverse cascade is stable too.
+
+    The design runs without any allocation, so it can be done on the audio
+    thread when the coefficient cache is not ready yet.
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <array>
+#include <complex>
+#include <cmath>
+#include <algorithm>
+
+namespace Sos
+{
+    constexpr int maxOrder = 8;
+    constexpr int maxSections = maxOrder / 2;
+    constexpr double twoPi = 6.283185307179586;
+}
+
+// Analog transfer function b(s) / a(s), highest power first as in FilterDesign.h. Both have
+// order + 1 coefficients, b starting with zeros if it is of a lower order.
+struct AnalogTransferFunction {
+    std::array<double, Sos::maxOrder + 1> b{};
+    std::array<double, Sos::maxOrder + 1> a{};
+    int order = 0;
+    double matchFrequency = 0.0; // Hz, where the digital gain is matched to the analog one (0 for DC)
+};
+
+// Product of two transfer functions, to build a model from simpler ones
+inline AnalogTransferFunction multiply(const AnalogTransferFunction& h1, const AnalogTransferFunction& h2) {
+    AnalogTransferFunction h;
+    h.order = std::min(h1.order + h2.order, Sos::maxOrder);
+    h.matchFrequency = h1.matchFrequency;
+
+    for (int i = 0; i <= h1.order; ++i) {
+        for (int j = 0; j <= h2.order; ++j) {
+            if (i + j <= h.order) {
+                h.b[size_t(i + j)] += h1.b[size_t(i)] * h2.b[size_t(j)];
+                h.a[size_t(i + j)] += h1.a[size_t(i)] * h2.a[size_t(j)];
+            }
+        }
+    }
+    return h;
+}
+
+// One biquad, with a0 = 1
+struct SosSection {
+    float b0 = 1.0f, b1 = 0.0f, b2 = 0.0f;
+    float a1 = 0.0f, a2 = 0.0f;
+};
+
+struct SosCoefficients {
+    std::array<SosSection, Sos::maxSections> sections;
+    int numSections = 0;
+};
+
+namespace Sos
+{
+    // Roots of a polynomial of the given order, highest power first (Durand-Kerner). The leading
+    // zero coefficients lower the order, the trailing ones are roots at 0. Returns the number of roots.
+    inline int findRoots(const double* coeffs, int order, std::complex<double>* roots) {
+        int first = 0;
+        while (first < order && coeffs[first] == 0.0)
+            ++first;
+
+        int last = order;
+        int numRoots = 0;
+        while (last > first && coeffs[last] == 0.0) {
+            roots[numRoots++] = 0.0;
+            --last;
+        }
+
+        int degree = last - first;
+        if (degree <= 0)
+            return numRoots;
+
+        //in units of the geometric mean of the roots, so that the coefficients are close to 1
+        double scale = std::pow(std::abs(coeffs[last] / coeffs[first]), 1.0 / degree);
+        std::array<double, maxOrder + 1> monic{};
+        double power = 1.0;
+        for (int k = 0; k <= degree; ++k) {
+            monic[size_t(k)] = coeffs[first + k] / (coeffs[first] * power);
+            power *= scale;
+        }
+
+        auto evaluate = [&monic, degree](std::complex<double> x) {
+            std::complex<double> y = 1.0;
+            for (int k = 1; k <= degree; ++k)
+                y = y * x + monic[size_t(k)];
+            return y;
+        };
+
+        std::array<std::complex<double>, maxOrder> r;
+        const std::complex<double> seed(0.4, 0.9);
+        r[0] = seed;
+        for (int k = 1; k < degree; ++k)
+            r[size_t(k)] = r[size_t(k - 1)] * seed;
+
+        for (int iteration = 0; iteration < 500; ++iteration) {
+            double maxStep = 0.0;
+            for (int k = 0; k < degree; ++k) {
+                std::complex<double> denominator = 1.0;
+                for (int j = 0; j < degree; ++j) {
+                    if (j != k)
+                        denominator *= r[size_t(k)] - r[size_t(j)];
+                }
+                auto step = evaluate(r[size_t(k)]) / denominator;
+                r[size_t(k)] -= step;
+                maxStep = std::max(maxStep, std::abs(step));
+            }
+            if (maxStep < 1e-14)
+                break;
+        }
+
+        for (int k = 0; k < degree; ++k)
+            roots[numRoots++] = r[size_t(k)] * scale;
+        return numRoots;
+    }
+
+    // Two conjugate or real roots of one section, or a single real one
+    struct RootPair {
+        std::complex<double> first, second;
+        bool single = false;
+
+        double getRadius() const { return single ? std::abs(first) : std::max(std::abs(first), std::abs(second)); }
+    };
+
+    // Groups roots which are conjugate up to rounding into pairs: the complex ones with their exact
+    // conjugate, the real ones two by two from the unit circle inwards, with one left if they are odd
+    inline int pairRoots(const std::complex<double>* roots, int numRoots, RootPair* pairs) {
+        std::array<double, maxOrder> reals;
+        int numReals = 0;
+        int numPairs = 0;
+
+        for (int i = 0; i < numRoots; ++i) {
+            auto root = roots[i];
+            if (std::abs(root.imag()) <= 1e-9 * std::max(1.0, std::abs(root)))
+                reals[size_t(numReals++)] = root.real();
+            else if (root.imag() > 0.0)
+                pairs[numPairs++] = { root, std::conj(root), false };
+        }
+
+        std::sort(reals.begin(), reals.begin() + numReals, [](double x, double y) { return std::abs(x) > std::abs(y); });
+        for (int i = 0; i + 1 < numReals; i += 2)
+            pairs[numPairs++] = { reals[size_t(i)], reals[size_t(i + 1)], false };
+        if (numReals % 2 == 1)
+            pairs[numPairs++] = { reals[size_t(numReals - 1)], 0.0, true };
+
+        return numPairs;
+    }
+
+    inline std::complex<double> evaluatePolynomial(const double* coeffs, int order, std::complex<double> x) {
+        std::complex<double> y = 0.0;
+        for (int k = 0; k <= order; ++k)
+            y = y * x + coeffs[k];
+        return y;
+    }
+
+    inline std::complex<double> evaluateSections(const SosCoefficients& sos, std::complex<double> z) {
+        std::complex<double> h = 1.0;
+        auto zi = 1.0 / z;
+        for (int i = 0; i < sos.numSections; ++i) {
+            const auto& s = sos.sections[size_t(i)];
+            h *= (double(s.b0) + zi * (double(s.b1) + zi * double(s.b2))) / (1.0 + zi * (double(s.a1) + zi * double(s.a2)));
+        }
+        return h;
+    }
+}
+
+// Digital cascade of an analog transfer function, with the bilinear transform at Fs. The zeros
+// on or outside the unit circle (the zeros at infinity land on Nyquist) are moved to
+// (1 - alpha) / conj(zero), and the gain is matched to the analog one at matchFrequency,
+// to compensate what the moved zeros added. The sections are sorted from the least
+// resonant poles to the most, each with the zeros nearest to its poles.
+inline SosCoefficients designSections(const AnalogTransferFunction& h, double Fs, double alpha) {
+    std::array<std::complex<double>, Sos::maxOrder> poles, zeros;
+    int numPoles = Sos::findRoots(h.a.data(), h.order, poles.data());
+    int numZeros = Sos::findRoots(h.b.data(), h.order, zeros.data());
+
+    auto bilinear = [Fs](std::complex<double> s) { return (2.0 * Fs + s) / (2.0 * Fs - s); };
+    for (int i = 0; i < numPoles; ++i)
+        poles[size_t(i)] = bilinear(poles[size_t(i)]);
+    for (int i = 0; i < numZeros; ++i)
+        zeros[size_t(i)] = bilinear(zeros[size_t(i)]);
+    while (numZeros < numPoles)
+        zeros[size_t(numZeros++)] = -1.0;
+
+    //stabilization of the future inverse filter, whose poles are these zeros
+    for (int i = 0; i < numZeros; ++i) {
+        if (std::abs(zeros[size_t(i)]) >= 1.0)
+            zeros[size_t(i)] = (1.0 - alpha) / std::conj(zeros[size_t(i)]);
+    }
+
+    std::array<Sos::RootPair, Sos::maxOrder> polePairs, zeroPairs;
+    int numPolePairs = Sos::pairRoots(poles.data(), numPoles, polePairs.data());
+    int numZeroPairs = Sos::pairRoots(zeros.data(), numZeros, zeroPairs.data());
+
+    //the most resonant poles choose their zeros first
+    std::sort(polePairs.begin(), polePairs.begin() + numPolePairs,
+              [](const Sos::RootPair& p1, const Sos::RootPair& p2) { return p1.getRadius() > p2.getRadius(); });
+
+    SosCoefficients sos;
+    sos.numSections = numPolePairs;
+    std::array<bool, Sos::maxOrder> used{};
+
+    for (int i = 0; i < numPolePairs; ++i) {
+        const auto& p = polePairs[size_t(i)];
+
+        int nearest = -1;
+        for (int j = 0; j < numZeroPairs; ++j) {
+            if (used[size_t(j)] || zeroPairs[size_t(j)].single != p.single)
+                continue;
+            if (nearest < 0 || std::abs(zeroPairs[size_t(j)].first - p.first) < std::abs(zeroPairs[size_t(nearest)].first - p.first))
+                nearest = j;
+        }
+        used[size_t(nearest)] = true;
+        const auto& z = zeroPairs[size_t(nearest)];
+
+        //stored from the last section, so that the most resonant one comes last
+        auto& section = sos.sections[size_t(numPolePairs - 1 - i)];
+        if (p.single) {
+            section.b1 = float(-z.first.real());
+            section.a1 = float(-p.first.real());
+        }
+        else {
+            section.b1 = float(-(z.first + z.second).real());
+            section.b2 = float((z.first * z.second).real());
+            section.a1 = float(-(p.first + p.second).real());
+            section.a2 = float((p.first * p.second).real());
+        }
+    }
+
+    //gain of the first section, from the analog and digital responses at matchFrequency
+    double omega = Sos::twoPi * h.matchFrequency;
+    auto analog = Sos::evaluatePolynomial(h.b.data(), h.order, { 0.0, omega })
+                / Sos::evaluatePolynomial(h.a.data(), h.order, { 0.0, omega });
+    auto digital = Sos::evaluateSections(sos, std::polar(1.0, omega / Fs));
+
+    double k = h.matchFrequency > 0.0 ? std::abs(analog) / std::abs(digital) : (analog / digital).real();
+    auto& first = sos.sections[0];
+    first.b0 = float(k);
+    first.b1 = float(k * double(first.b1));
+    first.b2 = float(k * double(first.b2));
+
+    return sos;
+}
+
+// Inverse cascade: the zeros become the poles, which designSections put inside the unit circle
+inline SosCoefficients invertSections(const SosCoefficients& sos) {
+    SosCoefficients inverse;
+    inverse.numSections = sos.numSections;
+
+    for (int i = 0; i < sos.numSections; ++i) {
+        const auto& s = sos.sections[size_t(i)];
+        auto& t = inverse.sections[size_t(i)];
+
+        t.b0 = 1.0f / s.b0;
+        t.b1 = s.a1 / s.b0;
+        t.b2 = s.a2 / s.b0;
+        t.a1 = s.b1 / s.b0;
+        t.a2 = s.b2 / s.b0;
+    }
+    return inverse;
+}
+
+// Cascade of second-order sections in direct form I, for numChannels channels processed
+// together. The state of a section is stored channel by channel, so that the channels of
+// one section are computed by the same vector instructions; the sections themselves depend
+// on each other and are computed one after the other, so the cost grows with the order.
+template<typename Sample = float, int numChannels = 2>
+class SosCascade {
+public:
+    void setCoefficients(const SosCoefficients& sos) {
+        numSections = sos.numSections;
+        for (int i = 0; i < numSections; ++i) {
+            const auto& s = sos.sections[size_t(i)];
+            coeffs[size_t(i)] = { Sample(s.b0), Sample(s.b1), Sample(s.b2), Sample(s.a1), Sample(s.a2) };
+        }
+    }
+
+    void reset() {
+        for (auto& state : states)
+            state = State();
+    }
+
+    // Processes one sample of every channel in place
+    void processSample(Sample* frame) {
+        for (int i = 0; i < numSections; ++i) {
+            const auto& c = coeffs[size_t(i)];
+            auto& s = states[size_t(i)];
+
+            for (int channel = 0; channel < numChannels; ++channel) {
+                Sample x = frame[channel];
+                Sample y = c.b0 * x + c.b1 * s.x1[channel] + c.b2 * s.x2[channel] - c.a1 * s.y1[channel] - c.a2 * s.y2[channel];
+
+                s.x2[channel] = s.x1[channel];
+                s.x1[channel] = x;
+                s.y2[channel] = s.y1[channel];
+                s.y1[channel] = y;
+                frame[channel] = y;
+            }
+        }
+    }
+
+    void processSample(Sample& sampleL, Sample& sampleR) {
+        static_assert(numChannels == 2, "stereo cascade only");
+        Sample frame[2] = { sampleL, sampleR };
+        processSample(frame);
+        sampleL = frame[0];
+        sampleR = frame[1];
+    }
+
+    Sample processSample(Sample x) {
+        static_assert(numChannels == 1, "mono cascade only");
+        processSample(&x);
+        return x;
+    }
+
+    int getNumSections() const { return numSections; }
+
+private:
+    struct Coefficients {
+        Sample b0 = 1, b1 = 0, b2 = 0, a1 = 0, a2 = 0;
+    };
+
+    struct State {
+        std::array<Sample, numChannels> x1{}, x2{}, y1{}, y2{};
+    };
+
+    std::array<Coefficients, Sos::maxSections> coeffs;
+    std::array<State, Sos::maxSections> states;
+    int numSections = 0;
+};
+
+// Cascades of second-order sections with their own coefficients in every lane, for numLanes
+// different filters processed together, as the drivers of an array: the lanes of one section
+// fill a vector register (8 floats with AVX). A lane of fewer sections than the longest one
+// is padded with pass-through sections.
+template<typename Sample = float, int numLanes = 8, int maxSections = Sos::maxSections>
+class SosLanes {
+public:
+    SosLanes() {
+        for (auto& c : coeffs)
+            c.b0.fill(Sample(1));
+    }
+
+    void setCoefficients(int lane, const SosCoefficients& sos) {
+        setCoefficients(lane, sos.sections.data(), sos.numSections);
+    }
+
+    // Sections of one lane, at most maxSections
+    void setCoefficients(int lane, const SosSection* sections, int count) {
+        for (int i = 0; i < maxSections; ++i) {
+            SosSection s = i < count ? sections[i] : SosSection();
+            auto& c = coeffs[size_t(i)];
+            c.b0[size_t(lane)] = Sample(s.b0);
+            c.b1[size_t(lane)] = Sample(s.b1);
+            c.b2[size_t(lane)] = Sample(s.b2);
+            c.a1[size_t(lane)] = Sample(s.a1);
+            c.a2[size_t(lane)] = Sample(s.a2);
+        }
+        laneSections[size_t(lane)] = std::min(count, maxSections);
+        numSections = *std::max_element(laneSections.begin(), laneSections.end());
+    }
+
+    void reset() {
+        for (auto& state : states)
+            state = State();
+    }
+
+    // Clears the state of one lane only, when its filter is replaced
+    void reset(int lane) {
+        for (auto& s : states)
+            s.x1[size_t(lane)] = s.x2[size_t(lane)] = s.y1[size_t(lane)] = s.y2[size_t(lane)] = Sample(0);
+    }
+
+    // Processes one sample of every lane in place
+    void processSample(Sample* frame) {
+        //a local copy, which the compiler knows is not the state, so that the lanes are vectorized
+        alignas(sizeof(Sample) * numLanes) std::array<Sample, numLanes> v;
+        std::copy(frame, frame + numLanes, v.begin());
+
+        for (int i = 0; i < numSections; ++i) {
+            const auto& c = coeffs[size_t(i)];
+            auto& s = states[size_t(i)];
+
+            for (int lane = 0; lane < numLanes; ++lane) {
+                Sample x = v[lane];
+                Sample y = c.b0[lane] * x + c.b1[lane] * s.x1[lane] + c.b2[lane] * s.x2[lane] - c.a1[lane] * s.y1[lane] - c.a2[lane] * s.y2[lane];
+
+                s.x2[lane] = s.x1[lane];
+                s.x1[lane] = x;
+                s.y2[lane] = s.y1[lane];
+                s.y1[lane] = y;
+                v[lane] = y;
+            }
+        }
+        std::copy(v.begin(), v.end(), frame);
+    }
+
+    int getNumSections() const { return numSections; }
+
+private:
+    struct alignas(sizeof(Sample) * numLanes) Coefficients {
+        std::array<Sample, numLanes> b0{}, b1{}, b2{}, a1{}, a2{};
+    };
+
+    struct alignas(sizeof(Sample) * numLanes) State {
+        std::array<Sample, numLanes> x1{}, x2{}, y1{}, y2{};
+    };
+
+    std::array<Coefficients, maxSections> coeffs;
+    std::array<State, maxSections> states;
+    std::array<int, numLanes> laneSections{};
+    int numSections = 0;
+};
@@ -0,0 +1,428 @@
+/*
+  ==============================================================================
+
+    SpeakerDatabase.cpp
+    Created: 19 Oct 2026 2:06:51pm
+    Author:  eliot
+
+  ==============================================================================
+*/
+
+#include "SpeakerDatabase.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <string>
+
+struct SpeakerDatabase::Header
+{
+    char magic[4];
+    uint32_t version;
+    uint32_t numRecords;
+    uint32_t numIndexEntries;
+    int64_t sourceSize;            // of the compiled source, to know when to compile it again
+    int64_t sourceTime;            // ms
+};
+
+// A word of a name: the record, and where the word starts in its name
+struct SpeakerDatabase::IndexEntry
+{
+    uint32_t record;
+    uint32_t offset;
+};
+
+static const char cacheMagic[4] = { 'X', 'S', 'P', 'K' };
+static constexpr uint32_t cacheVersion = 1;
+
+static char toLowerAscii(char c)
+{
+    return c >= 'A' && c <= 'Z' ? char(c - 'A' + 'a') : c;
+}
+
+static bool isWordCharacter(char c)
+{
+    return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+}
+
+// Lower case runs of letters and digits, the words of the index
+static std::vector<std::string> splitWords(const char* text)
+{
+    std::vector<std::string> words;
+    std::string word;
+    for (const char* c = text; ; ++c) {
+        if (*c != 0 && isWordCharacter(*c)) {
+            word += toLowerAscii(*c);
+        }
+        else {
+            if (!word.empty())
+                words.push_back(word);
+            word.clear();
+            if (*c == 0)
+                break;
+        }
+    }
+    return words;
+}
+
+static bool hasWordStartingWith(const char* name, const std::string& word)
+{
+    for (size_t i = 0; name[i] != 0; ++i) {
+        if (i > 0 && isWordCharacter(name[i - 1]))
+            continue;
+
+        size_t j = 0;
+        while (j < word.size() && name[i + j] != 0 && toLowerAscii(name[i + j]) == word[j])
+            ++j;
+        if (j == word.size())
+            return true;
+    }
+    return false;
+}
+
+static int compareIgnoreCase(const char* a, const char* b)
+{
+    for (;; ++a, ++b) {
+        char ca = toLowerAscii(*a);
+        char cb = toLowerAscii(*b);
+        if (ca != cb || ca == 0)
+            return int((unsigned char)ca) - int((unsigned char)cb);
+    }
+}
+
+//==============================================================================
+// Fills a record from the values of one driver, and derives what the file does not give
+static juce::Result makeRecord(const juce::NamedValueSet& values, int row, SpeakerDatabase::Record& record)
+{
+    auto fail = [row](const juce::String& message) {
+        return juce::Result::fail("Driver " + juce::String(row) + ": " + message);
+    };
+    auto get = [&values](const char* key) {
+        const auto* value = values.getVarPointer(key);
+        return value != nullptr && value->toString().isNotEmpty() ? double(*value) : 0.0;
+    };
+
+    auto name = values["name"].toString().trim();
+    if (name.isEmpty())
+        return fail("no name");
+    if (name.getNumBytesAsUTF8() > size_t(SpeakerDatabase::maxNameLength))
+        return fail(name + " is longer than " + juce::String(SpeakerDatabase::maxNameLength) + " bytes");
+
+    double fs = get("fs"), Rec = get("Rec"), Lec = get("Lec");
+    double Qms = get("Qms"), Qes = get("Qes"), Qts = get("Qts");
+    double Mms = get("Mms"), Cms = get("Cms"), Bl = get("Bl"), Vas = get("Vas"), Sd = get("Sd");
+
+    if (fs <= 0 || Rec <= 0 || Qms <= 0 || Qes <= 0 || Sd <= 0)
+        return fail(name + " needs fs, Rec, Qms, Qes and Sd");
+
+    if (Cms <= 0 && Vas > 0)
+        Cms = Vas / (rhoC2 * Sd * Sd);
+    if (Cms <= 0 && Mms <= 0)
+        return fail(name + " needs Cms, Vas or Mms");
+    auto model = makeLoudspeakerModel(float(fs), float(Rec), float(Lec), float(Qms), float(Qes), float(Mms), float(Cms), float(Bl), float(Sd));
+
+    Enclosure box;
+    auto boxName = values["box"].toString().trim();
+    if (boxName == "sealed")
+        box.type = Enclosure::sealed;
+    else if (boxName == "vented")
+        box.type = Enclosure::vented;
+    else if (boxName == "passiveRadiator")
+        box.type = Enclosure::passiveRadiator;
+    else if (boxName.isNotEmpty() && boxName != "infiniteBaffle")
+        return fail(name + ": unknown box " + boxName + " (infiniteBaffle, sealed, vented or passiveRadiator)");
+
+    box.Vb = float(get("Vb"));
+    box.fb = float(get("fb"));
+    box.fp = float(get("fp"));
+    if (get("Ql") > 0)
+        box.Ql = float(get("Ql"));
+
+    if (box.type != Enclosure::infiniteBaffle && box.Vb <= 0)
+        return fail(name + ": a box needs Vb");
+    if ((box.type == Enclosure::vented || box.type == Enclosure::passiveRadiator) && box.fb <= box.fp)
+        return fail(name + ": fb must be above fp");
+
+    record = SpeakerDatabase::Record();
+    name.copyToUTF8(record.name, sizeof(record.name));
+    record.fs = model.fs;
+    record.Rec = model.Rec;
+    record.Lec = model.Lec;
+    record.Qms = model.Qms;
+    record.Qes = model.Qes;
+    record.Qts = Qts > 0 ? float(Qts) : model.Qts;
+    record.Mms = model.Mms;
+    record.Cms = model.Cms;
+    record.Bl = model.Bl;
+    record.Vas = Vas > 0 ? float(Vas) : model.Vas;
+    record.Sd = model.Sd;
+    record.enclosureType = int32_t(box.type);
+    record.Vb = box.Vb;
+    record.fb = box.fb;
+    record.fp = box.fp;
+    record.Ql = box.Ql;
+    return juce::Result::ok();
+}
+
+// An array of objects, whose properties are the parameters
+static juce::Result readJson(const juce::File& source, std::vector<SpeakerDatabase::Record>& records)
+{
+    juce::var json;
+    auto result = juce::JSON::parse(source.loadFileAsString(), json);
+    if (result.failed())
+        return juce::Result::fail(source.getFileName() + ": " + result.getErrorMessage());
+
+    const auto* drivers = json.getArray();
+    if (drivers == nullptr)
+        return juce::Result::fail(source.getFileName() + " is not an array of drivers");
+
+    for (int i = 0; i < drivers->size(); ++i) {
+        auto* object = drivers->getReference(i).getDynamicObject();
+        if (object == nullptr)
+            return juce::Result::fail("Driver " + juce::String(i + 1) + " is not an object");
+
+        SpeakerDatabase::Record record;
+        result = makeRecord(object->getProperties(), i + 1, record);
+        if (result.failed())
+            return result;
+        records.push_back(record);
+    }
+    return juce::Result::ok();
+}
+
+// A header line with the names of the parameters, then one line per driver.
+// Lines starting with # are comments.
+static juce::Result readCsv(const juce::File& source, std::vector<SpeakerDatabase::Record>& records)
+{
+    juce::StringArray lines;
+    source.readLines(lines);
+
+    juce::StringArray columns;
+    int row = 0;
+
+    for (const auto& line : lines) {
+        if (line.trim().isEmpty() || line.trimStart().startsWithChar('#'))
+            continue;
+
+        juce::StringArray cells;
+        cells.addTokens(line, ",;", "\"");
+        for (auto& cell : cells)
+            cell = cell.trim().unquoted();
+
+        if (columns.isEmpty()) {
+            columns = cells;
+            continue;
+        }
+
+        juce::NamedValueSet values;
+        for (int i = 0; i < columns.size() && i < cells.size(); ++i)
+            values.set(juce::Identifier(columns[i]), cells[i]);
+
+        SpeakerDatabase::Record record;
+        auto result = makeRecord(values, ++row, record);
+        if (result.failed())
+            return result;
+        records.push_back(record);
+    }
+    return juce::Result::ok();
+}
+
+juce::Result SpeakerDatabase::compile(const juce::File& source, const juce::File& cache)
+{
+    std::vector<Record> records;
+    auto result = source.hasFileExtension("csv") ? readCsv(source, records) : readJson(source, records);
+    if (result.failed())
+        return result;
+
+    std::sort(records.begin(), records.end(), [](const Record& a, const Record& b) { return compareIgnoreCase(a.name, b.name) < 0; });
+
+    for (size_t i = 1; i < records.size(); ++i) {
+        if (compareIgnoreCase(records[i - 1].name, records[i].name) == 0)
+            return juce::Result::fail("Two drivers are named " + juce::String(records[i].name));
+    }
+
+    std::vector<IndexEntry> index;
+    for (size_t i = 0; i < records.size(); ++i) {
+        const char* name = records[i].name;
+        for (size_t offset = 0; name[offset] != 0; ++offset) {
+            if (isWordCharacter(name[offset]) && (offset == 0 || !isWordCharacter(name[offset - 1])))
+                index.push_back({ uint32_t(i), uint32_t(offset) });
+        }
+    }
+    std::sort(index.begin(), index.end(), [&records](const IndexEntry& a, const IndexEntry& b) {
+        int order = compareIgnoreCase(records[a.record].name + a.offset, records[b.record].name + b.offset);
+        return order != 0 ? order < 0 : a.record < b.record;
+    });
+
+    Header header;
+    std::memcpy(header.magic, cacheMagic, sizeof(cacheMagic));
+    header.version = cacheVersion;
+    header.numRecords = uint32_t(records.size());
+    header.numIndexEntries = uint32_t(index.size());
+    header.sourceSize = source.getSize();
+    header.sourceTime = source.getLastModificationTime().toMilliseconds();
+
+    //written next to the cache and moved over it, so that another instance never maps half a file
+    juce::TemporaryFile temporary(cache);
+    {
+        juce::FileOutputStream stream(temporary.getFile());
+        if (!stream.openedOk())
+            return juce::Result::fail("Cannot write " + cache.getFullPathName());
+
+        bool written = stream.write(&header, sizeof(header))
+                    && stream.write(records.data(), records.size() * sizeof(Record))
+                    && stream.write(index.data(), index.size() * sizeof(IndexEntry));
+        stream.flush();
+        if (!written || stream.getStatus().failed())
+            return juce::Result::fail("Cannot write " + cache.getFullPathName());
+    }
+
+    if (!temporary.overwriteTargetFileWithTemporary())
+        return juce::Result::fail("Cannot replace " + cache.getFullPathName());
+    return juce::Result::ok();
+}
+
+void SpeakerDatabase::close() noexcept
+{
+    mappedFile.reset();
+    header = nullptr;
+    records = nullptr;
+    index = nullptr;
+    numRecords = 0;
+    numIndexEntries = 0;
+}
+
+juce::Result SpeakerDatabase::open(const juce::File& cache)
+{
+    close();
+
+    auto file = std::make_unique<juce::MemoryMappedFile>(cache, juce::MemoryMappedFile::readOnly);
+    const auto* data = static_cast<const char*>(file->getData());
+    auto size = file->getSize();
+
+    if (data == nullptr || size < sizeof(Header))
+        return juce::Result::fail("Cannot read " + cache.getFullPathName());
+
+    const auto* fileHeader = reinterpret_cast<const Header*>(data);
+    if (std::memcmp(fileHeader->magic, cacheMagic, sizeof(cacheMagic)) != 0 || fileHeader->version != cacheVersion)
+        return juce::Result::fail(cache.getFullPathName() + " is not a speaker cache of this version");
+
+    auto expectedSize = sizeof(Header) + size_t(fileHeader->numRecords) * sizeof(Record) + size_t(fileHeader->numIndexEntries) * sizeof(IndexEntry);
+    if (size != expectedSize)
+        return juce::Result::fail(cache.getFullPathName() + " is truncated");
+
+    //touch every page now, so that the audio thread does not fault them in when it switches models
+    volatile char sum = 0;
+    for (size_t i = 0; i < size; i += 4096)
+        sum = char(sum + data[i]);
+
+    mappedFile = std::move(file);
+    header = fileHeader;
+    records = reinterpret_cast<const Record*>(data + sizeof(Header));
+    index = reinterpret_cast<const IndexEntry*>(data + sizeof(Header) + size_t(header->numRecords) * sizeof(Record));
+    numRecords = int(header->numRecords);
+    numIndexEntries = int(header->numIndexEntries);
+    return juce::Result::ok();
+}
+
+juce::Result SpeakerDatabase::load(const juce::File& source)
+{
+    auto cache = getCacheFile(source);
+
+    if (!source.existsAsFile())
+        return cache.existsAsFile() ? open(cache) : juce::Result::fail("No speaker database at " + source.getFullPathName());
+
+    if (cache.existsAsFile() && open(cache).wasOk()) {
+        if (header->sourceSize == source.getSize() && header->sourceTime == source.getLastModificationTime().toMilliseconds())
+            return juce::Result::ok();
+        close(); //unmapped before it is replaced
+    }
+
+    auto result = compile(source, cache);
+    return result.wasOk() ? open(cache) : result;
+}
+
+juce::File SpeakerDatabase::getDefaultSource()
+{
+    auto folder = juce::File::getSpecialLocation(juce::File::userApplicationDataDirectory).getChildFile("Xmax");
+    auto csv = folder.getChildFile("Speakers.csv");
+    return csv.existsAsFile() ? csv : folder.getChildFile("Speakers.json");
+}
+
+juce::File SpeakerDatabase::getCacheFile(const juce::File& source)
+{
+    return source.withFileExtension("xspk");
+}
+
+//==============================================================================
+juce::String SpeakerDatabase::getName(int modelIndex) const
+{
+    return juce::String::fromUTF8(records[modelIndex].name);
+}
+
+LoudspeakerModel SpeakerDatabase::getModel(int modelIndex) const noexcept
+{
+    const auto& r = records[modelIndex];
+
+    LoudspeakerModel model(r.fs, r.Rec, r.Lec, r.Qms, r.Qes, r.Qts, r.Mms, r.Cms, r.Bl, r.Vas, r.Sd);
+    model.enclosure.type = Enclosure::Type(r.enclosureType);
+    model.enclosure.Vb = r.Vb;
+    model.enclosure.fb = r.fb;
+    model.enclosure.fp = r.fp;
+    model.enclosure.Ql = r.Ql;
+    return model;
+}
+
+// Compares the word of the entry with the beginning of a lower case word: 0 if it starts with it
+int SpeakerDatabase::compareWord(const IndexEntry& entry, const char* word, size_t length) const noexcept
+{
+    const char* name = records[entry.record].name + entry.offset;
+    for (size_t i = 0; i < length; ++i) {
+        char c = toLowerAscii(name[i]);
+        if (c != word[i])
+            return int((unsigned char)c) - int((unsigned char)word[i]);
+    }
+    return 0;
+}
+
+juce::Array<int> SpeakerDatabase::search(const juce::String& text, int maxResults) const
+{
+    juce::Array<int> results;
+    auto words = splitWords(text.toRawUTF8());
+
+    if (words.empty()) {
+        for (int i = 0; i < numRecords && results.size() < maxResults; ++i)
+            results.add(i);
+        return results;
+    }
+
+    //the first word finds the candidates in the index, the others filter them
+    const auto& first = words.front();
+    const auto* end = index + numIndexEntries;
+    const auto* entry = std::lower_bound(index, end, first, [this](const IndexEntry& e, const std::string& word) {
+        return compareWord(e, word.c_str(), word.size()) < 0;
+    });
+
+    std::vector<int> candidates;
+    for (; entry != end && compareWord(*entry, first.c_str(), first.size()) == 0; ++entry)
+        candidates.push_back(int(entry->record));
+
+    std::sort(candidates.begin(), candidates.end());
+    candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+
+    for (auto candidate : candidates) {
+        const char* name = records[candidate].name;
+        bool matches = std::all_of(words.begin() + 1, words.end(), [name](const std::string& word) { return hasWordStartingWith(name, word); });
+        if (matches)
+            results.add(candidate);
+        if (results.size() >= maxResults)
+            break;
+    }
+    return results;
+}
+
+bool SpeakerDatabase::matches(const juce::String& name, const juce::String& text)
+{
+    auto words = splitWords(text.toRawUTF8());
+    const char* utf8 = name.toRawUTF8();
+    return std::all_of(words.begin(), words.end(), [utf8](const std::string& word) { return hasWordStartingWith(utf8, word); });
+}
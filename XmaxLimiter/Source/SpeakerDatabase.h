@@ -0,0 +1,82 @@
+/*
+  ==============================================================================
+
+    SpeakerDatabase.h
+    Created: 19 Oct 2026 2:06:51pm
+    Author:  eliot
+
+    Drivers of the user, besides the built-in models. They are written as a
+    JSON array or a CSV table of Thiele/Small parameters (in the units of
+    LoudspeakerModel), and compiled once into a binary cache next to the
+    source: fixed-size records sorted by name, with the missing parameters
+    derived (Qts, Cms or Vas, Mms, Bl), followed by an index of every word
+    of the names. The cache is memory-mapped as it is, so opening it costs
+    the same with ten drivers or ten thousand, and a search is a binary
+    search in the word index.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "Parameters.h"
+
+class SpeakerDatabase
+{
+public:
+    static constexpr int maxNameLength = 47;
+
+    // One driver in the cache, as written in the file
+    struct Record
+    {
+        char name[maxNameLength + 1];
+        float fs, Rec, Lec, Qms, Qes, Qts, Mms, Cms, Bl, Vas, Sd;
+        int32_t enclosureType; // Enclosure::Type
+        float Vb, fb, fp, Ql;
+    };
+
+    // Compiles a JSON or CSV file (by its extension) into a binary cache
+    static juce::Result compile(const juce::File& source, const juce::File& cache);
+
+    // Maps a compiled cache
+    juce::Result open(const juce::File& cache);
+
+    // Opens the cache of this source, compiled again first if the source changed since.
+    // Without the source, the cache alone is opened if it exists.
+    juce::Result load(const juce::File& source);
+
+    // Speakers.json or Speakers.csv in the Xmax folder of the user application data, and its cache
+    static juce::File getDefaultSource();
+    static juce::File getCacheFile(const juce::File& source);
+
+    bool isOpen() const noexcept { return records != nullptr; }
+    int getNumModels() const noexcept { return numRecords; }
+
+    juce::String getName(int index) const;
+    LoudspeakerModel getModel(int index) const noexcept;
+
+    // Models whose name has a word starting with each word of the text (case insensitive),
+    // in the order of the names. An empty text matches every model.
+    juce::Array<int> search(const juce::String& text, int maxResults) const;
+
+    // True if the name has a word starting with each word of the text, as found by search()
+    static bool matches(const juce::String& name, const juce::String& text);
+
+private:
+    struct Header;
+    struct IndexEntry;
+
+    void close() noexcept;
+    int compareWord(const IndexEntry& entry, const char* word, size_t length) const noexcept;
+
+    std::unique_ptr<juce::MemoryMappedFile> mappedFile;
+    const Header* header = nullptr;
+    const Record* records = nullptr;
+    const IndexEntry* index = nullptr;
+    int numRecords = 0;
+    int numIndexEntries = 0;
+};
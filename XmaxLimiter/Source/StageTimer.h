@@ -0,0 +1,254 @@
+/*
+  ==============================================================================
+
+    StageTimer.h
+    Created: 19 Oct 2026 6:12:40pm
+    Author:  eliot
+
+    Time spent in each stage of processBlock, and counts of the work whose
+    cost depends on the signal, so that the profiler of XmaxTools can tell
+    which stage made a block slow. The macros are empty unless
+    XMAX_STAGE_TIMING is defined to 1, so the plugins pay nothing for it.
+
+    PipelineTimes goes down to the stages of the per-sample loop, with the
+    cycle counter, and publishes their time per block for the editor. It
+    only exists when XMAX_PIPELINE_TIMING is defined to 1 (add it to the
+    preprocessor definitions of the Projucer exporter), since timing every
+    sample costs more than some of the stages it measures.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+
+#ifndef XMAX_STAGE_TIMING
+ #define XMAX_STAGE_TIMING 0
+#endif
+
+#ifndef XMAX_PIPELINE_TIMING
+ #define XMAX_PIPELINE_TIMING 0
+#endif
+
+#if XMAX_PIPELINE_TIMING
+ #include <atomic>
+ #include <limits>
+ #if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+  #if defined(_MSC_VER)
+   #include <intrin.h>
+  #else
+   #include <x86intrin.h>
+  #endif
+  #define XMAX_CYCLE_COUNTER 1
+ #else
+  #include <time.h>
+  #define XMAX_CYCLE_COUNTER 0
+ #endif
+#endif
+
+struct StageTimes
+{
+    enum Stage { parameters, modelSwitch, latency, samples, meters, numStages };
+    enum Counter { crossfadeSamples, minFilterScans, numCounters };
+
+    static const char* getStageName(int stage) noexcept
+    {
+        static const char* const names[numStages] = { "parameters", "modelSwitch", "latency", "samples", "meters" };
+        return names[stage];
+    }
+
+    static const char* getCounterName(int counter) noexcept
+    {
+        static const char* const names[numCounters] = { "crossfadeSamples", "minFilterScans" };
+        return names[counter];
+    }
+
+    static int64_t now() noexcept
+    {
+        auto time = std::chrono::steady_clock::now().time_since_epoch();
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(time).count();
+    }
+
+    // Starts a new block
+    void start() noexcept
+    {
+        nanoseconds.fill(0);
+        counters.fill(0);
+        lastTime = now();
+    }
+
+    // The time since the previous lap was spent in this stage
+    void lap(Stage stage) noexcept
+    {
+        auto time = now();
+        nanoseconds[size_t(stage)] += time - lastTime;
+        lastTime = time;
+    }
+
+    void count(Counter counter, int64_t amount) noexcept
+    {
+        counters[size_t(counter)] += amount;
+    }
+
+    bool enabled = false; // switched on by the profiler only
+    std::array<int64_t, numStages> nanoseconds{};
+    std::array<int64_t, numCounters> counters{};
+    int64_t lastTime = 0;
+};
+
+#if XMAX_STAGE_TIMING
+ #define XMAX_STAGE_START(times)                  do { if ((times).enabled) (times).start(); } while (false)
+ #define XMAX_STAGE_LAP(times, stage)             do { if ((times).enabled) (times).lap(StageTimes::stage); } while (false)
+ #define XMAX_STAGE_COUNT(times, counter, amount) do { if ((times).enabled) (times).count(StageTimes::counter, (amount)); } while (false)
+#else
+ #define XMAX_STAGE_START(times)
+ #define XMAX_STAGE_LAP(times, stage)
+ #define XMAX_STAGE_COUNT(times, counter, amount)
+#endif
+
+#if XMAX_PIPELINE_TIMING
+// Cheapest monotonic timestamp: the time stamp counter on x86, clock_gettime elsewhere
+struct CycleClock
+{
+    static int64_t now() noexcept
+    {
+       #if XMAX_CYCLE_COUNTER
+        return int64_t(__rdtsc());
+       #else
+        timespec time;
+        clock_gettime(CLOCK_MONOTONIC, &time);
+        return int64_t(time.tv_sec) * 1000000000 + int64_t(time.tv_nsec);
+       #endif
+    }
+
+    // Measured once against steady_clock, which spins for 10 ms: call it from prepareToPlay
+    static double getNanosecondsPerTick() noexcept
+    {
+       #if XMAX_CYCLE_COUNTER
+        static const double nanosecondsPerTick = [] {
+            auto startTime = std::chrono::steady_clock::now();
+            auto startTicks = now();
+            while (std::chrono::steady_clock::now() - startTime < std::chrono::milliseconds(10)) {}
+            auto ticks = now() - startTicks;
+            auto elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - startTime);
+            return ticks > 0 ? elapsed.count() / double(ticks) : 1.0;
+        }();
+        return nanosecondsPerTick;
+       #else
+        return 1.0;
+       #endif
+    }
+};
+
+// Time of one stage per block, in microseconds, between two reads. Like Measurement, the
+// audio thread updates it and the editor reads and resets it, without locks. A block
+// published during a read may be counted in the next one, which the display does not mind.
+struct StageMeasurement
+{
+    struct Summary
+    {
+        float minimum = 0.0f;
+        float mean = 0.0f;
+        float maximum = 0.0f;
+        int numBlocks = 0;
+    };
+
+    void reset() noexcept
+    {
+        minimum.store(std::numeric_limits<float>::max());
+        maximum.store(0.0f);
+        total.store(0.0f);
+        numBlocks.store(0);
+    }
+
+    void update(float newValue) noexcept
+    {
+        auto oldMinimum = minimum.load();
+        while (newValue < oldMinimum && !minimum.compare_exchange_weak(oldMinimum, newValue));
+
+        auto oldMaximum = maximum.load();
+        while (newValue > oldMaximum && !maximum.compare_exchange_weak(oldMaximum, newValue));
+
+        auto oldTotal = total.load();
+        while (!total.compare_exchange_weak(oldTotal, oldTotal + newValue));
+
+        numBlocks.fetch_add(1);
+    }
+
+    Summary readAndReset() noexcept
+    {
+        Summary summary;
+        summary.numBlocks = numBlocks.exchange(0);
+        float sum = total.exchange(0.0f);
+        float lowest = minimum.exchange(std::numeric_limits<float>::max());
+        summary.maximum = maximum.exchange(0.0f);
+
+        if (summary.numBlocks > 0) {
+            summary.minimum = lowest;
+            summary.mean = sum / float(summary.numBlocks);
+        }
+        return summary;
+    }
+
+    std::atomic<float> minimum{ std::numeric_limits<float>::max() };
+    std::atomic<float> maximum{ 0.0f };
+    std::atomic<float> total{ 0.0f };
+    std::atomic<int> numBlocks{ 0 };
+};
+
+struct PipelineTimes
+{
+    enum Stage { inputGain, xuFilter, delay, gainComputer, minFilter, release, boxFilter, uxFilter, output, numStages };
+
+    static const char* getStageName(int stage) noexcept
+    {
+        static const char* const names[numStages] = { "inputGain", "xuFilter", "delay", "gainComputer", "minFilter", "release", "boxFilter", "uxFilter", "output" };
+        return names[stage];
+    }
+
+    void prepare() noexcept
+    {
+        nanosecondsPerTick = CycleClock::getNanosecondsPerTick();
+        for (auto& measurement : measurements)
+            measurement.reset();
+    }
+
+    // Starts the samples of a new block
+    void start() noexcept
+    {
+        ticks.fill(0);
+        lastTime = CycleClock::now();
+    }
+
+    // The time since the previous lap was spent in this stage
+    void lap(Stage stage) noexcept
+    {
+        auto time = CycleClock::now();
+        ticks[size_t(stage)] += time - lastTime;
+        lastTime = time;
+    }
+
+    // Publishes the time of each stage in this block
+    void finish() noexcept
+    {
+        for (size_t stage = 0; stage < numStages; ++stage)
+            measurements[stage].update(float(double(ticks[stage]) * nanosecondsPerTick * 1e-3));
+    }
+
+    std::array<StageMeasurement, numStages> measurements; // read by the editor
+    std::array<int64_t, numStages> ticks{};
+    int64_t lastTime = 0;
+    double nanosecondsPerTick = 1.0;
+};
+
+ #define XMAX_PIPELINE_START(times)               (times).start()
+ #define XMAX_PIPELINE_LAP(times, stage)          (times).lap(PipelineTimes::stage)
+ #define XMAX_PIPELINE_FINISH(times)              (times).finish()
+#else
+ #define XMAX_PIPELINE_START(times)
+ #define XMAX_PIPELINE_LAP(times, stage)
+ #define XMAX_PIPELINE_FINISH(times)
+#endif
@@ -0,0 +1,57 @@
+/*
+  ==============================================================================
+
+    TemperatureMeter.cpp
+    Created: 19 Oct 2026 7:31:08pm
+    Author:  eliot
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "TemperatureMeter.h"
+#include "LookAndFeel.h"
+#include "ThermalModel.h"
+
+TemperatureMeter::TemperatureMeter(Measurement& measurementL_, Measurement& measurementR_, std::atomic<float>& maxTemperature_)
+    : measurementL(measurementL_), measurementR(measurementR_), maxTemperature(maxTemperature_)
+{
+    setOpaque(true);
+    setInterceptsMouseClicks(false, false);
+    startTimerHz(refreshRate);
+    temperature = float(ThermalModel::ambientTemperature);
+}
+
+TemperatureMeter::~TemperatureMeter()
+{
+}
+
+void TemperatureMeter::paint(juce::Graphics& g)
+{
+    auto bounds = getLocalBounds();
+    g.fillAll(Colors::TemperatureMeter::background);
+
+    //from the ambient temperature to the maximum
+    float ambient = float(ThermalModel::ambientTemperature);
+    float maximum = maxTemperature.load();
+    float share = (temperature - ambient) / std::max(maximum - ambient, 1.0f);
+    int width = juce::roundToInt(juce::jlimit(0.0f, 1.0f, share) * float(bounds.getWidth()));
+    g.setColour(temperature > maximum - warningMargin ? Colors::TemperatureMeter::hot : Colors::TemperatureMeter::level);
+    g.fillRect(0, 0, width, bounds.getHeight());
+
+    g.setFont(Fonts::getFont(11.0f));
+    g.setColour(Colors::TemperatureMeter::text);
+    g.drawText("Coil " + juce::String(juce::roundToInt(temperature)) + " / " + juce::String(juce::roundToInt(maximum))
+               + juce::String::fromUTF8(" \xc2\xb0" "C"),
+               bounds.reduced(4, 0), juce::Justification::centredLeft);
+}
+
+void TemperatureMeter::timerCallback()
+{
+    //nothing was measured if no block was processed since the last read
+    float newTemperature = std::max(measurementL.readAndReset(), measurementR.readAndReset());
+    if (newTemperature > 0.0f)
+        temperature = newTemperature;
+
+    repaint();
+}
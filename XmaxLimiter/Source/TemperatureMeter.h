@@ -0,0 +1,41 @@
+/*
+  ==============================================================================
+
+    TemperatureMeter.h
+    Created: 19 Oct 2026 7:31:08pm
+    Author:  eliot
+
+    Voice coil temperature estimated by the thermal protection, the hotter of
+    the two channels, as a bar that fills up to the maximum temperature. The
+    magnet heats over minutes, so the reading is not held nor smoothed.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "Measurement.h"
+
+class TemperatureMeter : public juce::Component, private juce::Timer
+{
+public:
+    TemperatureMeter(Measurement& measurementL, Measurement& measurementR, std::atomic<float>& maxTemperature);
+    ~TemperatureMeter() override;
+
+    void paint(juce::Graphics&) override;
+
+private:
+    void timerCallback() override;
+
+    Measurement& measurementL;
+    Measurement& measurementR;
+    std::atomic<float>& maxTemperature;
+
+    static constexpr int refreshRate = 10;
+    static constexpr float warningMargin = 10.0f; // K below the maximum, where the bar turns red
+
+    float temperature = 0.0f;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(TemperatureMeter)
+};
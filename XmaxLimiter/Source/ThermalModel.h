@@ -0,0 +1,146 @@
+/*
+  ==============================================================================
+
+    ThermalModel.h
+    Created: 19 Oct 2026 7:05:26pm
+    Author:  eliot
+
+    Temperature of the voice coil of one channel, and the gain that keeps it
+    below its maximum. The heat dissipated in the coil, u^2 / Re(T), flows
+    through two thermal RC cells, from the coil to the magnet and from the
+    magnet to the air:
+
+        Ctv dTv/dt = P - (Tv - Tm) / Rtv
+        Ctm dTm/dt = (Tv - Tm) / Rtv - (Tm - Ta) / Rtm
+
+    with Re rising by 0.393 % per kelvin of the coil. The thermal resistances
+    are those of a driver whose coil heats by ratedTemperatureRise at its
+    rated power, split between the coil and the magnet as in typical
+    measurements, and the time constants are typical too: seconds for the
+    coil, minutes for the magnet.
+
+    The tension is only squared and summed for each sample; the network and
+    the gain are computed once per control period. The gain lets through
+    the power that brings the coil to its maximum in about attackTime, and
+    holds it there. It is computed from the tension before any limiting,
+    so that the estimated temperature errs on the hot side.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include "Parameters.h"
+
+class ThermalModel
+{
+public:
+    static constexpr double controlRate = 500.0;           // Hz, of the network and the gain
+    static constexpr double ambientTemperature = 25.0;     // degrees Celsius
+    static constexpr double ratedTemperatureRise = 100.0;  // K, of the coil at the rated power
+    static constexpr double coilShare = 0.6;               // of the thermal resistance, coil to magnet
+    static constexpr double coilTimeConstant = 10.0;       // s
+    static constexpr double magnetTimeConstant = 600.0;    // s
+    static constexpr double copperCoefficient = 0.00393;   // 1/K
+    static constexpr double powerTime = 0.1;               // s, averaging of the power seen by the gain
+    static constexpr double attackTime = 1.0;              // s
+    static constexpr double releaseTime = 1.0;             // s
+
+    // Re of this driver, at this sample rate. Real-time safe; the temperatures are kept.
+    void prepare(const LoudspeakerModel& model, double sampleRate) noexcept
+    {
+        Re = model.Rec;
+        decimation = std::max(1, int(std::round(sampleRate / controlRate)));
+        step = decimation / sampleRate;
+        powerCoeff = 1.0 - std::exp(-step / powerTime);
+        releaseCoeff = 1.0 - std::exp(-step / releaseTime);
+    }
+
+    void setLimits(float ratedPower, float maxTemperature) noexcept
+    {
+        double resistance = ratedTemperatureRise / std::max(double(ratedPower), 1e-3);
+        coilResistance = coilShare * resistance;
+        magnetResistance = (1.0 - coilShare) * resistance;
+        coilCapacity = coilTimeConstant / coilResistance;
+        magnetCapacity = magnetTimeConstant / magnetResistance;
+        maxCoilTemperature = maxTemperature;
+    }
+
+    // Only the gain is left at 1 when the protection is off: the temperature is still estimated
+    void setEnabled(bool shouldBeEnabled) noexcept
+    {
+        enabled = shouldBeEnabled;
+        if (!enabled)
+            gain = 1.0;
+    }
+
+    // A new driver, at the ambient temperature
+    void reset() noexcept
+    {
+        coilTemperature = magnetTemperature = ambientTemperature;
+        meanSquare = 0.0;
+        gain = 1.0;
+        sumOfSquares = 0.0f;
+        count = 0;
+    }
+
+    // Tension at the terminals (V) of one sample, without the thermal gain
+    void add(float tension) noexcept
+    {
+        sumOfSquares += tension * tension;
+        if (++count >= decimation)
+            update();
+    }
+
+    float getGain() const noexcept { return float(gain); }
+    float getCoilTemperature() const noexcept { return float(coilTemperature); }
+
+private:
+    void update() noexcept
+    {
+        double squared = double(sumOfSquares) / count;
+        sumOfSquares = 0.0f;
+        count = 0;
+
+        double hotRe = Re * (1.0 + copperCoefficient * (coilTemperature - ambientTemperature));
+        double power = gain * gain * squared / hotRe;
+
+        double coilFlow = (coilTemperature - magnetTemperature) / coilResistance;
+        double magnetFlow = (magnetTemperature - ambientTemperature) / magnetResistance;
+        coilTemperature += step * (power - coilFlow) / coilCapacity;
+        magnetTemperature += step * (coilFlow - magnetFlow) / magnetCapacity;
+
+        if (!enabled)
+            return;
+
+        //what holds the coil at its maximum, and what brings it there in attackTime
+        meanSquare += powerCoeff * (squared - meanSquare);
+        double allowed = (maxCoilTemperature - magnetTemperature) / coilResistance
+                       + coilCapacity * (maxCoilTemperature - coilTemperature) / attackTime;
+        double available = meanSquare / hotRe;
+        double target = available > allowed ? std::sqrt(std::max(allowed, 0.0) / available) : 1.0;
+
+        gain = target < gain ? target : gain + releaseCoeff * (target - gain);
+    }
+
+    double Re = 1.0;
+    int decimation = 1;
+    double step = 0.0; // s, control period
+    double powerCoeff = 0.0;
+    double releaseCoeff = 0.0;
+
+    double coilResistance = 1.0, magnetResistance = 1.0; // K/W
+    double coilCapacity = 1.0, magnetCapacity = 1.0;     // J/K
+    double maxCoilTemperature = 150.0;
+    bool enabled = false;
+
+    double coilTemperature = ambientTemperature;
+    double magnetTemperature = ambientTemperature;
+    double meanSquare = 0.0; // V^2
+    double gain = 1.0;
+
+    float sumOfSquares = 0.0f;
+    int count = 0;
+};
@@ -0,0 +1,122 @@
+/*
+  ==============================================================================
+
+    CoefficientCache.h
+    Created: 19 Oct 2026 10:02:37am
+    Author:  eliot
+
+    Designs the X/U filter and the low-shelf prototype of every speaker
+    model for the current sample rate on a background thread, and publishes
+    the finished table with an atomic pointer, so that a model switch in
+    processBlock is only a pointer load and a copy.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <array>
+#include <atomic>
+#include <vector>
+#include "Parameters.h"
+#include "FilterDesign.h"
+
+// Coefficients of the tension to displacement filter, and low-shelf prototype at the speaker resonance
+struct SpeakerCoefficients
+{
+    std::array<float, 3> bXu, aXu; // tension to displacement
+    LowShelfPrototype shelf;
+};
+
+inline SpeakerCoefficients designSpeakerCoefficients(const LoudspeakerModel& model, float Q, float sampleRate)
+{
+    SpeakerCoefficients coeffs;
+
+    auto doubleCoeffs = getXUFilterCoefficients(model, sampleRate);
+    coeffs.bXu = doubleCoeffs.first;
+    coeffs.aXu = doubleCoeffs.second;
+
+    coeffs.shelf = getLowShelfPrototype(float(model.fs), Q, sampleRate);
+
+    return coeffs;
+}
+
+class CoefficientCache : private juce::Thread
+{
+public:
+    CoefficientCache() : juce::Thread("Xmax coefficient cache") {}
+
+    ~CoefficientCache() override
+    {
+        stopThread(1000);
+    }
+
+    // Called from prepareToPlay: starts the design of every speaker model for this sample rate.
+    // The audio thread is not running at this point, so the table can safely be rewritten.
+    void prepare(double sampleRate, float shelfQ)
+    {
+        if (published.load(std::memory_order_acquire) != nullptr && table.sampleRate == sampleRate && table.shelfQ == shelfQ)
+            return;
+
+        if (isThreadRunning() && pendingSampleRate == sampleRate && pendingShelfQ == shelfQ)
+            return;
+
+        stopThread(1000);
+        published.store(nullptr, std::memory_order_release);
+        pendingSampleRate = sampleRate;
+        pendingShelfQ = shelfQ;
+        startThread(juce::Thread::Priority::low);
+    }
+
+    // Audio thread: returns nullptr while the table for this sample rate is not ready yet
+    const SpeakerCoefficients* find(int modelIndex, double sampleRate) const noexcept
+    {
+        const auto* current = published.load(std::memory_order_acquire);
+
+        if (current == nullptr || current->sampleRate != sampleRate)
+            return nullptr;
+
+        if (modelIndex < 0 || modelIndex >= int(current->models.size()))
+            return nullptr;
+
+        return &current->models[size_t(modelIndex)];
+    }
+
+    bool isReady() const noexcept
+    {
+        return published.load(std::memory_order_acquire) != nullptr;
+    }
+
+private:
+    struct Table
+    {
+        double sampleRate = 0.0;
+        float shelfQ = 0.0f;
+        std::vector<SpeakerCoefficients> models; // same order as SpeakerModels::modelNames
+    };
+
+    void run() override
+    {
+        table.sampleRate = pendingSampleRate;
+        table.shelfQ = pendingShelfQ;
+        table.models.resize(size_t(SpeakerModels::modelNames.size()));
+
+        for (int i = 0; i < SpeakerModels::modelNames.size(); ++i) {
+            if (threadShouldExit())
+                return;
+
+            const auto& model = Parameters::getSpeakerModel(i);
+            table.models[size_t(i)] = designSpeakerCoefficients(model, table.shelfQ, float(table.sampleRate));
+        }
+
+        published.store(&table, std::memory_order_release);
+    }
+
+    Table table;
+    double pendingSampleRate = 0.0;
+    float pendingShelfQ = 0.0f;
+    std::atomic<const Table*> published{ nullptr };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(CoefficientCache)
+};
@@ -0,0 +1,110 @@
+/*
+  ==============================================================================
+
+    CustomDriverPanel.cpp
+    Created: 19 Oct 2026 3:12:37pm
+    Author:  eliot
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "CustomDriverPanel.h"
+#include "LookAndFeel.h"
+
+const std::array<CustomDriverPanel::Field, CustomDriverPanel::numFields> CustomDriverPanel::fields = { {
+    { "fs",  "Hz",    1.0, false },
+    { "Re",  "Ohm",   1.0, false },
+    { "Le",  "mH",    1e-3, true },
+    { "Qms", "",      1.0, false },
+    { "Qes", "",      1.0, false },
+    { "Mms", "g",     1e-3, true },
+    { "Cms", "mm/N",  1e-3, true },
+    { "Bl",  "T.m",   1.0, true },
+    { "Sd",  "cm2",   1e-4, false }
+} };
+
+CustomDriverPanel::CustomDriverPanel(const LoudspeakerModel& model, std::function<void(const LoudspeakerModel&)> onApply_)
+    : onApply(std::move(onApply_))
+{
+    const std::array<double, numFields> values = { model.fs, model.Rec, model.Lec, model.Qms, model.Qes,
+                                                  model.Mms, model.Cms, model.Bl, model.Sd };
+
+    for (size_t i = 0; i < fields.size(); ++i) {
+        auto text = juce::String(fields[i].name);
+        if (*fields[i].unit != 0)
+            text << " (" << fields[i].unit << ")";
+
+        labels[i].setText(text, juce::dontSendNotification);
+        labels[i].setColour(juce::Label::textColourId, Colors::Button::text);
+        addAndMakeVisible(labels[i]);
+
+        editors[i].setInputRestrictions(12, "0123456789.eE-");
+        editors[i].setText(juce::String(values[i] / fields[i].scale), juce::dontSendNotification);
+        editors[i].onReturnKey = [this]() { apply(); };
+        addAndMakeVisible(editors[i]);
+    }
+    editors[Mms].setTextToShowWhenEmpty("from Cms", Colors::Button::text);
+    editors[Cms].setTextToShowWhenEmpty("from Mms", Colors::Button::text);
+    editors[Bl].setTextToShowWhenEmpty("from Qes", Colors::Button::text);
+
+    applyButton.setLookAndFeel(ButtonLookAndFeel::get());
+    applyButton.onClick = [this]() { apply(); };
+    addAndMakeVisible(applyButton);
+
+    errorLabel.setColour(juce::Label::textColourId, juce::Colours::darkred);
+    errorLabel.setJustificationType(juce::Justification::centred);
+    addAndMakeVisible(errorLabel);
+
+    setSize(labelWidth + editorWidth + 20, rowHeight * (numFields + 2) + 20);
+}
+
+CustomDriverPanel::~CustomDriverPanel()
+{
+    applyButton.setLookAndFeel(nullptr);
+}
+
+void CustomDriverPanel::paint(juce::Graphics& g)
+{
+    g.fillAll(Colors::background);
+}
+
+void CustomDriverPanel::resized()
+{
+    auto area = getLocalBounds().reduced(10);
+
+    for (size_t i = 0; i < fields.size(); ++i) {
+        auto row = area.removeFromTop(rowHeight);
+        labels[i].setBounds(row.removeFromLeft(labelWidth));
+        editors[i].setBounds(row.reduced(0, 2));
+    }
+
+    errorLabel.setBounds(area.removeFromTop(rowHeight));
+    applyButton.setBounds(area.removeFromTop(rowHeight).withSizeKeepingCentre(70, rowHeight - 2));
+}
+
+// Checks the entries and hands the model over, or says what is missing
+void CustomDriverPanel::apply()
+{
+    std::array<double, numFields> values;
+
+    for (size_t i = 0; i < fields.size(); ++i) {
+        auto text = editors[i].getText().trim();
+        double value = text.getDoubleValue() * fields[i].scale;
+
+        if (value < 0.0 || (value == 0.0 && !fields[i].optional)) {
+            errorLabel.setText(juce::String(fields[i].name) + " must be above 0", juce::dontSendNotification);
+            return;
+        }
+        values[i] = value;
+    }
+
+    if (values[Mms] == 0.0 && values[Cms] == 0.0) {
+        errorLabel.setText("Mms or Cms is needed", juce::dontSendNotification);
+        return;
+    }
+
+    errorLabel.setText({}, juce::dontSendNotification);
+    onApply(makeLoudspeakerModel(values[fs], values[Rec], values[Lec], values[Qms], values[Qes],
+                                 values[Mms], values[Cms], values[Bl], values[Sd]));
+}
@@ -118,23 +118,40 @@ inline std::pair<std::array<float, 3>, std::array<float, 3>> getXUFilterCoeffici
     return { bd_xu , ad_xu };
 }
 
-inline std::pair<std::array<float, 3>, std::array<float, 3>> getLowShelfCoefficients(float Fc, float Q, float dBgain, float Fs) {
+// Terms of the low-shelf design that only depend on the cutoff frequency and the sample rate
+struct LowShelfPrototype {
+    float cosw = 1.0f;
+    float alpha = 0.0f;
+};
+
+inline LowShelfPrototype getLowShelfPrototype(float Fc, float Q, float Fs) {
 
     float wc = 2 * pi * Fc / Fs;
-    float alpha = std::sin(wc) / (2 * Q);
+    return { std::cos(wc), std::sin(wc) / (2 * Q) };
+}
+
+// Low-shelf design from a precomputed prototype, only the gain dependent part is evaluated
+inline std::pair<std::array<float, 3>, std::array<float, 3>> getLowShelfCoefficients(const LowShelfPrototype& prototype, float dBgain) {
+
+    float cosw = prototype.cosw;
+    float alpha = prototype.alpha;
     float A = std::pow(10, (dBgain / 40));
+    float sqrtA = std::sqrt(A);
 
-    std::array<float, 3> b = {  A*((A + 1) - (A - 1) * std::cos(wc) + 2 * std::sqrt(A) * alpha),
-								2 * A*((A - 1) - (A + 1) * std::cos(wc)),
-							    A*((A + 1) - (A - 1) * std::cos(wc) - 2 * std::sqrt(A) * alpha) };
+    std::array<float, 3> b = {  A*((A + 1) - (A - 1) * cosw + 2 * sqrtA * alpha),
+                                2 * A*((A - 1) - (A + 1) * cosw),
+                                A*((A + 1) - (A - 1) * cosw - 2 * sqrtA * alpha) };
 
-    std::array<float, 3> a = {  (A + 1) + (A - 1) * std::cos(wc) + 2 * std::sqrt(A) * alpha,
-                                -2 * ((A - 1) + (A + 1) * std::cos(wc)),
-                                (A + 1) + (A - 1) * std::cos(wc) - 2 * std::sqrt(A) * alpha };
+    std::array<float, 3> a = {  (A + 1) + (A - 1) * cosw + 2 * sqrtA * alpha,
+                                -2 * ((A - 1) + (A + 1) * cosw),
+                                (A + 1) + (A - 1) * cosw - 2 * sqrtA * alpha };
 
     normalize(a, b);
-             
+
     return { b, a };
 }
 
+inline std::pair<std::array<float, 3>, std::array<float, 3>> getLowShelfCoefficients(float Fc, float Q, float dBgain, float Fs) {
 
+    return getLowShelfCoefficients(getLowShelfPrototype(Fc, Q, Fs), dBgain);
+}
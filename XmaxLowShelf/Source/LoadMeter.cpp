@@ -0,0 +1,70 @@
+/*
+  ==============================================================================
+
+    LoadMeter.cpp
+    Created: 19 Oct 2026 9:44:12pm
+    Author:  eliot
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "LoadMeter.h"
+#include "LookAndFeel.h"
+
+LoadMeter::LoadMeter(Measurement& peakMeasurement_, AverageMeasurement& averageMeasurement_)
+    : peakMeasurement(peakMeasurement_), averageMeasurement(averageMeasurement_)
+{
+    setOpaque(true);
+    setInterceptsMouseClicks(false, false);
+    startTimerHz(refreshRate);
+    decay = 1.0f - std::exp(-1.0f / (float(refreshRate) * 0.3f));
+}
+
+LoadMeter::~LoadMeter()
+{
+}
+
+void LoadMeter::paint(juce::Graphics& g)
+{
+    auto bounds = getLocalBounds();
+    g.fillAll(Colors::LoadMeter::background);
+
+    //the bar covers the whole budget, a peak above it stays at the right end
+    auto width = float(bounds.getWidth());
+    int averageWidth = juce::roundToInt(juce::jlimit(0.0f, 1.0f, average) * width);
+    g.setColour(average > warningLoad ? Colors::LoadMeter::overload : Colors::LoadMeter::level);
+    g.fillRect(0, 0, averageWidth, bounds.getHeight());
+
+    int peakX = juce::roundToInt(juce::jlimit(0.0f, 1.0f, heldPeak) * (width - 2.0f));
+    g.setColour(heldPeak > 1.0f ? Colors::LoadMeter::overload : Colors::LoadMeter::peak);
+    g.fillRect(peakX, 0, 2, bounds.getHeight());
+
+    g.setFont(Fonts::getFont(11.0f));
+    g.setColour(Colors::LoadMeter::text);
+    g.drawText("DSP " + juce::String(juce::roundToInt(average * 100.0f)) + "%  peak "
+               + juce::String(juce::roundToInt(heldPeak * 100.0f)) + "%",
+               bounds.reduced(4, 0), juce::Justification::centredLeft);
+}
+
+void LoadMeter::timerCallback()
+{
+    float newPeak = peakMeasurement.readAndReset();
+    float newAverage = averageMeasurement.readAndReset();
+
+    average += (newAverage - average) * decay;
+
+    //hold the highest peak, then let it fall back to the current one
+    if (newPeak >= heldPeak) {
+        heldPeak = newPeak;
+        holdCounter = int(holdTime * float(refreshRate));
+    }
+    else if (holdCounter > 0) {
+        --holdCounter;
+    }
+    else {
+        heldPeak += (newPeak - heldPeak) * decay;
+    }
+
+    repaint();
+}
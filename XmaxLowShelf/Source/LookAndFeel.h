@@ -66,6 +66,15 @@ namespace Colors
         const juce::Colour tickLabel{ 80, 80, 80 };
         const juce::Colour level{ 53, 156, 255 };
     }
+
+    namespace LoadMeter
+    {
+        const juce::Colour background{ 60, 60, 60 };
+        const juce::Colour level{ 65, 206, 88 };
+        const juce::Colour overload{ 226, 74, 81 };
+        const juce::Colour peak{ 245, 240, 235 };
+        const juce::Colour text{ 245, 240, 235 };
+    }
 }
 
 
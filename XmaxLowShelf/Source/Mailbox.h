@@ -0,0 +1,62 @@
+/*
+  ==============================================================================
+
+    Mailbox.h
+    Created: 19 Oct 2026 2:48:20pm
+    Author:  eliot
+
+    Hands the latest value written by one thread to another one, without any
+    lock or allocation on either side (triple buffer). The producer writes
+    in its own slot and swaps it with the middle one; the consumer swaps its
+    own slot with the middle one only when a new value was put there. A value
+    written twice before the consumer looks is only read once, the latest.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <array>
+#include <atomic>
+
+template<typename T>
+class Mailbox
+{
+public:
+    explicit Mailbox(const T& initialValue)
+        : slots{ initialValue, initialValue, initialValue }
+    {
+    }
+
+    // Producer thread only
+    void push(const T& value) noexcept
+    {
+        slots[size_t(writeSlot)] = value;
+        int previous = middle.exchange(writeSlot | newValue, std::memory_order_acq_rel);
+        writeSlot = previous & slotMask;
+    }
+
+    // Consumer thread only: copies the value pushed last, if it has not been pulled yet
+    bool pull(T& value) noexcept
+    {
+        if ((middle.load(std::memory_order_relaxed) & newValue) == 0)
+            return false;
+
+        int previous = middle.exchange(readSlot, std::memory_order_acq_rel);
+        readSlot = previous & slotMask;
+        value = slots[size_t(readSlot)];
+        return true;
+    }
+
+private:
+    static constexpr int slotMask = 3;
+    static constexpr int newValue = 4;
+
+    std::array<T, 3> slots;
+    std::atomic<int> middle{ 1 }; // index of the middle slot, with the newValue flag
+    int writeSlot = 0;
+    int readSlot = 2;
+
+    JUCE_DECLARE_NON_COPYABLE(Mailbox)
+};
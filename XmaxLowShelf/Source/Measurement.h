@@ -32,3 +32,30 @@ struct Measurement
 
     std::atomic<float> value;
 };
+
+// Mean of the values added between two reads, with the same threading as Measurement
+struct AverageMeasurement
+{
+    void reset() noexcept
+    {
+        total.store(0.0f);
+        count.store(0);
+    }
+
+    void add(float newValue) noexcept
+    {
+        auto oldTotal = total.load();
+        while (!total.compare_exchange_weak(oldTotal, oldTotal + newValue));
+        count.fetch_add(1);
+    }
+
+    float readAndReset() noexcept
+    {
+        auto numValues = count.exchange(0);
+        auto sum = total.exchange(0.0f);
+        return numValues > 0 ? sum / float(numValues) : 0.0f;
+    }
+
+    std::atomic<float> total{ 0.0f };
+    std::atomic<int> count{ 0 };
+};
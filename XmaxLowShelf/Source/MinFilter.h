@@ -11,12 +11,33 @@
 #pragma once
 #include <vector>
 #include <limits>
+#include <algorithm>
+#include <cstdint>
+#include <utility>
 
 
 template<typename Sample = float>
 class MinFilter {
 public:
-    MinFilter(int maxSize) : buffer(maxSize), bufferLength(maxSize), head(0), tail(0), currentMin(std::numeric_limits<Sample>::max()) {}
+    MinFilter(int maxSize) : ownedBuffer(size_t(maxSize)), buffer(ownedBuffer.data()), bufferLength(maxSize), head(0), tail(0), currentMin(std::numeric_limits<Sample>::max()) {}
+
+    MinFilter(const MinFilter&) = delete;
+    MinFilter& operator=(const MinFilter&) = delete;
+    MinFilter(MinFilter&&) = default;
+    MinFilter& operator=(MinFilter&&) = default;
+
+    // Number of samples of memory needed for a window of maxSize samples
+    static int getStorageSize(int maxSize) noexcept {
+        return maxSize;
+    }
+
+    // Uses external memory (e.g. carved from a DspArena) of getStorageSize(maxSize) samples, and resets the filter
+    void setStorage(Sample* data, int maxSize) noexcept {
+        buffer = data;
+        bufferLength = maxSize;
+        windowSize = 0;
+        reset();
+    }
 
     // Sets a new size for the window (resizes looking window for the minimum if needed)
     void set(int newSize) {
@@ -66,12 +87,17 @@ public:
 
     // Resets the filter
     void reset() {
-        std::fill(buffer.begin(), buffer.end(), max);
+        std::fill(buffer, buffer + bufferLength, max);
         head = tail = 0;
         currentMin = max; //because the maximum value of the gain computer is 1.0f.
         currentSize = 0;
     }
 
+    // Number of samples read to recalculate the minimum since the last call, for the profiler
+    int64_t takeNumScanned() noexcept {
+        return std::exchange(numScanned, int64_t(0));
+    }
+
     void setMax(Sample newMax) {
         max = newMax;
         recalculateMin();
@@ -87,10 +113,12 @@ private:
                 currentMin = buffer[index];
             }
         }
+        numScanned += currentSize;
         needsRecalculation = false;
     }
 
-    std::vector<Sample> buffer;
+    std::vector<Sample> ownedBuffer; // unused when the memory is external
+    Sample* buffer;
     int bufferLength;
     int windowSize = 0;
     int head = 0;             // Index of the newest element
@@ -99,4 +127,5 @@ private:
     Sample max = 1.0f;		  // Maximum value that it is possible to have in the input buffer -> 1.0f if we process gain computer output
     int currentSize = 0;      // Current number of elements in the window
     bool needsRecalculation = false;
+    int64_t numScanned = 0;
 };
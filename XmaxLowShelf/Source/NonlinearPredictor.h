@@ -0,0 +1,135 @@
+/*
+  ==============================================================================
+
+    NonlinearPredictor.h
+    Created: 19 Oct 2026 6:41:12pm
+    Author:  eliot
+
+    Displacement of the driver for the gain computer, with the force factor
+    and the stiffness of the suspension varying with the excursion. The X/U
+    filter is exact for small signals only: near Xmax, Bl falls and the
+    suspension stiffens, and the linear prediction is wrong exactly when the
+    protection matters. Le is neglected, as in the X/U filter:
+
+        Mms dv/dt = Bl(x)/Re (u - Bl(x) v) - Rms v - Kms(x) x
+
+    Bl(x) and Kms(x) are evaluated in Horner form at the displacement of the
+    previous sample, then the equation is stepped by the trapezoidal rule:
+    with constant Bl and Kms, the prediction is the one of the bilinear X/U
+    filter.
+
+    The channels are processed together, the state of each variable stored
+    channel by channel, so that they are computed by the same vector
+    instructions.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include "Parameters.h"
+
+template<typename Sample = float, int numChannels = 2>
+class NonlinearPredictor {
+public:
+    // Relative variation with the displacement x in mm, without the constant term:
+    // Bl(x) = Bl (1 + bl[0] x + bl[1] x^2 + bl[2] x^3 + bl[3] x^4), and Kms(x) as well
+    static constexpr int order = 4;
+    using Polynomial = std::array<Sample, order>;
+
+    // The driver at this sample rate. Real-time safe.
+    void prepare(const LoudspeakerModel& model, double sampleRate) noexcept
+    {
+        double h = 0.5 / sampleRate;
+
+        //per unit of mass, times the half step
+        force = Sample(h * model.Bl / (model.Rec * model.Mms));
+        electricalDamping = Sample(h * model.Bl * model.Bl / (model.Rec * model.Mms));
+        mechanicalDamping = Sample(h * model.Rms / model.Mms);
+        stiffness = Sample(h * h / (model.Cms * model.Mms));
+        halfStep = Sample(h);
+        twoPerHalfStep = Sample(2 / h);
+    }
+
+    // Typical curves of a driver of this Xmax (mm), as defined by Klippel: Bl falls to 82 %
+    // and the compliance to 75 % at Xmax, a little more outwards than inwards. Linear if 0.
+    void setXmax(float xmax) noexcept
+    {
+        if (xmax <= 0.0f) {
+            setNonlinearity({}, {});
+            return;
+        }
+        Sample x2 = Sample(xmax) * Sample(xmax);
+        setNonlinearity({ Sample(-0.02) / Sample(xmax), Sample(-0.18) / x2, 0, 0 },
+                        { 0, Sample(1 / 0.75 - 1) / x2, 0, 0 });
+    }
+
+    void setNonlinearity(const Polynomial& newBl, const Polynomial& newKms) noexcept
+    {
+        bl = newBl;
+        kms = newKms;
+    }
+
+    void reset() noexcept
+    {
+        state = State();
+    }
+
+    // Tension at the terminals in V to displacement in m, one sample of every channel in place
+    void processSample(Sample* frame) noexcept
+    {
+        auto& s = state;
+
+        for (int channel = 0; channel < numChannels; ++channel) {
+            Sample u = frame[channel];
+            Sample x = s.x[channel], v = s.v[channel];
+
+            Sample mm = x * Sample(1e3);
+            Sample blFactor = std::max(Sample(1) + mm * (bl[0] + mm * (bl[1] + mm * (bl[2] + mm * bl[3]))), minFactor);
+            Sample kmsFactor = std::max(Sample(1) + mm * (kms[0] + mm * (kms[1] + mm * (kms[2] + mm * kms[3]))), minFactor);
+
+            //the unknown is the sum of the velocities at both ends of the step
+            Sample k = stiffness * kmsFactor;
+            Sample a = 1 + mechanicalDamping + electricalDamping * blFactor * blFactor + k;
+            Sample S = (2 * v + force * blFactor * (u + s.u[channel]) - twoPerHalfStep * k * x) / a;
+
+            s.x[channel] = x + halfStep * S;
+            s.v[channel] = S - v;
+            s.u[channel] = u;
+            frame[channel] = s.x[channel];
+        }
+    }
+
+    void processSample(Sample& sampleL, Sample& sampleR) noexcept
+    {
+        static_assert(numChannels == 2, "stereo predictor only");
+        Sample frame[2] = { sampleL, sampleR };
+        processSample(frame);
+        sampleL = frame[0];
+        sampleR = frame[1];
+    }
+
+    Sample processSample(Sample x) noexcept
+    {
+        static_assert(numChannels == 1, "mono predictor only");
+        processSample(&x);
+        return x;
+    }
+
+private:
+    static constexpr Sample minFactor = Sample(0.05); // Bl and Kms kept positive far beyond Xmax
+
+    struct State {
+        std::array<Sample, numChannels> x{}, v{}, u{};
+    };
+
+    Polynomial bl{}, kms{};
+
+    Sample force = 0, electricalDamping = 0, mechanicalDamping = 0, stiffness = 0;
+    Sample halfStep = 1, twoPerHalfStep = 2;
+
+    State state;
+};
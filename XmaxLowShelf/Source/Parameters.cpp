@@ -20,6 +20,31 @@ const std::map<juce::String, LoudspeakerModel> Parameters::speakerModelData = {
     { "SB 10PGC21-4",       LoudspeakerModel(  89,   3.4,  0.15e-3, 11.2,  1.01, 0.92,  2.8e-3, 1.14e-3,  2.3,  1.2e-3,   27e-4) }
 };
 
+// Same order as the choices of the speaker model parameter
+const std::vector<const LoudspeakerModel*> Parameters::speakerModelsByIndex = [] {
+    std::vector<const LoudspeakerModel*> models;
+    for (const auto& name : SpeakerModels::modelNames)
+        models.push_back(&speakerModelData.at(name));
+    return models;
+}();
+
+static void getRawValue(juce::AudioProcessorValueTreeState& apvts,
+    const juce::ParameterID& id, std::atomic<float>*& destination)
+{
+    destination = apvts.getRawParameterValue(id.getParamID());
+    jassert(destination);  // parameter does not exist
+}
+
+// Converts a parameter in decibels to a linear gain, only when it changed since the last block
+static void updateGain(const std::atomic<float>* value, float& lastDecibels, float& gain) noexcept
+{
+    float decibels = value->load(std::memory_order_relaxed);
+    if (decibels != lastDecibels) {
+        lastDecibels = decibels;
+        gain = juce::Decibels::decibelsToGain(decibels);
+    }
+}
+
 template<typename T>
 static void castParameter(juce::AudioProcessorValueTreeState& apvts,
     const juce::ParameterID& id, T& destination)
@@ -63,22 +88,27 @@ static juce::String stringFromPercent(float value, int)
 
 Parameters::Parameters(juce::AudioProcessorValueTreeState& apvts)
 {
-    castParameter(apvts, inputGainParamID, inputGainParam);
-    castParameter(apvts, stereoParamID, stereoParam);
+    getRawValue(apvts, inputGainParamID, inputGainValue);
+    getRawValue(apvts, stereoParamID, stereoValue);
 
     castParameter(apvts, speakerModelParamID, speakerModelParam);
-    castParameter(apvts, speakerGainParamID, speakerGainParam);
+    getRawValue(apvts, speakerModelParamID, speakerModelValue);
+    getRawValue(apvts, speakerGainParamID, speakerGainValue);
 
-    castParameter(apvts, attackTimeParamID, attackTimeParam);
-    castParameter(apvts, holdTimeParamID, holdTimeParam);
-    castParameter(apvts, releaseTimeParamID, releaseTimeParam);
+    getRawValue(apvts, attackTimeParamID, attackTimeValue);
+    getRawValue(apvts, holdTimeParamID, holdTimeValue);
+    getRawValue(apvts, releaseTimeParamID, releaseTimeValue);
+    getRawValue(apvts, fixedLatencyParamID, fixedLatencyValue);
 
     castParameter(apvts, filterModeParamID, filterModeParam);
-    castParameter(apvts, thresholdDisplacementParamID, thresholdDisplacementParam);
-    castParameter(apvts, kneeParamID, kneeParam);
-
-    castParameter(apvts, mixParamID, mixParam);
-    castParameter(apvts, gainParamID, gainParam);
+    getRawValue(apvts, filterModeParamID, filterModeValue);
+    getRawValue(apvts, thresholdDisplacementParamID, thresholdDisplacementValue);
+    getRawValue(apvts, kneeParamID, kneeValue);
+    getRawValue(apvts, nonlinearPredictionParamID, nonlinearPredictionValue);
+    getRawValue(apvts, xmaxParamID, xmaxValue);
+
+    getRawValue(apvts, mixParamID, mixValue);
+    getRawValue(apvts, gainParamID, gainValue);
 }
 
 juce::AudioProcessorValueTreeState::ParameterLayout Parameters::createParameterLayout()
@@ -99,8 +129,10 @@ juce::AudioProcessorValueTreeState::ParameterLayout Parameters::createParameterL
 
     //==============================================================================
 
+    auto speakerModelNames = SpeakerModels::modelNames;
+    speakerModelNames.add(SpeakerModels::customModelName);
     layout.add(std::make_unique<juce::AudioParameterChoice>(
-        speakerModelParamID, "Speaker Model", SpeakerModels::modelNames, 0));
+        speakerModelParamID, "Speaker Model", speakerModelNames, 0));
 
     layout.add(std::make_unique<juce::AudioParameterFloat>(
         speakerGainParamID,
@@ -135,6 +167,9 @@ juce::AudioProcessorValueTreeState::ParameterLayout Parameters::createParameterL
         juce::AudioParameterFloatAttributes().withStringFromValueFunction(stringFromMilliseconds)
     ));
 
+    layout.add(std::make_unique<juce::AudioParameterBool>(
+        fixedLatencyParamID, "Fixed Latency", false));
+
     //==============================================================================
 
     layout.add(std::make_unique<juce::AudioParameterChoice>(
@@ -157,6 +192,17 @@ juce::AudioProcessorValueTreeState::ParameterLayout Parameters::createParameterL
         juce::AudioParameterFloatAttributes().withStringFromValueFunction(stringFromPercent)
     ));
 
+    layout.add(std::make_unique<juce::AudioParameterBool>(
+        nonlinearPredictionParamID, "Nonlinear Prediction", false));
+
+    layout.add(std::make_unique<juce::AudioParameterFloat>(
+        xmaxParamID,
+        "Xmax",
+        juce::NormalisableRange<float> { minDisplacementThreshold, maxDisplacementThreshold, 0.01f, 0.25f },
+        3.0f,
+        juce::AudioParameterFloatAttributes().withStringFromValueFunction(stringFromMillimeters)
+    ));
+
     //==============================================================================
     layout.add(std::make_unique<juce::AudioParameterFloat>(
         gainParamID,
@@ -177,33 +223,38 @@ juce::AudioProcessorValueTreeState::ParameterLayout Parameters::createParameterL
     return layout;
 }
 
-void Parameters::prepareToPlay(double sampleRate) noexcept
+void Parameters::prepareToPlay(double newSampleRate) noexcept
 {
     double duration = 0.02;
-
-    inputGainSmoother.reset(sampleRate, duration);
-    speakerGainSmoother.reset(sampleRate, duration);
-    thresholdDisplacementSmoother.reset(sampleRate, duration);
-    kneeSmoother.reset(sampleRate, duration);
-    gainSmoother.reset(sampleRate, duration);
-    mixSmoother.reset(sampleRate, duration);
-
-
-    smoothingCoeff = 1.0f - std::exp(-1.0f / (0.1f * float(sampleRate)));
+    sampleRate = float(newSampleRate);
+    
+    inputGainSmoother.reset(newSampleRate, duration);
+    speakerGainSmoother.reset(newSampleRate, duration);
+    thresholdDisplacementSmoother.reset(newSampleRate, duration);
+    kneeSmoother.reset(newSampleRate, duration);
+    gainSmoother.reset(newSampleRate, duration);
+    mixSmoother.reset(newSampleRate, duration);
+
+
+    smoothingCoeff = 1.0f - std::exp(-1.0f / (0.1f * sampleRate));
+    lastReleaseTime = std::numeric_limits<float>::quiet_NaN(); //the release coefficient depends on the sample rate
 }
 
 void Parameters::reset() noexcept
 {
+    update();
+
     inputGain = 0.0f;
-    inputGainSmoother.setCurrentAndTargetValue(juce::Decibels::decibelsToGain(inputGainParam->get()));
+    inputGainSmoother.setCurrentAndTargetValue(snapshot.inputGain);
 
     speakerGain = 0.0f;
-    speakerGainSmoother.setCurrentAndTargetValue(juce::Decibels::decibelsToGain(speakerGainParam->get()));
+    speakerGainSmoother.setCurrentAndTargetValue(snapshot.speakerGain);
+
 
     thresholdDisplacement = 1.0f;
-    thresholdDisplacementSmoother.setCurrentAndTargetValue(thresholdDisplacementParam->get());
+    thresholdDisplacementSmoother.setCurrentAndTargetValue(snapshot.thresholdDisplacement);
     knee = 0.0f;
-    kneeSmoother.setCurrentAndTargetValue(kneeParam->get());
+    kneeSmoother.setCurrentAndTargetValue(snapshot.knee);
 
 
     attackTime = 0.0f;
@@ -211,36 +262,57 @@ void Parameters::reset() noexcept
     releaseTime = 0.0f;
 
     gain = 0.0f;
-    gainSmoother.setCurrentAndTargetValue(juce::Decibels::decibelsToGain(gainParam->get()));
+    gainSmoother.setCurrentAndTargetValue(snapshot.gain);
     mix = 1.0f;
-    mixSmoother.setCurrentAndTargetValue(mixParam->get() * 0.01f);
+    mixSmoother.setCurrentAndTargetValue(snapshot.mix);
 }
 
-void Parameters::update() noexcept
+ParameterSnapshot Parameters::update() noexcept
 {
+    //read every parameter once for this block
+    updateGain(inputGainValue, lastInputGain, snapshot.inputGain);
+    updateGain(speakerGainValue, lastSpeakerGain, snapshot.speakerGain);
+    updateGain(gainValue, lastGain, snapshot.gain);
+
+    snapshot.thresholdDisplacement = thresholdDisplacementValue->load(std::memory_order_relaxed);
+    snapshot.knee = kneeValue->load(std::memory_order_relaxed) * 0.01f;
+    snapshot.nonlinearPrediction = nonlinearPredictionValue->load(std::memory_order_relaxed) >= 0.5f;
+    snapshot.xmax = xmaxValue->load(std::memory_order_relaxed);
+    snapshot.mix = mixValue->load(std::memory_order_relaxed) * 0.01f;
+
+    snapshot.attackTime = attackTimeValue->load(std::memory_order_relaxed);
+    snapshot.holdTime = holdTimeValue->load(std::memory_order_relaxed);
+    snapshot.releaseTime = releaseTimeValue->load(std::memory_order_relaxed);
+
+    snapshot.filterMode = int(filterModeValue->load(std::memory_order_relaxed));
+    snapshot.speakerModel = int(speakerModelValue->load(std::memory_order_relaxed));
+    snapshot.stereo = stereoValue->load(std::memory_order_relaxed) >= 0.5f;
+    snapshot.fixedLatency = fixedLatencyValue->load(std::memory_order_relaxed) >= 0.5f;
+
+    inputGainSmoother.setTargetValue(snapshot.inputGain);
+    speakerGainSmoother.setTargetValue(snapshot.speakerGain);
+    thresholdDisplacementSmoother.setTargetValue(snapshot.thresholdDisplacement);
+    kneeSmoother.setTargetValue(snapshot.knee);
+    gainSmoother.setTargetValue(snapshot.gain);
+    mixSmoother.setTargetValue(snapshot.mix);
 
-    inputGainSmoother.setTargetValue(juce::Decibels::decibelsToGain(inputGainParam->get()));
-    speakerGainSmoother.setTargetValue(juce::Decibels::decibelsToGain(speakerGainParam->get()));
-    thresholdDisplacementSmoother.setTargetValue(thresholdDisplacementParam->get());
-    kneeSmoother.setTargetValue(kneeParam->get() * 0.01f);
-    gainSmoother.setTargetValue(juce::Decibels::decibelsToGain(gainParam->get()));
-    mixSmoother.setTargetValue(mixParam->get() * 0.01f);
-
-    targetAttackTime = attackTimeParam->get();
     if (attackTime == 0.0f) {
-        attackTime = targetAttackTime;
+        attackTime = snapshot.attackTime;
     }
-    targetHoldTime = holdTimeParam->get();
     if (holdTime == 0.0f) {
-        holdTime = targetHoldTime;
-    }
-    targetReleaseTime = releaseTimeParam->get();
+		holdTime = snapshot.holdTime;
+	}
     if (releaseTime == 0.0f) {
-        releaseTime = targetReleaseTime;
+        releaseTime = snapshot.releaseTime;
+    }
+
+    //the release time is smoothed, so the coefficient only changes while it moves
+    if (releaseTime != lastReleaseTime) {
+        lastReleaseTime = releaseTime;
+        snapshot.releaseCoeff = 1 - std::exp(-2.2f / (sampleRate * releaseTime * 0.001f));
     }
 
-    filterMode = filterModeParam->getIndex();
-    speakerModel = speakerModelParam->getIndex();
+    return snapshot;
 }
 
 void Parameters::smoothen() noexcept
@@ -255,7 +327,7 @@ void Parameters::smoothen() noexcept
     gain = gainSmoother.getNextValue();
     mix = mixSmoother.getNextValue();
 
-    attackTime += (targetAttackTime - attackTime) * smoothingCoeff;
-    holdTime += (targetHoldTime - holdTime) * smoothingCoeff;
-    releaseTime += (targetReleaseTime - releaseTime) * smoothingCoeff;
+    attackTime += (snapshot.attackTime - attackTime) * smoothingCoeff;
+    holdTime += (snapshot.holdTime - holdTime) * smoothingCoeff;
+    releaseTime += (snapshot.releaseTime - releaseTime) * smoothingCoeff;
 }
@@ -11,9 +11,13 @@
 #pragma once
 
 #include <JuceHeader.h>
+#include <atomic>
+#include <limits>
+#include <vector>
 
 
 static constexpr double pi = juce::MathConstants<double>::pi;
+static constexpr double rhoC2 = 1.18 * 345.0 * 345.0; // air density times the speed of sound squared, Pa
 
 struct LoudspeakerModel {
     double fs;
@@ -36,6 +40,22 @@ struct LoudspeakerModel {
         Bl(Bl), Vas(Vas), Sd(Sd) {}
 };
 
+// Model from the parameters of a datasheet or a measurement: Mms or Cms may be zero, and is
+// then derived from the other one and fs; Bl is derived from Qes if zero, Qts and Vas always
+inline LoudspeakerModel makeLoudspeakerModel(double fs, double Rec, double Lec, double Qms, double Qes, double Mms, double Cms, double Bl, double Sd) {
+    double w = 2 * pi * fs;
+    if (Cms <= 0)
+        Cms = 1 / (w * w * Mms);
+    if (Mms <= 0)
+        Mms = 1 / (w * w * Cms);
+    if (Bl <= 0)
+        Bl = std::sqrt(w * Mms * Rec / Qes);
+
+    double Qts = Qms * Qes / (Qms + Qes);
+    double Vas = rhoC2 * Sd * Sd * Cms;
+    return LoudspeakerModel(fs, Rec, Lec, Qms, Qes, Qts, Mms, Cms, Bl, Vas, Sd);
+}
+
 //input section
 const juce::ParameterID inputGainParamID{ "inputGain", 1 };
 const juce::ParameterID stereoParamID{ "stereo", 1 };
@@ -46,13 +66,18 @@ const juce::ParameterID speakerGainParamID{ "speakerGain", 1 };
 const juce::ParameterID attackTimeParamID{ "attackTime", 1 };
 const juce::ParameterID holdTimeParamID{ "holdTime", 1 };
 const juce::ParameterID releaseTimeParamID{ "releaseTime", 1 };
+const juce::ParameterID fixedLatencyParamID{ "fixedLatency", 1 };
 //gain computer section
 const juce::ParameterID filterModeParamID{ "filterMode", 1 };
 const juce::ParameterID thresholdDisplacementParamID{ "thresholdDisplacement", 1 };
 const juce::ParameterID kneeParamID{ "knee", 1 };
+const juce::ParameterID nonlinearPredictionParamID{ "nonlinearPrediction", 1 };
+const juce::ParameterID xmaxParamID{ "xmax", 1 };
 //output section
 const juce::ParameterID gainParamID{ "gain", 1 };
 const juce::ParameterID mixParamID{ "mix", 1 };
+//saved with the state, besides the parameters
+const juce::Identifier customDriverID{ "CustomDriver" };
 
 namespace SpeakerModels
 {
@@ -63,12 +88,42 @@ namespace SpeakerModels
                                             "Dayton DCS165-4", 
                                             "B&C 15FW76-4",
                                             "SB 10PGC21-4"};
+
+    // Last choice of the parameter: the model entered in the editor
+    const juce::String customModelName = "Custom driver";
 }
 namespace FilterModes
 {
     const juce::StringArray modeNames = { "Low-shelf", "Gain" };
 }
 
+// Values of the parameters for one block, read once from the APVTS atomics and passed
+// by value to the processing kernel. Derived values (linear gains, release coefficient)
+// are only computed again when their source parameter changed.
+struct ParameterSnapshot
+{
+    float inputGain = 1.0f;             // linear gain
+    float speakerGain = 1.0f;           // linear gain
+
+    float attackTime = 0.0f;            // targets of the smoothed times, in ms
+    float holdTime = 0.0f;
+    float releaseTime = 0.0f;
+    float releaseCoeff = 0.0f;          // one-pole coefficient of the smoothed release time
+
+    int filterMode = 1;
+    float thresholdDisplacement = 1.0f; // mm
+    float knee = 0.0f;                  // 0 to 1
+    bool nonlinearPrediction = false;   // the gain computer follows the excursion of a nonlinear driver
+    float xmax = 3.0f;                  // mm, of the typical nonlinear curves
+
+    float gain = 1.0f;                  // linear gain
+    float mix = 1.0f;                   // 0 to 1
+
+    int speakerModel = 0;
+    bool stereo = true;
+    bool fixedLatency = false;          // look-ahead fixed at maxAttackTime, reported to the host
+};
+
 class Parameters
 {
 public:
@@ -78,22 +133,31 @@ public:
 
     void prepareToPlay(double sampleRate) noexcept;
     void reset() noexcept;
-    void update() noexcept;
+    ParameterSnapshot update() noexcept;
     void smoothen() noexcept;
 
     static const std::map<juce::String, LoudspeakerModel> speakerModelData;
 
+    // Model at this index of SpeakerModels::modelNames, without any string copy or lookup (audio thread)
+    static const LoudspeakerModel& getSpeakerModel(int modelIndex) noexcept
+    {
+        return *speakerModelsByIndex[size_t(modelIndex)];
+    }
+
+    static int getNumSpeakerModels() noexcept { return SpeakerModels::modelNames.size(); }
+
+    // The custom driver, whose model is not here but in the processor (see setCustomModel)
+    static bool isCustomModel(int modelIndex) noexcept { return modelIndex >= getNumSpeakerModels(); }
+
+    // smoothed values, updated for each sample by smoothen()
     float inputGain = 0.0f;
-    bool stereo = true;
 
-    int speakerModel = 0;
     float speakerGain = 0.0f;
 
     float attackTime = 0.02f;
     float holdTime = 0.0f;
     float releaseTime = 0.0f;
 
-    int filterMode = 1;
     float knee = 0.0f;
     float thresholdDisplacement = 1.0f;
 
@@ -107,37 +171,46 @@ public:
     static constexpr float minReleaseTime = 0.0f;
     static constexpr float maxReleaseTime = 4000.0f;
 
+    static constexpr double maxSampleRate = 384000.0; //the DSP state is allocated once for this rate
+
     static constexpr float minDisplacementThreshold = 0.11f; //displacement in mm.
     static constexpr float maxDisplacementThreshold = 30.0f;
 
     juce::AudioParameterChoice* speakerModelParam;
     juce::AudioParameterChoice* filterModeParam;
 private:
+    static const std::vector<const LoudspeakerModel*> speakerModelsByIndex;
+
+    // raw values of the parameters, in their own units (dB, ms, %, index)
+    std::atomic<float>* inputGainValue;
+    std::atomic<float>* stereoValue;
+    std::atomic<float>* speakerModelValue;
+    std::atomic<float>* speakerGainValue;
+    std::atomic<float>* attackTimeValue;
+    std::atomic<float>* holdTimeValue;
+    std::atomic<float>* releaseTimeValue;
+    std::atomic<float>* fixedLatencyValue;
+    std::atomic<float>* filterModeValue;
+    std::atomic<float>* thresholdDisplacementValue;
+    std::atomic<float>* kneeValue;
+    std::atomic<float>* nonlinearPredictionValue;
+    std::atomic<float>* xmaxValue;
+    std::atomic<float>* gainValue;
+    std::atomic<float>* mixValue;
 
-    juce::AudioParameterFloat* inputGainParam;
     juce::LinearSmoothedValue<float> inputGainSmoother;
-    juce::AudioParameterBool* stereoParam;
-
-
-    juce::AudioParameterFloat* speakerGainParam;
     juce::LinearSmoothedValue<float> speakerGainSmoother;
-
-    juce::AudioParameterFloat* thresholdDisplacementParam;
     juce::LinearSmoothedValue<float> thresholdDisplacementSmoother;
-    juce::AudioParameterFloat* kneeParam;
     juce::LinearSmoothedValue<float> kneeSmoother;
-
-    juce::AudioParameterFloat* gainParam;
     juce::LinearSmoothedValue<float> gainSmoother;
-    juce::AudioParameterFloat* mixParam;
     juce::LinearSmoothedValue<float> mixSmoother;
 
-    juce::AudioParameterFloat* attackTimeParam;
-    juce::AudioParameterFloat* holdTimeParam;
-    juce::AudioParameterFloat* releaseTimeParam;
+    ParameterSnapshot snapshot;
+    float lastInputGain = std::numeric_limits<float>::quiet_NaN(); //in dB, to detect the changes
+    float lastSpeakerGain = std::numeric_limits<float>::quiet_NaN();
+    float lastGain = std::numeric_limits<float>::quiet_NaN();
+    float lastReleaseTime = std::numeric_limits<float>::quiet_NaN();
+    float sampleRate = 44100.0f;
 
-    float targetAttackTime = 0.0f;
-    float targetHoldTime = 0.0f;
-    float targetReleaseTime = 0.0f;
     float smoothingCoeff = 0.0f;  // one-pole smoothing
 };
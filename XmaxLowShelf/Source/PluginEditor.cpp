@@ -14,7 +14,8 @@ XmaxLowShelfAudioProcessorEditor::XmaxLowShelfAudioProcessorEditor (XmaxLowShelf
     : AudioProcessorEditor (&p),
     audioProcessor(p),
     meter(p.levelL, p.levelR),
-    displacementMeter(p.displacementLevelL, p.displacementLevelR, p.params.thresholdDisplacement)
+    displacementMeter(p.displacementLevelL, p.displacementLevelR, p.params.thresholdDisplacement),
+    loadMeter(p.dspLoadPeak, p.dspLoadAverage)
 {
 
     inputGroup.setText("Input");
@@ -29,6 +30,15 @@ XmaxLowShelfAudioProcessorEditor::XmaxLowShelfAudioProcessorEditor (XmaxLowShelf
         };
     stereoButton.setLookAndFeel(ButtonLookAndFeel::get());
     inputGroup.addAndMakeVisible(stereoButton);
+    latencyButton.setClickingTogglesState(true);
+    latencyButton.setBounds(0, 0, 70, 27);
+    latencyButton.onClick = [this]() {
+        if (latencyButton.getToggleState()) { latencyButton.setButtonText("Fixed Lat."); }
+        else { latencyButton.setButtonText("Min. Lat."); }
+    };
+    latencyButton.onClick();
+    latencyButton.setLookAndFeel(ButtonLookAndFeel::get());
+    inputGroup.addAndMakeVisible(latencyButton);
     addAndMakeVisible(inputGroup);
 
 
@@ -36,7 +46,7 @@ XmaxLowShelfAudioProcessorEditor::XmaxLowShelfAudioProcessorEditor (XmaxLowShelf
     speakerGroup.setTextLabelPosition(juce::Justification::horizontallyCentred);
     speakerGroup.addAndMakeVisible(speakerGainKnob);
     speakerModelComboBox.setBounds(0, 0, 70, 27);
-    speakerModelComboBox.addItemList(SpeakerModels::modelNames, 1);
+    speakerModelComboBox.addItemList(audioProcessor.params.speakerModelParam->choices, 1);
     speakerModelComboBox.setSelectedItemIndex(audioProcessor.params.speakerModelParam->getIndex(), juce::dontSendNotification);
     speakerModelComboBox.setLookAndFeel(ComboBoxLookAndFeel::get());
     speakerComboBoxLabel.setText("Driver Model", juce::dontSendNotification);
@@ -45,6 +55,11 @@ XmaxLowShelfAudioProcessorEditor::XmaxLowShelfAudioProcessorEditor (XmaxLowShelf
     speakerComboBoxLabel.attachToComponent(&speakerModelComboBox, false);
     speakerGroup.addAndMakeVisible(speakerModelComboBox);
     speakerGroup.addAndMakeVisible(speakerComboBoxLabel);
+    customDriverButton.setButtonText("Custom...");
+    customDriverButton.setBounds(0, 0, 70, 20);
+    customDriverButton.onClick = [this]() { showCustomDriverPanel(); };
+    customDriverButton.setLookAndFeel(ButtonLookAndFeel::get());
+    speakerGroup.addAndMakeVisible(customDriverButton);
     speakerGroup.addAndMakeVisible(displacementMeter);
     addAndMakeVisible(speakerGroup);
 
@@ -92,6 +107,11 @@ XmaxLowShelfAudioProcessorEditor::XmaxLowShelfAudioProcessorEditor (XmaxLowShelf
     websiteLinkButton.setFont(juce::Font(15.0f, 0), false, juce::Justification::centredRight);
     websiteLinkButton.setColour(juce::HyperlinkButton::textColourId, Colors::background);
     addAndMakeVisible(websiteLinkButton);
+    addAndMakeVisible(loadMeter);
+
+   #if XMAX_PIPELINE_TIMING
+    addAndMakeVisible(pipelineOverlay);
+   #endif
 }
 
 XmaxLowShelfAudioProcessorEditor::~XmaxLowShelfAudioProcessorEditor()
@@ -134,9 +154,11 @@ void XmaxLowShelfAudioProcessorEditor::resized()
     // Position the knobs inside the groups
     inputGainKnob.setTopLeftPosition(20, 20);
     stereoButton.setTopLeftPosition(20, inputGainKnob.getBottom() + 70);
+    latencyButton.setTopLeftPosition(20, stereoButton.getBottom() + 10);
 
     speakerGainKnob.setTopLeftPosition(20, 20);
     speakerModelComboBox.setTopLeftPosition(20, speakerGainKnob.getBottom() + 70);
+    customDriverButton.setTopLeftPosition(20, speakerModelComboBox.getBottom() + 5);
     displacementMeter.setBounds(outputGroup.getWidth() - 45, 30, 35, speakerModelComboBox.getBottom() + 3);
 
     attackTimeKnob.setTopLeftPosition(20, 15);
@@ -153,4 +175,34 @@ void XmaxLowShelfAudioProcessorEditor::resized()
 
 
     websiteLinkButton.setBounds(520, 25, 200, 15);
-}
\ No newline at end of file
+    loadMeter.setBounds(websiteLinkButton.getX() - 120, 27, 110, 14);
+
+   #if XMAX_PIPELINE_TIMING
+    pipelineOverlay.setBounds(getLocalBounds().withTrimmedTop(50).reduced(60, 15));
+   #endif
+}
+
+// Edits the custom driver in a call-out box, which selects it when applied
+void XmaxLowShelfAudioProcessorEditor::showCustomDriverPanel()
+{
+    auto panel = std::make_unique<CustomDriverPanel>(audioProcessor.getCustomModel(), [this](const LoudspeakerModel& model) {
+        audioProcessor.setCustomModel(model);
+
+        auto& speakerModelParam = *audioProcessor.params.speakerModelParam;
+        speakerModelParam.beginChangeGesture();
+        speakerModelParam = speakerModelParam.choices.size() - 1;
+        speakerModelParam.endChangeGesture();
+    });
+
+    //a child of the editor, so that it is closed with it
+    juce::CallOutBox::launchAsynchronously(std::move(panel), getLocalArea(&customDriverButton, customDriverButton.getLocalBounds()), this);
+}
+
+#if XMAX_PIPELINE_TIMING
+void XmaxLowShelfAudioProcessorEditor::mouseDown(const juce::MouseEvent& event)
+{
+    //a click on the header shows or hides the stage timings
+    if (event.y < 50)
+        pipelineOverlay.setVisible(!pipelineOverlay.isVisible());
+}
+#endif
@@ -15,6 +15,9 @@
 #include "LookAndFeel.h"
 #include "LevelMeter.h"
 #include "DisplacementMeter.h"
+#include "LoadMeter.h"
+#include "PipelineOverlay.h"
+#include "CustomDriverPanel.h"
 
 //==============================================================================
 /**
@@ -29,7 +32,12 @@ public:
     void paint (juce::Graphics&) override;
     void resized() override;
 
+   #if XMAX_PIPELINE_TIMING
+    void mouseDown(const juce::MouseEvent& event) override;
+   #endif
+
 private:
+    void showCustomDriverPanel();
 
     // This reference is provided as a quick way for your editor to
     // access the processor object that created it.
@@ -52,11 +60,17 @@ private:
     audioProcessor.apvts, stereoParamID.getParamID(), stereoButton
     };
 
+    juce::TextButton latencyButton;
+    juce::AudioProcessorValueTreeState::ButtonAttachment latencyButtonAttachment{
+    audioProcessor.apvts, fixedLatencyParamID.getParamID(), latencyButton
+    };
+
     juce::Label speakerComboBoxLabel;
     juce::ComboBox speakerModelComboBox;
     juce::AudioProcessorValueTreeState::ComboBoxAttachment speakerModelComboBoxAttachment{
     audioProcessor.apvts, speakerModelParamID.getParamID(), speakerModelComboBox
     };
+    juce::TextButton customDriverButton;
 
     juce::Label filterComboBoxLabel;
     juce::ComboBox filterModeComboBox;
@@ -75,4 +89,9 @@ private:
 
     LevelMeter meter;
     DisplacementMeter displacementMeter;
+    LoadMeter loadMeter;
+
+   #if XMAX_PIPELINE_TIMING
+    PipelineOverlay pipelineOverlay{ audioProcessor.pipelineTimes };
+   #endif
 };
@@ -16,9 +16,13 @@ XmaxLowShelfAudioProcessor::XmaxLowShelfAudioProcessor()
         .withInput("Input", juce::AudioChannelSet::stereo(), true)
         .withOutput("Output", juce::AudioChannelSet::stereo(), true)
     ),
-    params(apvts)
+    params(apvts),
+    customModel(Parameters::getSpeakerModel(0)),
+    customMailbox({ customModel, {}, 0.0 }),
+    customSpeaker({ customModel, {}, 0.0 }) //designed in prepareToPlay
 {
-    //do nothing
+    //allocate the DSP state once, large enough for every supported sample rate
+    arena.reserve(getArenaSize(Parameters::maxSampleRate));
 }
 
 XmaxLowShelfAudioProcessor::~XmaxLowShelfAudioProcessor()
@@ -88,20 +92,67 @@ void XmaxLowShelfAudioProcessor::changeProgramName (int index, const juce::Strin
 }
 //==============================================================================
 
-void XmaxLowShelfAudioProcessor::setFiltersCoeffs(const LoudspeakerModel& model, float sampleRate)
+static int getDelayInSamples(float timeInMs, double sampleRate)
 {
-    auto doubleCoeffs = getXUFilterCoefficients(model, sampleRate);
-    std::array<float, 3> b_xu = doubleCoeffs.first;
-    std::array<float, 3> a_xu = doubleCoeffs.second;
+    return int(std::ceil(timeInMs * 0.001f * sampleRate));
+}
+
+// Bytes of DSP state of one instance at this sample rate, with the largest dry block.
+// Must follow the buffers carved in prepareToPlay.
+size_t XmaxLowShelfAudioProcessor::getArenaSize(double sampleRate)
+{
+    int maxDelayInSamplesMinFilter = getDelayInSamples(Parameters::maxAttackTime + Parameters::maxHoldTime, sampleRate);
+    int maxDelayInSamplesSignal = getDelayInSamples(Parameters::maxAttackTime, sampleRate);
+
+    size_t channelSize = DspArena::getAlignedSize<float>(size_t(MinFilter<float>::getStorageSize(maxDelayInSamplesMinFilter)))
+                       + DspArena::getAlignedSize<float>(size_t(BoxFilter<float>::getStorageSize(maxDelayInSamplesSignal)))
+                       + DspArena::getAlignedSize<float>(size_t(DelayLine::getStorageSize(maxDelayInSamplesSignal)))
+                       + DspArena::getAlignedSize<float>(size_t(DelayLine::getStorageSize(maxDelayInSamplesSignal))) // gain padding
+                       + DspArena::getAlignedSize<float>(size_t(DelayLine::getStorageSize(maxDelayInSamplesSignal + maxDryBlockSize)))
+                       + DspArena::getAlignedSize<float>(size_t(maxDryBlockSize));
+
+    return 2 * channelSize;
+}
+
+size_t XmaxLowShelfAudioProcessor::getMemoryFootprint() const noexcept
+{
+    return sizeof(*this) + arena.getCapacity();
+}
+
+SpeakerCoefficients XmaxLowShelfAudioProcessor::getSpeakerCoefficients(int modelIndex, double sampleRate)
+{
+    if (Parameters::isCustomModel(modelIndex))
+        return customSpeaker.coeffs;
 
-    xuFilterInL.setCoefficients(b_xu, a_xu);
-    xuFilterInR.setCoefficients(b_xu, a_xu);
+    if (auto* coeffs = coefficientCache.find(modelIndex, sampleRate))
+        return *coeffs;
 
-    xuFilterOutL.setCoefficients(b_xu, a_xu);
-    xuFilterOutR.setCoefficients(b_xu, a_xu);
+    // the background design is not finished yet, design this model only
+    const auto& model = Parameters::getSpeakerModel(modelIndex);
+    return designSpeakerCoefficients(model, Q, float(sampleRate));
+}
+
+void XmaxLowShelfAudioProcessor::setFiltersCoeffs(SpeakerChain& chain, const SpeakerCoefficients& coeffs)
+{
+    chain.xuFilterInL.setCoefficients(coeffs.bXu, coeffs.aXu);
+    chain.xuFilterInR.setCoefficients(coeffs.bXu, coeffs.aXu);
 
+    chain.xuFilterOutL.setCoefficients(coeffs.bXu, coeffs.aXu);
+    chain.xuFilterOutR.setCoefficients(coeffs.bXu, coeffs.aXu);
+}
+
+// The nonlinear prediction of the gain computer, for the same driver as the filters
+void XmaxLowShelfAudioProcessor::setPredictor(SpeakerChain& chain, int modelIndex, double sampleRate) noexcept
+{
+    const auto& model = Parameters::isCustomModel(modelIndex) ? customSpeaker.model : Parameters::getSpeakerModel(modelIndex);
+    chain.predictor.prepare(model, sampleRate);
+    chain.predictor.setXmax(lastXmax);
+}
+
+void XmaxLowShelfAudioProcessor::setShelfCoeffs(const SpeakerCoefficients& coeffs)
+{
     //set lowShelf filter coefficients
-    auto doubleShelfCoeffs = getLowShelfCoefficients(model.fs, Q, shelfGainL, float(sampleRate));
+    auto doubleShelfCoeffs = getLowShelfCoefficients(coeffs.shelf, shelfGainL);
     std::array<float, 3> b_shelf = doubleShelfCoeffs.first;
     std::array<float, 3> a_shelf = doubleShelfCoeffs.second;
 
@@ -109,11 +160,100 @@ void XmaxLowShelfAudioProcessor::setFiltersCoeffs(const LoudspeakerModel& model,
     lowShelfFilterR.setCoefficients(b_shelf, a_shelf);
 }
 
+XmaxLowShelfAudioProcessor::CustomSpeaker XmaxLowShelfAudioProcessor::designCustomSpeaker(const LoudspeakerModel& model, double sampleRate) const
+{
+    return { model, designSpeakerCoefficients(model, Q, float(sampleRate)), sampleRate };
+}
+
+// Message thread: the design takes a few microseconds, the audio thread only pulls the result
+void XmaxLowShelfAudioProcessor::setCustomModel(const LoudspeakerModel& model)
+{
+    std::lock_guard<std::mutex> lock(customModelLock);
+    customModel = model;
+
+    //before prepareToPlay, the model is designed there
+    double sampleRate = getSampleRate();
+    if (sampleRate > 0.0)
+        customMailbox.push(designCustomSpeaker(model, sampleRate));
+}
+
+LoudspeakerModel XmaxLowShelfAudioProcessor::getCustomModel() const
+{
+    std::lock_guard<std::mutex> lock(customModelLock);
+    return customModel;
+}
+
+// Loads the new model in the spare chain from a clean state. The shelf is shared
+// by both chains and is left untouched, so that it does not jump during the fade.
+void XmaxLowShelfAudioProcessor::startModelSwitch(int modelIndex)
+{
+    auto& nextChain = chains[size_t(1 - activeChain)];
+
+    setFiltersCoeffs(nextChain, getSpeakerCoefficients(modelIndex, getSampleRate()));
+    nextChain.xuFilterInL.reset();
+    nextChain.xuFilterInR.reset();
+    nextChain.xuFilterOutL.reset();
+    nextChain.xuFilterOutR.reset();
+    setPredictor(nextChain, modelIndex, getSampleRate());
+    nextChain.predictor.reset();
+
+    modelSwitch.start();
+}
+
+// New curves of the nonlinear prediction, which starts again from rest when it is turned on
+void XmaxLowShelfAudioProcessor::updatePrediction(ParameterSnapshot snapshot) noexcept
+{
+    for (auto& chain : chains) {
+        chain.predictor.setXmax(snapshot.xmax);
+        if (snapshot.nonlinearPrediction && !lastNonlinearPrediction)
+            chain.predictor.reset();
+    }
+    lastXmax = snapshot.xmax;
+    lastNonlinearPrediction = snapshot.nonlinearPrediction;
+}
+
+// Reports the constant look-ahead to the host in fixed latency mode, and restarts
+// the padding delays with a neutral gain and a silent dry signal
+void XmaxLowShelfAudioProcessor::updateLatency(bool fixedLatency)
+{
+    lastFixedLatency = fixedLatency;
+    setLatencySamples(lastFixedLatency ? fixedLatencySamples : 0);
+
+    gainDelayLineL.reset(1.0f);
+    gainDelayLineR.reset(1.0f);
+    dryDelayLineL.reset();
+    dryDelayLineR.reset();
+}
+
+// Delays the next numSamples (at most dryBlockSize) dry samples by the fixed latency,
+// as two block copies per channel
+void XmaxLowShelfAudioProcessor::delayDryPath(const float* inputL, const float* inputR, int numSamples)
+{
+    dryDelayLineL.write(inputL, numSamples);
+    dryDelayLineR.write(inputR, numSamples);
+    dryDelayLineL.read(dryBufferL, numSamples, fixedLatencySamples);
+    dryDelayLineR.read(dryBufferR, numSamples, fixedLatencySamples);
+}
+
+// Publishes the time of this block relative to its duration, for the load meter of the editor
+void XmaxLowShelfAudioProcessor::updateDspLoad(std::chrono::steady_clock::time_point blockStart, int numSamples) noexcept
+{
+    if (numSamples <= 0)
+        return;
+
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - blockStart;
+    auto load = float(elapsed.count() * getSampleRate() / double(numSamples));
+
+    dspLoadPeak.updateIfGreater(load);
+    dspLoadAverage.add(load);
+}
+
 //==============================================================================
 void XmaxLowShelfAudioProcessor::prepareToPlay (double sampleRate, int samplesPerBlock)
 {
     params.prepareToPlay(sampleRate);
     params.reset();
+    auto snapshot = params.update();
 
 
     // Initialize delay line (circular buffer)
@@ -123,42 +263,90 @@ void XmaxLowShelfAudioProcessor::prepareToPlay (double sampleRate, int samplesPe
     spec.numChannels = 2;
 
 
-    float maxDelayTimeSignal = Parameters::maxAttackTime;
-    float maxDelayTimeMinFilter = Parameters::maxAttackTime + Parameters::maxHoldTime;
-    double numSamplesMinFilter = maxDelayTimeMinFilter * 0.001f * sampleRate;
+    int maxDelayInSamplesMinFilter = getDelayInSamples(Parameters::maxAttackTime + Parameters::maxHoldTime, sampleRate);
+    int maxDelayInSamplesSignal = getDelayInSamples(Parameters::maxAttackTime, sampleRate);
+
+    //the fixed latency is the longest look-ahead, so it does not depend on the attack time
+    fixedLatencySamples = maxDelayInSamplesSignal;
+    dryBlockSize = juce::jlimit(1, maxDryBlockSize, samplesPerBlock);
 
-    double numSamplesSignal = maxDelayTimeSignal * 0.001f * sampleRate;
+    //carve every buffer from the arena, which was allocated for maxSampleRate in the constructor,
+    //left channel first then right channel, so that the state of one channel is contiguous
+    arena.reserve(getArenaSize(sampleRate));
+    arena.clear();
 
-    int maxDelayInSamplesMinFilter = int(std::ceil(numSamplesMinFilter));
-    int maxDelayInSamplesSignal = int(std::ceil(numSamplesSignal));
+    auto carve = [this](int numSamples) { return arena.allocate<float>(size_t(numSamples)); };
 
+    minFilterL.setStorage(carve(MinFilter<float>::getStorageSize(maxDelayInSamplesMinFilter)), maxDelayInSamplesMinFilter);
+    rectFilterL.setStorage(carve(BoxFilter<float>::getStorageSize(maxDelayInSamplesSignal)), maxDelayInSamplesSignal);
+    delayLineL.setStorage(carve(DelayLine::getStorageSize(maxDelayInSamplesSignal)), maxDelayInSamplesSignal);
+    gainDelayLineL.setStorage(carve(DelayLine::getStorageSize(fixedLatencySamples)), fixedLatencySamples);
+    dryDelayLineL.setStorage(carve(DelayLine::getStorageSize(fixedLatencySamples + dryBlockSize)), fixedLatencySamples + dryBlockSize);
+    dryBufferL = carve(dryBlockSize);
 
-    minFilterL = MinFilter<float>(maxDelayInSamplesMinFilter);
-    minFilterR = MinFilter<float>(maxDelayInSamplesMinFilter);
+    minFilterR.setStorage(carve(MinFilter<float>::getStorageSize(maxDelayInSamplesMinFilter)), maxDelayInSamplesMinFilter);
+    rectFilterR.setStorage(carve(BoxFilter<float>::getStorageSize(maxDelayInSamplesSignal)), maxDelayInSamplesSignal);
+    delayLineR.setStorage(carve(DelayLine::getStorageSize(maxDelayInSamplesSignal)), maxDelayInSamplesSignal);
+    gainDelayLineR.setStorage(carve(DelayLine::getStorageSize(fixedLatencySamples)), fixedLatencySamples);
+    dryDelayLineR.setStorage(carve(DelayLine::getStorageSize(fixedLatencySamples + dryBlockSize)), fixedLatencySamples + dryBlockSize);
+    dryBufferR = carve(dryBlockSize);
 
-    delayLineL.setMaximumDelayInSamples(maxDelayInSamplesSignal);
-    delayLineR.setMaximumDelayInSamples(maxDelayInSamplesSignal);
     delayLineL.reset();
     delayLineR.reset();
 
-    rectFilterL.resize(maxDelayInSamplesSignal);
-    rectFilterR.resize(maxDelayInSamplesSignal);
     rectFilterL.reset(1);
     rectFilterR.reset(1);
 
-    //get speaker model to set the coefficients
-    currentSpeakerModel = SpeakerModels::modelNames[params.speakerModel];
-    lastSpeakerModel = currentSpeakerModel;
-    const auto& model = Parameters::speakerModelData.at(currentSpeakerModel);
-    setFiltersCoeffs(model, sampleRate);
+    //the release and the shelf start again from the state of a new instance, so
+    //that nothing of a previous stream is carried over
+    cL = 0.0f;
+    cR = 0.0f;
+    shelfGainL = 0.0f;
+    shelfGainR = 0.0f;
+    lastShelfGainL = 0.0f;
+    lastShelfGainR = 0.0f;
+    lowShelfFilterL.reset();
+    lowShelfFilterR.reset();
+
+    updateLatency(snapshot.fixedLatency);
+
+    //design the coefficients of every speaker model in the background,
+    //and only the current one right now
+    coefficientCache.prepare(sampleRate, Q);
+    customSpeaker = designCustomSpeaker(getCustomModel(), sampleRate);
+    lastSpeakerModel = snapshot.speakerModel;
+
+    auto coeffs = getSpeakerCoefficients(lastSpeakerModel, sampleRate);
+    for (auto& chain : chains) {
+        chain.xuFilterInL.reset();
+        chain.xuFilterInR.reset();
+        chain.xuFilterOutL.reset();
+        chain.xuFilterOutR.reset();
+        chain.predictor.reset();
+    }
+    lastXmax = snapshot.xmax;
+    lastNonlinearPrediction = snapshot.nonlinearPrediction;
+
+    activeChain = 0;
+    setFiltersCoeffs(chains[0], coeffs);
+    setPredictor(chains[0], lastSpeakerModel, sampleRate);
+    setShelfCoeffs(coeffs);
+    modelSwitch.prepare(sampleRate);
 
-    filterProcessorL = [](float input, float gain) { return input; };
-    filterProcessorR = filterProcessorL;
+    shelfPrototype = getLowShelfPrototype(fc, Q, float(sampleRate));
 
     levelL.reset();
     levelR.reset();
     displacementLevelL.reset();
     displacementLevelR.reset();
+    gainReductionL.reset();
+    gainReductionR.reset();
+    dspLoadPeak.reset();
+    dspLoadAverage.reset();
+
+   #if XMAX_PIPELINE_TIMING
+    pipelineTimes.prepare();
+   #endif
 }
 
 void XmaxLowShelfAudioProcessor::releaseResources()
@@ -195,6 +383,7 @@ bool XmaxLowShelfAudioProcessor::isBusesLayoutSupported (const BusesLayout& layo
 
 void XmaxLowShelfAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
 {
+    auto blockStart = std::chrono::steady_clock::now();
     juce::ScopedNoDenormals noDenormals;
     auto totalNumInputChannels = getTotalNumInputChannels();
     auto totalNumOutputChannels = getTotalNumOutputChannels();
@@ -203,60 +392,75 @@ void XmaxLowShelfAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer,
         buffer.clear(i, 0, buffer.getNumSamples());
 
 
-    float maxL = 0.0f;
-    float maxR = 0.0f;
-    float maxDispL = 0.0f;
-    float maxDispR = 0.0f;
-
-    float* channelDataL = buffer.getWritePointer(0);
-    float* channelDataR = buffer.getWritePointer(1);
+    XMAX_STAGE_START(stageTimes);
 
-    float sampleRate = float(getSampleRate());
-
-    params.update();
+    //read every parameter once, the kernel only sees this copy
+    auto snapshot = params.update();
+    XMAX_STAGE_LAP(stageTimes, parameters);
 
+    //a new custom driver is switched to like another model, if it was designed for this rate
+    CustomSpeaker received = customSpeaker;
+    if (customMailbox.pull(received) && received.sampleRate == getSampleRate()) {
+        customSpeaker = received;
+        if (Parameters::isCustomModel(lastSpeakerModel))
+            lastSpeakerModel = -1;
+    }
 
-    float releaseCoeff = 1 - std::exp(-2.2f / (sampleRate * params.releaseTime * 0.001f));
+    //a model change waits for the end of the current crossfade, if any
+    if (snapshot.speakerModel != lastSpeakerModel && !modelSwitch.isActive()) {
+        startModelSwitch(snapshot.speakerModel);
+        lastSpeakerModel = snapshot.speakerModel;
+    }
+    XMAX_STAGE_LAP(stageTimes, modelSwitch);
 
-    currentSpeakerModel = SpeakerModels::modelNames[params.speakerModel];
-    const auto& model = Parameters::speakerModelData.at(currentSpeakerModel);
 
-    if (currentSpeakerModel != lastSpeakerModel) {
-        setFiltersCoeffs(model, sampleRate);
-        lastSpeakerModel = currentSpeakerModel;
+    if (snapshot.fixedLatency != lastFixedLatency) {
+        updateLatency(snapshot.fixedLatency);
     }
+    XMAX_STAGE_LAP(stageTimes, latency);
 
-    if (params.filterMode == 0) { // Low-shelf filter mode
-        filterProcessorL = [this](float input, float gain) -> float {
-            if (shelfGainL != lastShelfGainL) {
-                auto shelfCoeffsL = getLowShelfCoefficients(fc, Q, shelfGainL, getSampleRate());
-                lowShelfFilterL.setCoefficients(shelfCoeffsL.first, shelfCoeffsL.second);
-                lastShelfGainL = shelfGainL;
-            }
-            return lowShelfFilterL.processSample(input);
-            };
-        filterProcessorR = [this](float input, float gain) -> float {
-            if (shelfGainR != lastShelfGainR) {
-                auto shelfCoeffsR = getLowShelfCoefficients(fc, Q, shelfGainR, getSampleRate());
-                lowShelfFilterR.setCoefficients(shelfCoeffsR.first, shelfCoeffsR.second);
-                lastShelfGainR = shelfGainR;
-            }
-            return lowShelfFilterR.processSample(input);
-            };
-    }
-    else { // Simple gain mode
-        filterProcessorL = [](float input, float gain) -> float {
-            return gain * input;
-            };
-        filterProcessorR = filterProcessorL;
+    if (snapshot.xmax != lastXmax || snapshot.nonlinearPrediction != lastNonlinearPrediction) {
+        updatePrediction(snapshot);
     }
 
+    XMAX_PIPELINE_START(pipelineTimes);
+    auto levels = processSamples(snapshot, buffer.getWritePointer(0), buffer.getWritePointer(1), buffer.getNumSamples());
+    XMAX_PIPELINE_FINISH(pipelineTimes);
+    XMAX_STAGE_COUNT(stageTimes, minFilterScans, minFilterL.takeNumScanned() + minFilterR.takeNumScanned());
+    XMAX_STAGE_LAP(stageTimes, samples);
+
+    levelL.updateIfGreater(levels.maxL);
+    levelR.updateIfGreater(levels.maxR);
 
+    displacementLevelL.updateIfGreater(levels.maxDispL);
+    displacementLevelR.updateIfGreater(levels.maxDispR);
 
-    for (int sample = 0; sample < buffer.getNumSamples(); ++sample) {
+    gainReductionL.updateIfGreater(-juce::Decibels::gainToDecibels(levels.minGainL));
+    gainReductionR.updateIfGreater(-juce::Decibels::gainToDecibels(levels.minGainR));
+    XMAX_STAGE_LAP(stageTimes, meters);
+
+    updateDspLoad(blockStart, buffer.getNumSamples());
+}
+
+// Per-sample limiter, with the parameters of this block
+XmaxLowShelfAudioProcessor::BlockLevels XmaxLowShelfAudioProcessor::processSamples(
+    ParameterSnapshot snapshot, float* channelDataL, float* channelDataR, int numSamples) noexcept
+{
+    BlockLevels levels;
+    float sampleRate = float(getSampleRate());
+    float releaseCoeff = snapshot.releaseCoeff;
+    bool shelfMode = snapshot.filterMode == 0;
+
+    for (int sample = 0; sample < numSamples; ++sample) {
         params.smoothen();
 
+        //the dry path is delayed one chunk ahead, before these samples are overwritten
+        if (snapshot.fixedLatency && sample % dryBlockSize == 0) {
+            delayDryPath(channelDataL + sample, channelDataR + sample, std::min(dryBlockSize, numSamples - sample));
+        }
+
         int nAttack = int(std::ceil(params.attackTime * 1e-3f * sampleRate));
+        int nDelay = snapshot.fixedLatency ? fixedLatencySamples : nAttack;
         int nAttackHold = int(std::ceil((params.attackTime + params.holdTime) * 1e-3f * sampleRate));
 
         minFilterL.set(nAttackHold);
@@ -271,26 +475,63 @@ void XmaxLowShelfAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer,
         // apply the input gain
         float inputAmpL = dryL * params.inputGain;
         float inputAmpR = dryR * params.inputGain;
+        XMAX_PIPELINE_LAP(pipelineTimes, inputGain);
 
         delayLineL.write(inputAmpL);
         delayLineR.write(inputAmpR);
+        XMAX_PIPELINE_LAP(pipelineTimes, delay);
+
+        auto& chain = chains[size_t(activeChain)];
+        auto& nextChain = chains[size_t(1 - activeChain)];
+        bool switching = modelSwitch.isActive();
+        float fade = switching ? modelSwitch.getNextWeight() : 0.0f;
+
+        xInL = chain.xuFilterInL.processSample(inputAmpL); 
+        xInR = chain.xuFilterInR.processSample(inputAmpR);
 
-        xInL = xuFilterInL.processSample(inputAmpL); 
-        xInR = xuFilterInR.processSample(inputAmpR);
+        if (switching) {
+            XMAX_STAGE_COUNT(stageTimes, crossfadeSamples, 1);
+
+            //the output plays each look-ahead sample after the fade moved on, so the gain
+            //computer sees the larger of both displacements for the whole switch
+            xInL = std::max(std::abs(xInL), std::abs(nextChain.xuFilterInL.processSample(inputAmpL)));
+            xInR = std::max(std::abs(xInR), std::abs(nextChain.xuFilterInR.processSample(inputAmpR)));
+        }
 
         threshold = params.thresholdDisplacement * 1e-3f; //convert in m
         knee = params.knee;
 
         gain = params.speakerGain;
 
-        gcL = computeGain(std::abs(xInL) * gain, threshold, knee);
-        gcR = computeGain(std::abs(xInR) * gain, threshold, knee);
+        //the gain computer sees the excursion of the nonlinear driver instead
+        float sideL = xInL * gain;
+        float sideR = xInR * gain;
+        if (snapshot.nonlinearPrediction) {
+            sideL = inputAmpL * gain;
+            sideR = inputAmpR * gain;
+            chain.predictor.processSample(sideL, sideR);
+
+            if (switching) {
+                float nextSideL = inputAmpL * gain;
+                float nextSideR = inputAmpR * gain;
+                nextChain.predictor.processSample(nextSideL, nextSideR);
+
+                sideL = std::max(std::abs(sideL), std::abs(nextSideL));
+                sideR = std::max(std::abs(sideR), std::abs(nextSideR));
+            }
+        }
+        XMAX_PIPELINE_LAP(pipelineTimes, xuFilter);
+
+        gcL = computeGain(std::abs(sideL), threshold, knee);
+        gcR = computeGain(std::abs(sideR), threshold, knee);
+        XMAX_PIPELINE_LAP(pipelineTimes, gainComputer);
 
         //store the gain computer function  output in the circular buffers for the minimum filter
         minFilterL.add(gcL);
         minFilterR.add(gcR);
         float minGainL = minFilterL.getMinimum();
         float minGainR = minFilterR.getMinimum();
+        XMAX_PIPELINE_LAP(pipelineTimes, minFilter);
 
         //apply exponential release to the minimum filter output
         cL = std::min(minGainL, (1.0f - releaseCoeff) * cL + releaseCoeff * minGainL);
@@ -301,19 +542,44 @@ void XmaxLowShelfAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer,
         // To prevent this:
         if (cL > 0.999f) cL = 1.0f;
         if (cR > 0.999f) cR = 1.0f;
+        XMAX_PIPELINE_LAP(pipelineTimes, release);
 
         //Apply the averaging filter to the exponential release output.
         gL = rectFilterL(cL);
         gR = rectFilterR(cR);
-
-        //convert the linear gain to dB
-        shelfGainL = 20.0f * std::log10(gL);
-        shelfGainR = 20.0f * std::log10(gR);
-
-        //this big if loop could be simplified by using a function that would return the output of the filter depending on the mode...
-        // Use pre-set filter logic
-        wetL = filterProcessorL(delayLineL.read(nAttack), gL);
-        wetR = filterProcessorR(delayLineR.read(nAttack), gR);
+        XMAX_PIPELINE_LAP(pipelineTimes, boxFilter);
+
+        //pad the gain envelope so that it stays aligned with the fixed look-ahead
+        if (snapshot.fixedLatency) {
+            gainDelayLineL.write(gL);
+            gainDelayLineR.write(gR);
+            int nPadding = std::max(0, fixedLatencySamples - nAttack);
+            gL = gainDelayLineL.read(nPadding);
+            gR = gainDelayLineR.read(nPadding);
+        }
+        levels.minGainL = std::min(levels.minGainL, gL);
+        levels.minGainR = std::min(levels.minGainR, gR);
+        XMAX_PIPELINE_LAP(pipelineTimes, delay);
+
+        if (shelfMode) {
+            //convert the linear gain to dB
+            shelfGainL = 20.0f * std::log10(gL);
+            shelfGainR = 20.0f * std::log10(gR);
+
+            wetL = processShelf(lowShelfFilterL, delayLineL.read(nDelay), shelfGainL, lastShelfGainL);
+            wetR = processShelf(lowShelfFilterR, delayLineR.read(nDelay), shelfGainR, lastShelfGainR);
+        }
+        else { // simple gain mode
+            wetL = gL * delayLineL.read(nDelay);
+            wetR = gR * delayLineR.read(nDelay);
+        }
+        XMAX_PIPELINE_LAP(pipelineTimes, shelfFilter);
+
+        //keep the dry signal aligned with the wet one
+        if (snapshot.fixedLatency) {
+            dryL = dryBufferL[size_t(sample % dryBlockSize)];
+            dryR = dryBufferR[size_t(sample % dryBlockSize)];
+        }
 
         // output processing - not part of the limiter
         float mixL = params.mix * wetL + (1.0f - params.mix) * dryL;
@@ -324,24 +590,45 @@ void XmaxLowShelfAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer,
 
         channelDataL[sample] = outL;
         channelDataR[sample] = outR;
+        XMAX_PIPELINE_LAP(pipelineTimes, output);
 
         //convert the limited signal to displacement to check the displacement level
-        xOutL = xuFilterOutL.processSample(wetL);
-        xOutR = xuFilterOutR.processSample(wetR);
+        xOutL = chain.xuFilterOutL.processSample(wetL);
+        xOutR = chain.xuFilterOutR.processSample(wetR);
+
+        if (switching) {
+            xOutL += fade * (nextChain.xuFilterOutL.processSample(wetL) - xOutL);
+            xOutR += fade * (nextChain.xuFilterOutR.processSample(wetR) - xOutR);
+
+            //the new chain is fully faded in, retire the old one
+            if (modelSwitch.isFinished()) {
+                activeChain = 1 - activeChain;
+                modelSwitch.reset();
+            }
+        }
 
         //output displacement level to display on the displacement level meter
-        maxDispL = std::max(maxDispL, std::abs(xOutL * 1e3f * params.speakerGain));
-        maxDispR = std::max(maxDispR, std::abs(xOutR * 1e3f * params.speakerGain));
+        levels.maxDispL = std::max(levels.maxDispL, std::abs(xOutL * 1e3f * params.speakerGain));
+        levels.maxDispR = std::max(levels.maxDispR, std::abs(xOutR * 1e3f * params.speakerGain));
 
-        maxL = std::max(maxL, std::abs(outL));
-        maxR = std::max(maxR, std::abs(outR));
+        levels.maxL = std::max(levels.maxL, std::abs(outL));
+        levels.maxR = std::max(levels.maxR, std::abs(outR));
+        XMAX_PIPELINE_LAP(pipelineTimes, displacementMeter);
     }
 
-    levelL.updateIfGreater(maxL);
-    levelR.updateIfGreater(maxR);
+    return levels;
+}
 
-    displacementLevelL.updateIfGreater(maxDispL);
-    displacementLevelR.updateIfGreater(maxDispR);
+// Adaptive low-shelf filter of one channel, designed again only when its gain changed
+float XmaxLowShelfAudioProcessor::processShelf(BiquadFilterTDF2<float>& filter, float input, float shelfGain, float& lastShelfGain) noexcept
+{
+    if (shelfGain != lastShelfGain) {
+        XMAX_STAGE_COUNT(stageTimes, shelfDesigns, 1);
+        auto shelfCoeffs = getLowShelfCoefficients(shelfPrototype, shelfGain);
+        filter.setCoefficients(shelfCoeffs.first, shelfCoeffs.second);
+        lastShelfGain = shelfGain;
+    }
+    return filter.processSample(input);
 }
 
 //==============================================================================
@@ -358,7 +645,21 @@ juce::AudioProcessorEditor* XmaxLowShelfAudioProcessor::createEditor()
 //==============================================================================
 void XmaxLowShelfAudioProcessor::getStateInformation (juce::MemoryBlock& destData)
 {
-    copyXmlToBinary(*apvts.state.createXml(), destData);
+    auto state = apvts.copyState();
+
+    auto model = getCustomModel();
+    auto driver = state.getOrCreateChildWithName(customDriverID, nullptr);
+    driver.setProperty("fs", model.fs, nullptr);
+    driver.setProperty("Rec", model.Rec, nullptr);
+    driver.setProperty("Lec", model.Lec, nullptr);
+    driver.setProperty("Qms", model.Qms, nullptr);
+    driver.setProperty("Qes", model.Qes, nullptr);
+    driver.setProperty("Mms", model.Mms, nullptr);
+    driver.setProperty("Cms", model.Cms, nullptr);
+    driver.setProperty("Bl", model.Bl, nullptr);
+    driver.setProperty("Sd", model.Sd, nullptr);
+
+    copyXmlToBinary(*state.createXml(), destData);
 }
 
 void XmaxLowShelfAudioProcessor::setStateInformation(const void* data, int sizeInBytes)
@@ -367,6 +668,12 @@ void XmaxLowShelfAudioProcessor::setStateInformation(const void* data, int sizeI
     if (xml.get() != nullptr && xml->hasTagName(apvts.state.getType()))
     {
         apvts.replaceState(juce::ValueTree::fromXml(*xml));
+
+        auto driver = apvts.state.getChildWithName(customDriverID);
+        if (driver.isValid() && double(driver["fs"]) > 0.0) {
+            setCustomModel(makeLoudspeakerModel(driver["fs"], driver["Rec"], driver["Lec"], driver["Qms"], driver["Qes"],
+                                                driver["Mms"], driver["Cms"], driver["Bl"], driver["Sd"]));
+        }
     }
 }
 //==============================================================================
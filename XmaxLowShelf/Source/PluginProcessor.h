@@ -9,13 +9,20 @@
 #pragma once
 
 #include <JuceHeader.h>
+#include <mutex>
 #include "Parameters.h"
+#include "DspArena.h"
 #include "DelayLine.h"
 #include "BoxFilter.h"
 #include "MinFilter.h"
 #include "BiquadFilter.h"
 #include "FilterDesign.h"
+#include "NonlinearPredictor.h"
+#include "CoefficientCache.h"
+#include "Mailbox.h"
+#include "ModelCrossfade.h"
 #include "Measurement.h"
+#include "StageTimer.h"
 #include "LimiterUtils.h"
 
 //==============================================================================
@@ -70,26 +77,113 @@ public:
 
     Measurement levelL, levelR;
     Measurement displacementLevelL, displacementLevelR;
+    Measurement gainReductionL, gainReductionR; // dB
+
+    // Time spent in processBlock over the duration of the block (1 is the real-time deadline)
+    Measurement dspLoadPeak;
+    AverageMeasurement dspLoadAverage;
+
+    StageTimes stageTimes; // filled by processBlock when built with XMAX_STAGE_TIMING
+
+   #if XMAX_PIPELINE_TIMING
+    PipelineTimes pipelineTimes; // time of each stage of the sample loop, shown by PipelineOverlay
+   #endif
+
+    // Driver of the custom speaker model, entered in the editor. Its X/U filter and shelf are
+    // designed here, on the message thread, and handed to the audio thread through a mailbox.
+    void setCustomModel(const LoudspeakerModel& model);
+    LoudspeakerModel getCustomModel() const;
+
+    // Memory used by this instance, including all of its DSP state, in bytes
+    size_t getMemoryFootprint() const noexcept;
+
+    // The adaptive shelf at fc, designed by prepareToPlay for its sample rate
+    const LowShelfPrototype& getShelfPrototype() const noexcept { return shelfPrototype; }
+
+    static constexpr int maxDryBlockSize = 2048; // longer blocks are delayed in several chunks
+
+    // Peak levels of one processed block, for the meters
+    struct BlockLevels
+    {
+        float maxL = 0.0f;
+        float maxR = 0.0f;
+        float maxDispL = 0.0f; // mm
+        float maxDispR = 0.0f;
+        float minGainL = 1.0f; // lowest gain of the envelope
+        float minGainR = 1.0f;
+    };
+
+    // Processes numSamples stereo samples in place, with the parameters read for this block
+    BlockLevels processSamples(ParameterSnapshot snapshot, float* channelDataL, float* channelDataR, int numSamples) noexcept;
+
 
 private:
-    void setFiltersCoeffs(const LoudspeakerModel& model, float sampleRate);
-    std::function<float(float, float)> filterProcessorL;
-    std::function<float(float, float)> filterProcessorR;
+    static size_t getArenaSize(double sampleRate);
+
+    // Filters that depend on the speaker model. Two chains are kept, so that a
+    // new model can be faded in next to the current one.
+    struct SpeakerChain
+    {
+        BiquadFilterDF1<float> xuFilterInL; // tension to displacement
+        BiquadFilterDF1<float> xuFilterInR;
+        BiquadFilterDF1<float> xuFilterOutL;
+        BiquadFilterDF1<float> xuFilterOutR;
+        NonlinearPredictor<float> predictor; // tension to displacement of the nonlinear driver, for the gain computer
+    };
+
+    // The custom driver with its coefficients for one sample rate
+    struct CustomSpeaker
+    {
+        LoudspeakerModel model;
+        SpeakerCoefficients coeffs;
+        double sampleRate;
+    };
+
+    CustomSpeaker designCustomSpeaker(const LoudspeakerModel& model, double sampleRate) const;
+    SpeakerCoefficients getSpeakerCoefficients(int modelIndex, double sampleRate);
+    void setFiltersCoeffs(SpeakerChain& chain, const SpeakerCoefficients& coeffs);
+    void setPredictor(SpeakerChain& chain, int modelIndex, double sampleRate) noexcept;
+    void setShelfCoeffs(const SpeakerCoefficients& coeffs);
+    void startModelSwitch(int modelIndex);
+    void updateLatency(bool fixedLatency);
+    void updatePrediction(ParameterSnapshot snapshot) noexcept;
+    void updateDspLoad(std::chrono::steady_clock::time_point blockStart, int numSamples) noexcept;
+    void delayDryPath(const float* inputL, const float* inputR, int numSamples);
+    float processShelf(BiquadFilterTDF2<float>& filter, float input, float shelfGain, float& lastShelfGain) noexcept;
+
+    CoefficientCache coefficientCache;
+
+    mutable std::mutex customModelLock; // message thread and state only, never taken by the audio thread
+    LoudspeakerModel customModel;
+    Mailbox<CustomSpeaker> customMailbox;
+    CustomSpeaker customSpeaker; // audio thread copy, used by getSpeakerCoefficients
+    DspArena arena; // holds the buffers of every filter and delay line below
 
     DelayLine delayLineL, delayLineR;
     BoxFilter<float> rectFilterL{ 0 };
     BoxFilter<float> rectFilterR{ 0 };
     MinFilter<float> minFilterL{ 0 };
     MinFilter<float> minFilterR{ 0 };
-    BiquadFilterDF1<float> xuFilterInL; // tension to displacement
-    BiquadFilterDF1<float> xuFilterInR;
-    BiquadFilterDF1<float> xuFilterOutL;
-    BiquadFilterDF1<float> xuFilterOutR;
+
+    // Fixed latency mode: the look-ahead is always fixedLatencySamples long, the gain
+    // envelope is padded to stay aligned with it, and the dry path is delayed to match
+    DelayLine gainDelayLineL, gainDelayLineR;
+    DelayLine dryDelayLineL, dryDelayLineR;
+    float* dryBufferL = nullptr;
+    float* dryBufferR = nullptr;
+    int dryBlockSize = 1;
+    int fixedLatencySamples = 0;
+    bool lastFixedLatency = false;
+
+    std::array<SpeakerChain, 2> chains;
+    int activeChain = 0;
+    ModelCrossfade modelSwitch;
 
     BiquadFilterTDF2<float> lowShelfFilterL; //adaptive low shelf filter
     BiquadFilterTDF2<float> lowShelfFilterR;
     float Q = 0.707f;
     float fc = 200.0f;
+    LowShelfPrototype shelfPrototype; // cos/sin terms of the adaptive shelf at fc
     float shelfGainL = 0.0f;
     float shelfGainR = 0.0f;
     float lastShelfGainL = 0.0f;
@@ -116,8 +210,10 @@ private:
     float knee = 0.0f;
     float gain = 1.0f;
 
-    juce::String currentSpeakerModel;
-    juce::String lastSpeakerModel;
+    int lastSpeakerModel = -1;
+
+    bool lastNonlinearPrediction = false;
+    float lastXmax = 0.0f;
     //==============================================================================
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (XmaxLowShelfAudioProcessor)
 };
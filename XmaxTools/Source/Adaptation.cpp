@@ -0,0 +1,153 @@
+/*
+  ==============================================================================
+
+    Adaptation.cpp
+    Created: 19 Oct 2026 5:52:18pm
+    Author:  eliot
+
+  ==============================================================================
+*/
+
+#include "Adaptation.h"
+#include "HeadlessProcessor.h"
+#include "PluginUnits.h"
+#include "SpeakerPlant.h"
+#include "TestSignals.h"
+#include <iostream>
+
+static const char* const trackedParameters[] = { "fs", "Qts", "Rec", "Bl" };
+static constexpr int adapterDelay = 100; // ms, twice the polling interval of the model adapter
+
+Adaptation::Adaptation(const Options& adaptationOptions)
+    : options(adaptationOptions)
+{
+}
+
+int Adaptation::run()
+{
+    const auto& unit = *findPluginUnit("Limiter");
+    HeadlessProcessor processor(unit);
+    if (!processor.enableSidechain()) {
+        std::cerr << "the sense inputs could not be enabled" << std::endl;
+        return numFailures = 1;
+    }
+
+    auto modelNames = unit.getSpeakerModelNames();
+    int model = options.model.isEmpty() ? 0 : modelNames.indexOf(options.model, true);
+    if (model < 0) {
+        std::cerr << "unknown speaker model: " << options.model << std::endl;
+        return numFailures = 1;
+    }
+
+    processor.setParameter("limiterMode", 1.0f);
+    processor.setParameter(HeadlessProcessor::speakerModelID, float(model));
+    processor.setParameter("adaptive", 1.0f);
+    for (const auto& parameter : options.parameters)
+        processor.setParameterText(parameter.first, parameter.second);
+    processor.prepare(options.sampleRate, options.blockSize);
+
+    auto speakerGain = juce::Decibels::decibelsToGain(processor.getParameter("speakerGain"));
+    auto senseVoltage = processor.getParameter("senseVoltage");
+    auto senseCurrent = processor.getParameter("senseCurrent");
+
+    //the plant, drifted from the model
+    auto plantParameters = unit.getPlantParameters(model);
+    plantParameters.Rec *= 1 + options.reDrift;
+    plantParameters.Kms *= (1 + options.fsDrift) * (1 + options.fsDrift);
+    plantParameters.Bl *= 1 + options.blDrift;
+    SpeakerPlant<1> plant;
+    plant.prepare(plantParameters, options.sampleRate);
+
+    const auto& p = plantParameters;
+    double ws = std::sqrt(p.Kms / p.Mms);
+    auto* expected = new juce::DynamicObject();
+    expected->setProperty("fs", ws / juce::MathConstants<double>::twoPi);
+    expected->setProperty("Qts", ws * p.Mms / (p.Rms + p.Bl * p.Bl / p.Rec));
+    expected->setProperty("Rec", p.Rec);
+    expected->setProperty("Bl", p.Bl);
+    truth = juce::var(expected);
+
+    int numSamples = std::max(1, int(options.seconds * options.sampleRate));
+    auto length = size_t(numSamples);
+    std::vector<float> dataL(length), dataR(length);
+    TestSignals::findGenerator(options.signal)->fill(dataL.data(), dataR.data(), numSamples, options.sampleRate);
+
+    auto blockLength = size_t(options.blockSize);
+    std::vector<float> senseU(blockLength), senseI(blockLength);
+    std::vector<float> tension(blockLength), displacement(blockLength), current(blockLength);
+    juce::Random random(0x5eed);
+    int secondLength = int(options.sampleRate);
+
+    for (int start = 0; start < numSamples; start += options.blockSize) {
+        int blockSize = std::min(options.blockSize, numSamples - start);
+
+        //the sense inputs carry what the plant did during the previous block
+        processor.processBlock(dataL.data() + start, dataR.data() + start, senseU.data(), senseI.data(), blockSize);
+
+        for (int i = 0; i < blockSize; ++i)
+            tension[size_t(i)] = dataL[size_t(start + i)] * speakerGain;
+
+        const float* input[] = { tension.data() };
+        float* outputs[] = { displacement.data() };
+        float* currents[] = { current.data() };
+        plant.process(input, outputs, blockSize, currents);
+
+        for (int i = 0; i < blockSize; ++i) {
+            float noise = float(options.senseNoise * std::sqrt(3.0) * (2 * random.nextDouble() - 1)); // uniform, of this RMS
+            senseU[size_t(i)] = tension[size_t(i)] / senseVoltage;
+            senseI[size_t(i)] = (current[size_t(i)] + noise) / senseCurrent;
+        }
+
+        //once per second of audio, the model tracked so far: the adapter designs it in the
+        //background, faster than real time but not as fast as this loop
+        int end = start + blockSize;
+        if (end / secondLength != start / secondLength || end == numSamples) {
+            juce::Thread::sleep(adapterDelay);
+            auto tracked = XmaxLimiterUnit::getAdaptedModel(processor.getProcessor());
+            auto* entry = new juce::DynamicObject();
+            entry->setProperty("time", double(end) / options.sampleRate);
+            entry->setProperty("model", tracked);
+            trace.add(juce::var(entry));
+            estimate = tracked;
+        }
+    }
+
+    numFailures = 0;
+    for (auto name : trackedParameters) {
+        double expectedValue = truth[name];
+        bool tracked = estimate.isObject();
+        double error = tracked ? double(estimate[name]) / expectedValue - 1.0 : 0.0;
+        bool failed = !tracked || std::abs(error) > options.tolerance;
+        numFailures += failed ? 1 : 0;
+
+        std::cerr << (failed ? "  FAIL " : "  ok   ") << name << ": plant " << juce::String(expectedValue, 3);
+        if (tracked)
+            std::cerr << ", tracked " << juce::String(double(estimate[name]), 3) << " (" << juce::String(error * 100, 1) << " %)";
+        else
+            std::cerr << ", not tracked";
+        std::cerr << std::endl;
+    }
+    return numFailures;
+}
+
+juce::var Adaptation::getReport() const
+{
+    auto* report = new juce::DynamicObject();
+    report->setProperty("tool", "XmaxTools adapt");
+    report->setProperty("formatVersion", 1);
+    report->setProperty("date", juce::Time::getCurrentTime().toISO8601(true));
+    report->setProperty("sampleRate", options.sampleRate);
+    report->setProperty("blockSize", options.blockSize);
+    report->setProperty("seconds", options.seconds);
+    report->setProperty("signal", options.signal);
+    report->setProperty("reDrift", options.reDrift);
+    report->setProperty("fsDrift", options.fsDrift);
+    report->setProperty("blDrift", options.blDrift);
+    report->setProperty("senseNoise", options.senseNoise);
+    report->setProperty("tolerance", options.tolerance);
+    report->setProperty("plant", truth);
+    report->setProperty("tracked", estimate);
+    report->setProperty("trace", trace);
+    report->setProperty("failures", numFailures);
+    return juce::var(report);
+}
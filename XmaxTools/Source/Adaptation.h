@@ -0,0 +1,62 @@
+/*
+  ==============================================================================
+
+    Adaptation.h
+    Created: 19 Oct 2026 5:52:18pm
+    Author:  eliot
+
+    Checks the adaptive mode of the Limiter in a closed loop: its output,
+    amplified by speakerGain, drives a SpeakerPlant whose Re, resonance and
+    Bl drifted away from the speaker model, and the tension and current of
+    the plant are fed back to the sense inputs of the next block, as a
+    sense amplifier would. The model tracked by the Limiter is compared
+    with the parameters of the plant.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <utility>
+#include <vector>
+
+class Adaptation
+{
+public:
+    struct Options
+    {
+        juce::String model;        // the first speaker model if empty
+        juce::String signal = "pinkNoise";
+        double sampleRate = 48000.0;
+        int blockSize = 512;
+        double seconds = 10.0;
+
+        // Drift of the plant from the speaker model, relative
+        double reDrift = 0.3;      // a voice coil about 75 degrees hotter
+        double fsDrift = -0.1;     // a softer suspension
+        double blDrift = -0.05;
+        double senseNoise = 1e-3;  // RMS noise of the current sense, A
+
+        // Parameters set by ID in their own units, over the defaults of the Limiter, its
+        // displacement mode and its adaptive mode
+        std::vector<std::pair<juce::String, juce::String>> parameters{ { "speakerGain", "20" } };
+        double tolerance = 0.05;   // relative error allowed on each tracked parameter
+    };
+
+    explicit Adaptation(const Options& options);
+
+    // Runs the loop, and returns the number of parameters tracked with a larger error than
+    // the tolerance (all of them if nothing was tracked)
+    int run();
+
+    juce::var getReport() const;
+
+private:
+    Options options;
+    juce::var truth, estimate;
+    juce::Array<juce::var> trace; // the tracked model after each second
+    int numFailures = 0;
+
+    JUCE_DECLARE_NON_COPYABLE(Adaptation)
+};
@@ -0,0 +1,293 @@
+/*
+  ==============================================================================
+
+    BatchRender.cpp
+    Created: 19 Oct 2026 11:24:38pm
+    Author:  eliot
+
+  ==============================================================================
+*/
+
+#include "BatchRender.h"
+#include "HeadlessProcessor.h"
+#include "PluginUnits.h"
+#include <algorithm>
+#include <chrono>
+#include <deque>
+#include <iostream>
+#include <memory>
+#include <thread>
+
+// One queue of job indices per worker. A worker takes its own jobs from the front,
+// and once its queue is empty, steals from the back of the others.
+class WorkQueues
+{
+public:
+    explicit WorkQueues(int numWorkers)
+        : queues(size_t(numWorkers))
+    {
+    }
+
+    void push(int worker, size_t job)
+    {
+        auto& queue = queues[size_t(worker)];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.jobs.push_back(job);
+    }
+
+    // Returns false when every queue is empty
+    bool pop(int worker, size_t& job)
+    {
+        {
+            auto& queue = queues[size_t(worker)];
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            if (!queue.jobs.empty()) {
+                job = queue.jobs.front();
+                queue.jobs.pop_front();
+                return true;
+            }
+        }
+
+        for (size_t i = 1; i < queues.size(); ++i) {
+            auto& victim = queues[(size_t(worker) + i) % queues.size()];
+            std::lock_guard<std::mutex> lock(victim.mutex);
+            if (!victim.jobs.empty()) {
+                job = victim.jobs.back();
+                victim.jobs.pop_back();
+                return true;
+            }
+        }
+        return false;
+    }
+
+private:
+    struct Queue
+    {
+        std::mutex mutex;
+        std::deque<size_t> jobs;
+    };
+
+    std::vector<Queue> queues;
+};
+
+//==============================================================================
+BatchRender::BatchRender(const Options& batchOptions)
+    : options(batchOptions)
+{
+    numThreads = options.numThreads > 0 ? options.numThreads : juce::SystemStats::getNumCpus();
+}
+
+juce::Array<juce::File> BatchRender::findAudioFiles(const juce::Array<juce::File>& files)
+{
+    const juce::String pattern = "*.wav;*.aif;*.aiff;*.flac;*.ogg;*.f32;*.raw";
+    juce::Array<juce::File> audioFiles;
+
+    for (const auto& file : files) {
+        if (file.isDirectory()) {
+            auto found = file.findChildFiles(juce::File::findFiles, true, pattern);
+            found.sort();
+            audioFiles.addArray(found);
+        }
+        else {
+            audioFiles.add(file);
+        }
+    }
+    return audioFiles;
+}
+
+// One job per input, preset and model, named after all three
+juce::Result BatchRender::createJobs(const PluginUnit& unit)
+{
+    jobs.clear();
+
+    juce::Array<juce::File> presets = options.presets;
+    if (presets.isEmpty())
+        presets.add(juce::File());
+
+    juce::StringArray models = options.models;
+    if (models.isEmpty())
+        models.add({});
+
+    auto modelNames = unit.getSpeakerModelNames();
+    for (const auto& model : models) {
+        if (model.isNotEmpty() && !modelNames.contains(model))
+            return juce::Result::fail(unit.name + " has no speaker model " + model + " (" + modelNames.joinIntoString(", ") + ")");
+    }
+
+    juce::StringArray outputNames;
+
+    for (const auto& input : options.inputs) {
+        for (const auto& preset : presets) {
+            for (const auto& model : models) {
+                Job job;
+                job.input = input;
+                job.preset = preset;
+                job.model = model;
+                job.inputSize = input.getSize();
+
+                auto name = input.getFileNameWithoutExtension();
+                if (preset.getFullPathName().isNotEmpty())
+                    name << "_" << preset.getFileNameWithoutExtension();
+                if (model.isNotEmpty())
+                    name << "_" << juce::File::createLegalFileName(model);
+
+                job.output = options.outputDirectory.getChildFile(name + input.getFileExtension());
+                if (outputNames.contains(job.output.getFullPathName()))
+                    return juce::Result::fail("Two jobs would write " + job.output.getFullPathName());
+
+                outputNames.add(job.output.getFullPathName());
+                jobs.push_back(job);
+            }
+        }
+    }
+
+    //the longest files first, so that the workers finish together
+    std::stable_sort(jobs.begin(), jobs.end(), [](const Job& a, const Job& b) { return a.inputSize > b.inputSize; });
+    return juce::Result::ok();
+}
+
+juce::Result BatchRender::run()
+{
+    auto* unit = findPluginUnit(options.render.plugin);
+    if (unit == nullptr)
+        return juce::Result::fail("Unknown plugin: " + options.render.plugin);
+
+    auto result = createJobs(*unit);
+    if (result.failed())
+        return result;
+    if (jobs.empty())
+        return juce::Result::fail("No audio files to render");
+
+    result = options.outputDirectory.createDirectory();
+    if (result.failed())
+        return result;
+
+    numThreads = std::max(1, std::min(numThreads, int(jobs.size())));
+    numDone = 0;
+
+    //the processors are created here, on the message thread, and reused by their worker
+    std::vector<std::unique_ptr<HeadlessProcessor>> processors;
+    for (int worker = 0; worker < numThreads; ++worker)
+        processors.push_back(std::make_unique<HeadlessProcessor>(*unit));
+
+    WorkQueues queues(numThreads);
+    for (size_t index = 0; index < jobs.size(); ++index)
+        queues.push(int(index % size_t(numThreads)), index);
+
+    std::cerr << jobs.size() << " jobs on " << numThreads << " threads" << std::endl;
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> workers;
+    for (int worker = 0; worker < numThreads; ++worker)
+        workers.emplace_back([this, worker, &queues, &processors] { work(worker, queues, *processors[size_t(worker)]); });
+
+    for (auto& thread : workers)
+        thread.join();
+    wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    return juce::Result::ok();
+}
+
+void BatchRender::work(int worker, WorkQueues& queues, HeadlessProcessor& processor)
+{
+    size_t index = 0;
+    while (queues.pop(worker, index)) {
+        auto& job = jobs[index];
+
+        auto renderOptions = options.render;
+        renderOptions.input = job.input;
+        renderOptions.output = job.output;
+        renderOptions.preset = job.preset;
+        renderOptions.csv = options.writeCsv ? job.output.withFileExtension("csv") : juce::File();
+        if (job.model.isNotEmpty())
+            renderOptions.parameters.emplace_back(HeadlessProcessor::speakerModelID, job.model);
+
+        OfflineRender render(renderOptions);
+        auto result = render.run(processor);
+
+        job.error = result.failed() ? result.getErrorMessage() : juce::String();
+        job.statistics = render.getStatistics();
+        job.worker = worker;
+
+        std::lock_guard<std::mutex> lock(printLock);
+        ++numDone;
+        std::cerr << "[" << numDone << "/" << jobs.size() << "] " << job.output.getFileName() << ": ";
+        if (result.failed())
+            std::cerr << "FAILED, " << job.error << std::endl;
+        else
+            std::cerr << "peak displacement " << job.statistics.peakDisplacement << " mm, max gain reduction "
+                      << job.statistics.maxGainReduction << " dB" << std::endl;
+    }
+}
+
+int BatchRender::getNumFailures() const
+{
+    return int(std::count_if(jobs.begin(), jobs.end(), [](const Job& job) { return job.error.isNotEmpty(); }));
+}
+
+//==============================================================================
+juce::var BatchRender::getReport() const
+{
+    juce::Array<juce::var> jobList;
+    double audioSeconds = 0.0;
+    double busySeconds = 0.0;
+
+    for (const auto& job : jobs) {
+        const auto& statistics = job.statistics;
+        auto duration = statistics.sampleRate > 0.0 ? double(statistics.numSamples) / statistics.sampleRate : 0.0;
+
+        auto* entry = new juce::DynamicObject();
+        entry->setProperty("input", job.input.getFullPathName());
+        entry->setProperty("preset", job.preset.getFullPathName());
+        entry->setProperty("speakerModel", job.model);
+        entry->setProperty("output", job.output.getFullPathName());
+        entry->setProperty("worker", job.worker);
+
+        if (job.error.isNotEmpty()) {
+            entry->setProperty("error", job.error);
+        }
+        else {
+            entry->setProperty("seconds", duration);
+            entry->setProperty("renderSeconds", statistics.seconds);
+            entry->setProperty("realtimeFactor", duration / std::max(statistics.seconds, 1e-9));
+            entry->setProperty("peakDisplacement", statistics.peakDisplacement);
+            entry->setProperty("thresholdDisplacement", statistics.threshold);
+            entry->setProperty("blocksOverThreshold", statistics.numBlocksOverThreshold);
+            entry->setProperty("numBlocks", statistics.numBlocks);
+            entry->setProperty("maxGainReduction", statistics.maxGainReduction);
+
+            audioSeconds += duration;
+            busySeconds += statistics.seconds;
+        }
+        jobList.add(juce::var(entry));
+    }
+
+    //per core, the rate of the whole run spread over its threads, idle time included
+    auto realtimeFactor = audioSeconds / std::max(wallSeconds, 1e-9);
+
+    auto* summary = new juce::DynamicObject();
+    summary->setProperty("jobs", int(jobs.size()));
+    summary->setProperty("failures", getNumFailures());
+    summary->setProperty("threads", numThreads);
+    summary->setProperty("seconds", audioSeconds);
+    summary->setProperty("wallSeconds", wallSeconds);
+    summary->setProperty("realtimeFactor", realtimeFactor);
+    summary->setProperty("realtimeFactorPerCore", realtimeFactor / double(numThreads));
+    summary->setProperty("utilisation", busySeconds / std::max(wallSeconds * double(numThreads), 1e-9));
+
+    auto* report = new juce::DynamicObject();
+    report->setProperty("tool", "XmaxTools batch");
+    report->setProperty("formatVersion", 1);
+    report->setProperty("date", juce::Time::getCurrentTime().toISO8601(true));
+    report->setProperty("os", juce::SystemStats::getOperatingSystemName());
+    report->setProperty("cpu", juce::SystemStats::getCpuModel());
+   #if JUCE_DEBUG
+    report->setProperty("build", "debug");
+   #else
+    report->setProperty("build", "release");
+   #endif
+    report->setProperty("plugin", options.render.plugin);
+    report->setProperty("summary", juce::var(summary));
+    report->setProperty("jobs", jobList);
+    return juce::var(report);
+}
@@ -0,0 +1,81 @@
+/*
+  ==============================================================================
+
+    BatchRender.h
+    Created: 19 Oct 2026 11:24:38pm
+    Author:  eliot
+
+    Renders a corpus of files through one plugin, for every combination of
+    preset and speaker model, on all the cores. Each worker owns a processor
+    which is reused from one job to the next (the parameters are reset and
+    prepareToPlay clears the state), and takes its jobs from its own queue,
+    or steals them from the others once it is empty. The longest files are
+    dealt first, so that the last jobs are the short ones.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <mutex>
+#include <vector>
+#include "OfflineRender.h"
+
+class HeadlessProcessor;
+class WorkQueues;
+struct PluginUnit;
+
+class BatchRender
+{
+public:
+    struct Options
+    {
+        OfflineRender::Options render;   // plugin, block and chunk sizes, formats and parameters of every job
+        juce::Array<juce::File> inputs;  // audio files
+        juce::Array<juce::File> presets; // the defaults of the plugin if empty
+        juce::StringArray models;        // the model of the preset if empty
+        juce::File outputDirectory;
+        bool writeCsv = false;           // per-block meters next to each output
+        int numThreads = 0;              // one per core if 0
+    };
+
+    struct Job
+    {
+        juce::File input;
+        juce::File preset;
+        juce::String model;
+        juce::File output;
+        juce::int64 inputSize = 0;
+
+        juce::String error;              // empty if the job succeeded
+        OfflineRender::Statistics statistics;
+        int worker = -1;
+    };
+
+    explicit BatchRender(const Options& options);
+
+    // Fails if the jobs cannot be started; a failed job is only counted
+    juce::Result run();
+
+    int getNumFailures() const;
+
+    juce::var getReport() const;
+
+    // The audio files in these files and directories (searched recursively)
+    static juce::Array<juce::File> findAudioFiles(const juce::Array<juce::File>& files);
+
+private:
+    juce::Result createJobs(const PluginUnit& unit);
+    void work(int worker, WorkQueues& queues, HeadlessProcessor& processor);
+
+    Options options;
+    std::vector<Job> jobs;
+    int numThreads = 1;
+    double wallSeconds = 0.0;
+
+    std::mutex printLock;
+    int numDone = 0;
+
+    JUCE_DECLARE_NON_COPYABLE(BatchRender)
+};
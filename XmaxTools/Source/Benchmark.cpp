@@ -0,0 +1,241 @@
+/*
+  ==============================================================================
+
+    Benchmark.cpp
+    Created: 19 Oct 2026 4:18:52pm
+    Author:  eliot
+
+  ==============================================================================
+*/
+
+#include "Benchmark.h"
+#include "HeadlessProcessor.h"
+#include "PluginUnits.h"
+#include "SpeakerPlant.h"
+#include "TestSignals.h"
+#include <iostream>
+
+const std::array<Benchmark::Envelope, 3> Benchmark::envelopes = { {
+    { "shortest", 0.04f, 0.0f },
+    { "default", 3.0f, 10.0f },
+    { "longest", 20.0f, 100.0f }
+} };
+
+static double getMedian(std::vector<double>& values)
+{
+    std::sort(values.begin(), values.end());
+    size_t middle = values.size() / 2;
+    return values.size() % 2 == 1 ? values[middle] : 0.5 * (values[middle - 1] + values[middle]);
+}
+
+Benchmark::Benchmark(const Options& benchmarkOptions)
+    : options(benchmarkOptions)
+{
+    options.repeats = std::max(1, options.repeats);
+}
+
+int Benchmark::getNumSamples(double sampleRate) const noexcept
+{
+    return std::max(1, int(options.seconds * sampleRate));
+}
+
+void Benchmark::run()
+{
+    if (options.kernels) {
+        std::cerr << "kernels" << std::endl;
+        XmaxLimiterUnit::benchmarkKernels(*this);
+        XmaxFeedbackUnit::benchmarkKernels(*this);
+        runPlant();
+    }
+
+    if (options.processors) {
+        runProcessors();
+    }
+}
+
+// The simulated driver of the simulate command, whose speed decides how long a validation takes
+template<int numChannels>
+static void measurePlant(Benchmark& bench, const PlantParameters& parameters, double sampleRate,
+                         const std::vector<float>& tension)
+{
+    SpeakerPlant<numChannels> plant;
+    plant.prepare(parameters, sampleRate);
+
+    int numSamples = int(tension.size());
+    std::vector<float> displacement(tension.size() * numChannels);
+    std::array<const float*, numChannels> inputs;
+    std::array<float*, numChannels> outputs;
+    for (int c = 0; c < numChannels; ++c) {
+        inputs[size_t(c)] = tension.data();
+        outputs[size_t(c)] = displacement.data() + c * numSamples;
+    }
+
+    Benchmark::Description description{ "kernel", "SpeakerPlant", "sample", {
+        { "sampleRate", sampleRate },
+        { "channels", numChannels },
+        { "nonlinear", !parameters.isLinear() },
+        { "stepsPerSample", plant.getStepsPerSample() }
+    } };
+
+    bench.measure(description, numSamples,
+        [&] { plant.reset(); },
+        [&] {
+            plant.process(inputs.data(), outputs.data(), numSamples);
+            bench.consume(displacement.back());
+        });
+}
+
+void Benchmark::runPlant()
+{
+    auto linear = getPluginUnits().front().getPlantParameters(0);
+    auto nonlinear = linear;
+    nonlinear.setTypicalNonlinearity(1.0);
+
+    for (auto sampleRate : options.sampleRates) {
+        auto length = size_t(getNumSamples(sampleRate));
+        std::vector<float> tension(length), unused(length);
+        TestSignals::fillProgramme(tension.data(), unused.data(), int(length), sampleRate);
+        for (auto& sample : tension)
+            sample *= 10.0f; //full scale at 10 V
+
+        for (const auto* parameters : { &linear, &nonlinear }) {
+            measurePlant<1>(*this, *parameters, sampleRate, tension);
+            measurePlant<2>(*this, *parameters, sampleRate, tension);
+            measurePlant<4>(*this, *parameters, sampleRate, tension);
+        }
+    }
+}
+
+bool Benchmark::isSelected(const PluginUnit& unit) const
+{
+    if (options.plugins.isEmpty())
+        return true;
+
+    for (const auto& name : options.plugins) {
+        if (findPluginUnit(name) == &unit)
+            return true;
+    }
+    return false;
+}
+
+void Benchmark::runProcessors()
+{
+    for (const auto& unit : getPluginUnits()) {
+        if (!isSelected(unit))
+            continue;
+
+        std::cerr << unit.name << " processBlock" << std::endl;
+
+        HeadlessProcessor processor(unit);
+        int numModels = unit.getSpeakerModelNames().size();
+        const auto& defaultEnvelope = envelopes[1];
+
+        if (options.full) {
+            for (auto sampleRate : options.sampleRates)
+                for (auto blockSize : options.blockSizes)
+                    for (const auto& envelope : envelopes)
+                        for (int model = 0; model < numModels; ++model)
+                            measureProcessor(processor, sampleRate, blockSize, envelope, model);
+            continue;
+        }
+
+        //one sweep per setting, around 48 kHz, 512 samples, default envelope and first model
+        for (auto sampleRate : options.sampleRates)
+            for (auto blockSize : options.blockSizes)
+                measureProcessor(processor, sampleRate, blockSize, defaultEnvelope, 0);
+
+        for (const auto& envelope : envelopes)
+            for (int model = 0; model < numModels; ++model)
+                measureProcessor(processor, 48000.0, 512, envelope, model);
+
+        //the multiband mode of the Limiter, next to the full band one above
+        if (processor.setParameter(HeadlessProcessor::multibandID, 1.0f)) {
+            measureProcessor(processor, 48000.0, 512, defaultEnvelope, 0);
+            processor.setParameter(HeadlessProcessor::multibandID, 0.0f);
+        }
+    }
+}
+
+void Benchmark::measureProcessor(HeadlessProcessor& processor, double sampleRate, int blockSize,
+                                 const Envelope& envelope, int speakerModel)
+{
+    //set before prepare, so that the processor starts with these values without any transition
+    processor.setParameter(HeadlessProcessor::speakerModelID, float(speakerModel));
+    processor.setParameter(HeadlessProcessor::attackTimeID, envelope.attackTime);
+    processor.setParameter(HeadlessProcessor::holdTimeID, envelope.holdTime);
+    processor.setParameter(HeadlessProcessor::lookAheadTimeID, envelope.attackTime);
+    processor.prepare(sampleRate, blockSize);
+
+    int numSamples = getNumSamples(sampleRate);
+    numSamples = std::max(1, numSamples / blockSize) * blockSize;
+    signalL.resize(size_t(numSamples));
+    signalR.resize(size_t(numSamples));
+
+    Description description{ "processBlock", processor.getUnit().name, "sample", {
+        { "sampleRate", sampleRate },
+        { "blockSize", blockSize },
+        { "envelope", envelope.name },
+        { "attackTime", envelope.attackTime },
+        { "holdTime", envelope.holdTime },
+        { "speakerModel", processor.getUnit().getSpeakerModelNames()[speakerModel] }
+    } };
+    if (processor.hasParameter(HeadlessProcessor::multibandID))
+        description.settings.push_back({ "multiband", processor.getParameter(HeadlessProcessor::multibandID) >= 0.5f });
+
+    //the processing is in place, so the signal is written again before each run
+    measure(description, numSamples,
+        [&] { TestSignals::fillProgramme(signalL.data(), signalR.data(), numSamples, sampleRate); },
+        [&] { processor.process(signalL.data(), signalR.data(), numSamples); });
+}
+
+void Benchmark::addResult(const Description& description, int numItems,
+                          std::vector<double>& nanoseconds, std::vector<double>& cycles)
+{
+    auto* result = new juce::DynamicObject();
+    result->setProperty("group", description.group);
+    result->setProperty("name", description.name);
+
+    for (const auto& setting : description.settings)
+        result->setProperty(juce::Identifier(setting.first), setting.second);
+
+    //e.g. nsPerSample, nsPerSampleMin, cyclesPerSample
+    auto per = "Per" + description.unit.substring(0, 1).toUpperCase() + description.unit.substring(1);
+    double medianNanoseconds = getMedian(nanoseconds);
+
+    result->setProperty("count", numItems);
+    result->setProperty("ns" + per, medianNanoseconds);
+    result->setProperty("ns" + per + "Min", nanoseconds.front());
+    result->setProperty("ns" + per + "Max", nanoseconds.back());
+
+    if (CycleCounter::isAvailable)
+        result->setProperty("cycles" + per, getMedian(cycles));
+
+    results.add(juce::var(result));
+
+    std::cerr << "  " << description.name;
+    for (const auto& setting : description.settings)
+        std::cerr << " " << setting.first << "=" << setting.second.toString();
+    std::cerr << ": " << juce::String(medianNanoseconds, 2) << " ns/" << description.unit << std::endl;
+}
+
+juce::var Benchmark::getReport() const
+{
+    auto* report = new juce::DynamicObject();
+    report->setProperty("tool", "XmaxTools bench");
+    report->setProperty("formatVersion", 1);
+    report->setProperty("date", juce::Time::getCurrentTime().toISO8601(true));
+    report->setProperty("juceVersion", juce::SystemStats::getJUCEVersion());
+    report->setProperty("os", juce::SystemStats::getOperatingSystemName());
+    report->setProperty("cpu", juce::SystemStats::getCpuModel());
+    report->setProperty("cpuMHz", juce::SystemStats::getCpuSpeedInMegahertz());
+   #if JUCE_DEBUG
+    report->setProperty("build", "debug");
+   #else
+    report->setProperty("build", "release");
+   #endif
+    report->setProperty("cycleCounter", CycleCounter::isAvailable ? "tsc" : "none");
+    report->setProperty("secondsPerMeasurement", options.seconds);
+    report->setProperty("repeats", options.repeats);
+    report->setProperty("results", results);
+    return juce::var(report);
+}
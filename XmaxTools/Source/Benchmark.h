@@ -0,0 +1,114 @@
+/*
+  ==============================================================================
+
+    Benchmark.h
+    Created: 19 Oct 2026 4:18:52pm
+    Author:  eliot
+
+    Throughput of the DSP kernels and of the full processBlock of the three
+    plugins, across sample rates, block sizes, envelope settings and
+    speaker models. Each measurement processes the same amount of audio
+    time, is repeated after a warm-up run, and reports the median in
+    nanoseconds and cycles per sample (or per call for the coefficient
+    design functions), as JSON. The simulated driver of the simulate
+    command is measured with the kernels.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <array>
+#include <vector>
+#include <algorithm>
+#include "CycleCounter.h"
+
+class HeadlessProcessor;
+struct PluginUnit;
+
+class Benchmark
+{
+public:
+    struct Options
+    {
+        juce::Array<double> sampleRates{ 44100.0, 48000.0, 88200.0, 96000.0, 176400.0, 192000.0, 384000.0 };
+        juce::Array<int> blockSizes{ 1, 16, 64, 256, 1024, 8192 };
+        juce::StringArray plugins;  // every plugin if empty
+        double seconds = 1.0;       // audio time processed by each measurement
+        int repeats = 5;            // the median is reported
+        bool kernels = true;
+        bool processors = true;
+        bool full = false;          // every combination of the processor settings, instead of one sweep per setting
+    };
+
+    // Envelope settings of the sweeps, in ms: shortest, default and longest windows
+    struct Envelope
+    {
+        const char* name;
+        float attackTime;
+        float holdTime;
+    };
+    static const std::array<Envelope, 3> envelopes;
+
+    // What a measurement is, as written in the report
+    struct Description
+    {
+        juce::String group;           // "kernel" or "processBlock"
+        juce::String name;            // kernel or plugin name
+        juce::String unit = "sample"; // what the items counted by measure() are
+        std::vector<std::pair<juce::String, juce::var>> settings;
+    };
+
+    explicit Benchmark(const Options& options);
+
+    void run();
+    juce::var getReport() const;
+
+    const Options& getOptions() const noexcept { return options; }
+
+    // Samples processed by each measurement at this sample rate
+    int getNumSamples(double sampleRate) const noexcept;
+
+    // Times run(), which processes numItems items, once to warm up and then options.repeats times.
+    // setup() is called before each run, outside of the timed section.
+    template<typename Setup, typename Function>
+    void measure(const Description& description, int numItems, Setup&& setup, Function&& run)
+    {
+        std::vector<double> nanoseconds, cycles;
+
+        for (int repeat = 0; repeat <= options.repeats; ++repeat) {
+            setup();
+            auto start = Timestamp::now();
+            run();
+            auto end = Timestamp::now();
+
+            if (repeat > 0) {
+                nanoseconds.push_back(double(end.nanoseconds - start.nanoseconds) / numItems);
+                cycles.push_back(double(end.cycles - start.cycles) / numItems);
+            }
+        }
+
+        addResult(description, numItems, nanoseconds, cycles);
+    }
+
+    // Keeps the output of a kernel alive, so that the compiler cannot remove the loop
+    void consume(float value) noexcept
+    {
+        sink = sink + value;
+    }
+
+private:
+    bool isSelected(const PluginUnit& unit) const;
+    void runPlant();
+    void runProcessors();
+    void measureProcessor(HeadlessProcessor& processor, double sampleRate, int blockSize, const Envelope& envelope, int speakerModel);
+    void addResult(const Description& description, int numItems, std::vector<double>& nanoseconds, std::vector<double>& cycles);
+
+    Options options;
+    juce::Array<juce::var> results;
+    std::vector<float> signalL, signalR;
+    volatile float sink = 0.0f;
+
+    JUCE_DECLARE_NON_COPYABLE(Benchmark)
+};
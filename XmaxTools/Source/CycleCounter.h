@@ -0,0 +1,63 @@
+/*
+  ==============================================================================
+
+    CycleCounter.h
+    Created: 19 Oct 2026 4:02:18pm
+    Author:  eliot
+
+    Cheap timestamps for the benchmarks. On x86 the time stamp counter is
+    read directly: it ticks at the nominal CPU frequency on every recent
+    processor, whatever the current clock, so the "cycles" are reference
+    cycles. Elsewhere there is no portable cycle counter, and only the
+    nanoseconds are reported.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+ #if defined(_MSC_VER)
+  #include <intrin.h>
+ #else
+  #include <x86intrin.h>
+ #endif
+ #define XMAX_HAS_CYCLE_COUNTER 1
+#else
+ #define XMAX_HAS_CYCLE_COUNTER 0
+#endif
+
+struct CycleCounter
+{
+    static constexpr bool isAvailable = XMAX_HAS_CYCLE_COUNTER != 0;
+
+    static uint64_t readCycles() noexcept
+    {
+       #if XMAX_HAS_CYCLE_COUNTER
+        return uint64_t(__rdtsc());
+       #else
+        return 0;
+       #endif
+    }
+
+    static int64_t readNanoseconds() noexcept
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+};
+
+// Start and end of one measured section
+struct Timestamp
+{
+    static Timestamp now() noexcept
+    {
+        return { CycleCounter::readNanoseconds(), CycleCounter::readCycles() };
+    }
+
+    int64_t nanoseconds = 0;
+    uint64_t cycles = 0;
+};
@@ -0,0 +1,130 @@
+/*
+  ==============================================================================
+
+    FeedbackUnit.cpp
+    Created: 19 Oct 2026 4:31:10pm
+    Author:  eliot
+
+    XmaxFeedback compiled into the tools, in the XmaxFeedbackUnit namespace,
+    with the stage timing of processBlock compiled in (see StageTimer.h).
+    The standard headers used by the plugin are included first, so that
+    they are not declared again inside the namespace.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <complex>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <map>
+#include <memory>
+#include <tuple>
+#include <utility>
+#include <vector>
+#include "PluginUnits.h"
+#include "Benchmark.h"
+#include "TestSignals.h"
+
+#define JucePlugin_Name "XmaxFeedback"
+#define XMAX_STAGE_TIMING 1
+
+namespace XmaxFeedbackUnit
+{
+#include "../../XmaxFeedback/Source/Parameters.cpp"
+#include "../../XmaxFeedback/Source/PluginProcessor.cpp"
+#include "../../XmaxFeedback/Source/PluginEditor.cpp"
+#include "../../XmaxFeedback/Source/LookAndFeel.cpp"
+#include "../../XmaxFeedback/Source/RotaryKnob.cpp"
+#include "../../XmaxFeedback/Source/LevelMeter.cpp"
+#include "../../XmaxFeedback/Source/DisplacementMeter.cpp"
+#include "../../XmaxFeedback/Source/LoadMeter.cpp"
+#include "../../XmaxFeedback/Source/PipelineOverlay.cpp"
+#include "../../XmaxFeedback/Source/CustomDriverPanel.cpp"
+
+std::unique_ptr<juce::AudioProcessor> createProcessor()
+{
+    return std::make_unique<XmaxFeedbackAudioProcessor>();
+}
+
+juce::StringArray getSpeakerModelNames()
+{
+    return SpeakerModels::modelNames;
+}
+
+PlantParameters getPlantParameters(int modelIndex)
+{
+    return makePlantParameters(Parameters::getSpeakerModel(modelIndex));
+}
+
+StageProbe getStageProbe()
+{
+    return makeStageProbe<XmaxFeedbackAudioProcessor>();
+}
+
+float takePeakDisplacement(juce::AudioProcessor& processor)
+{
+    return ::takePeakDisplacement<XmaxFeedbackAudioProcessor>(processor);
+}
+
+float takeGainReduction(juce::AudioProcessor& processor)
+{
+    return ::takeGainReduction<XmaxFeedbackAudioProcessor>(processor);
+}
+
+// The TDF2 biquad and the design of the compensation filter, which the feedback
+// processor runs for every sample of each channel
+void benchmarkKernels(Benchmark& bench)
+{
+    for (auto sampleRate : bench.getOptions().sampleRates) {
+        int numSamples = bench.getNumSamples(sampleRate);
+        auto length = size_t(numSamples);
+        std::vector<float> input(length), inputR(length);
+        TestSignals::fillProgramme(input.data(), inputR.data(), numSamples, sampleRate);
+
+        const auto& model = Parameters::speakerModelData.at(SpeakerModels::modelNames[0]);
+        auto coeffs = getXUFilterCoefficients(model, float(sampleRate));
+        BiquadFilterTDF2<float> biquad;
+        biquad.setCoefficients(coeffs.first, coeffs.second);
+
+        Benchmark::Description description{ "kernel", "BiquadFilterTDF2", "sample", { { "sampleRate", sampleRate } } };
+        bench.measure(description, numSamples,
+            [&] { biquad.reset(); },
+            [&] {
+                float sum = 0.0f;
+                for (int i = 0; i < numSamples; ++i)
+                    sum += biquad.processSample(input[size_t(i)]);
+                bench.consume(sum);
+            });
+
+        //the compliance goes down to a tenth of the model one, as when the limiter is working hard
+        const int numCalls = 10000;
+        for (const auto& name : SpeakerModels::modelNames) {
+            const auto& compModel = Parameters::speakerModelData.at(name);
+            Benchmark::Description compDescription{ "kernel", "getCompFilterCoeffs", "call", {
+                { "sampleRate", sampleRate },
+                { "speakerModel", name }
+            } };
+            bench.measure(compDescription, numCalls,
+                [] {},
+                [&] {
+                    float sum = 0.0f;
+                    for (int i = 0; i < numCalls; ++i) {
+                        float CmsComp = compModel.Cms * (1.0f - 0.9f * float(i) / float(numCalls));
+                        float RmsComp = computeRmsComp1(CmsComp, compModel, 0.707f, 0.5f, 1.0f);
+                        sum += getCompFilterCoeffs(compModel, CmsComp, RmsComp, float(sampleRate)).second[1];
+                    }
+                    bench.consume(sum);
+                });
+        }
+    }
+}
+}
+
+#undef JucePlugin_Name
@@ -0,0 +1,136 @@
+/*
+  ==============================================================================
+
+    HeadlessProcessor.cpp
+    Created: 19 Oct 2026 4:11:06pm
+    Author:  eliot
+
+  ==============================================================================
+*/
+
+#include "HeadlessProcessor.h"
+
+HeadlessProcessor::HeadlessProcessor(const PluginUnit& pluginUnit)
+    : unit(pluginUnit), processor(pluginUnit.createProcessor())
+{
+    //the main buses in stereo, any other one as the plugin declares it
+    auto stereo = juce::AudioChannelSet::stereo();
+    auto layout = processor->getBusesLayout();
+    layout.inputBuses.set(0, stereo);
+    layout.outputBuses.set(0, stereo);
+    processor->setBusesLayout(layout);
+}
+
+bool HeadlessProcessor::enableSidechain()
+{
+    if (processor->getBusCount(true) < 2)
+        return false;
+
+    auto layout = processor->getBusesLayout();
+    layout.inputBuses.set(1, juce::AudioChannelSet::stereo());
+    return processor->setBusesLayout(layout);
+}
+
+void HeadlessProcessor::prepare(double newSampleRate, int newBlockSize)
+{
+    sampleRate = newSampleRate;
+    blockSize = newBlockSize;
+
+    processor->setRateAndBufferSizeDetails(sampleRate, blockSize);
+    processor->prepareToPlay(sampleRate, blockSize);
+}
+
+juce::RangedAudioParameter* HeadlessProcessor::findParameter(const juce::String& parameterID) const
+{
+    for (auto* parameter : processor->getParameters()) {
+        auto* ranged = dynamic_cast<juce::RangedAudioParameter*>(parameter);
+        if (ranged != nullptr && ranged->getParameterID() == parameterID)
+            return ranged;
+    }
+    return nullptr;
+}
+
+bool HeadlessProcessor::hasParameter(const juce::String& parameterID) const
+{
+    return findParameter(parameterID) != nullptr;
+}
+
+float HeadlessProcessor::getParameter(const juce::String& parameterID) const
+{
+    auto* parameter = findParameter(parameterID);
+    return parameter != nullptr ? parameter->convertFrom0to1(parameter->getValue()) : 0.0f;
+}
+
+juce::Array<juce::RangedAudioParameter*> HeadlessProcessor::getParameters() const
+{
+    juce::Array<juce::RangedAudioParameter*> parameters;
+    for (auto* parameter : processor->getParameters()) {
+        if (auto* ranged = dynamic_cast<juce::RangedAudioParameter*>(parameter))
+            parameters.add(ranged);
+    }
+    return parameters;
+}
+
+bool HeadlessProcessor::setParameter(const juce::String& parameterID, float value)
+{
+    auto* parameter = findParameter(parameterID);
+    if (parameter == nullptr)
+        return false;
+
+    auto range = parameter->getNormalisableRange();
+    parameter->setValueNotifyingHost(range.convertTo0to1(range.snapToLegalValue(value)));
+    return true;
+}
+
+bool HeadlessProcessor::setParameterText(const juce::String& parameterID, const juce::String& text)
+{
+    auto value = text.trim();
+    if (value.isNotEmpty() && value.containsOnly("0123456789.-+eE"))
+        return setParameter(parameterID, value.getFloatValue());
+
+    auto* parameter = findParameter(parameterID);
+    if (parameter == nullptr)
+        return false;
+
+    //getValueForText would fall back on the first choice
+    if (auto* choice = dynamic_cast<juce::AudioParameterChoice*>(parameter)) {
+        if (!choice->choices.contains(value))
+            return false;
+    }
+
+    parameter->setValueNotifyingHost(parameter->getValueForText(value));
+    return true;
+}
+
+void HeadlessProcessor::resetParameters()
+{
+    for (auto* parameter : getParameters())
+        parameter->setValueNotifyingHost(parameter->getDefaultValue());
+}
+
+void HeadlessProcessor::processBlock(float* channelDataL, float* channelDataR, int numSamples)
+{
+    jassert(numSamples <= blockSize);
+
+    float* channels[] = { channelDataL, channelDataR };
+    juce::AudioBuffer<float> buffer(channels, 2, numSamples); // refers to the data, no copy
+    processor->processBlock(buffer, midiMessages);
+}
+
+void HeadlessProcessor::processBlock(float* channelDataL, float* channelDataR, float* sidechainL, float* sidechainR, int numSamples)
+{
+    jassert(numSamples <= blockSize);
+
+    //the main input and output, then the second input bus
+    float* channels[] = { channelDataL, channelDataR, sidechainL, sidechainR };
+    juce::AudioBuffer<float> buffer(channels, 4, numSamples);
+    processor->processBlock(buffer, midiMessages);
+}
+
+void HeadlessProcessor::process(float* channelDataL, float* channelDataR, int numSamples)
+{
+    for (int start = 0; start < numSamples; start += blockSize) {
+        int length = std::min(blockSize, numSamples - start);
+        processBlock(channelDataL + start, channelDataR + start, length);
+    }
+}
@@ -0,0 +1,81 @@
+/*
+  ==============================================================================
+
+    HeadlessProcessor.h
+    Created: 19 Oct 2026 4:11:06pm
+    Author:  eliot
+
+    Runs one of the plugin processors without a host: stereo in and out,
+    a fixed block size, and the parameters set by ID in their own units
+    (dB, ms, mm, %, choice index), as they are displayed in the editor.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "PluginUnits.h"
+
+class HeadlessProcessor
+{
+public:
+    explicit HeadlessProcessor(const PluginUnit& unit);
+
+    void prepare(double sampleRate, int blockSize);
+
+    // Enables a stereo second input bus (the sense inputs of the Limiter), before prepare;
+    // returns false if the plugin has none
+    bool enableSidechain();
+
+    // Returns false if the plugin has no parameter with this ID
+    bool setParameter(const juce::String& parameterID, float value);
+    bool hasParameter(const juce::String& parameterID) const;
+
+    // Sets a parameter from a number in its own units, or from a text such as the name of a
+    // choice (a speaker model); returns false if the ID or the text is unknown
+    bool setParameterText(const juce::String& parameterID, const juce::String& text);
+
+    // Sets every parameter back to its default value, before the processor is reused
+    void resetParameters();
+
+    // Value of the parameter in its own units, 0 if the plugin has no parameter with this ID
+    float getParameter(const juce::String& parameterID) const;
+
+    // Every parameter of the plugin, in the order of the host
+    juce::Array<juce::RangedAudioParameter*> getParameters() const;
+
+    // Processes one block of at most getBlockSize() samples in place
+    void processBlock(float* channelDataL, float* channelDataR, int numSamples);
+
+    // Same, with the two channels of the second input bus
+    void processBlock(float* channelDataL, float* channelDataR, float* sidechainL, float* sidechainR, int numSamples);
+
+    // Processes a whole signal in place, split in blocks of getBlockSize() samples
+    void process(float* channelDataL, float* channelDataR, int numSamples);
+
+    juce::AudioProcessor& getProcessor() noexcept { return *processor; }
+    const PluginUnit& getUnit() const noexcept { return unit; }
+    double getSampleRate() const noexcept { return sampleRate; }
+    int getBlockSize() const noexcept { return blockSize; }
+
+    // IDs shared by the three plugins
+    static constexpr const char* speakerModelID = "speakeModel"; // sic, as saved in the plugin states
+    static constexpr const char* attackTimeID = "attackTime";
+    static constexpr const char* holdTimeID = "holdTime";
+    static constexpr const char* releaseTimeID = "releaseTime";
+    static constexpr const char* lookAheadTimeID = "lookAheadTime";
+    static constexpr const char* thresholdDisplacementID = "thresholdDisplacement";
+    static constexpr const char* multibandID = "multiband"; // XmaxLimiter only
+
+private:
+    juce::RangedAudioParameter* findParameter(const juce::String& parameterID) const;
+
+    const PluginUnit& unit;
+    std::unique_ptr<juce::AudioProcessor> processor;
+    juce::MidiBuffer midiMessages;
+    double sampleRate = 48000.0;
+    int blockSize = 512;
+
+    JUCE_DECLARE_NON_COPYABLE(HeadlessProcessor)
+};
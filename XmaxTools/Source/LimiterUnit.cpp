@@ -0,0 +1,596 @@
+/*
+  ==============================================================================
+
+    LimiterUnit.cpp
+    Created: 19 Oct 2026 4:27:33pm
+    Author:  eliot
+
+    XmaxLimiter compiled into the tools, in the XmaxLimiterUnit namespace,
+    with the stage timing of processBlock compiled in (see StageTimer.h).
+    The standard headers used by the plugin are included first, so that
+    they are not declared again inside the namespace.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <complex>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <memory>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+#include "PluginUnits.h"
+#include "Benchmark.h"
+#include "TestSignals.h"
+
+#define JucePlugin_Name "XmaxLimiter"
+#define XMAX_STAGE_TIMING 1
+
+namespace XmaxLimiterUnit
+{
+#include "../../XmaxLimiter/Source/Parameters.cpp"
+#include "../../XmaxLimiter/Source/SpeakerDatabase.cpp"
+#include "../../XmaxLimiter/Source/PluginProcessor.cpp"
+#include "../../XmaxLimiter/Source/PluginEditor.cpp"
+#include "../../XmaxLimiter/Source/LookAndFeel.cpp"
+#include "../../XmaxLimiter/Source/RotaryKnob.cpp"
+#include "../../XmaxLimiter/Source/LevelMeter.cpp"
+#include "../../XmaxLimiter/Source/DisplacementMeter.cpp"
+#include "../../XmaxLimiter/Source/LoadMeter.cpp"
+#include "../../XmaxLimiter/Source/TemperatureMeter.cpp"
+#include "../../XmaxLimiter/Source/PipelineOverlay.cpp"
+#include "../../XmaxLimiter/Source/CustomDriverPanel.cpp"
+
+std::unique_ptr<juce::AudioProcessor> createProcessor()
+{
+    return std::make_unique<XmaxLimiterAudioProcessor>();
+}
+
+juce::StringArray getSpeakerModelNames()
+{
+    return Parameters::getSpeakerModelNames();
+}
+
+// The box as in getXUTransferFunction: the air stiffness seen by the cone, and the port or
+// the passive radiator tuned to fb
+PlantParameters getPlantParameters(int modelIndex)
+{
+    auto model = Parameters::getSpeakerModel(modelIndex);
+    auto plant = makePlantParameters(model);
+
+    const auto& box = model.enclosure;
+    if (box.type == Enclosure::infiniteBaffle || box.Vb <= 0.0f)
+        return plant;
+
+    plant.Kb = rhoC2 * double(model.Sd) * double(model.Sd) / double(box.Vb);
+    if (box.type == Enclosure::vented || box.type == Enclosure::passiveRadiator) {
+        double wb = 2 * pi * box.fb;
+        double wp = box.type == Enclosure::passiveRadiator ? 2 * pi * box.fp : 0.0;
+        plant.Mp = plant.Kb / (wb * wb - wp * wp);
+        plant.Rp = wb * plant.Mp / box.Ql;
+        plant.Kp = wp * wp * plant.Mp;
+    }
+    return plant;
+}
+
+StageProbe getStageProbe()
+{
+    return makeStageProbe<XmaxLimiterAudioProcessor>();
+}
+
+float takePeakDisplacement(juce::AudioProcessor& processor)
+{
+    return ::takePeakDisplacement<XmaxLimiterAudioProcessor>(processor);
+}
+
+float takeGainReduction(juce::AudioProcessor& processor)
+{
+    return ::takeGainReduction<XmaxLimiterAudioProcessor>(processor);
+}
+
+// The gain computer and the output of processSamples, without the look-ahead delays: the
+// envelope is computed beforehand from the whole file. The parameters are constant offline,
+// so their targets are used from the first sample, without smoothing.
+class LimiterTwoPassStages : public TwoPassStages
+{
+public:
+    LimiterTwoPassStages(XmaxLimiterAudioProcessor& processor, double sampleRate)
+        : snapshot(processor.params.update())
+    {
+        //the custom driver is not in the table of models, the processor keeps it with its state
+        auto model = Parameters::isCustomModel(snapshot.speakerModel) ? processor.getCustomModel()
+                                                                      : Parameters::getSpeakerModel(snapshot.speakerModel);
+        auto coeffs = designSpeakerCoefficients(model, float(sampleRate));
+        for (auto& channel : channels) {
+            channel.sidechainFilter.setCoefficients(coeffs.xu);
+            channel.xuFilter.setCoefficients(coeffs.xu);
+            channel.uxFilter.setCoefficients(coeffs.ux);
+            channel.predictor.prepare(model, sampleRate);
+            channel.predictor.setXmax(snapshot.xmax);
+            channel.thermal.prepare(model, sampleRate);
+            channel.thermal.setLimits(snapshot.ratedPower, snapshot.maxCoilTemperature);
+            channel.thermal.setEnabled(snapshot.thermalProtection);
+        }
+
+        displacementMode = snapshot.limiterMode == 1;
+        nonlinearMode = displacementMode && snapshot.nonlinearPrediction;
+        threshold = displacementMode ? snapshot.thresholdDisplacement * 1e-3f : snapshot.thresholdTension;
+        gain = displacementMode ? snapshot.speakerGain : 1.0f;
+
+        attackTime = snapshot.attackTime;
+        holdTime = snapshot.holdTime;
+        releaseTime = snapshot.releaseTime;
+    }
+
+    void computeGains(int channel, const float* input, float* gains, int numSamples) noexcept override
+    {
+        auto& filter = channels[size_t(channel)].sidechainFilter;
+        auto& predictor = channels[size_t(channel)].predictor;
+        auto& thermal = channels[size_t(channel)].thermal;
+
+        for (int i = 0; i < numSamples; ++i) {
+            float inputAmp = input[i] * snapshot.inputGain;
+            thermal.add(inputAmp * snapshot.speakerGain);
+            float var = inputAmp;
+            if (nonlinearMode)
+                var = predictor.processSample(inputAmp * gain);
+            else if (displacementMode)
+                var = filter.processSample(inputAmp) * gain;
+            gains[i] = std::min(computeGain(std::abs(var), threshold, snapshot.knee), thermal.getGain());
+        }
+    }
+
+    float applyGains(int channel, float* channelData, const float* gains, int numSamples) noexcept override
+    {
+        auto& state = channels[size_t(channel)];
+        float maxDisp = 0.0f;
+
+        for (int i = 0; i < numSamples; ++i) {
+            float dry = channelData[i];
+            float inputAmp = dry * snapshot.inputGain;
+
+            float lim = gains[i] * (displacementMode ? state.xuFilter.processSample(inputAmp) : inputAmp);
+            float wet = displacementMode ? state.uxFilter.processSample(lim) : lim;
+
+            if (displacementMode)
+                maxDisp = std::max(maxDisp, std::abs(lim * snapshot.speakerGain * 1e3f));
+
+            channelData[i] = (snapshot.mix * wet + (1.0f - snapshot.mix) * dry) * snapshot.gain;
+        }
+        return maxDisp;
+    }
+
+private:
+    struct Channel
+    {
+        SosCascade<float, 1> sidechainFilter; // tension to displacement, for the gain computer
+        SosCascade<float, 1> xuFilter;        // tension to displacement, of the signal
+        SosCascade<float, 1> uxFilter;        // displacement to tension
+        NonlinearPredictor<float, 1> predictor; // excursion of the nonlinear driver, for the gain computer
+        ThermalModel thermal;                   // temperature of the voice coil, from a cold start
+    };
+
+    ParameterSnapshot snapshot;
+    std::array<Channel, 2> channels;
+    bool displacementMode = true;
+    bool nonlinearMode = false;
+    float threshold = 1.0f;
+    float gain = 1.0f;
+};
+
+std::unique_ptr<TwoPassStages> createTwoPassStages(juce::AudioProcessor& processor, double sampleRate)
+{
+    return std::make_unique<LimiterTwoPassStages>(static_cast<XmaxLimiterAudioProcessor&>(processor), sampleRate);
+}
+
+juce::Result compileSpeakerDatabase(const juce::File& source, const juce::File& cache, const juce::String& query)
+{
+    auto seconds = [](std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    };
+
+    auto start = std::chrono::steady_clock::now();
+    auto result = SpeakerDatabase::compile(source, cache);
+    if (result.failed())
+        return result;
+    auto compileSeconds = seconds(start);
+
+    SpeakerDatabase database;
+    start = std::chrono::steady_clock::now();
+    result = database.open(cache);
+    if (result.failed())
+        return result;
+    auto openSeconds = seconds(start);
+
+    std::cerr << database.getNumModels() << " drivers in " << cache.getFullPathName() << " (" << cache.getSize() / 1024
+              << " kB), compiled in " << compileSeconds * 1e3 << " ms, opened in " << openSeconds * 1e6 << " us" << std::endl;
+
+    if (query.isNotEmpty()) {
+        start = std::chrono::steady_clock::now();
+        auto matches = database.search(query, std::numeric_limits<int>::max());
+        auto searchSeconds = seconds(start);
+
+        for (auto index : matches)
+            std::cout << database.getName(index) << std::endl;
+        std::cerr << matches.size() << " matches in " << searchSeconds * 1e6 << " us" << std::endl;
+    }
+    return juce::Result::ok();
+}
+
+juce::var getAdaptedModel(juce::AudioProcessor& processor)
+{
+    auto model = Parameters::getSpeakerModel(0);
+    if (!static_cast<XmaxLimiterAudioProcessor&>(processor).getAdaptedModel(model))
+        return {};
+
+    auto* object = new juce::DynamicObject();
+    object->setProperty("fs", model.fs);
+    object->setProperty("Qts", model.Qts);
+    object->setProperty("Qms", model.Qms);
+    object->setProperty("Qes", model.Qes);
+    object->setProperty("Rec", model.Rec);
+    object->setProperty("Bl", model.Bl);
+    object->setProperty("Cms", model.Cms);
+    return juce::var(object);
+}
+
+// The nonlinear prediction of the sidechain, next to the X/U cascade it replaces, per
+// channel: the channels of one sample are computed by the same vector instructions
+template<int numChannels>
+static void measurePredictor(Benchmark& bench, const LoudspeakerModel& model, double sampleRate, const std::vector<float>& tension)
+{
+    NonlinearPredictor<float, numChannels> predictor;
+    predictor.prepare(model, sampleRate);
+    predictor.setXmax(3.0f);
+
+    SosCascade<float, numChannels> cascade;
+    cascade.setCoefficients(designSpeakerCoefficients(model, float(sampleRate)).xu);
+
+    int numSamples = int(tension.size());
+    auto describe = [&](const char* path) {
+        return Benchmark::Description{ "kernel", "NonlinearPredictor", "channel", {
+            { "sampleRate", sampleRate },
+            { "channels", numChannels },
+            { "path", path }
+        } };
+    };
+
+    auto run = [&](auto& kernel) {
+        float sum = 0.0f;
+        std::array<float, numChannels> frame;
+        for (int i = 0; i < numSamples; ++i) {
+            frame.fill(tension[size_t(i)]);
+            kernel.processSample(frame.data());
+            sum += frame[0];
+        }
+        bench.consume(sum);
+    };
+
+    bench.measure(describe("nonlinear"), numSamples * numChannels, [&] { predictor.reset(); }, [&] { run(predictor); });
+    bench.measure(describe("linear"), numSamples * numChannels, [&] { cascade.reset(); }, [&] { run(cascade); });
+}
+
+// The thermal protection of one channel, which only sums the squares of most samples
+static void measureThermalModel(Benchmark& bench, const LoudspeakerModel& model, double sampleRate, const std::vector<float>& tension)
+{
+    ThermalModel thermal;
+    thermal.prepare(model, sampleRate);
+    thermal.setLimits(100.0f, 150.0f);
+    thermal.setEnabled(true);
+
+    int numSamples = int(tension.size());
+    Benchmark::Description description{ "kernel", "ThermalModel", "sample", { { "sampleRate", sampleRate } } };
+    bench.measure(description, numSamples,
+        [&] { thermal.reset(); },
+        [&] {
+            float sum = 0.0f;
+            for (int i = 0; i < numSamples; ++i) {
+                thermal.add(tension[size_t(i)]);
+                sum += thermal.getGain();
+            }
+            bench.consume(sum);
+        });
+}
+
+// The X/U filters of the array mode, per driver: the built-in models in the lanes of the
+// groups, next to one cascade per driver as in as many instances
+static void measureDriverArray(Benchmark& bench, double sampleRate, const std::vector<float>& input)
+{
+    constexpr int numDrivers = DriverArray::maxDrivers;
+    constexpr int numLanes = DriverArray::numLanes;
+    std::array<SosLanes<float, numLanes>, numDrivers / numLanes> groups;
+    std::array<SosCascade<float, 1>, numDrivers> cascades;
+
+    for (int i = 0; i < numDrivers; ++i) {
+        auto model = Parameters::getSpeakerModel(i % Parameters::getNumSpeakerModels());
+        auto coeffs = designSpeakerCoefficients(model, float(sampleRate)).xu;
+        groups[size_t(i / numLanes)].setCoefficients(i % numLanes, coeffs);
+        cascades[size_t(i)].setCoefficients(coeffs);
+    }
+
+    int numSamples = int(input.size());
+    auto describe = [&](const char* path) {
+        return Benchmark::Description{ "kernel", "DriverArray", "channel", {
+            { "sampleRate", sampleRate },
+            { "drivers", numDrivers },
+            { "path", path }
+        } };
+    };
+
+    bench.measure(describe("lanes"), numSamples * numDrivers,
+        [&] { for (auto& group : groups) group.reset(); },
+        [&] {
+            float sum = 0.0f;
+            std::array<float, numDrivers> frame;
+            for (int i = 0; i < numSamples; ++i) {
+                frame.fill(input[size_t(i)]);
+                for (int first = 0; first < numDrivers; first += numLanes)
+                    groups[size_t(first / numLanes)].processSample(frame.data() + first);
+                sum += frame[0];
+            }
+            bench.consume(sum);
+        });
+
+    bench.measure(describe("instances"), numSamples * numDrivers,
+        [&] { for (auto& cascade : cascades) cascade.reset(); },
+        [&] {
+            float sum = 0.0f;
+            for (int i = 0; i < numSamples; ++i) {
+                for (auto& cascade : cascades)
+                    sum += cascade.processSample(input[size_t(i)]);
+            }
+            bench.consume(sum);
+        });
+}
+
+// 4-way crossover: all the bands in the lanes of one cascade, against one stereo cascade per band
+static void measureCrossover(Benchmark& bench, double sampleRate, const std::vector<float>& inputL, const std::vector<float>& inputR)
+{
+    constexpr int numWays = Crossover::maxWays;
+    std::array<float, numWays - 1> frequencies{ 300.0f, 3000.0f, 10000.0f };
+    Crossover crossover;
+    crossover.setFrequencies(numWays, frequencies, sampleRate);
+
+    std::array<SosLanes<float, 2, Crossover::maxSections>, numWays> bands;
+    for (int band = 0; band < numWays; ++band) {
+        std::array<SosSection, Crossover::maxSections> sections;
+        int count = Crossover::designBand(band, numWays, frequencies.data(), sampleRate, sections.data());
+        bands[size_t(band)].setCoefficients(0, sections.data(), count);
+        bands[size_t(band)].setCoefficients(1, sections.data(), count);
+    }
+
+    int numSamples = int(inputL.size());
+    auto describe = [&](const char* path) {
+        return Benchmark::Description{ "kernel", "Crossover", "sample", {
+            { "sampleRate", sampleRate },
+            { "ways", numWays },
+            { "path", path }
+        } };
+    };
+
+    bench.measure(describe("lanes"), numSamples,
+        [&] { crossover.reset(); },
+        [&] {
+            float sum = 0.0f;
+            std::array<float, Crossover::numLanes> frame;
+            for (int i = 0; i < numSamples; ++i) {
+                crossover.processSample(inputL[size_t(i)], inputR[size_t(i)], frame.data());
+                sum += frame[0] + frame[Crossover::numLanes - 1];
+            }
+            bench.consume(sum);
+        });
+
+    bench.measure(describe("bands"), numSamples,
+        [&] { for (auto& band : bands) band.reset(); },
+        [&] {
+            float sum = 0.0f;
+            for (int i = 0; i < numSamples; ++i) {
+                for (auto& band : bands) {
+                    std::array<float, 2> frame{ inputL[size_t(i)], inputR[size_t(i)] };
+                    band.processSample(frame.data());
+                    sum += frame[0] + frame[1];
+                }
+            }
+            bench.consume(sum);
+        });
+}
+
+// The look-ahead kernels (their cost depends on the window lengths), the DF1 biquad,
+// the cascades of the enclosure models, of the array mode and of the crossover, the gain computer, the
+// nonlinear prediction, the thermal protection, the estimator of the adaptive mode and the design of the X/U filter
+void benchmarkKernels(Benchmark& bench)
+{
+    for (auto sampleRate : bench.getOptions().sampleRates) {
+        int numSamples = bench.getNumSamples(sampleRate);
+        auto length = size_t(numSamples);
+        std::vector<float> input(length), inputR(length), gains(length);
+        TestSignals::fillProgramme(input.data(), inputR.data(), numSamples, sampleRate);
+
+        for (size_t i = 0; i < gains.size(); ++i)
+            gains[i] = computeGain(std::abs(input[i]), 0.25f, 0.1f);
+
+        for (const auto& envelope : Benchmark::envelopes) {
+            int nAttack = std::max(1, int(std::ceil(envelope.attackTime * 1e-3 * sampleRate)));
+            int nAttackHold = std::max(1, int(std::ceil((envelope.attackTime + envelope.holdTime) * 1e-3 * sampleRate)));
+
+            auto describe = [&](const char* name, int length) {
+                return Benchmark::Description{ "kernel", name, "sample", {
+                    { "sampleRate", sampleRate },
+                    { "envelope", envelope.name },
+                    { "length", length }
+                } };
+            };
+
+            MinFilter<float> minFilter(nAttackHold);
+            minFilter.set(nAttackHold);
+            bench.measure(describe("MinFilter", nAttackHold), numSamples,
+                [&] { minFilter.reset(); },
+                [&] {
+                    float sum = 0.0f;
+                    for (int i = 0; i < numSamples; ++i) {
+                        minFilter.add(gains[size_t(i)]);
+                        sum += minFilter.getMinimum();
+                    }
+                    bench.consume(sum);
+                });
+
+            BoxFilter<float> boxFilter(nAttack);
+            boxFilter.set(nAttack);
+            bench.measure(describe("BoxFilter", nAttack), numSamples,
+                [&] { boxFilter.reset(1.0f); },
+                [&] {
+                    float sum = 0.0f;
+                    for (int i = 0; i < numSamples; ++i)
+                        sum += boxFilter(gains[size_t(i)]);
+                    bench.consume(sum);
+                });
+
+            DelayLine delayLine;
+            delayLine.setMaximumDelayInSamples(nAttack);
+            bench.measure(describe("DelayLine", nAttack), numSamples,
+                [&] { delayLine.reset(); },
+                [&] {
+                    float sum = 0.0f;
+                    for (int i = 0; i < numSamples; ++i) {
+                        delayLine.write(input[size_t(i)]);
+                        sum += delayLine.read(nAttack);
+                    }
+                    bench.consume(sum);
+                });
+        }
+
+        //the filter and the gain computer do not depend on the envelope
+        auto describe = [&](const char* name) {
+            return Benchmark::Description{ "kernel", name, "sample", { { "sampleRate", sampleRate } } };
+        };
+
+        const auto& model = Parameters::speakerModelData.at(SpeakerModels::modelNames[0]);
+        auto coeffs = getXUFilterCoefficients(model, float(sampleRate), 0.95f);
+        BiquadFilterDF1<float> biquad;
+        biquad.setCoefficients(coeffs.first, coeffs.second);
+        bench.measure(describe("BiquadFilterDF1"), numSamples,
+            [&] { biquad.reset(); },
+            [&] {
+                float sum = 0.0f;
+                for (int i = 0; i < numSamples; ++i)
+                    sum += biquad.processSample(input[size_t(i)]);
+                bench.consume(sum);
+            });
+
+        //a resonance added to the vented model for each order above 4, to time the longer cascades
+        Enclosure box;
+        box.type = Enclosure::vented;
+        box.Vb = 20e-3f;
+        box.fb = model.fs;
+        auto transferFunction = getXUTransferFunction(model.withEnclosure(box));
+
+        for (int order = 2; order <= Sos::maxOrder; order += 2) {
+            AnalogTransferFunction h = order == 2 ? getXUTransferFunction(model) : transferFunction;
+            for (int extra = 4; extra < order; extra += 2) {
+                AnalogTransferFunction resonance;
+                double w = Sos::twoPi * 200.0 * extra;
+                resonance.order = 2;
+                resonance.b = { 1.0, 0.1 * w, 1.2 * w * w };
+                resonance.a = { 1.0, 0.2 * w, w * w };
+                h = multiply(h, resonance);
+            }
+
+            SosCascade<float> cascade;
+            cascade.setCoefficients(designSections(h, sampleRate, 0.95));
+            Benchmark::Description description{ "kernel", "SosCascade", "sample", {
+                { "sampleRate", sampleRate },
+                { "order", order }
+            } };
+            bench.measure(description, numSamples,
+                [&] { cascade.reset(); },
+                [&] {
+                    float sum = 0.0f;
+                    for (int i = 0; i < numSamples; ++i) {
+                        float sampleL = input[size_t(i)];
+                        float sampleR = inputR[size_t(i)];
+                        cascade.processSample(sampleL, sampleR);
+                        sum += sampleL + sampleR;
+                    }
+                    bench.consume(sum);
+                });
+        }
+
+        bench.measure(describe("computeGain"), numSamples,
+            [] {},
+            [&] {
+                float sum = 0.0f;
+                for (int i = 0; i < numSamples; ++i)
+                    sum += computeGain(std::abs(input[size_t(i)]), 0.25f, 0.1f);
+                bench.consume(sum);
+            });
+
+        //the programme at 10 V full scale, as for the simulated driver
+        std::vector<float> tension(input);
+        for (auto& sample : tension)
+            sample *= 10.0f;
+        measurePredictor<1>(bench, model, sampleRate, tension);
+        measurePredictor<2>(bench, model, sampleRate, tension);
+        measurePredictor<4>(bench, model, sampleRate, tension);
+        measureThermalModel(bench, model, sampleRate, tension);
+        measureDriverArray(bench, sampleRate, input);
+        measureCrossover(bench, sampleRate, input, inputR);
+
+        //the programme as a tension and as a current, at 10 V and 2 A full scale, always learning
+        ParameterEstimator estimator;
+        bench.measure(describe("ParameterEstimator"), numSamples,
+            [&] { estimator.prepare(model, sampleRate); },
+            [&] {
+                estimator.process(input.data(), inputR.data(), numSamples, 10.0f, 2.0f);
+                auto estimate = model;
+                bench.consume(estimator.takeModel(estimate) ? estimate.fs : 0.0f);
+            });
+
+        //designed when the sample rate or the speaker model changes
+        const int numCalls = 1000;
+        for (const auto& name : SpeakerModels::modelNames) {
+            const auto& designModel = Parameters::speakerModelData.at(name);
+            Benchmark::Description description{ "kernel", "getXUFilterCoefficients", "call", {
+                { "sampleRate", sampleRate },
+                { "speakerModel", name }
+            } };
+            bench.measure(description, numCalls,
+                [] {},
+                [&] {
+                    float sum = 0.0f;
+                    for (int i = 0; i < numCalls; ++i)
+                        sum += getXUFilterCoefficients(designModel, float(sampleRate), 0.95f).first[0];
+                    bench.consume(sum);
+                });
+
+            Benchmark::Description sosDescription{ "kernel", "getXUSections", "call", {
+                { "sampleRate", sampleRate },
+                { "speakerModel", name },
+                { "enclosure", "vented" }
+            } };
+            auto ventedModel = designModel.withEnclosure(box);
+            bench.measure(sosDescription, numCalls,
+                [] {},
+                [&] {
+                    float sum = 0.0f;
+                    for (int i = 0; i < numCalls; ++i)
+                        sum += getXUSections(ventedModel, float(sampleRate), 0.95f).sections[0].b0;
+                    bench.consume(sum);
+                });
+        }
+    }
+}
+}
+
+#undef JucePlugin_Name
@@ -0,0 +1,176 @@
+/*
+  ==============================================================================
+
+    LowShelfUnit.cpp
+    Created: 19 Oct 2026 4:29:48pm
+    Author:  eliot
+
+    XmaxLowShelf compiled into the tools, in the XmaxLowShelfUnit namespace,
+    with the stage timing of processBlock compiled in (see StageTimer.h).
+    The standard headers used by the plugin are included first, so that
+    they are not declared again inside the namespace.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <complex>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <map>
+#include <memory>
+#include <tuple>
+#include <utility>
+#include <vector>
+#include "PluginUnits.h"
+
+#define JucePlugin_Name "XmaxLowShelf"
+#define XMAX_STAGE_TIMING 1
+
+namespace XmaxLowShelfUnit
+{
+#include "../../XmaxLowShelf/Source/Parameters.cpp"
+#include "../../XmaxLowShelf/Source/PluginProcessor.cpp"
+#include "../../XmaxLowShelf/Source/PluginEditor.cpp"
+#include "../../XmaxLowShelf/Source/LookAndFeel.cpp"
+#include "../../XmaxLowShelf/Source/RotaryKnob.cpp"
+#include "../../XmaxLowShelf/Source/LevelMeter.cpp"
+#include "../../XmaxLowShelf/Source/DisplacementMeter.cpp"
+#include "../../XmaxLowShelf/Source/LoadMeter.cpp"
+#include "../../XmaxLowShelf/Source/PipelineOverlay.cpp"
+#include "../../XmaxLowShelf/Source/CustomDriverPanel.cpp"
+
+std::unique_ptr<juce::AudioProcessor> createProcessor()
+{
+    return std::make_unique<XmaxLowShelfAudioProcessor>();
+}
+
+juce::StringArray getSpeakerModelNames()
+{
+    return SpeakerModels::modelNames;
+}
+
+PlantParameters getPlantParameters(int modelIndex)
+{
+    return makePlantParameters(Parameters::getSpeakerModel(modelIndex));
+}
+
+StageProbe getStageProbe()
+{
+    return makeStageProbe<XmaxLowShelfAudioProcessor>();
+}
+
+float takePeakDisplacement(juce::AudioProcessor& processor)
+{
+    return ::takePeakDisplacement<XmaxLowShelfAudioProcessor>(processor);
+}
+
+float takeGainReduction(juce::AudioProcessor& processor)
+{
+    return ::takeGainReduction<XmaxLowShelfAudioProcessor>(processor);
+}
+
+// The gain computer and the output of processSamples, without the look-ahead delay: the
+// envelope is computed beforehand from the whole file. The parameters are constant offline,
+// so their targets are used from the first sample, without smoothing.
+class LowShelfTwoPassStages : public TwoPassStages
+{
+public:
+    LowShelfTwoPassStages(XmaxLowShelfAudioProcessor& processor, double sampleRate)
+        : snapshot(processor.params.update()),
+          shelfPrototype(processor.getShelfPrototype())
+    {
+        //the custom driver is not in the table of models, the processor keeps it with its state
+        auto model = Parameters::isCustomModel(snapshot.speakerModel) ? processor.getCustomModel()
+                                                                      : Parameters::getSpeakerModel(snapshot.speakerModel);
+        auto coeffs = getXUFilterCoefficients(model, float(sampleRate));
+        for (auto& channel : channels) {
+            channel.xuFilterIn.setCoefficients(coeffs.first, coeffs.second);
+            channel.xuFilterOut.setCoefficients(coeffs.first, coeffs.second);
+            channel.predictor.prepare(model, sampleRate);
+            channel.predictor.setXmax(snapshot.xmax);
+        }
+
+        shelfMode = snapshot.filterMode == 0;
+        threshold = snapshot.thresholdDisplacement * 1e-3f;
+
+        attackTime = snapshot.attackTime;
+        holdTime = snapshot.holdTime;
+        releaseTime = snapshot.releaseTime;
+    }
+
+    void computeGains(int channel, const float* input, float* gains, int numSamples) noexcept override
+    {
+        auto& filter = channels[size_t(channel)].xuFilterIn;
+        auto& predictor = channels[size_t(channel)].predictor;
+
+        for (int i = 0; i < numSamples; ++i) {
+            float inputAmp = input[i] * snapshot.inputGain;
+            float xIn = snapshot.nonlinearPrediction ? predictor.processSample(inputAmp * snapshot.speakerGain)
+                                                     : filter.processSample(inputAmp) * snapshot.speakerGain;
+            gains[i] = computeGain(std::abs(xIn), threshold, snapshot.knee);
+        }
+    }
+
+    float applyGains(int channel, float* channelData, const float* gains, int numSamples) noexcept override
+    {
+        auto& state = channels[size_t(channel)];
+        float maxDisp = 0.0f;
+
+        for (int i = 0; i < numSamples; ++i) {
+            float dry = channelData[i];
+            float inputAmp = dry * snapshot.inputGain;
+            float wet;
+
+            if (shelfMode) {
+                //the identity filter of a new channel is the shelf at 0 dB
+                float shelfGain = 20.0f * std::log10(gains[i]);
+                if (shelfGain != state.lastShelfGain) {
+                    auto shelfCoeffs = getLowShelfCoefficients(shelfPrototype, shelfGain);
+                    state.lowShelfFilter.setCoefficients(shelfCoeffs.first, shelfCoeffs.second);
+                    state.lastShelfGain = shelfGain;
+                }
+                wet = state.lowShelfFilter.processSample(inputAmp);
+            }
+            else { // simple gain mode
+                wet = gains[i] * inputAmp;
+            }
+
+            channelData[i] = (snapshot.mix * wet + (1.0f - snapshot.mix) * dry) * snapshot.gain;
+
+            float xOut = state.xuFilterOut.processSample(wet);
+            maxDisp = std::max(maxDisp, std::abs(xOut * 1e3f * snapshot.speakerGain));
+        }
+        return maxDisp;
+    }
+
+private:
+    struct Channel
+    {
+        BiquadFilterDF1<float> xuFilterIn;  // tension to displacement, for the gain computer
+        BiquadFilterDF1<float> xuFilterOut; // tension to displacement, of the output
+        NonlinearPredictor<float, 1> predictor; // excursion of the nonlinear driver, for the gain computer
+        BiquadFilterTDF2<float> lowShelfFilter;
+        float lastShelfGain = 0.0f;         // dB
+    };
+
+    ParameterSnapshot snapshot;
+    LowShelfPrototype shelfPrototype;
+    std::array<Channel, 2> channels;
+    bool shelfMode = true;
+    float threshold = 1.0f;
+};
+
+std::unique_ptr<TwoPassStages> createTwoPassStages(juce::AudioProcessor& processor, double sampleRate)
+{
+    return std::make_unique<LowShelfTwoPassStages>(static_cast<XmaxLowShelfAudioProcessor&>(processor), sampleRate);
+}
+}
+
+#undef JucePlugin_Name
@@ -0,0 +1,581 @@
+/*
+  ==============================================================================
+
+    Main.cpp
+    Created: 19 Oct 2026 4:02:18pm
+    Author:  eliot
+
+    Command line tools around the three plugins, run without a host.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include <iostream>
+#include "PluginUnits.h"
+#include "Benchmark.h"
+#include "Profiler.h"
+#include "RealtimeCheck.h"
+#include "Regression.h"
+#include "OfflineRender.h"
+#include "BatchRender.h"
+#include "Simulation.h"
+#include "Adaptation.h"
+#include "TestSignals.h"
+
+// "a,b,c" -> { "a", "b", "c" }
+static juce::StringArray getListOption(const juce::ArgumentList& args, juce::StringRef option)
+{
+    auto list = juce::StringArray::fromTokens(args.getValueForOption(option), ",", "");
+    list.trim();
+    list.removeEmptyStrings();
+    return list;
+}
+
+static void checkPluginNames(const juce::StringArray& names)
+{
+    for (const auto& name : names) {
+        if (findPluginUnit(name) == nullptr)
+            juce::ConsoleApplication::fail("Unknown plugin: " + name);
+    }
+}
+
+// Writes the report to the file given with --output, or to the standard output
+static void writeReport(const juce::ArgumentList& args, const juce::var& report)
+{
+    auto json = juce::JSON::toString(report);
+    auto path = args.getValueForOption("--output");
+
+    if (path.isEmpty()) {
+        std::cout << json << std::endl;
+        return;
+    }
+
+    auto file = juce::File::getCurrentWorkingDirectory().getChildFile(path);
+    if (!file.replaceWithText(json))
+        juce::ConsoleApplication::fail("Could not write " + file.getFullPathName());
+
+    std::cerr << "report written to " << file.getFullPathName() << std::endl;
+}
+
+static void runBenchmark(const juce::ArgumentList& args)
+{
+    Benchmark::Options options;
+
+    if (args.containsOption("--rates")) {
+        options.sampleRates.clear();
+        for (const auto& rate : getListOption(args, "--rates"))
+            options.sampleRates.add(rate.getDoubleValue());
+    }
+
+    if (args.containsOption("--blocks")) {
+        options.blockSizes.clear();
+        for (const auto& size : getListOption(args, "--blocks"))
+            options.blockSizes.add(std::max(1, size.getIntValue()));
+    }
+
+    options.plugins = getListOption(args, "--plugins");
+    checkPluginNames(options.plugins);
+
+    if (args.containsOption("--seconds"))
+        options.seconds = args.getValueForOption("--seconds").getDoubleValue();
+    if (args.containsOption("--repeats"))
+        options.repeats = args.getValueForOption("--repeats").getIntValue();
+
+    options.kernels = !args.containsOption("--processors-only");
+    options.processors = !args.containsOption("--kernels-only");
+    options.full = args.containsOption("--full");
+
+    Benchmark benchmark(options);
+    benchmark.run();
+    writeReport(args, benchmark.getReport());
+}
+
+static void runProfiler(const juce::ArgumentList& args)
+{
+    Profiler::Options options;
+
+    options.plugins = getListOption(args, "--plugins");
+    checkPluginNames(options.plugins);
+
+    options.scenarios = getListOption(args, "--scenarios");
+    for (const auto& name : options.scenarios) {
+        auto scenarios = Profiler::getScenarios();
+        if (std::none_of(scenarios.begin(), scenarios.end(), [&](const Profiler::Scenario& s) { return s.name.equalsIgnoreCase(name); }))
+            juce::ConsoleApplication::fail("Unknown scenario: " + name);
+    }
+
+    if (args.containsOption("--rate"))
+        options.sampleRate = args.getValueForOption("--rate").getDoubleValue();
+    if (args.containsOption("--block"))
+        options.blockSize = args.getValueForOption("--block").getIntValue();
+    if (args.containsOption("--seconds"))
+        options.seconds = args.getValueForOption("--seconds").getDoubleValue();
+    if (args.containsOption("--outliers"))
+        options.numOutliers = args.getValueForOption("--outliers").getIntValue();
+
+    if (options.sampleRate <= 0.0 || options.blockSize <= 0)
+        juce::ConsoleApplication::fail("Invalid sample rate or block size");
+
+    Profiler profiler(options);
+    profiler.run();
+    writeReport(args, profiler.getReport());
+}
+
+static void runRealtimeCheck(const juce::ArgumentList& args)
+{
+    RealtimeCheck::Options options;
+
+    options.plugins = getListOption(args, "--plugins");
+    checkPluginNames(options.plugins);
+
+    if (args.containsOption("--rate"))
+        options.sampleRate = args.getValueForOption("--rate").getDoubleValue();
+    if (args.containsOption("--block"))
+        options.blockSize = args.getValueForOption("--block").getIntValue();
+    if (args.containsOption("--blocks"))
+        options.blocksPerStep = args.getValueForOption("--blocks").getIntValue();
+    options.verbose = args.containsOption("--verbose");
+
+    if (options.sampleRate <= 0.0 || options.blockSize <= 0)
+        juce::ConsoleApplication::fail("Invalid sample rate or block size");
+
+    RealtimeCheck check(options);
+    int numFailures = check.run();
+
+    if (numFailures > 0)
+        juce::ConsoleApplication::fail(juce::String(numFailures) + " steps are not real-time safe");
+}
+
+static void runRegression(const juce::ArgumentList& args)
+{
+    Regression::Options options;
+
+    options.plugins = getListOption(args, "--plugins");
+    checkPluginNames(options.plugins);
+
+    auto directory = args.containsOption("--references") ? args.getValueForOption("--references") : juce::String("regression");
+    options.directory = juce::File::getCurrentWorkingDirectory().getChildFile(directory);
+
+    if (args.containsOption("--rate"))
+        options.sampleRate = args.getValueForOption("--rate").getDoubleValue();
+    if (args.containsOption("--block"))
+        options.blockSize = args.getValueForOption("--block").getIntValue();
+    if (args.containsOption("--seconds"))
+        options.seconds = args.getValueForOption("--seconds").getDoubleValue();
+    options.verbose = args.containsOption("--verbose");
+
+    if (options.sampleRate <= 0.0 || options.blockSize <= 0 || options.seconds <= 0.0)
+        juce::ConsoleApplication::fail("Invalid sample rate, block size or length");
+
+    Regression regression(options);
+
+    if (args.containsOption("--record")) {
+        if (!regression.record())
+            juce::ConsoleApplication::fail("Could not record the references");
+        return;
+    }
+
+    int numFailures = regression.compare();
+    if (numFailures > 0)
+        juce::ConsoleApplication::fail(juce::String(numFailures) + " cases differ from their reference");
+}
+
+// The options shared by render and batch: the plugin, its parameters and the processing
+static OfflineRender::Options getRenderOptions(const juce::ArgumentList& args)
+{
+    OfflineRender::Options options;
+
+    options.plugin = args.getValueForOption("--plugin");
+    if (findPluginUnit(options.plugin) == nullptr)
+        juce::ConsoleApplication::fail("Unknown plugin: " + options.plugin);
+
+    // --set=thresholdDisplacement=2.5,speakeModel=...
+    for (const auto& assignment : getListOption(args, "--set")) {
+        auto parameterID = assignment.upToFirstOccurrenceOf("=", false, false).trim();
+        auto value = assignment.fromFirstOccurrenceOf("=", false, false).trim();
+        if (parameterID.isEmpty() || !assignment.contains("="))
+            juce::ConsoleApplication::fail("Expected ID=value: " + assignment);
+        options.parameters.emplace_back(parameterID, value);
+    }
+
+    if (args.containsOption("--block"))
+        options.blockSize = args.getValueForOption("--block").getIntValue();
+    if (args.containsOption("--chunk"))
+        options.chunkSize = args.getValueForOption("--chunk").getIntValue();
+    if (args.containsOption("--rate"))
+        options.rawSampleRate = args.getValueForOption("--rate").getDoubleValue();
+    if (args.containsOption("--channels"))
+        options.rawNumChannels = args.getValueForOption("--channels").getIntValue();
+    if (args.containsOption("--bits"))
+        options.bitsPerSample = args.getValueForOption("--bits").getIntValue();
+    options.compensateLatency = !args.containsOption("--keep-latency");
+
+    if (options.blockSize <= 0 || options.chunkSize <= 0)
+        juce::ConsoleApplication::fail("Invalid block or chunk size");
+
+    return options;
+}
+
+static void runRender(const juce::ArgumentList& args)
+{
+    auto options = getRenderOptions(args);
+    auto cwd = juce::File::getCurrentWorkingDirectory();
+
+    if (!args.containsOption("--input") || !args.containsOption("--output"))
+        juce::ConsoleApplication::fail("An --input and an --output file are needed");
+    options.input = cwd.getChildFile(args.getValueForOption("--input"));
+    options.output = cwd.getChildFile(args.getValueForOption("--output"));
+
+    if (args.containsOption("--csv"))
+        options.csv = cwd.getChildFile(args.getValueForOption("--csv"));
+    if (args.containsOption("--preset"))
+        options.preset = cwd.getChildFile(args.getValueForOption("--preset"));
+
+    if (args.containsOption("--threads"))
+        options.numThreads = args.getValueForOption("--threads").getIntValue();
+    if (args.containsOption("--segment"))
+        options.segmentSeconds = args.getValueForOption("--segment").getDoubleValue();
+    if (args.containsOption("--preroll"))
+        options.prerollSeconds = args.getValueForOption("--preroll").getDoubleValue();
+    if (options.numThreads == 0)
+        options.numThreads = juce::SystemStats::getNumCpus();
+    if (options.numThreads < 0 || options.segmentSeconds <= 0.0)
+        juce::ConsoleApplication::fail("Invalid number of threads or segment length");
+
+    bool twoPass = args.containsOption("--two-pass");
+    if (args.containsOption("--attack"))
+        options.attackTime = args.getValueForOption("--attack").getDoubleValue();
+    if (args.containsOption("--hold"))
+        options.holdTime = args.getValueForOption("--hold").getDoubleValue();
+    if (args.containsOption("--release"))
+        options.releaseTime = args.getValueForOption("--release").getDoubleValue();
+    if (args.containsOption("--smoothing"))
+        options.smoothingTime = args.getValueForOption("--smoothing").getDoubleValue();
+
+    if (twoPass && args.containsOption("--verify"))
+        juce::ConsoleApplication::fail("--verify compares a render on several threads with one on a single thread, not a two-pass render");
+
+    bool parallel = options.numThreads > 1 && !twoPass;
+    OfflineRender render(options);
+    auto result = twoPass ? render.runTwoPass() : parallel ? render.runParallel() : render.run();
+    if (result.failed())
+        juce::ConsoleApplication::fail(result.getErrorMessage());
+
+    const auto& statistics = render.getStatistics();
+    auto duration = double(statistics.numSamples) / statistics.sampleRate;
+    std::cerr << options.output.getFileName() << ": " << duration << " s rendered in " << statistics.seconds << " s ("
+              << juce::roundToInt(duration / std::max(statistics.seconds, 1e-9)) << "x real time)";
+    if (parallel)
+        std::cerr << " on " << options.numThreads << " threads, " << statistics.prerollSeconds << " s of pre-roll per segment";
+    std::cerr << std::endl;
+    if (twoPass)
+        std::cerr << "  sidechain " << statistics.passSeconds[0] << " s, attack and release " << statistics.passSeconds[1]
+                  << " s, smoothing " << statistics.passSeconds[2] << " s, output " << statistics.passSeconds[3] << " s" << std::endl;
+    std::cerr << "  max gain reduction " << statistics.maxGainReduction << " dB, peak displacement "
+              << statistics.peakDisplacement << " mm, " << statistics.numBlocksOverThreshold << " of "
+              << statistics.numBlocks << " blocks over thresholdDisplacement";
+    if (statistics.latency > 0)
+        std::cerr << ", " << statistics.latency << " samples of latency removed";
+    std::cerr << std::endl;
+
+    if (!args.containsOption("--verify"))
+        return;
+
+    //the single-threaded render, next to the output and in its format
+    auto serialOptions = options;
+    serialOptions.output = options.output.getNonexistentSibling();
+    serialOptions.csv = juce::File();
+
+    OfflineRender serialRender(serialOptions);
+    result = serialRender.run();
+
+    OfflineRender::Deviation deviation;
+    if (result.wasOk())
+        result = OfflineRender::compareFiles(options.output, serialOptions.output, options, deviation);
+    serialOptions.output.deleteFile();
+    if (result.failed())
+        juce::ConsoleApplication::fail(result.getErrorMessage());
+
+    auto serialSeconds = serialRender.getStatistics().seconds;
+    std::cerr << "  single-threaded render: " << serialSeconds << " s, speed-up " << serialSeconds / std::max(statistics.seconds, 1e-9)
+              << ", max deviation " << deviation.maxDifference << " (" << juce::Decibels::toString(juce::Decibels::gainToDecibels(deviation.maxDifference))
+              << ") at " << double(deviation.position) / statistics.sampleRate << " s, " << deviation.numDifferentSamples
+              << " samples differ" << std::endl;
+}
+
+static void runBatch(const juce::ArgumentList& args)
+{
+    BatchRender::Options options;
+    options.render = getRenderOptions(args);
+    auto cwd = juce::File::getCurrentWorkingDirectory();
+
+    juce::Array<juce::File> inputs;
+    for (const auto& path : getListOption(args, "--inputs"))
+        inputs.add(cwd.getChildFile(path));
+    options.inputs = BatchRender::findAudioFiles(inputs);
+
+    for (const auto& path : getListOption(args, "--presets"))
+        options.presets.add(cwd.getChildFile(path));
+
+    options.models = getListOption(args, "--models");
+    if (options.models.contains("all"))
+        options.models = findPluginUnit(options.render.plugin)->getSpeakerModelNames();
+
+    if (!args.containsOption("--output-dir"))
+        juce::ConsoleApplication::fail("An --output-dir is needed");
+    options.outputDirectory = cwd.getChildFile(args.getValueForOption("--output-dir"));
+    options.writeCsv = args.containsOption("--csv");
+
+    if (args.containsOption("--threads"))
+        options.numThreads = args.getValueForOption("--threads").getIntValue();
+
+    BatchRender batch(options);
+    auto result = batch.run();
+    if (result.failed())
+        juce::ConsoleApplication::fail(result.getErrorMessage());
+
+    auto report = batch.getReport();
+    writeReport(args, report);
+
+    const auto& summary = report["summary"];
+    std::cerr << double(summary["seconds"]) << " s of audio in " << double(summary["wallSeconds"]) << " s on "
+              << int(summary["threads"]) << " threads: " << juce::roundToInt(double(summary["realtimeFactorPerCore"]))
+              << "x real time per core" << std::endl;
+
+    int numFailures = batch.getNumFailures();
+    if (numFailures > 0)
+        juce::ConsoleApplication::fail(juce::String(numFailures) + " jobs failed");
+}
+
+static void runSpeakers(const juce::ArgumentList& args)
+{
+    if (!args.containsOption("--input"))
+        juce::ConsoleApplication::fail("An --input file of drivers is needed");
+
+    auto cwd = juce::File::getCurrentWorkingDirectory();
+    auto source = cwd.getChildFile(args.getValueForOption("--input"));
+    auto cache = args.containsOption("--output") ? cwd.getChildFile(args.getValueForOption("--output"))
+                                                 : source.withFileExtension("xspk");
+
+    auto result = XmaxLimiterUnit::compileSpeakerDatabase(source, cache, args.getValueForOption("--search"));
+    if (result.failed())
+        juce::ConsoleApplication::fail(result.getErrorMessage());
+}
+
+static void runSimulation(const juce::ArgumentList& args)
+{
+    Simulation::Options options;
+
+    options.plugins = getListOption(args, "--plugins");
+    checkPluginNames(options.plugins);
+    options.models = getListOption(args, "--models");
+
+    if (args.containsOption("--signals"))
+        options.signals = getListOption(args, "--signals");
+    for (const auto& name : options.signals) {
+        if (TestSignals::findGenerator(name) == nullptr)
+            juce::ConsoleApplication::fail("Unknown signal: " + name);
+    }
+
+    // --set=speakerGain=26,attackTime=1
+    for (const auto& assignment : getListOption(args, "--set")) {
+        auto parameterID = assignment.upToFirstOccurrenceOf("=", false, false).trim();
+        auto value = assignment.fromFirstOccurrenceOf("=", false, false).trim();
+        if (parameterID.isEmpty() || !assignment.contains("="))
+            juce::ConsoleApplication::fail("Expected ID=value: " + assignment);
+        options.parameters.emplace_back(parameterID, value);
+    }
+
+    if (args.containsOption("--rate"))
+        options.sampleRate = args.getValueForOption("--rate").getDoubleValue();
+    if (args.containsOption("--block"))
+        options.blockSize = args.getValueForOption("--block").getIntValue();
+    if (args.containsOption("--seconds"))
+        options.seconds = args.getValueForOption("--seconds").getDoubleValue();
+    if (args.containsOption("--threshold"))
+        options.threshold = args.getValueForOption("--threshold").getDoubleValue();
+    if (args.containsOption("--xmax"))
+        options.xmax = args.getValueForOption("--xmax").getDoubleValue();
+    if (args.containsOption("--tolerance"))
+        options.tolerance = args.getValueForOption("--tolerance").getDoubleValue() / 100.0;
+    options.linear = args.containsOption("--linear");
+    options.modelSwitch = !args.containsOption("--no-switch");
+    options.verbose = args.containsOption("--verbose");
+
+    if (options.sampleRate <= 0.0 || options.blockSize <= 0 || options.seconds <= 0.0)
+        juce::ConsoleApplication::fail("Invalid sample rate, block size or length");
+
+    Simulation simulation(options);
+    int numFailures = simulation.run();
+    writeReport(args, simulation.getReport());
+
+    if (numFailures > 0)
+        juce::ConsoleApplication::fail(juce::String(numFailures) + " cases exceed the threshold on the simulated driver");
+}
+
+static void runAdaptation(const juce::ArgumentList& args)
+{
+    Adaptation::Options options;
+
+    options.model = args.getValueForOption("--model");
+    if (args.containsOption("--signal"))
+        options.signal = args.getValueForOption("--signal");
+    if (TestSignals::findGenerator(options.signal) == nullptr)
+        juce::ConsoleApplication::fail("Unknown signal: " + options.signal);
+
+    for (const auto& assignment : getListOption(args, "--set")) {
+        auto parameterID = assignment.upToFirstOccurrenceOf("=", false, false).trim();
+        auto value = assignment.fromFirstOccurrenceOf("=", false, false).trim();
+        if (parameterID.isEmpty() || !assignment.contains("="))
+            juce::ConsoleApplication::fail("Expected ID=value: " + assignment);
+        options.parameters.emplace_back(parameterID, value);
+    }
+
+    //drifts and tolerance in percent
+    if (args.containsOption("--re"))
+        options.reDrift = args.getValueForOption("--re").getDoubleValue() / 100.0;
+    if (args.containsOption("--fs"))
+        options.fsDrift = args.getValueForOption("--fs").getDoubleValue() / 100.0;
+    if (args.containsOption("--bl"))
+        options.blDrift = args.getValueForOption("--bl").getDoubleValue() / 100.0;
+    if (args.containsOption("--tolerance"))
+        options.tolerance = args.getValueForOption("--tolerance").getDoubleValue() / 100.0;
+    if (args.containsOption("--noise"))
+        options.senseNoise = args.getValueForOption("--noise").getDoubleValue();
+
+    if (args.containsOption("--rate"))
+        options.sampleRate = args.getValueForOption("--rate").getDoubleValue();
+    if (args.containsOption("--block"))
+        options.blockSize = args.getValueForOption("--block").getIntValue();
+    if (args.containsOption("--seconds"))
+        options.seconds = args.getValueForOption("--seconds").getDoubleValue();
+
+    if (options.sampleRate <= 0.0 || options.blockSize <= 0 || options.seconds <= 0.0)
+        juce::ConsoleApplication::fail("Invalid sample rate, block size or length");
+
+    Adaptation adaptation(options);
+    int numFailures = adaptation.run();
+    writeReport(args, adaptation.getReport());
+
+    if (numFailures > 0)
+        juce::ConsoleApplication::fail(juce::String(numFailures) + " parameters not tracked within the tolerance");
+}
+
+//==============================================================================
+int main(int argc, char* argv[])
+{
+    //the parameters of the processors need a message manager, even without any editor
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    juce::ConsoleApplication app;
+    app.addHelpCommand("--help|-h", "XmaxTools, command line tools for the Xmax plugins", true);
+
+    app.addCommand({ "bench",
+                     "bench [--plugins=Limiter,LowShelf,Feedback] [--rates=44100,...] [--blocks=1,...] [--seconds=1] [--repeats=5] "
+                     "[--kernels-only|--processors-only] [--full] [--output=report.json]",
+                     "Measures the DSP kernels and processBlock of each plugin, in ns and cycles per sample",
+                     "Writes a JSON report, to compare the performance of two releases on the same machine.\n"
+                     "--full measures every combination of sample rate, block size, envelope and speaker model, "
+                     "instead of one sweep per setting.",
+                     runBenchmark });
+
+    app.addCommand({ "profile",
+                     "profile [--plugins=Limiter,LowShelf,Feedback] [--scenarios=decreasingPeaks,...] [--rate=48000] [--block=256] "
+                     "[--seconds=10] [--outliers=10] [--output=profile.json]",
+                     "Times every block of each plugin driven by adversarial signals, and reports the worst cases",
+                     "Writes a JSON report with the percentiles (up to p99.9), the maximum, the jitter and a histogram "
+                     "of the block times against the real-time budget, and the slowest blocks with the stage of "
+                     "processBlock that caused them.\n"
+                     "Scenarios: programme, decreasingPeaks, thresholdBursts, resonanceSweep, denormalTails, resonanceTones, pinkNoise, "
+                     "modelSwitches.",
+                     runProfiler });
+
+    app.addCommand({ "rtcheck",
+                     "rtcheck [--plugins=Limiter,LowShelf,Feedback] [--rate=48000] [--block=256] [--blocks=16] [--verbose]",
+                     "Fails if processBlock allocates, frees, locks or makes a blocking system call",
+                     "Runs each plugin from its first block, across every value of each parameter (speaker models and "
+                     "modes included) and under random automation, and prints the call stack of the first offending "
+                     "call of each failed step. The exit code is not zero if any step failed.",
+                     runRealtimeCheck });
+
+    app.addCommand({ "regress",
+                     "regress [--record] [--references=regression] [--plugins=Limiter,LowShelf,Feedback] [--rate=48000] "
+                     "[--block=512] [--seconds=2] [--verbose]",
+                     "Compares the output and the predicted displacement of each plugin with stored references",
+                     "Renders a corpus of test signals (tones and sweeps around the driver resonances, threshold bursts, "
+                     "decreasing peaks, pink noise, programme) through each plugin with a matrix of settings. With "
+                     "--record, the results are stored as the references, to do before an optimisation. Otherwise they "
+                     "are rendered again with the rate, block size and length of the references, and the command fails "
+                     "if an output differs by more than the tolerance of its signal, if a peak displacement grew, or if "
+                     "the displacement of a block exceeds thresholdDisplacement where the reference did not.",
+                     runRegression });
+
+    app.addCommand({ "render",
+                     "render --plugin=Limiter --input=in.wav --output=out.wav [--csv=blocks.csv] [--preset=preset.json] "
+                     "[--set=ID=value,...] [--block=512] [--chunk=65536] [--rate=48000] [--channels=2] [--bits=24] [--keep-latency] "
+                     "[--threads=1] [--segment=30] [--preroll=seconds] [--verify] "
+                     "[--two-pass [--attack=ms] [--hold=ms] [--release=ms] [--smoothing=1]]",
+                     "Renders an audio file through a plugin, as fast as possible",
+                     "Reads WAV, AIFF, FLAC or raw interleaved 32-bit floats (.f32 or .raw, with --rate and --channels), "
+                     "and writes the output in the format of its extension (32-bit float by default, or --bits). "
+                     "The preset is a state saved by the plugin (XML or binary) or a JSON object of parameter IDs and values; "
+                     "--set overrides it, with values in the units of the editor or the name of a choice. "
+                     "The latency reported by the plugin is removed unless --keep-latency is given. "
+                     "--csv lists the gain reduction (dB) and the peak predicted displacement (mm) of every block. "
+                     "With --threads (0 for one per core), the file is split in segments of --segment seconds rendered "
+                     "at once, each warmed up on the --preroll seconds before it (by default, from the release, attack, "
+                     "hold and look-ahead times). --verify renders the file again on one thread and prints the largest "
+                     "difference between the two outputs. "
+                     "With --two-pass (Limiter and LowShelf), the gain envelope is computed from the whole file before "
+                     "the output is rendered: the attack is not limited by the look-ahead, there is no latency, and "
+                     "--attack, --hold and --release override the envelope times of the settings.",
+                     runRender });
+
+    app.addCommand({ "batch",
+                     "batch --plugin=Limiter --inputs=corpus/,extra.wav --output-dir=rendered [--presets=a.json,b.xml] "
+                     "[--models=all|name,...] [--set=ID=value,...] [--threads=0] [--csv] [--output=batch.json] (and the options of render)",
+                     "Renders every file with every preset and speaker model, on all the cores",
+                     "Directories are searched for audio files recursively. Each thread reuses one processor between its jobs, "
+                     "and takes more jobs from the other threads once its own are done. Writes a JSON report with the peak "
+                     "displacement, the gain reduction and the speed of every job, and the real-time factor per core "
+                     "of the whole batch. The exit code is not zero if any job failed.",
+                     runBatch });
+
+    app.addCommand({ "speakers",
+                     "speakers --input=drivers.csv [--output=drivers.xspk] [--search=text]",
+                     "Compiles a database of drivers for the Limiter into its binary cache",
+                     "The input is a JSON array of objects or a CSV table with a header line, with the Thiele/Small "
+                     "parameters in SI units: name, fs, Rec, Lec, Qms, Qes, Qts, Mms, Cms, Bl, Vas, Sd, and for a box, "
+                     "box (sealed, vented or passiveRadiator), Vb, fb, fp and Ql. fs, Rec, Qms, Qes, Sd and one of Cms, "
+                     "Vas or Mms are needed, the others are derived. The Limiter reads Speakers.json or Speakers.csv "
+                     "in the Xmax folder of the user application data, and compiles it itself when it changed. "
+                     "--search prints the drivers with a word starting with each word of the text.",
+                     runSpeakers });
+
+    app.addCommand({ "simulate",
+                     "simulate [--plugins=Limiter,LowShelf,Feedback] [--models=name,...] [--signals=resonanceTones,...] [--rate=48000] "
+                     "[--block=512] [--seconds=4] [--set=ID=value,...] [--threshold=mm] [--xmax=mm] [--linear] [--tolerance=10] "
+                     "[--no-switch] [--verbose] [--output=simulation.json]",
+                     "Drives a simulated nonlinear loudspeaker with the output of each plugin, and checks its true excursion",
+                     "The output of the plugin, amplified by speakerGain (20 dB unless set), drives a lumped model of the "
+                     "same speaker model and box, integrated far faster than real time. Bl, the stiffness and the inductance "
+                     "vary with the displacement as in a typical driver of this --xmax (the threshold by default), or not "
+                     "with --linear. Each plugin is also switched, under a full-scale bass tone, from the selected model "
+                     "that moves the least to the one that moves the most, unless --no-switch. Writes a JSON report of the predicted and the true peak excursion of every case; the "
+                     "exit code is not zero if the true excursion exceeds the threshold by more than --tolerance percent.",
+                     runSimulation });
+
+    app.addCommand({ "adapt",
+                     "adapt [--model=name] [--re=30] [--fs=-10] [--bl=-5] [--noise=0.001] [--signal=pinkNoise] [--rate=48000] "
+                     "[--block=512] [--seconds=10] [--set=ID=value,...] [--tolerance=5] [--output=adaptation.json]",
+                     "Checks that the adaptive mode of the Limiter tracks a drifted driver from its sense inputs",
+                     "The output of the Limiter drives a simulated driver whose Re, resonance and Bl drifted by the given "
+                     "percentages from the speaker model; its tension and its current, with --noise amperes RMS of sense "
+                     "noise, are fed back to the sense inputs of the next block. Writes a JSON report with the model "
+                     "tracked after each second; the exit code is not zero if fs, Qts, Re or Bl is off by more than "
+                     "--tolerance percent at the end. Only the models on a baffle or in a sealed box are tracked.",
+                     runAdaptation });
+
+    return app.findAndRunCommand(argc, argv);
+}
@@ -0,0 +1,945 @@
+/*
+  ==============================================================================
+
+    OfflineRender.cpp
+    Created: 19 Oct 2026 10:52:17pm
+    Author:  eliot
+
+  ==============================================================================
+*/
+
+#include "OfflineRender.h"
+#include "HeadlessProcessor.h"
+#include "PluginUnits.h"
+#include "TwoPassEnvelope.h"
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <functional>
+#include <future>
+
+// Reads a file of any format known to JUCE, or a raw file of interleaved little-endian floats
+class OfflineRender::Input
+{
+public:
+    // Reads numSamples from a position of the file into both channels of the buffer, a mono
+    // file into both of them; outside of the file, the buffer is filled with silence
+    bool read(juce::AudioBuffer<float>& buffer, int startSample, juce::int64 position, int numSamples)
+    {
+        buffer.clear(startSample, numSamples);
+        auto numToRead = int(std::max<juce::int64>(0, std::min<juce::int64>(numSamples, length - position)));
+        bool ok = true;
+
+        if (numToRead > 0 && reader != nullptr) {
+            ok = reader->read(&buffer, startSample, numToRead, position, true, numChannels > 1);
+        }
+        else if (numToRead > 0) {
+            auto frameSize = juce::int64(sizeof(float)) * numChannels;
+            ok = stream->setPosition(position * frameSize);
+
+            //in pieces of the size of the interleaved buffer
+            for (int done = 0; done < numToRead && ok;) {
+                int numFrames = std::min(numToRead - done, int(interleaved.size()) / numChannels);
+                auto numBytes = int(numFrames * frameSize);
+                ok = stream->read(interleaved.data(), numBytes) == numBytes;
+
+                for (int channel = 0; channel < numChannels; ++channel) {
+                    auto* channelData = buffer.getWritePointer(channel, startSample + done);
+                    for (int i = 0; i < numFrames; ++i)
+                        channelData[i] = interleaved[size_t(i * numChannels + channel)];
+                }
+                done += numFrames;
+            }
+        }
+
+        if (numChannels == 1)
+            buffer.copyFrom(1, startSample, buffer, 0, startSample, numSamples);
+
+        return ok;
+    }
+
+    std::unique_ptr<juce::AudioFormatReader> reader;
+    std::unique_ptr<juce::FileInputStream> stream; // raw file
+    std::vector<float> interleaved;
+    double sampleRate = 0.0;
+    juce::int64 length = 0;
+    int numChannels = 0;
+};
+
+// Writes the channels of the input file, with an AudioFormatWriter or as raw interleaved floats
+class OfflineRender::Output
+{
+public:
+    bool write(const juce::AudioBuffer<float>& buffer, int startSample, int numSamples)
+    {
+        if (writer != nullptr)
+            return writer->writeFromAudioSampleBuffer(buffer, startSample, numSamples);
+
+        for (int channel = 0; channel < numChannels; ++channel) {
+            auto* channelData = buffer.getReadPointer(channel, startSample);
+            for (int i = 0; i < numSamples; ++i)
+                interleaved[size_t(i * numChannels + channel)] = channelData[i];
+        }
+        return stream->write(interleaved.data(), size_t(numSamples) * size_t(numChannels) * sizeof(float));
+    }
+
+    bool flush()
+    {
+        if (writer != nullptr)
+            return writer->flush();
+
+        stream->flush();
+        return stream->getStatus().wasOk();
+    }
+
+    std::unique_ptr<juce::AudioFormatWriter> writer;
+    std::unique_ptr<juce::FileOutputStream> stream; // raw file
+    std::vector<float> interleaved;
+    int numChannels = 0;
+};
+
+// One of the buffers going round between the reader, the processor and the writer
+struct OfflineRender::Chunk
+{
+    juce::AudioBuffer<float> buffer;
+    int numSamples = 0;            // 0 once the whole file has been read
+    juce::MemoryOutputStream rows; // CSV rows of its blocks
+    Statistics meters;             // of its blocks
+};
+
+OfflineRender::OfflineRender(const Options& renderOptions)
+    : options(renderOptions)
+{
+    //whole blocks in each chunk, so that the rows of the CSV are regular
+    options.blockSize = std::max(1, options.blockSize);
+    options.chunkSize = std::max(1, (options.chunkSize + options.blockSize - 1) / options.blockSize) * options.blockSize;
+}
+
+OfflineRender::~OfflineRender()
+{
+}
+
+bool OfflineRender::isRawFile(const juce::File& file)
+{
+    return file.hasFileExtension("f32;raw");
+}
+
+//==============================================================================
+static juce::Result setParameter(HeadlessProcessor& processor, const juce::String& parameterID, const juce::String& value)
+{
+    if (processor.setParameterText(parameterID, value))
+        return juce::Result::ok();
+
+    if (!processor.hasParameter(parameterID)) {
+        juce::StringArray parameterIDs;
+        for (auto* parameter : processor.getParameters())
+            parameterIDs.add(parameter->getParameterID());
+
+        return juce::Result::fail(processor.getUnit().name + " has no parameter " + parameterID
+                                  + " (" + parameterIDs.joinIntoString(", ") + ")");
+    }
+    return juce::Result::fail("Invalid value for " + parameterID + ": " + value);
+}
+
+// A state saved by the plugin, in binary as hosts store it or as XML text, goes through
+// setStateInformation; otherwise the preset is a JSON object of parameter IDs and values
+juce::Result OfflineRender::applyPreset(HeadlessProcessor& processor) const
+{
+    if (options.preset.getFullPathName().isEmpty())
+        return juce::Result::ok();
+
+    juce::MemoryBlock data;
+    if (!options.preset.loadFileAsData(data))
+        return juce::Result::fail("Cannot read " + options.preset.getFullPathName());
+
+    auto& plugin = processor.getProcessor();
+
+    if (juce::AudioProcessor::getXmlFromBinary(data.getData(), int(data.getSize())) != nullptr) {
+        plugin.setStateInformation(data.getData(), int(data.getSize()));
+        return juce::Result::ok();
+    }
+
+    auto text = data.toString();
+
+    if (auto xml = juce::parseXML(text)) {
+        juce::MemoryBlock state;
+        juce::AudioProcessor::copyXmlToBinary(*xml, state);
+        plugin.setStateInformation(state.getData(), int(state.getSize()));
+        return juce::Result::ok();
+    }
+
+    auto json = juce::JSON::parse(text);
+    auto* object = json.getDynamicObject();
+    if (object == nullptr)
+        return juce::Result::fail(options.preset.getFullPathName() + " is neither a plugin state nor a JSON object of parameters");
+
+    for (const auto& property : object->getProperties()) {
+        auto result = setParameter(processor, property.name.toString(), property.value.toString());
+        if (result.failed())
+            return result;
+    }
+    return juce::Result::ok();
+}
+
+juce::Result OfflineRender::applyParameters(HeadlessProcessor& processor) const
+{
+    for (const auto& parameter : options.parameters) {
+        auto result = setParameter(processor, parameter.first, parameter.second);
+        if (result.failed())
+            return result;
+    }
+    return juce::Result::ok();
+}
+
+
+// The parameters of a new instance, then the preset and the parameters of the options
+juce::Result OfflineRender::configure(HeadlessProcessor& processor) const
+{
+    processor.resetParameters();
+
+    auto result = applyPreset(processor);
+    if (result.failed())
+        return result;
+
+    return applyParameters(processor);
+}
+
+// The release has the longest memory: releaseTime is its 10-90% time (2.2 time constants), so
+// four of them take the initial state down by 76 dB. The look-ahead windows are flushed after
+// the attack, hold and look-ahead times, and the X/U filters settle within 200 ms.
+double OfflineRender::getDefaultPreroll(const HeadlessProcessor& processor) const
+{
+    double milliseconds = 200.0 + 4.0 * processor.getParameter(HeadlessProcessor::releaseTimeID);
+    for (auto* parameterID : { HeadlessProcessor::attackTimeID, HeadlessProcessor::holdTimeID, HeadlessProcessor::lookAheadTimeID })
+        milliseconds += processor.getParameter(parameterID);
+
+    return milliseconds * 1e-3;
+}
+
+//==============================================================================
+juce::Result OfflineRender::openInput(const juce::File& file, const Options& options, std::unique_ptr<Input>& input)
+{
+    auto path = file.getFullPathName();
+    if (!file.existsAsFile())
+        return juce::Result::fail("Cannot find " + path);
+
+    input = std::make_unique<Input>();
+
+    if (isRawFile(file)) {
+        input->stream = std::make_unique<juce::FileInputStream>(file);
+        if (!input->stream->openedOk())
+            return juce::Result::fail("Cannot open " + path);
+
+        input->sampleRate = options.rawSampleRate;
+        input->numChannels = options.rawNumChannels;
+        input->length = file.getSize() / juce::int64(sizeof(float) * size_t(std::max(1, input->numChannels)));
+    }
+    else {
+        juce::AudioFormatManager formats;
+        formats.registerBasicFormats();
+
+        input->reader.reset(formats.createReaderFor(file));
+        if (input->reader == nullptr)
+            return juce::Result::fail("Cannot read " + path + ", which is neither an audio file nor raw floats (.f32, .raw)");
+
+        input->sampleRate = input->reader->sampleRate;
+        input->numChannels = int(input->reader->numChannels);
+        input->length = input->reader->lengthInSamples;
+    }
+
+    if (input->numChannels < 1 || input->numChannels > 2)
+        return juce::Result::fail("The plugins are stereo, " + path + " has " + juce::String(input->numChannels) + " channels");
+    if (input->sampleRate <= 0.0)
+        return juce::Result::fail("Invalid sample rate");
+
+    input->interleaved.resize(size_t(options.chunkSize) * size_t(input->numChannels));
+    return juce::Result::ok();
+}
+
+juce::Result OfflineRender::openOutput()
+{
+    auto file = options.output;
+    auto path = file.getFullPathName();
+
+    if (file == options.input)
+        return juce::Result::fail("The output would overwrite the input");
+
+    //a FileOutputStream appends to an existing file
+    if (file.exists() && !file.deleteFile())
+        return juce::Result::fail("Cannot replace " + path);
+
+    auto stream = std::make_unique<juce::FileOutputStream>(file);
+    if (!stream->openedOk())
+        return juce::Result::fail("Cannot write " + path);
+
+    output = std::make_unique<Output>();
+    output->numChannels = input->numChannels;
+
+    bool raw = isRawFile(file) || (file.getFileExtension().isEmpty() && input->reader == nullptr);
+
+    if (raw) {
+        output->stream = std::move(stream);
+        output->interleaved.resize(size_t(options.chunkSize) * size_t(output->numChannels));
+    }
+    else {
+        juce::AudioFormatManager formats;
+        formats.registerBasicFormats();
+
+        auto extension = file.getFileExtension().isNotEmpty() ? file.getFileExtension() : options.input.getFileExtension();
+        auto* format = formats.findFormatForFileExtension(extension);
+        if (format == nullptr)
+            return juce::Result::fail("Unknown output format: " + extension);
+
+        int bitsPerSample = options.bitsPerSample;
+        if (bitsPerSample == 0)
+            bitsPerSample = format->getPossibleBitDepths().contains(32) ? 32 : 24;
+        if (!format->getPossibleBitDepths().contains(bitsPerSample))
+            return juce::Result::fail(format->getFormatName() + " cannot store " + juce::String(bitsPerSample) + " bits per sample");
+
+        output->writer.reset(format->createWriterFor(stream.get(), input->sampleRate, (unsigned int)(output->numChannels),
+                                                     bitsPerSample, {}, 0));
+        if (output->writer == nullptr)
+            return juce::Result::fail("Cannot write " + path + " as " + format->getFormatName());
+
+        stream.release(); // owned by the writer
+    }
+
+    if (options.csv.getFullPathName().isNotEmpty()) {
+        if (options.csv.exists() && !options.csv.deleteFile())
+            return juce::Result::fail("Cannot replace " + options.csv.getFullPathName());
+
+        csvStream = std::make_unique<juce::FileOutputStream>(options.csv);
+        if (!csvStream->openedOk())
+            return juce::Result::fail("Cannot write " + options.csv.getFullPathName());
+
+        csvStream->writeText("block,seconds,gainReductionDb,displacementMm\n", false, false, nullptr);
+    }
+    return juce::Result::ok();
+}
+
+// Writes a processed chunk, without the first numToSkip samples of the file (the latency)
+bool OfflineRender::write(Chunk& chunk, juce::int64& numToSkip)
+{
+    auto numSkipped = int(std::min<juce::int64>(numToSkip, chunk.numSamples));
+    numToSkip -= numSkipped;
+
+    bool ok = numSkipped == chunk.numSamples || output->write(chunk.buffer, numSkipped, chunk.numSamples - numSkipped);
+    if (csvStream != nullptr)
+        ok = csvStream->write(chunk.rows.getData(), chunk.rows.getDataSize()) && ok;
+    return ok;
+}
+
+bool OfflineRender::closeOutput()
+{
+    bool ok = output->flush();
+    if (csvStream != nullptr) {
+        csvStream->flush();
+        ok = csvStream->getStatus().wasOk() && ok;
+    }
+
+    //the writer completes the header of the file when it is deleted
+    output.reset();
+    csvStream.reset();
+    return ok;
+}
+
+// Prepares the processor for the input, and reads what the settings imply
+void OfflineRender::prepare(HeadlessProcessor& processor)
+{
+    processor.prepare(input->sampleRate, options.blockSize);
+    statistics.threshold = processor.hasParameter(HeadlessProcessor::thresholdDisplacementID)
+                         ? processor.getParameter(HeadlessProcessor::thresholdDisplacementID) : 0.0f;
+
+    //the latency is set by prepareToPlay, from the fixedLatency parameter
+    statistics.latency = options.compensateLatency ? processor.getProcessor().getLatencySamples() : 0;
+}
+
+//==============================================================================
+juce::Result OfflineRender::run()
+{
+    auto* unit = findPluginUnit(options.plugin);
+    if (unit == nullptr)
+        return juce::Result::fail("Unknown plugin: " + options.plugin);
+
+    HeadlessProcessor processor(*unit);
+    return run(processor);
+}
+
+juce::Result OfflineRender::run(HeadlessProcessor& processor)
+{
+    statistics = {};
+
+    auto result = openInput(options.input, options, input);
+    if (result.failed())
+        return result;
+
+    statistics.sampleRate = input->sampleRate;
+    statistics.numSamples = input->length;
+
+    result = configure(processor);
+    if (result.failed())
+        return result;
+
+    prepare(processor);
+
+    result = openOutput();
+    if (result.failed())
+        return result;
+
+    //the latency is flushed out with silence at the end, and skipped at the start
+    auto totalLength = input->length + statistics.latency;
+    juce::int64 readPosition = 0;
+    juce::int64 numToSkip = statistics.latency;
+
+    std::array<Chunk, 3> chunks;
+    for (auto& chunk : chunks)
+        chunk.buffer.setSize(2, options.chunkSize);
+
+    auto readChunk = [this, &readPosition, totalLength](Chunk& chunk) {
+        chunk.numSamples = int(std::min<juce::int64>(options.chunkSize, totalLength - readPosition));
+        bool ok = chunk.numSamples == 0 || input->read(chunk.buffer, 0, readPosition, chunk.numSamples);
+        readPosition += chunk.numSamples;
+        return ok;
+    };
+
+    auto writeChunk = [this, &numToSkip](Chunk& chunk) {
+        return write(chunk, numToSkip);
+    };
+
+    auto start = std::chrono::steady_clock::now();
+    auto reading = std::async(std::launch::async, readChunk, std::ref(chunks[0]));
+    std::future<bool> writing;
+    juce::int64 position = 0;
+
+    for (size_t index = 0;; ++index) {
+        auto& chunk = chunks[index % chunks.size()];
+        if (!reading.get())
+            return juce::Result::fail("Cannot read " + options.input.getFullPathName());
+        if (chunk.numSamples == 0)
+            break;
+
+        //the next buffer was being written two chunks ago, which has been waited for below
+        reading = std::async(std::launch::async, readChunk, std::ref(chunks[(index + 1) % chunks.size()]));
+
+        process(processor, chunk, position);
+        merge(statistics, chunk.meters);
+        position += chunk.numSamples;
+
+        if (writing.valid() && !writing.get())
+            return juce::Result::fail("Cannot write " + options.output.getFullPathName());
+        writing = std::async(std::launch::async, writeChunk, std::ref(chunk));
+    }
+
+    bool written = !writing.valid() || writing.get();
+    written = closeOutput() && written;
+    statistics.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    if (!written)
+        return juce::Result::fail("Cannot write " + options.output.getFullPathName());
+    return juce::Result::ok();
+}
+
+//==============================================================================
+juce::Result OfflineRender::runParallel()
+{
+    auto* unit = findPluginUnit(options.plugin);
+    if (unit == nullptr)
+        return juce::Result::fail("Unknown plugin: " + options.plugin);
+
+    statistics = {};
+
+    auto result = openInput(options.input, options, input);
+    if (result.failed())
+        return result;
+
+    statistics.sampleRate = input->sampleRate;
+    statistics.numSamples = input->length;
+
+    //one processor and one reader per thread, created here on the message thread
+    int numThreads = std::max(1, options.numThreads);
+    std::vector<std::unique_ptr<HeadlessProcessor>> processors;
+    auto numInputs = size_t(numThreads);
+    std::vector<std::unique_ptr<Input>> inputs(numInputs);
+
+    for (size_t thread = 0; thread < inputs.size(); ++thread) {
+        processors.push_back(std::make_unique<HeadlessProcessor>(*unit));
+
+        result = configure(*processors.back());
+        if (result.failed())
+            return result;
+
+        result = openInput(options.input, options, inputs[thread]);
+        if (result.failed())
+            return result;
+    }
+
+    prepare(*processors.front());
+
+    result = openOutput();
+    if (result.failed())
+        return result;
+
+    //segments and pre-roll in whole blocks, so that every block is the same as in run()
+    auto blockSize = juce::int64(options.blockSize);
+    auto toBlocks = [blockSize](double seconds, double sampleRate) {
+        return (juce::int64(std::ceil(std::max(0.0, seconds) * sampleRate)) + blockSize - 1) / blockSize * blockSize;
+    };
+
+    auto segmentLength = std::max(blockSize, toBlocks(options.segmentSeconds, input->sampleRate));
+    auto prerollSeconds = options.prerollSeconds >= 0.0 ? options.prerollSeconds : getDefaultPreroll(*processors.front());
+    auto preroll = toBlocks(prerollSeconds, input->sampleRate);
+    statistics.prerollSeconds = double(preroll) / input->sampleRate;
+
+    auto totalLength = input->length + statistics.latency;
+    auto numSegments = (totalLength + segmentLength - 1) / segmentLength;
+    juce::int64 numToSkip = statistics.latency;
+
+    //two rounds of segments: one is rendered while the previous one is written
+    std::array<std::vector<Chunk>, 2> rounds{ std::vector<Chunk>(size_t(numThreads)), std::vector<Chunk>(size_t(numThreads)) };
+    for (auto& round : rounds) {
+        for (auto& chunk : round)
+            chunk.buffer.setSize(2, int(segmentLength));
+    }
+
+    auto writeRound = [this, &numToSkip](std::vector<Chunk>& round) {
+        bool ok = true;
+        for (auto& chunk : round) {
+            if (chunk.numSamples > 0)
+                ok = write(chunk, numToSkip) && ok;
+        }
+        return ok;
+    };
+
+    auto start = std::chrono::steady_clock::now();
+    std::future<bool> writing;
+
+    for (juce::int64 first = 0; first < numSegments; first += numThreads) {
+        auto& round = rounds[size_t(first / numThreads) % rounds.size()];
+        std::vector<std::future<bool>> rendering;
+
+        for (size_t thread = 0; thread < round.size(); ++thread) {
+            auto& chunk = round[thread];
+            auto segmentStart = (first + juce::int64(thread)) * segmentLength;
+
+            chunk.numSamples = int(std::max<juce::int64>(0, std::min(segmentLength, totalLength - segmentStart)));
+            chunk.meters = {};
+            chunk.rows.reset();
+            if (chunk.numSamples == 0)
+                continue;
+
+            auto& processor = *processors[thread];
+            auto& segmentInput = *inputs[thread];
+            rendering.push_back(std::async(std::launch::async, [this, &processor, &segmentInput, &chunk, segmentStart, preroll] {
+                return renderSegment(processor, segmentInput, chunk, segmentStart, preroll);
+            }));
+        }
+
+        bool read = true;
+        for (auto& segment : rendering)
+            read = segment.get() && read;
+        if (!read)
+            return juce::Result::fail("Cannot read " + options.input.getFullPathName());
+
+        for (const auto& chunk : round)
+            merge(statistics, chunk.meters);
+
+        //the buffers of this round were written two rounds ago, which has been waited for here
+        if (writing.valid() && !writing.get())
+            return juce::Result::fail("Cannot write " + options.output.getFullPathName());
+        writing = std::async(std::launch::async, writeRound, std::ref(round));
+    }
+
+    bool written = !writing.valid() || writing.get();
+    written = closeOutput() && written;
+    statistics.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    if (!written)
+        return juce::Result::fail("Cannot write " + options.output.getFullPathName());
+    return juce::Result::ok();
+}
+
+// Renders chunk.numSamples samples from start, with a processor in the state of a new instance
+// warmed up on the preroll samples before them, whose meters are discarded
+bool OfflineRender::renderSegment(HeadlessProcessor& processor, Input& segmentInput, Chunk& chunk, juce::int64 start, juce::int64 preroll) const
+{
+    processor.prepare(statistics.sampleRate, options.blockSize);
+    bool ok = true;
+
+    for (auto position = std::max<juce::int64>(0, start - preroll); position < start;) {
+        auto numSamples = int(std::min<juce::int64>(chunk.buffer.getNumSamples(), start - position));
+        ok = segmentInput.read(chunk.buffer, 0, position, numSamples) && ok;
+        processor.process(chunk.buffer.getWritePointer(0), chunk.buffer.getWritePointer(1), numSamples);
+        position += numSamples;
+    }
+
+    const auto& unit = processor.getUnit();
+    unit.takeGainReduction(processor.getProcessor());
+    unit.takePeakDisplacement(processor.getProcessor());
+
+    ok = segmentInput.read(chunk.buffer, 0, start, chunk.numSamples) && ok;
+    process(processor, chunk, start);
+    return ok;
+}
+
+// Processes one chunk in place, in blocks, and keeps the meters of every block
+void OfflineRender::process(HeadlessProcessor& processor, Chunk& chunk, juce::int64 position) const
+{
+    const auto& unit = processor.getUnit();
+    auto* channelDataL = chunk.buffer.getWritePointer(0);
+    auto* channelDataR = chunk.buffer.getWritePointer(1);
+    auto& meters = chunk.meters;
+    meters = {};
+    chunk.rows.reset();
+
+    for (int start = 0; start < chunk.numSamples; start += options.blockSize) {
+        int length = std::min(options.blockSize, chunk.numSamples - start);
+        processor.processBlock(channelDataL + start, channelDataR + start, length);
+
+        float gainReduction = unit.takeGainReduction(processor.getProcessor());
+        float displacement = unit.takePeakDisplacement(processor.getProcessor());
+
+        meters.maxGainReduction = std::max(meters.maxGainReduction, gainReduction);
+        meters.peakDisplacement = std::max(meters.peakDisplacement, displacement);
+        if (statistics.threshold > 0.0f && displacement > statistics.threshold)
+            ++meters.numBlocksOverThreshold;
+        ++meters.numBlocks;
+
+        if (csvStream != nullptr) {
+            //the time of the block in the output file, negative until the latency has passed
+            auto blockPosition = position + start;
+            auto seconds = double(blockPosition - statistics.latency) / statistics.sampleRate;
+            chunk.rows << int(blockPosition / options.blockSize) << "," << juce::String(seconds, 6) << ","
+                       << juce::String(gainReduction, 3) << "," << juce::String(displacement, 4) << "\n";
+        }
+    }
+}
+
+void OfflineRender::merge(Statistics& total, const Statistics& part)
+{
+    total.maxGainReduction = std::max(total.maxGainReduction, part.maxGainReduction);
+    total.peakDisplacement = std::max(total.peakDisplacement, part.peakDisplacement);
+    total.numBlocks += part.numBlocks;
+    total.numBlocksOverThreshold += part.numBlocksOverThreshold;
+}
+
+//==============================================================================
+// Runs a function of the channel index for every channel at once, the first one on this thread
+template<typename Function>
+static void forEachChannel(int numChannels, Function&& function)
+{
+    std::vector<std::future<void>> others;
+    for (int channel = 1; channel < numChannels; ++channel)
+        others.push_back(std::async(std::launch::async, function, channel));
+
+    function(0);
+    for (auto& other : others)
+        other.get();
+}
+
+// Seconds since start, which is moved to now for the next lap
+static double lap(std::chrono::steady_clock::time_point& start)
+{
+    auto now = std::chrono::steady_clock::now();
+    auto seconds = std::chrono::duration<double>(now - start).count();
+    start = now;
+    return seconds;
+}
+
+juce::Result OfflineRender::runTwoPass()
+{
+    auto* unit = findPluginUnit(options.plugin);
+    if (unit == nullptr)
+        return juce::Result::fail("Unknown plugin: " + options.plugin);
+    if (!unit->createTwoPassStages)
+        return juce::Result::fail(unit->name + " has no two-pass mode, its gain reduction is a feedback loop");
+
+    statistics = {};
+
+    auto result = openInput(options.input, options, input);
+    if (result.failed())
+        return result;
+
+    statistics.sampleRate = input->sampleRate;
+    statistics.numSamples = input->length;
+
+    HeadlessProcessor processor(*unit);
+    result = configure(processor);
+    if (result.failed())
+        return result;
+
+    prepare(processor);
+    statistics.latency = 0; //the envelope is computed in advance, the signal is not delayed
+
+    auto stages = unit->createTwoPassStages(processor.getProcessor(), input->sampleRate);
+    auto attackTime = options.attackTime >= 0.0 ? options.attackTime : double(stages->attackTime);
+    auto holdTime = options.holdTime >= 0.0 ? options.holdTime : double(stages->holdTime);
+    auto releaseTime = options.releaseTime >= 0.0 ? options.releaseTime : double(stages->releaseTime);
+
+    result = openOutput();
+    if (result.failed())
+        return result;
+
+    //deleted with their TemporaryFile, whatever happens
+    std::vector<std::unique_ptr<juce::TemporaryFile>> temporaryFiles;
+    juce::Array<juce::File> gainFiles, envelopeFiles;
+    for (int channel = 0; channel < input->numChannels; ++channel) {
+        for (auto* files : { &gainFiles, &envelopeFiles }) {
+            temporaryFiles.push_back(std::make_unique<juce::TemporaryFile>(options.output.withFileExtension("envelope")));
+            files->add(temporaryFiles.back()->getFile());
+        }
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    result = writeGains(*stages, gainFiles);
+    statistics.passSeconds[0] = lap(start);
+
+    if (result.wasOk())
+        result = writeEnvelope(gainFiles, envelopeFiles, attackTime, holdTime, releaseTime);
+
+    start = std::chrono::steady_clock::now();
+    if (result.wasOk())
+        result = applyEnvelope(*stages, envelopeFiles);
+    statistics.passSeconds[3] = lap(start);
+
+    bool written = closeOutput();
+    for (auto seconds : statistics.passSeconds)
+        statistics.seconds += seconds;
+
+    if (result.failed())
+        return result;
+    if (!written)
+        return juce::Result::fail("Cannot write " + options.output.getFullPathName());
+    return juce::Result::ok();
+}
+
+// First pass: the gain computer output of every channel, one raw file per channel
+juce::Result OfflineRender::writeGains(TwoPassStages& stages, const juce::Array<juce::File>& gainFiles)
+{
+    std::vector<std::unique_ptr<juce::FileOutputStream>> streams;
+    for (const auto& file : gainFiles) {
+        streams.push_back(std::make_unique<juce::FileOutputStream>(file));
+        if (!streams.back()->openedOk())
+            return juce::Result::fail("Cannot write " + file.getFullPathName());
+    }
+
+    auto length = size_t(options.chunkSize);
+    juce::AudioBuffer<float> buffer(2, options.chunkSize);
+    std::vector<std::vector<float>> gains(streams.size(), std::vector<float>(length));
+
+    for (juce::int64 position = 0; position < input->length; position += options.chunkSize) {
+        auto numSamples = int(std::min<juce::int64>(options.chunkSize, input->length - position));
+        if (!input->read(buffer, 0, position, numSamples))
+            return juce::Result::fail("Cannot read " + options.input.getFullPathName());
+
+        forEachChannel(input->numChannels, [&](int channel) {
+            stages.computeGains(channel, buffer.getReadPointer(channel), gains[size_t(channel)].data(), numSamples);
+        });
+
+        for (size_t channel = 0; channel < streams.size(); ++channel) {
+            if (!streams[channel]->write(gains[channel].data(), size_t(numSamples) * sizeof(float)))
+                return juce::Result::fail("Cannot write " + gainFiles[int(channel)].getFullPathName());
+        }
+    }
+
+    for (auto& stream : streams) {
+        stream->flush();
+        if (stream->getStatus().failed())
+            return stream->getStatus();
+    }
+    return juce::Result::ok();
+}
+
+// Second and third passes: the attack and the release in place in the gain files, one thread per
+// channel, then the smoothing of both into the envelope files, by rounds of chunks on every thread
+juce::Result OfflineRender::writeEnvelope(const juce::Array<juce::File>& gainFiles, const juce::Array<juce::File>& envelopeFiles,
+                                          double attackTime, double holdTime, double releaseTime)
+{
+    auto start = std::chrono::steady_clock::now();
+    auto shape = TwoPassEnvelope::getShape(attackTime, holdTime, releaseTime, options.smoothingTime, input->sampleRate);
+    auto length = input->length;
+
+    std::vector<std::unique_ptr<juce::MemoryMappedFile>> maps;
+    std::vector<float*> gains;
+    for (const auto& file : gainFiles) {
+        maps.push_back(std::make_unique<juce::MemoryMappedFile>(file, juce::MemoryMappedFile::readWrite, true));
+        gains.push_back(static_cast<float*>(maps.back()->getData()));
+
+        if (length > 0 && (gains.back() == nullptr || maps.back()->getSize() < size_t(length) * sizeof(float)))
+            return juce::Result::fail("Cannot map " + file.getFullPathName());
+    }
+
+    forEachChannel(input->numChannels, [&](int channel) {
+        TwoPassEnvelope::applyAttack(gains[size_t(channel)], length, shape.attackCoeff);
+        TwoPassEnvelope::applyHoldRelease(gains[size_t(channel)], length, shape.holdLength, shape.releaseCoeff);
+    });
+
+    statistics.passSeconds[1] = lap(start);
+
+    std::vector<std::unique_ptr<juce::FileOutputStream>> streams;
+    for (const auto& file : envelopeFiles) {
+        streams.push_back(std::make_unique<juce::FileOutputStream>(file));
+        if (!streams.back()->openedOk())
+            return juce::Result::fail("Cannot write " + file.getFullPathName());
+    }
+
+    //the windows overlap the next chunks, which are only read, so the chunks of a round are independent
+    auto numThreads = size_t(std::max(1, options.numThreads));
+    auto chunkLength = size_t(options.chunkSize);
+    std::vector<std::vector<float>> smoothed(numThreads * streams.size(), std::vector<float>(chunkLength));
+
+    for (juce::int64 first = 0; first < length; first += juce::int64(numThreads * chunkLength)) {
+        std::vector<std::future<void>> tasks;
+
+        for (size_t thread = 0; thread < numThreads; ++thread) {
+            auto position = first + juce::int64(thread * chunkLength);
+            if (position >= length)
+                break;
+
+            auto numSamples = int(std::min<juce::int64>(options.chunkSize, length - position));
+            tasks.push_back(std::async(std::launch::async, [&, thread, position, numSamples] {
+                for (size_t channel = 0; channel < streams.size(); ++channel)
+                    TwoPassEnvelope::smooth(gains[channel], length, position, numSamples, shape.smoothingLength,
+                                            smoothed[thread * streams.size() + channel].data());
+            }));
+        }
+
+        for (auto& task : tasks)
+            task.get();
+
+        for (size_t thread = 0; thread < tasks.size(); ++thread) {
+            auto numSamples = size_t(std::min<juce::int64>(options.chunkSize, length - first - juce::int64(thread * chunkLength)));
+
+            for (size_t channel = 0; channel < streams.size(); ++channel) {
+                if (!streams[channel]->write(smoothed[thread * streams.size() + channel].data(), numSamples * sizeof(float)))
+                    return juce::Result::fail("Cannot write " + envelopeFiles[int(channel)].getFullPathName());
+            }
+        }
+    }
+
+    for (auto& stream : streams) {
+        stream->flush();
+        if (stream->getStatus().failed())
+            return stream->getStatus();
+    }
+
+    statistics.passSeconds[2] = lap(start);
+    return juce::Result::ok();
+}
+
+// Last pass: the output with the envelope, one thread per channel, and the meters of every block
+juce::Result OfflineRender::applyEnvelope(TwoPassStages& stages, const juce::Array<juce::File>& envelopeFiles)
+{
+    std::vector<std::unique_ptr<juce::FileInputStream>> streams;
+    for (const auto& file : envelopeFiles) {
+        streams.push_back(std::make_unique<juce::FileInputStream>(file));
+        if (!streams.back()->openedOk())
+            return juce::Result::fail("Cannot read " + file.getFullPathName());
+    }
+
+    Chunk chunk;
+    chunk.buffer.setSize(2, options.chunkSize);
+
+    auto length = size_t(options.chunkSize);
+    auto numBlocks = size_t((options.chunkSize + options.blockSize - 1) / options.blockSize);
+    std::vector<std::vector<float>> envelopes(streams.size(), std::vector<float>(length));
+    std::vector<std::vector<float>> blockGains(streams.size(), std::vector<float>(numBlocks));
+    std::vector<std::vector<float>> blockDisplacements(streams.size(), std::vector<float>(numBlocks));
+    juce::int64 numToSkip = 0;
+
+    for (juce::int64 position = 0; position < input->length; position += options.chunkSize) {
+        chunk.numSamples = int(std::min<juce::int64>(options.chunkSize, input->length - position));
+        if (!input->read(chunk.buffer, 0, position, chunk.numSamples))
+            return juce::Result::fail("Cannot read " + options.input.getFullPathName());
+
+        auto numBytes = int(size_t(chunk.numSamples) * sizeof(float));
+        for (size_t channel = 0; channel < streams.size(); ++channel) {
+            if (streams[channel]->read(envelopes[channel].data(), numBytes) != numBytes)
+                return juce::Result::fail("Cannot read " + envelopeFiles[int(channel)].getFullPathName());
+        }
+
+        forEachChannel(input->numChannels, [&](int channel) {
+            auto* channelData = chunk.buffer.getWritePointer(channel);
+            const auto* envelope = envelopes[size_t(channel)].data();
+
+            for (int start = 0, block = 0; start < chunk.numSamples; start += options.blockSize, ++block) {
+                int numSamples = std::min(options.blockSize, chunk.numSamples - start);
+                blockDisplacements[size_t(channel)][size_t(block)] = stages.applyGains(channel, channelData + start, envelope + start, numSamples);
+                blockGains[size_t(channel)][size_t(block)] = *std::min_element(envelope + start, envelope + start + numSamples);
+            }
+        });
+
+        //the same meters and rows as process(), from both channels
+        auto& meters = chunk.meters;
+        meters = {};
+        chunk.rows.reset();
+
+        for (int start = 0, block = 0; start < chunk.numSamples; start += options.blockSize, ++block) {
+            float minGain = 1.0f;
+            float displacement = 0.0f;
+            for (size_t channel = 0; channel < streams.size(); ++channel) {
+                minGain = std::min(minGain, blockGains[channel][size_t(block)]);
+                displacement = std::max(displacement, blockDisplacements[channel][size_t(block)]);
+            }
+            float gainReduction = -juce::Decibels::gainToDecibels(minGain);
+
+            meters.maxGainReduction = std::max(meters.maxGainReduction, gainReduction);
+            meters.peakDisplacement = std::max(meters.peakDisplacement, displacement);
+            if (statistics.threshold > 0.0f && displacement > statistics.threshold)
+                ++meters.numBlocksOverThreshold;
+            ++meters.numBlocks;
+
+            if (csvStream != nullptr) {
+                auto blockPosition = position + start;
+                chunk.rows << int(blockPosition / options.blockSize) << "," << juce::String(double(blockPosition) / statistics.sampleRate, 6) << ","
+                           << juce::String(gainReduction, 3) << "," << juce::String(displacement, 4) << "\n";
+            }
+        }
+
+        merge(statistics, meters);
+        if (!write(chunk, numToSkip))
+            return juce::Result::fail("Cannot write " + options.output.getFullPathName());
+    }
+    return juce::Result::ok();
+}
+
+//==============================================================================
+juce::Result OfflineRender::compareFiles(const juce::File& fileA, const juce::File& fileB, const Options& options, Deviation& deviation)
+{
+    std::unique_ptr<Input> inputA, inputB;
+
+    auto result = openInput(fileA, options, inputA);
+    if (result.failed())
+        return result;
+
+    result = openInput(fileB, options, inputB);
+    if (result.failed())
+        return result;
+
+    if (inputA->length != inputB->length || inputA->numChannels != inputB->numChannels)
+        return juce::Result::fail(fileA.getFileName() + " and " + fileB.getFileName() + " differ in length or channels");
+
+    deviation = {};
+    juce::AudioBuffer<float> bufferA(2, options.chunkSize), bufferB(2, options.chunkSize);
+
+    for (juce::int64 position = 0; position < inputA->length; position += options.chunkSize) {
+        auto numSamples = int(std::min<juce::int64>(options.chunkSize, inputA->length - position));
+        if (!inputA->read(bufferA, 0, position, numSamples) || !inputB->read(bufferB, 0, position, numSamples))
+            return juce::Result::fail("Cannot read " + fileA.getFileName() + " or " + fileB.getFileName());
+
+        for (int channel = 0; channel < inputA->numChannels; ++channel) {
+            auto* channelDataA = bufferA.getReadPointer(channel);
+            auto* channelDataB = bufferB.getReadPointer(channel);
+
+            for (int i = 0; i < numSamples; ++i) {
+                float difference = std::abs(channelDataA[i] - channelDataB[i]);
+                if (difference > 0.0f)
+                    ++deviation.numDifferentSamples;
+                if (difference > deviation.maxDifference) {
+                    deviation.maxDifference = difference;
+                    deviation.position = position + i;
+                }
+            }
+        }
+    }
+    return juce::Result::ok();
+}
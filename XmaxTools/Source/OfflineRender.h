@@ -0,0 +1,148 @@
+/*
+  ==============================================================================
+
+    OfflineRender.h
+    Created: 19 Oct 2026 10:52:17pm
+    Author:  eliot
+
+    Renders an audio file through one of the plugins, as fast as the DSP
+    allows: WAV, FLAC (or any format JUCE reads) or raw interleaved 32-bit
+    float, with a preset and parameters given by ID. The file is streamed in
+    large chunks through three buffers, so that the next chunk is read and
+    the previous one written while the current one is processed. Besides
+    the output, a CSV can list the gain reduction and the predicted
+    displacement of every block.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <array>
+#include <memory>
+#include <utility>
+#include <vector>
+
+class HeadlessProcessor;
+class TwoPassStages;
+struct PluginUnit;
+
+class OfflineRender
+{
+public:
+    struct Options
+    {
+        juce::String plugin;               // for run(), which creates its own processor
+        juce::File input;
+        juce::File output;                 // same format as the input if it has no known extension
+        juce::File csv;                    // per-block meters, not written if empty
+        juce::File preset;                 // plugin state (XML or binary) or JSON object of parameters, optional
+        std::vector<std::pair<juce::String, juce::String>> parameters; // ID and value, over the preset
+
+        int blockSize = 512;               // size of the calls to processBlock, and of the CSV rows
+        int chunkSize = 65536;             // samples read or written at once
+        double rawSampleRate = 48000.0;    // raw float files have no header
+        int rawNumChannels = 2;
+        int bitsPerSample = 0;             // 0 for 32-bit float if the output format has it, 24 otherwise
+        bool compensateLatency = true;     // remove the reported latency, as a host would
+
+        int numThreads = 1;                // runParallel: threads, and segments rendered at once
+        double segmentSeconds = 30.0;      // runParallel: length of each segment
+        double prerollSeconds = -1.0;      // runParallel: warm-up before each segment, from the envelope times if negative
+
+        double attackTime = -1.0;          // runTwoPass: ms, from the settings if negative, and not limited to maxAttackTime
+        double holdTime = -1.0;
+        double releaseTime = -1.0;
+        double smoothingTime = 1.0;        // runTwoPass: ms, rounds the corners of the envelope
+    };
+
+    // Sample rate, length and time spent of the last run, for the summary
+    struct Statistics
+    {
+        double sampleRate = 0.0;
+        juce::int64 numSamples = 0;
+        int latency = 0;
+        double seconds = 0.0;              // spent rendering, reading and writing included
+        float maxGainReduction = 0.0f;     // dB
+        float peakDisplacement = 0.0f;     // mm
+        int numBlocks = 0;
+        float threshold = 0.0f;            // thresholdDisplacement of the rendered settings, mm
+        int numBlocksOverThreshold = 0;    // peak displacement above it
+        double prerollSeconds = 0.0;       // runParallel only
+        std::array<double, 4> passSeconds{}; // runTwoPass: sidechain, attack and release, smoothing, output
+    };
+
+    // Largest difference between two renders of the same file
+    struct Deviation
+    {
+        float maxDifference = 0.0f;        // linear, full scale is 1
+        juce::int64 position = 0;          // sample where it is
+        juce::int64 numDifferentSamples = 0;
+    };
+
+    explicit OfflineRender(const Options& options);
+    ~OfflineRender();
+
+    juce::Result run();
+
+    // Renders with a processor which may have rendered other files before: its parameters
+    // start again from their defaults, and prepareToPlay clears its state
+    juce::Result run(HeadlessProcessor& processor);
+
+    // Splits the file in segments rendered on several threads, and stitches them in order.
+    // Each segment starts from a new processor state, warmed up on the audio before it: the
+    // envelope and the filters forget their initial state within a few release times, so the
+    // result only differs from run() by what is left of it after the pre-roll.
+    juce::Result runParallel();
+
+    // Limiter and LowShelf only: computes the gain computer output of the whole file, then the
+    // gain envelope from it, backwards for the attack and forwards for the release, and only then
+    // renders the output with it. There is no look-ahead window, so the attack can be longer than
+    // maxAttackTime, and no latency. The envelope is kept in temporary files next to the output
+    // and memory-mapped, so the file can be longer than the memory; the channels are processed
+    // at once, and the smoothing of the envelope on numThreads threads.
+    juce::Result runTwoPass();
+
+    // Compares two files of the same length, channel by channel
+    static juce::Result compareFiles(const juce::File& fileA, const juce::File& fileB, const Options& options, Deviation& deviation);
+
+    const Statistics& getStatistics() const noexcept { return statistics; }
+
+    // Raw files are recognised by these extensions
+    static bool isRawFile(const juce::File& file);
+
+private:
+    class Input;
+    class Output;
+    struct Chunk;
+
+    juce::Result configure(HeadlessProcessor& processor) const;
+    juce::Result applyPreset(HeadlessProcessor& processor) const;
+    juce::Result applyParameters(HeadlessProcessor& processor) const;
+    double getDefaultPreroll(const HeadlessProcessor& processor) const;
+
+    static juce::Result openInput(const juce::File& file, const Options& options, std::unique_ptr<Input>& input);
+    juce::Result openOutput();
+    bool write(Chunk& chunk, juce::int64& numToSkip);
+    bool closeOutput();
+    void prepare(HeadlessProcessor& processor);
+
+    void process(HeadlessProcessor& processor, Chunk& chunk, juce::int64 position) const;
+    bool renderSegment(HeadlessProcessor& processor, Input& segmentInput, Chunk& chunk, juce::int64 start, juce::int64 preroll) const;
+    static void merge(Statistics& total, const Statistics& part);
+
+    juce::Result writeGains(TwoPassStages& stages, const juce::Array<juce::File>& gainFiles);
+    juce::Result writeEnvelope(const juce::Array<juce::File>& gainFiles, const juce::Array<juce::File>& envelopeFiles, double attackTime,
+                               double holdTime, double releaseTime);
+    juce::Result applyEnvelope(TwoPassStages& stages, const juce::Array<juce::File>& envelopeFiles);
+
+    Options options;
+    Statistics statistics;
+
+    std::unique_ptr<Input> input;
+    std::unique_ptr<Output> output;
+    std::unique_ptr<juce::FileOutputStream> csvStream;
+
+    JUCE_DECLARE_NON_COPYABLE(OfflineRender)
+};
@@ -0,0 +1,30 @@
+/*
+  ==============================================================================
+
+    PluginUnits.cpp
+    Created: 19 Oct 2026 4:05:41pm
+    Author:  eliot
+
+  ==============================================================================
+*/
+
+#include "PluginUnits.h"
+
+const std::vector<PluginUnit>& getPluginUnits()
+{
+    static const std::vector<PluginUnit> units = {
+        { "XmaxLimiter",  XmaxLimiterUnit::createProcessor,  XmaxLimiterUnit::getSpeakerModelNames, XmaxLimiterUnit::getPlantParameters,  XmaxLimiterUnit::getStageProbe(),  XmaxLimiterUnit::takePeakDisplacement, XmaxLimiterUnit::takeGainReduction, XmaxLimiterUnit::createTwoPassStages },
+        { "XmaxLowShelf", XmaxLowShelfUnit::createProcessor, XmaxLowShelfUnit::getSpeakerModelNames, XmaxLowShelfUnit::getPlantParameters, XmaxLowShelfUnit::getStageProbe(), XmaxLowShelfUnit::takePeakDisplacement, XmaxLowShelfUnit::takeGainReduction, XmaxLowShelfUnit::createTwoPassStages },
+        { "XmaxFeedback", XmaxFeedbackUnit::createProcessor, XmaxFeedbackUnit::getSpeakerModelNames, XmaxFeedbackUnit::getPlantParameters, XmaxFeedbackUnit::getStageProbe(), XmaxFeedbackUnit::takePeakDisplacement, XmaxFeedbackUnit::takeGainReduction, {} }
+    };
+    return units;
+}
+
+const PluginUnit* findPluginUnit(const juce::String& name)
+{
+    for (const auto& unit : getPluginUnits()) {
+        if (unit.name.equalsIgnoreCase(name) || unit.name.substring(4).equalsIgnoreCase(name))
+            return &unit;
+    }
+    return nullptr;
+}
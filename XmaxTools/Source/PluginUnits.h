@@ -0,0 +1,174 @@
+/*
+  ==============================================================================
+
+    PluginUnits.h
+    Created: 19 Oct 2026 4:05:41pm
+    Author:  eliot
+
+    The three plugins are compiled into the tools as they are, each one in
+    its own namespace (see LimiterUnit.cpp, LowShelfUnit.cpp and
+    FeedbackUnit.cpp), because they share class and function names. This
+    header is the only way in: a factory for the processor, the kernel
+    benchmarks that need the plugin DSP headers, the per-stage times of
+    processBlock (the units are built with XMAX_STAGE_TIMING), the
+    displacement meters, the gain reduction, the stages of the offline
+    two-pass limiter, and the speaker models as simulated drivers.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+#include "SpeakerPlant.h"
+
+class Benchmark;
+
+// Reads the StageTimes of a processor (see StageTimer.h in the plugins), whose stages differ per plugin
+struct StageProbe
+{
+    juce::StringArray stageNames;
+    juce::StringArray counterNames;
+    std::function<void(juce::AudioProcessor&, bool enabled)> setEnabled;
+
+    // Copies the times of the last block, in ns, and the counters
+    std::function<void(juce::AudioProcessor&, int64_t* nanoseconds, int64_t* counters)> read;
+};
+
+template<typename Processor>
+StageProbe makeStageProbe()
+{
+    using Times = decltype(Processor::stageTimes);
+    StageProbe probe;
+
+    for (int stage = 0; stage < Times::numStages; ++stage)
+        probe.stageNames.add(Times::getStageName(stage));
+    for (int counter = 0; counter < Times::numCounters; ++counter)
+        probe.counterNames.add(Times::getCounterName(counter));
+
+    probe.setEnabled = [](juce::AudioProcessor& processor, bool enabled) {
+        static_cast<Processor&>(processor).stageTimes.enabled = enabled;
+    };
+    probe.read = [](juce::AudioProcessor& processor, int64_t* nanoseconds, int64_t* counters) {
+        const auto& times = static_cast<Processor&>(processor).stageTimes;
+        std::copy(times.nanoseconds.begin(), times.nanoseconds.end(), nanoseconds);
+        std::copy(times.counters.begin(), times.counters.end(), counters);
+    };
+    return probe;
+}
+
+// Peak displacement of both channels published by processBlock since the previous call, in mm
+template<typename Processor>
+float takePeakDisplacement(juce::AudioProcessor& processor)
+{
+    auto& plugin = static_cast<Processor&>(processor);
+    return std::max(plugin.displacementLevelL.readAndReset(), plugin.displacementLevelR.readAndReset());
+}
+
+// Largest gain reduction of both channels published by processBlock since the previous call, in dB
+template<typename Processor>
+float takeGainReduction(juce::AudioProcessor& processor)
+{
+    auto& plugin = static_cast<Processor&>(processor);
+    return std::max(plugin.gainReductionL.readAndReset(), plugin.gainReductionR.readAndReset());
+}
+
+// Driver of a speaker model of a plugin, for the simulation (see SpeakerPlant.h), in free air
+template<typename LoudspeakerModel>
+PlantParameters makePlantParameters(const LoudspeakerModel& model)
+{
+    PlantParameters plant;
+    plant.Rec = double(model.Rec);
+    plant.Lec = double(model.Lec);
+    plant.Mms = double(model.Mms);
+    plant.Kms = 1 / double(model.Cms);
+    plant.Rms = double(model.Rms);
+    plant.Bl = double(model.Bl);
+    return plant;
+}
+
+// The sidechain and the output stage of a limiter, for an envelope computed over the whole
+// file (see OfflineRender::runTwoPass). The settings are read once, from a prepared processor,
+// and each channel has its own filters, so that both channels can be processed at once.
+class TwoPassStages
+{
+public:
+    virtual ~TwoPassStages() = default;
+
+    // Gain computer output of the next numSamples input samples of one channel (0 or 1)
+    virtual void computeGains(int channel, const float* input, float* gains, int numSamples) noexcept = 0;
+
+    // Output of the next numSamples samples of one channel, in place, with these gains.
+    // Returns the peak predicted displacement of the output, in mm.
+    virtual float applyGains(int channel, float* channelData, const float* gains, int numSamples) noexcept = 0;
+
+    // Envelope times of the settings, in ms
+    float attackTime = 0.0f;
+    float holdTime = 0.0f;
+    float releaseTime = 0.0f;
+};
+
+namespace XmaxLimiterUnit
+{
+    std::unique_ptr<juce::AudioProcessor> createProcessor();
+    juce::StringArray getSpeakerModelNames();
+    PlantParameters getPlantParameters(int modelIndex);
+    StageProbe getStageProbe();
+    float takePeakDisplacement(juce::AudioProcessor& processor);
+    float takeGainReduction(juce::AudioProcessor& processor);
+    std::unique_ptr<TwoPassStages> createTwoPassStages(juce::AudioProcessor& processor, double sampleRate);
+    void benchmarkKernels(Benchmark& bench);
+
+    // Compiles a JSON or CSV speaker database into its binary cache, times the opening and
+    // prints the drivers matching the query
+    juce::Result compileSpeakerDatabase(const juce::File& source, const juce::File& cache, const juce::String& query);
+
+    // Driver tracked by the adaptive mode from the sense inputs (fs, Qts, Qms, Qes, Rec, Bl, Cms),
+    // or void if none was estimated for the current speaker model yet
+    juce::var getAdaptedModel(juce::AudioProcessor& processor);
+}
+
+namespace XmaxLowShelfUnit
+{
+    std::unique_ptr<juce::AudioProcessor> createProcessor();
+    juce::StringArray getSpeakerModelNames();
+    PlantParameters getPlantParameters(int modelIndex);
+    StageProbe getStageProbe();
+    float takePeakDisplacement(juce::AudioProcessor& processor);
+    float takeGainReduction(juce::AudioProcessor& processor);
+    std::unique_ptr<TwoPassStages> createTwoPassStages(juce::AudioProcessor& processor, double sampleRate);
+}
+
+namespace XmaxFeedbackUnit
+{
+    std::unique_ptr<juce::AudioProcessor> createProcessor();
+    juce::StringArray getSpeakerModelNames();
+    PlantParameters getPlantParameters(int modelIndex);
+    StageProbe getStageProbe();
+    float takePeakDisplacement(juce::AudioProcessor& processor);
+    float takeGainReduction(juce::AudioProcessor& processor);
+    void benchmarkKernels(Benchmark& bench);
+}
+
+struct PluginUnit
+{
+    juce::String name;
+    std::function<std::unique_ptr<juce::AudioProcessor>()> createProcessor;
+    std::function<juce::StringArray()> getSpeakerModelNames;
+    std::function<PlantParameters(int modelIndex)> getPlantParameters;
+    StageProbe stages;
+    std::function<float(juce::AudioProcessor&)> takePeakDisplacement;
+    std::function<float(juce::AudioProcessor&)> takeGainReduction;
+    std::function<std::unique_ptr<TwoPassStages>(juce::AudioProcessor&, double sampleRate)> createTwoPassStages; // empty for the feedback
+};
+
+// Every plugin, in the order of the reports
+const std::vector<PluginUnit>& getPluginUnits();
+
+// nullptr if there is no plugin with this name (case insensitive, "Xmax" may be omitted)
+const PluginUnit* findPluginUnit(const juce::String& name);
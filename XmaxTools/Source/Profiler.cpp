@@ -0,0 +1,353 @@
+/*
+  ==============================================================================
+
+    Profiler.cpp
+    Created: 19 Oct 2026 6:34:57pm
+    Author:  eliot
+
+  ==============================================================================
+*/
+
+#include "Profiler.h"
+#include "HeadlessProcessor.h"
+#include "PluginUnits.h"
+#include "TestSignals.h"
+#include "CycleCounter.h"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <numeric>
+
+// Nearest-rank percentile of sorted values, p in 0..1
+static int64_t getPercentile(const std::vector<int64_t>& sorted, double p)
+{
+    auto rank = size_t(std::ceil(p * double(sorted.size())));
+    return sorted[std::min(sorted.size() - 1, rank > 0 ? rank - 1 : 0)];
+}
+
+static int64_t getMedian(std::vector<int64_t> values)
+{
+    std::sort(values.begin(), values.end());
+    return getPercentile(values, 0.5);
+}
+
+Profiler::Profiler(const Options& profilerOptions)
+    : options(profilerOptions)
+{
+    options.blockSize = std::max(1, options.blockSize);
+    options.numOutliers = std::max(0, options.numOutliers);
+}
+
+std::vector<Profiler::Scenario> Profiler::getScenarios()
+{
+    std::vector<Scenario> scenarios;
+    for (const auto& generator : TestSignals::getGenerators())
+        scenarios.push_back({ generator.name, generator.description, generator.name, false });
+
+    scenarios.push_back({ "modelSwitches", "the programme, with a new speaker model every 250 ms", "programme", true });
+    return scenarios;
+}
+
+bool Profiler::isSelected(const juce::StringArray& names, const juce::String& name) const
+{
+    return names.isEmpty() || names.contains(name, true);
+}
+
+void Profiler::run()
+{
+    for (const auto& unit : getPluginUnits()) {
+        bool selected = options.plugins.isEmpty();
+        for (const auto& name : options.plugins)
+            selected = selected || findPluginUnit(name) == &unit;
+
+        if (!selected)
+            continue;
+
+        HeadlessProcessor processor(unit);
+        unit.stages.setEnabled(processor.getProcessor(), true);
+
+        for (const auto& scenario : getScenarios()) {
+            if (isSelected(options.scenarios, scenario.name))
+                results.add(profile(processor, scenario));
+        }
+    }
+}
+
+// Runs the whole scenario block by block from a freshly prepared processor,
+// and keeps the time and the stage times of every block if record is true
+void Profiler::processScenario(HeadlessProcessor& processor, const Scenario& scenario, bool record)
+{
+    const auto& unit = processor.getUnit();
+    int numModels = unit.getSpeakerModelNames().size();
+    int numStages = unit.stages.stageNames.size();
+    int numCounters = unit.stages.counterNames.size();
+
+    processor.setParameter(HeadlessProcessor::speakerModelID, 0.0f);
+    processor.prepare(options.sampleRate, options.blockSize);
+
+    int numBlocks = std::max(1, int(options.seconds * options.sampleRate) / options.blockSize);
+    int numSamples = numBlocks * options.blockSize;
+    signalL.resize(size_t(numSamples));
+    signalR.resize(size_t(numSamples));
+    TestSignals::findGenerator(scenario.signal)->fill(signalL.data(), signalR.data(), numSamples, options.sampleRate);
+
+    //everything is allocated before the first block, so that the measurements do not move memory around
+    blocks.clear();
+    if (record)
+        blocks.resize(size_t(numBlocks), Block{ 0, 0, std::vector<int64_t>(size_t(numStages)), std::vector<int64_t>(size_t(numCounters)) });
+
+    int switchPeriod = std::max(1, int(0.25 * options.sampleRate));
+    int speakerModel = 0;
+
+    for (int index = 0; index < numBlocks; ++index) {
+        int start = index * options.blockSize;
+
+        //the parameter is changed between two blocks, as a host would do from its message thread
+        if (scenario.switchModels && start / switchPeriod != (start + options.blockSize) / switchPeriod) {
+            speakerModel = (speakerModel + 1) % numModels;
+            processor.setParameter(HeadlessProcessor::speakerModelID, float(speakerModel));
+        }
+
+        auto startTime = CycleCounter::readNanoseconds();
+        processor.processBlock(signalL.data() + start, signalR.data() + start, options.blockSize);
+        auto endTime = CycleCounter::readNanoseconds();
+
+        if (record) {
+            auto& block = blocks[size_t(index)];
+            block.index = index;
+            block.nanoseconds = endTime - startTime;
+            unit.stages.read(processor.getProcessor(), block.stageNanoseconds.data(), block.counters.data());
+        }
+    }
+}
+
+juce::var Profiler::profile(HeadlessProcessor& processor, const Scenario& scenario)
+{
+    const auto& unit = processor.getUnit();
+    const auto& stageNames = unit.stages.stageNames;
+    const auto& counterNames = unit.stages.counterNames;
+
+    std::cerr << unit.name << " " << scenario.name << std::endl;
+
+    //the first run warms up the caches and the branch predictors
+    processScenario(processor, scenario, false);
+    processScenario(processor, scenario, true);
+
+    std::vector<int64_t> nanoseconds;
+    for (const auto& block : blocks)
+        nanoseconds.push_back(block.nanoseconds);
+
+    auto* result = new juce::DynamicObject();
+    result->setProperty("plugin", unit.name);
+    result->setProperty("scenario", scenario.name);
+    result->setProperty("description", scenario.description);
+    result->setProperty("sampleRate", options.sampleRate);
+    result->setProperty("blockSize", options.blockSize);
+    result->setProperty("blocks", int(blocks.size()));
+
+    double budget = 1e9 * options.blockSize / options.sampleRate;
+    result->setProperty("budgetNs", budget);
+    result->setProperty("distribution", getDistribution(nanoseconds));
+
+    //typical and worst cost of every stage
+    auto* stages = new juce::DynamicObject();
+    for (int stage = 0; stage < stageNames.size(); ++stage) {
+        std::vector<int64_t> values;
+        for (const auto& block : blocks)
+            values.push_back(block.stageNanoseconds[size_t(stage)]);
+        std::sort(values.begin(), values.end());
+
+        auto* stageResult = new juce::DynamicObject();
+        stageResult->setProperty("medianNs", getPercentile(values, 0.5));
+        stageResult->setProperty("p99Ns", getPercentile(values, 0.99));
+        stageResult->setProperty("maxNs", values.back());
+        stages->setProperty(juce::Identifier(stageNames[stage]), juce::var(stageResult));
+    }
+    result->setProperty("stages", juce::var(stages));
+
+    auto* counters = new juce::DynamicObject();
+    for (int counter = 0; counter < counterNames.size(); ++counter) {
+        int64_t total = 0, maximum = 0;
+        for (const auto& block : blocks) {
+            total += block.counters[size_t(counter)];
+            maximum = std::max(maximum, block.counters[size_t(counter)]);
+        }
+
+        auto* counterResult = new juce::DynamicObject();
+        counterResult->setProperty("mean", double(total) / double(blocks.size()));
+        counterResult->setProperty("max", maximum);
+        counters->setProperty(juce::Identifier(counterNames[counter]), juce::var(counterResult));
+    }
+    result->setProperty("counters", juce::var(counters));
+
+    auto outliers = getOutliers(stageNames, counterNames);
+    result->setProperty("outliers", outliers);
+
+    std::sort(nanoseconds.begin(), nanoseconds.end());
+    std::cerr << "  p50 " << juce::String(getPercentile(nanoseconds, 0.5) * 1e-3, 1)
+              << " us, p99.9 " << juce::String(getPercentile(nanoseconds, 0.999) * 1e-3, 1)
+              << " us, max " << juce::String(nanoseconds.back() * 1e-3, 1)
+              << " us (" << juce::String(100.0 * double(nanoseconds.back()) / budget, 1) << " % of the budget)";
+    if (outliers.size() > 0)
+        std::cerr << ", slowest block in " << outliers[0]["stage"].toString();
+    std::cerr << std::endl;
+
+    return juce::var(result);
+}
+
+// Percentiles, mean, jitter and a quarter-octave histogram of the block times
+juce::var Profiler::getDistribution(std::vector<int64_t> nanoseconds) const
+{
+    std::sort(nanoseconds.begin(), nanoseconds.end());
+    auto count = double(nanoseconds.size());
+
+    double mean = double(std::accumulate(nanoseconds.begin(), nanoseconds.end(), int64_t(0))) / count;
+    double variance = 0.0;
+    for (auto value : nanoseconds)
+        variance += (double(value) - mean) * (double(value) - mean);
+
+    auto* distribution = new juce::DynamicObject();
+    distribution->setProperty("minNs", nanoseconds.front());
+    distribution->setProperty("meanNs", mean);
+    distribution->setProperty("stddevNs", std::sqrt(variance / count));
+    distribution->setProperty("p50Ns", getPercentile(nanoseconds, 0.5));
+    distribution->setProperty("p90Ns", getPercentile(nanoseconds, 0.9));
+    distribution->setProperty("p99Ns", getPercentile(nanoseconds, 0.99));
+    distribution->setProperty("p999Ns", getPercentile(nanoseconds, 0.999));
+    distribution->setProperty("maxNs", nanoseconds.back());
+
+    //bins of a quarter of an octave, only the ones which are not empty
+    juce::Array<juce::var> histogram;
+    int currentBin = std::numeric_limits<int>::min();
+    int binCount = 0;
+
+    auto addBin = [&] {
+        if (binCount > 0) {
+            auto* bin = new juce::DynamicObject();
+            bin->setProperty("fromNs", std::pow(2.0, currentBin / 4.0));
+            bin->setProperty("count", binCount);
+            histogram.add(juce::var(bin));
+        }
+    };
+
+    for (auto value : nanoseconds) {
+        int bin = int(std::floor(4.0 * std::log2(double(std::max(value, int64_t(1))))));
+        if (bin != currentBin) {
+            addBin();
+            currentBin = bin;
+            binCount = 0;
+        }
+        ++binCount;
+    }
+    addBin();
+
+    distribution->setProperty("histogram", histogram);
+    return juce::var(distribution);
+}
+
+// The slowest blocks, each with the stage that exceeded its median time the most,
+// and the counter that was the furthest above its median
+juce::var Profiler::getOutliers(const juce::StringArray& stageNames, const juce::StringArray& counterNames) const
+{
+    std::vector<int64_t> stageMedians, counterMedians, nanoseconds;
+    for (const auto& block : blocks)
+        nanoseconds.push_back(block.nanoseconds);
+
+    for (int stage = 0; stage < stageNames.size(); ++stage) {
+        std::vector<int64_t> values;
+        for (const auto& block : blocks)
+            values.push_back(block.stageNanoseconds[size_t(stage)]);
+        stageMedians.push_back(getMedian(values));
+    }
+
+    for (int counter = 0; counter < counterNames.size(); ++counter) {
+        std::vector<int64_t> values;
+        for (const auto& block : blocks)
+            values.push_back(block.counters[size_t(counter)]);
+        counterMedians.push_back(getMedian(values));
+    }
+
+    int64_t medianNanoseconds = getMedian(nanoseconds);
+    double budget = 1e9 * options.blockSize / options.sampleRate;
+
+    std::vector<const Block*> slowest;
+    for (const auto& block : blocks)
+        slowest.push_back(&block);
+
+    auto numOutliers = std::min(slowest.size(), size_t(options.numOutliers));
+    std::partial_sort(slowest.begin(), slowest.begin() + std::ptrdiff_t(numOutliers), slowest.end(),
+                      [](const Block* a, const Block* b) { return a->nanoseconds > b->nanoseconds; });
+
+    juce::Array<juce::var> outliers;
+
+    for (size_t i = 0; i < numOutliers; ++i) {
+        const auto& block = *slowest[i];
+        auto* outlier = new juce::DynamicObject();
+        outlier->setProperty("block", block.index);
+        outlier->setProperty("time", block.index * options.blockSize / options.sampleRate);
+        outlier->setProperty("ns", block.nanoseconds);
+        outlier->setProperty("ofBudget", double(block.nanoseconds) / budget);
+        outlier->setProperty("ofMedian", double(block.nanoseconds) / double(std::max(medianNanoseconds, int64_t(1))));
+
+        int worstStage = 0;
+        int64_t worstExcess = std::numeric_limits<int64_t>::min();
+        auto* stages = new juce::DynamicObject();
+
+        for (int stage = 0; stage < stageNames.size(); ++stage) {
+            auto value = block.stageNanoseconds[size_t(stage)];
+            stages->setProperty(juce::Identifier(stageNames[stage]), value);
+
+            if (value - stageMedians[size_t(stage)] > worstExcess) {
+                worstExcess = value - stageMedians[size_t(stage)];
+                worstStage = stage;
+            }
+        }
+
+        outlier->setProperty("stage", stageNames[worstStage]);
+        outlier->setProperty("stageExcessNs", worstExcess);
+        outlier->setProperty("stagesNs", juce::var(stages));
+
+        //a counter well above its median explains why the stage was slow
+        juce::String worstCounter;
+        double worstRatio = 2.0;
+        auto* counters = new juce::DynamicObject();
+
+        for (int counter = 0; counter < counterNames.size(); ++counter) {
+            auto value = block.counters[size_t(counter)];
+            counters->setProperty(juce::Identifier(counterNames[counter]), value);
+
+            double ratio = double(value) / double(counterMedians[size_t(counter)] + 1);
+            if (ratio > worstRatio) {
+                worstRatio = ratio;
+                worstCounter = counterNames[counter];
+            }
+        }
+
+        outlier->setProperty("counters", juce::var(counters));
+        if (worstCounter.isNotEmpty())
+            outlier->setProperty("counter", worstCounter);
+
+        outliers.add(juce::var(outlier));
+    }
+
+    return outliers;
+}
+
+juce::var Profiler::getReport() const
+{
+    auto* report = new juce::DynamicObject();
+    report->setProperty("tool", "XmaxTools profile");
+    report->setProperty("formatVersion", 1);
+    report->setProperty("date", juce::Time::getCurrentTime().toISO8601(true));
+    report->setProperty("os", juce::SystemStats::getOperatingSystemName());
+    report->setProperty("cpu", juce::SystemStats::getCpuModel());
+   #if JUCE_DEBUG
+    report->setProperty("build", "debug");
+   #else
+    report->setProperty("build", "release");
+   #endif
+    report->setProperty("secondsPerScenario", options.seconds);
+    report->setProperty("results", results);
+    return juce::var(report);
+}
@@ -0,0 +1,79 @@
+/*
+  ==============================================================================
+
+    Profiler.h
+    Created: 19 Oct 2026 6:34:57pm
+    Author:  eliot
+
+    Worst-case block times of the three plugins. Each processor is driven
+    block by block with the adversarial test signals (and with speaker model
+    switches), every block is timed, and the report gives the distribution
+    of the block times against the real-time budget: percentiles up to
+    p99.9, maximum, jitter and a histogram. The slowest blocks are listed
+    with the stage of processBlock which took longer than usual, and the
+    signal dependent work counted during the block.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <cstdint>
+#include <vector>
+
+class HeadlessProcessor;
+
+class Profiler
+{
+public:
+    struct Options
+    {
+        juce::StringArray plugins;   // every plugin if empty
+        juce::StringArray scenarios; // every scenario if empty
+        double sampleRate = 48000.0;
+        int blockSize = 256;
+        double seconds = 10.0;       // audio time of each scenario
+        int numOutliers = 10;        // slowest blocks reported per scenario
+    };
+
+    // A test signal, and whether the speaker model changes every 250 ms while it plays
+    struct Scenario
+    {
+        juce::String name;
+        juce::String description;
+        juce::String signal;
+        bool switchModels = false;
+    };
+
+    explicit Profiler(const Options& options);
+
+    void run();
+    juce::var getReport() const;
+
+    static std::vector<Scenario> getScenarios();
+
+private:
+    // Everything measured for one block
+    struct Block
+    {
+        int index = 0;
+        int64_t nanoseconds = 0;
+        std::vector<int64_t> stageNanoseconds;
+        std::vector<int64_t> counters;
+    };
+
+    bool isSelected(const juce::StringArray& names, const juce::String& name) const;
+    juce::var profile(HeadlessProcessor& processor, const Scenario& scenario);
+    void processScenario(HeadlessProcessor& processor, const Scenario& scenario, bool record);
+
+    juce::var getDistribution(std::vector<int64_t> nanoseconds) const;
+    juce::var getOutliers(const juce::StringArray& stageNames, const juce::StringArray& counterNames) const;
+
+    Options options;
+    juce::Array<juce::var> results;
+    std::vector<float> signalL, signalR;
+    std::vector<Block> blocks;
+
+    JUCE_DECLARE_NON_COPYABLE(Profiler)
+};
@@ -0,0 +1,147 @@
+/*
+  ==============================================================================
+
+    RealtimeCheck.cpp
+    Created: 19 Oct 2026 8:15:36pm
+    Author:  eliot
+
+  ==============================================================================
+*/
+
+#include "RealtimeCheck.h"
+#include "HeadlessProcessor.h"
+#include "PluginUnits.h"
+#include "TestSignals.h"
+#include <iostream>
+
+RealtimeCheck::RealtimeCheck(const Options& checkOptions)
+    : options(checkOptions)
+{
+    options.blockSize = std::max(1, options.blockSize);
+    options.blocksPerStep = std::max(1, options.blocksPerStep);
+}
+
+int RealtimeCheck::run()
+{
+    if (!RealtimeGuard::canDetectAllEvents())
+        std::cerr << "only operator new and delete can be checked on this platform" << std::endl;
+
+    //ten seconds of programme, played in a loop
+    int numSamples = int(10.0 * options.sampleRate);
+    signalL.resize(size_t(numSamples));
+    signalR.resize(size_t(numSamples));
+    TestSignals::fillProgramme(signalL.data(), signalR.data(), numSamples, options.sampleRate);
+
+    for (const auto& unit : getPluginUnits()) {
+        bool selected = options.plugins.isEmpty();
+        for (const auto& name : options.plugins)
+            selected = selected || findPluginUnit(name) == &unit;
+
+        if (selected)
+            checkPlugin(unit);
+    }
+
+    std::cerr << numSteps - numFailures << " of " << numSteps << " steps passed" << std::endl;
+    return numFailures;
+}
+
+void RealtimeCheck::checkPlugin(const PluginUnit& unit)
+{
+    std::cerr << unit.name << std::endl;
+
+    HeadlessProcessor processor(unit);
+    processor.prepare(options.sampleRate, options.blockSize);
+    position = 0;
+
+    //hosts call the first blocks on the audio thread too, so there is no unchecked warm-up
+    runStep(processor, "first blocks", options.blocksPerStep);
+
+    //every value of the choices and switches, the ends and the default of the other parameters
+    auto parameters = processor.getParameters();
+
+    for (auto* parameter : parameters) {
+        int numValues = parameter->getNumSteps();
+        bool discrete = parameter->isDiscrete() || parameter->isBoolean();
+        juce::Array<float> values;
+
+        if (discrete && numValues > 1 && numValues <= 16) {
+            for (int i = 0; i < numValues; ++i)
+                values.add(float(i) / float(numValues - 1));
+        }
+        else {
+            values.add(0.0f);
+            values.add(1.0f);
+        }
+        values.add(parameter->getDefaultValue());
+
+        for (auto value : values) {
+            setParameter(*parameter, value);
+            runStep(processor, parameter->getParameterID() + " = " + parameter->getText(value, 64), options.blocksPerStep);
+        }
+    }
+
+    //a different parameter every block, so that changes also land in the middle of crossfades
+    juce::Random random(0x5eed);
+    const int numAutomatedBlocks = 256;
+    int numFailuresBefore = numFailures;
+
+    for (int block = 0; block < numAutomatedBlocks && numFailures == numFailuresBefore; ++block) {
+        auto* parameter = parameters[random.nextInt(parameters.size())];
+        setParameter(*parameter, random.nextFloat());
+        runStep(processor, "automation " + parameter->getParameterID() + " = " + parameter->getCurrentValueAsText(), 1);
+    }
+}
+
+void RealtimeCheck::setParameter(juce::RangedAudioParameter& parameter, float normalisedValue)
+{
+    //from the host side, outside of any watch
+    parameter.beginChangeGesture();
+    parameter.setValueNotifyingHost(normalisedValue);
+    parameter.endChangeGesture();
+}
+
+void RealtimeCheck::runStep(HeadlessProcessor& processor, const juce::String& step, int numBlocks)
+{
+    RealtimeGuard::Counts total, first;
+    bool failed = false;
+    ++numSteps;
+
+    for (int block = 0; block < numBlocks; ++block) {
+        if (position + options.blockSize > int(signalL.size()))
+            position = 0;
+
+        //the data is not copied, so the watch only sees the plugin
+        {
+            RealtimeGuard::Watch watch;
+            processor.processBlock(signalL.data() + position, signalR.data() + position, options.blockSize);
+
+            const auto& counts = watch.getCounts();
+            if (counts.getTotal() > 0 && !failed) {
+                first = counts;
+                failed = true;
+            }
+            for (int event = 0; event < RealtimeGuard::numEvents; ++event)
+                total.events[event] += counts.events[event];
+        }
+
+        position += options.blockSize;
+    }
+
+    if (!failed) {
+        if (options.verbose)
+            std::cerr << "  ok      " << step << std::endl;
+        return;
+    }
+
+    ++numFailures;
+    std::cerr << "  FAILED  " << step << ":";
+    for (int event = 0; event < RealtimeGuard::numEvents; ++event) {
+        if (total.events[event] > 0)
+            std::cerr << " " << total.events[event] << " " << RealtimeGuard::getEventName(event) << (total.events[event] > 1 ? "s" : "");
+    }
+    std::cerr << std::endl;
+
+    std::cerr << "    first " << RealtimeGuard::getEventName(first.firstEvent) << " from:" << std::endl;
+    for (const auto& frame : RealtimeGuard::getFirstStack(first))
+        std::cerr << "      " << frame << std::endl;
+}
@@ -0,0 +1,56 @@
+/*
+  ==============================================================================
+
+    RealtimeCheck.h
+    Created: 19 Oct 2026 8:15:36pm
+    Author:  eliot
+
+    Checks that processBlock of the three plugins never allocates, frees,
+    locks or makes a blocking system call (see RealtimeGuard.h), from the
+    first block after prepareToPlay, with steady parameters, across every
+    value of each parameter (speaker models and modes included) and under
+    random automation. Parameters are changed between blocks, outside of
+    the watch, as a host would do from another thread.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <vector>
+#include "RealtimeGuard.h"
+
+class HeadlessProcessor;
+struct PluginUnit;
+
+class RealtimeCheck
+{
+public:
+    struct Options
+    {
+        juce::StringArray plugins; // every plugin if empty
+        double sampleRate = 48000.0;
+        int blockSize = 256;
+        int blocksPerStep = 16;    // blocks processed after each change
+        bool verbose = false;      // also print the steps that passed
+    };
+
+    explicit RealtimeCheck(const Options& options);
+
+    // Returns the number of steps that failed
+    int run();
+
+private:
+    void checkPlugin(const PluginUnit& unit);
+    static void setParameter(juce::RangedAudioParameter& parameter, float normalisedValue);
+    void runStep(HeadlessProcessor& processor, const juce::String& step, int numBlocks);
+
+    Options options;
+    std::vector<float> signalL, signalR;
+    int position = 0;
+    int numSteps = 0;
+    int numFailures = 0;
+
+    JUCE_DECLARE_NON_COPYABLE(RealtimeCheck)
+};
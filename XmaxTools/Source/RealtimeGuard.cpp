@@ -0,0 +1,357 @@
+/*
+  ==============================================================================
+
+    RealtimeGuard.cpp
+    Created: 19 Oct 2026 7:48:03pm
+    Author:  eliot
+
+    The hooks may run before main, from any thread and from inside the C
+    library, so they only touch a thread_local pointer, and allocate with
+    the functions of the C library that they replace.
+
+  ==============================================================================
+*/
+
+#include "RealtimeGuard.h"
+#include <atomic>
+#include <cerrno>
+#include <cstdlib>
+#include <new>
+
+#if defined(__GLIBC__)
+ #include <dlfcn.h>
+ #include <execinfo.h>
+ #include <pthread.h>
+ #include <sched.h>
+ #include <time.h>
+ #include <unistd.h>
+ #define XMAX_INTERPOSE 1
+
+extern "C"
+{
+    void* __libc_malloc(size_t size);
+    void* __libc_calloc(size_t count, size_t size);
+    void* __libc_realloc(void* pointer, size_t size);
+    void* __libc_memalign(size_t alignment, size_t size);
+    void __libc_free(void* pointer);
+}
+#else
+ #define XMAX_INTERPOSE 0
+#endif
+
+namespace RealtimeGuard
+{
+static thread_local Counts* watched = nullptr;
+
+static void record(Event event) noexcept
+{
+    auto* counts = watched;
+    if (counts == nullptr)
+        return;
+
+    //capturing the stack may allocate or lock by itself
+    watched = nullptr;
+
+    if (counts->getTotal() == 0) {
+        counts->firstEvent = event;
+       #if XMAX_INTERPOSE
+        counts->firstStackSize = backtrace(counts->firstStack, Counts::maxStackSize);
+       #endif
+    }
+    ++counts->events[event];
+
+    watched = counts;
+}
+
+const char* getEventName(int event) noexcept
+{
+    static const char* const names[numEvents] = { "allocation", "deallocation", "lock", "system call" };
+    return names[event];
+}
+
+int64_t Counts::getTotal() const noexcept
+{
+    int64_t total = 0;
+    for (auto count : events)
+        total += count;
+    return total;
+}
+
+Watch::Watch() noexcept
+{
+   #if XMAX_INTERPOSE
+    //the first backtrace loads the unwinder, which allocates
+    static const bool unwinderLoaded = [] {
+        void* frame[1];
+        return backtrace(frame, 1) >= 0;
+    }();
+    juce::ignoreUnused(unwinderLoaded);
+   #endif
+
+    jassert(watched == nullptr);
+    watched = &counts;
+}
+
+Watch::~Watch()
+{
+    watched = nullptr;
+}
+
+bool canDetectAllEvents() noexcept
+{
+    return XMAX_INTERPOSE != 0;
+}
+
+juce::StringArray getFirstStack(const Counts& counts)
+{
+    juce::StringArray frames;
+
+   #if XMAX_INTERPOSE
+    if (counts.firstStackSize > 0) {
+        char** symbols = backtrace_symbols(counts.firstStack, counts.firstStackSize);
+        for (int i = 0; i < counts.firstStackSize; ++i)
+            frames.add(symbols != nullptr ? juce::String(symbols[i]) : juce::String::toHexString((juce::pointer_sized_int) counts.firstStack[i]));
+        std::free(symbols);
+    }
+   #else
+    juce::ignoreUnused(counts);
+   #endif
+
+    return frames;
+}
+
+//==============================================================================
+// Allocation functions which are not seen by the hooks
+static void* allocateRaw(size_t size) noexcept
+{
+   #if XMAX_INTERPOSE
+    return __libc_malloc(size);
+   #else
+    return std::malloc(size);
+   #endif
+}
+
+static void* allocateRawAligned(size_t size, size_t alignment) noexcept
+{
+   #if XMAX_INTERPOSE
+    return __libc_memalign(alignment, size);
+   #elif defined(_MSC_VER)
+    return _aligned_malloc(size, alignment);
+   #else
+    return std::aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment);
+   #endif
+}
+
+static void freeRaw(void* pointer) noexcept
+{
+   #if XMAX_INTERPOSE
+    __libc_free(pointer);
+   #else
+    std::free(pointer);
+   #endif
+}
+
+static void freeRawAligned(void* pointer) noexcept
+{
+   #if defined(_MSC_VER) && !XMAX_INTERPOSE
+    _aligned_free(pointer);
+   #else
+    freeRaw(pointer);
+   #endif
+}
+
+static void* newHook(size_t size)
+{
+    record(allocation);
+    if (auto* pointer = allocateRaw(size > 0 ? size : 1))
+        return pointer;
+    throw std::bad_alloc();
+}
+
+static void* newAlignedHook(size_t size, std::align_val_t alignment)
+{
+    record(allocation);
+    if (auto* pointer = allocateRawAligned(size > 0 ? size : 1, size_t(alignment)))
+        return pointer;
+    throw std::bad_alloc();
+}
+
+static void deleteHook(void* pointer) noexcept
+{
+    if (pointer != nullptr) {
+        record(deallocation);
+        freeRaw(pointer);
+    }
+}
+
+static void deleteAlignedHook(void* pointer) noexcept
+{
+    if (pointer != nullptr) {
+        record(deallocation);
+        freeRawAligned(pointer);
+    }
+}
+}
+
+//==============================================================================
+void* operator new(size_t size)                                   { return RealtimeGuard::newHook(size); }
+void* operator new[](size_t size)                                 { return RealtimeGuard::newHook(size); }
+void* operator new(size_t size, std::align_val_t alignment)       { return RealtimeGuard::newAlignedHook(size, alignment); }
+void* operator new[](size_t size, std::align_val_t alignment)     { return RealtimeGuard::newAlignedHook(size, alignment); }
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept
+{
+    try { return RealtimeGuard::newHook(size); } catch (...) { return nullptr; }
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept
+{
+    try { return RealtimeGuard::newHook(size); } catch (...) { return nullptr; }
+}
+
+void* operator new(size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+    try { return RealtimeGuard::newAlignedHook(size, alignment); } catch (...) { return nullptr; }
+}
+
+void* operator new[](size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+    try { return RealtimeGuard::newAlignedHook(size, alignment); } catch (...) { return nullptr; }
+}
+
+void operator delete(void* pointer) noexcept                                          { RealtimeGuard::deleteHook(pointer); }
+void operator delete[](void* pointer) noexcept                                        { RealtimeGuard::deleteHook(pointer); }
+void operator delete(void* pointer, size_t) noexcept                                  { RealtimeGuard::deleteHook(pointer); }
+void operator delete[](void* pointer, size_t) noexcept                                { RealtimeGuard::deleteHook(pointer); }
+void operator delete(void* pointer, const std::nothrow_t&) noexcept                   { RealtimeGuard::deleteHook(pointer); }
+void operator delete[](void* pointer, const std::nothrow_t&) noexcept                 { RealtimeGuard::deleteHook(pointer); }
+void operator delete(void* pointer, std::align_val_t) noexcept                        { RealtimeGuard::deleteAlignedHook(pointer); }
+void operator delete[](void* pointer, std::align_val_t) noexcept                      { RealtimeGuard::deleteAlignedHook(pointer); }
+void operator delete(void* pointer, size_t, std::align_val_t) noexcept                { RealtimeGuard::deleteAlignedHook(pointer); }
+void operator delete[](void* pointer, size_t, std::align_val_t) noexcept              { RealtimeGuard::deleteAlignedHook(pointer); }
+void operator delete(void* pointer, std::align_val_t, const std::nothrow_t&) noexcept { RealtimeGuard::deleteAlignedHook(pointer); }
+void operator delete[](void* pointer, std::align_val_t, const std::nothrow_t&) noexcept { RealtimeGuard::deleteAlignedHook(pointer); }
+
+//==============================================================================
+#if XMAX_INTERPOSE
+// The executable defines these symbols, so they are found before the ones of the C library,
+// also by the shared libraries. The next definition is looked up on the first call, without
+// a static guard, since the guard itself may lock a mutex.
+template<typename Function>
+static Function findNext(std::atomic<void*>& cache, const char* name) noexcept
+{
+    void* function = cache.load(std::memory_order_relaxed);
+    if (function == nullptr) {
+        function = dlsym(RTLD_NEXT, name);
+        cache.store(function, std::memory_order_relaxed);
+    }
+    return reinterpret_cast<Function>(function);
+}
+
+#define XMAX_CALL_NEXT(type, name, ...)                          \
+    static std::atomic<void*> next##name{ nullptr };             \
+    return findNext<type>(next##name, #name)(__VA_ARGS__)
+
+extern "C"
+{
+void* malloc(size_t size) noexcept
+{
+    RealtimeGuard::record(RealtimeGuard::allocation);
+    return __libc_malloc(size);
+}
+
+void* calloc(size_t count, size_t size) noexcept
+{
+    RealtimeGuard::record(RealtimeGuard::allocation);
+    return __libc_calloc(count, size);
+}
+
+void* realloc(void* pointer, size_t size) noexcept
+{
+    RealtimeGuard::record(RealtimeGuard::allocation);
+    return __libc_realloc(pointer, size);
+}
+
+void* memalign(size_t alignment, size_t size) noexcept
+{
+    RealtimeGuard::record(RealtimeGuard::allocation);
+    return __libc_memalign(alignment, size);
+}
+
+void* aligned_alloc(size_t alignment, size_t size) noexcept
+{
+    RealtimeGuard::record(RealtimeGuard::allocation);
+    return __libc_memalign(alignment, size);
+}
+
+int posix_memalign(void** pointer, size_t alignment, size_t size) noexcept
+{
+    RealtimeGuard::record(RealtimeGuard::allocation);
+    *pointer = __libc_memalign(alignment, size);
+    return *pointer != nullptr ? 0 : ENOMEM;
+}
+
+void free(void* pointer) noexcept
+{
+    if (pointer != nullptr)
+        RealtimeGuard::record(RealtimeGuard::deallocation);
+    __libc_free(pointer);
+}
+
+int pthread_mutex_lock(pthread_mutex_t* mutex) noexcept
+{
+    RealtimeGuard::record(RealtimeGuard::lock);
+    XMAX_CALL_NEXT(int (*)(pthread_mutex_t*), pthread_mutex_lock, mutex);
+}
+
+int pthread_mutex_trylock(pthread_mutex_t* mutex) noexcept
+{
+    RealtimeGuard::record(RealtimeGuard::lock);
+    XMAX_CALL_NEXT(int (*)(pthread_mutex_t*), pthread_mutex_trylock, mutex);
+}
+
+int pthread_rwlock_rdlock(pthread_rwlock_t* rwlock) noexcept
+{
+    RealtimeGuard::record(RealtimeGuard::lock);
+    XMAX_CALL_NEXT(int (*)(pthread_rwlock_t*), pthread_rwlock_rdlock, rwlock);
+}
+
+int pthread_rwlock_wrlock(pthread_rwlock_t* rwlock) noexcept
+{
+    RealtimeGuard::record(RealtimeGuard::lock);
+    XMAX_CALL_NEXT(int (*)(pthread_rwlock_t*), pthread_rwlock_wrlock, rwlock);
+}
+
+int nanosleep(const struct timespec* duration, struct timespec* remaining)
+{
+    RealtimeGuard::record(RealtimeGuard::systemCall);
+    XMAX_CALL_NEXT(int (*)(const struct timespec*, struct timespec*), nanosleep, duration, remaining);
+}
+
+int usleep(useconds_t microseconds)
+{
+    RealtimeGuard::record(RealtimeGuard::systemCall);
+    XMAX_CALL_NEXT(int (*)(useconds_t), usleep, microseconds);
+}
+
+int sched_yield() noexcept
+{
+    RealtimeGuard::record(RealtimeGuard::systemCall);
+    XMAX_CALL_NEXT(int (*)(), sched_yield);
+}
+
+ssize_t read(int file, void* data, size_t size)
+{
+    RealtimeGuard::record(RealtimeGuard::systemCall);
+    XMAX_CALL_NEXT(ssize_t (*)(int, void*, size_t), read, file, data, size);
+}
+
+ssize_t write(int file, const void* data, size_t size)
+{
+    RealtimeGuard::record(RealtimeGuard::systemCall);
+    XMAX_CALL_NEXT(ssize_t (*)(int, const void*, size_t), write, file, data, size);
+}
+}
+
+#undef XMAX_CALL_NEXT
+#endif
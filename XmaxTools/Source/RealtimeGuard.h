@@ -0,0 +1,62 @@
+/*
+  ==============================================================================
+
+    RealtimeGuard.h
+    Created: 19 Oct 2026 7:48:03pm
+    Author:  eliot
+
+    Detects what must never happen on the audio thread: memory allocations
+    and frees, locks and blocking system calls. The global operator new and
+    delete are replaced for the whole tool. With glibc, malloc and friends,
+    the pthread mutex and rwlock functions, and a few system calls (sleeps,
+    read, write) are interposed as well. Nothing is counted outside of a
+    Watch, and only on the thread that created it.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <cstdint>
+
+namespace RealtimeGuard
+{
+    enum Event { allocation, deallocation, lock, systemCall, numEvents };
+
+    const char* getEventName(int event) noexcept;
+
+    struct Counts
+    {
+        int64_t events[numEvents] = {};
+
+        // call stack of the first event, when it can be captured
+        static constexpr int maxStackSize = 32;
+        void* firstStack[maxStackSize] = {};
+        int firstStackSize = 0;
+        int firstEvent = allocation;
+
+        int64_t getTotal() const noexcept;
+    };
+
+    // Counts the events of the current thread while it exists. Watches do not nest.
+    class Watch
+    {
+    public:
+        Watch() noexcept;
+        ~Watch();
+
+        const Counts& getCounts() const noexcept { return counts; }
+
+    private:
+        Counts counts;
+
+        JUCE_DECLARE_NON_COPYABLE(Watch)
+    };
+
+    // Whether the events other than operator new and delete can be seen on this platform
+    bool canDetectAllEvents() noexcept;
+
+    // Readable frames of the stack captured with the first event (allocates, call it after the watch)
+    juce::StringArray getFirstStack(const Counts& counts);
+}
@@ -0,0 +1,332 @@
+/*
+  ==============================================================================
+
+    Regression.cpp
+    Created: 19 Oct 2026 10:06:44pm
+    Author:  eliot
+
+  ==============================================================================
+*/
+
+#include "Regression.h"
+#include "HeadlessProcessor.h"
+#include "PluginUnits.h"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+static const char* const indexFileName = "references.json";
+
+Regression::Regression(const Options& regressionOptions)
+    : options(regressionOptions)
+{
+    options.blockSize = std::max(1, options.blockSize);
+}
+
+//==============================================================================
+// The tolerances follow how much a reordering of the float operations can change each output:
+// little for steady tones, more for the broadband signals which keep the envelope moving
+const std::vector<Regression::Signal>& Regression::getCorpus()
+{
+    static const std::vector<Signal> corpus = {
+        { "resonanceTones",  TestSignals::fillResonanceTones,  -100.0f },
+        { "resonanceSweep",  TestSignals::fillResonanceSweep,  -90.0f },
+        { "thresholdBursts", TestSignals::fillThresholdBursts, -90.0f },
+        { "decreasingPeaks", TestSignals::fillDecreasingPeaks, -100.0f },
+        { "pinkNoise",       TestSignals::fillPinkNoise,       -80.0f },
+        { "programme",       TestSignals::fillProgramme,       -80.0f }
+    };
+    return corpus;
+}
+
+std::vector<Regression::Setting> Regression::getSettings(const HeadlessProcessor& processor)
+{
+    static const std::vector<Setting> settings = {
+        { "default",       {}, {} },
+        { "lowThreshold",  { { "thresholdDisplacement", 0.5f } }, {} },
+        { "highThreshold", { { "thresholdDisplacement", 4.0f } }, {} },
+        { "hotSpeaker",    { { "speakerGain", 12.0f }, { "inputGain", 6.0f } }, {} },
+        { "fastEnvelope",  { { "attackTime", 0.5f }, { "holdTime", 0.0f }, { "releaseTime", 10.0f }, { "lookAheadTime", 0.5f } }, {} },
+        { "slowEnvelope",  { { "attackTime", 20.0f }, { "holdTime", 100.0f }, { "releaseTime", 1000.0f }, { "lookAheadTime", 20.0f } }, {} },
+        { "softKnee",      { { "knee", 50.0f } }, {} },
+        { "fixedLatency",  { { "fixedLatency", 1.0f } }, {} },
+        { "mix",           { { "mix", 50.0f }, { "gain", -6.0f } }, {} },
+        { "levelMode",     { { "limiterMode", 0.0f }, { "thresholdTension", 0.5f } }, {} },
+        { "gainMode",      { { "filterMode", 1.0f } }, {} }
+    };
+
+    std::vector<Setting> applicable;
+    for (const auto& setting : settings) {
+        bool applies = setting.values.empty();
+        for (const auto& value : setting.values)
+            applies = applies || processor.hasParameter(value.first);
+
+        if (applies)
+            applicable.push_back(setting);
+    }
+
+    //every other speaker model, with the signals around the resonance only
+    int numModels = processor.getUnit().getSpeakerModelNames().size();
+    for (int model = 1; model < numModels; ++model)
+        applicable.push_back({ "model" + juce::String(model), { { HeadlessProcessor::speakerModelID, float(model) } }, { "resonanceTones", "programme" } });
+
+    return applicable;
+}
+
+bool Regression::isSelected(const PluginUnit& unit) const
+{
+    bool selected = options.plugins.isEmpty();
+    for (const auto& name : options.plugins)
+        selected = selected || findPluginUnit(name) == &unit;
+    return selected;
+}
+
+juce::String Regression::getCasePath(const PluginUnit& unit, const Setting& setting, const Signal& signal) const
+{
+    return unit.name + "/" + setting.name + "/" + signal.name + ".f32";
+}
+
+//==============================================================================
+Regression::Render Regression::render(const PluginUnit& unit, const Setting& setting, const Signal& signal) const
+{
+    Render result;
+    HeadlessProcessor processor(unit);
+
+    //the Limiter protects the displacement, except in the settings which change its mode
+    processor.setParameter("limiterMode", 1.0f);
+    for (const auto& value : setting.values)
+        processor.setParameter(value.first, value.second);
+
+    //prepareToPlay starts the smoothed parameters at their values
+    processor.prepare(options.sampleRate, options.blockSize);
+    result.threshold = processor.getParameter(HeadlessProcessor::thresholdDisplacementID);
+
+    int numSamples = int(options.seconds * options.sampleRate);
+    auto length = size_t(numSamples);
+    std::vector<float> dataL(length), dataR(length);
+    signal.fill(dataL.data(), dataR.data(), numSamples, options.sampleRate);
+
+    unit.takePeakDisplacement(processor.getProcessor());
+
+    for (int start = 0; start < numSamples; start += options.blockSize) {
+        int blockLength = std::min(options.blockSize, numSamples - start);
+        processor.processBlock(dataL.data() + start, dataR.data() + start, blockLength);
+        result.displacement.push_back(unit.takePeakDisplacement(processor.getProcessor()));
+    }
+
+    result.output.resize(2 * length);
+    for (size_t i = 0; i < length; ++i) {
+        result.output[2 * i] = dataL[i];
+        result.output[2 * i + 1] = dataR[i];
+    }
+    return result;
+}
+
+// Little-endian floats: the output, then the displacement of each block
+bool Regression::write(const juce::File& file, const Render& result) const
+{
+    juce::MemoryOutputStream stream;
+    for (auto sample : result.output)
+        stream.writeFloat(sample);
+    for (auto displacement : result.displacement)
+        stream.writeFloat(displacement);
+
+    return file.getParentDirectory().createDirectory().wasOk()
+        && file.replaceWithData(stream.getData(), stream.getDataSize());
+}
+
+bool Regression::read(const juce::File& file, int numSamples, int numBlocks, Render& result) const
+{
+    juce::MemoryBlock data;
+    auto numValues = 2 * size_t(numSamples) + size_t(numBlocks);
+    if (!file.loadFileAsData(data) || data.getSize() != numValues * sizeof(float))
+        return false;
+
+    juce::MemoryInputStream stream(data, false);
+    result.output.resize(2 * size_t(numSamples));
+    result.displacement.resize(size_t(numBlocks));
+    for (auto& sample : result.output)
+        sample = stream.readFloat();
+    for (auto& displacement : result.displacement)
+        displacement = stream.readFloat();
+    return true;
+}
+
+//==============================================================================
+bool Regression::record()
+{
+    juce::Array<juce::var> cases;
+
+    for (const auto& unit : getPluginUnits()) {
+        if (!isSelected(unit))
+            continue;
+
+        std::cerr << unit.name << std::endl;
+        HeadlessProcessor parameters(unit);
+
+        for (const auto& setting : getSettings(parameters)) {
+            for (const auto& signal : getCorpus()) {
+                if (!setting.signals.isEmpty() && !setting.signals.contains(signal.name))
+                    continue;
+
+                auto result = render(unit, setting, signal);
+                auto path = getCasePath(unit, setting, signal);
+                if (!write(options.directory.getChildFile(path), result)) {
+                    std::cerr << "could not write " << options.directory.getChildFile(path).getFullPathName() << std::endl;
+                    return false;
+                }
+
+                auto* entry = new juce::DynamicObject();
+                entry->setProperty("plugin", unit.name);
+                entry->setProperty("setting", setting.name);
+                entry->setProperty("signal", signal.name);
+                entry->setProperty("file", path);
+                entry->setProperty("numSamples", int(result.output.size() / 2));
+                entry->setProperty("numBlocks", int(result.displacement.size()));
+                entry->setProperty("thresholdDisplacement", result.threshold);
+                entry->setProperty("peakDisplacement", *std::max_element(result.displacement.begin(), result.displacement.end()));
+                cases.add(juce::var(entry));
+
+                if (options.verbose)
+                    std::cerr << "  " << path << std::endl;
+            }
+        }
+    }
+
+    auto* index = new juce::DynamicObject();
+    index->setProperty("sampleRate", options.sampleRate);
+    index->setProperty("blockSize", options.blockSize);
+    index->setProperty("seconds", options.seconds);
+    index->setProperty("cases", cases);
+
+    auto indexFile = options.directory.getChildFile(indexFileName);
+    if (!indexFile.replaceWithText(juce::JSON::toString(juce::var(index)))) {
+        std::cerr << "could not write " << indexFile.getFullPathName() << std::endl;
+        return false;
+    }
+
+    std::cerr << cases.size() << " references written to " << options.directory.getFullPathName() << std::endl;
+    return true;
+}
+
+int Regression::compare()
+{
+    auto indexFile = options.directory.getChildFile(indexFileName);
+    auto index = juce::JSON::parse(indexFile);
+    if (!index.isObject()) {
+        std::cerr << "no references in " << options.directory.getFullPathName() << ", record them first" << std::endl;
+        return 1;
+    }
+
+    //the references are only comparable with the same rendering
+    options.sampleRate = index["sampleRate"];
+    options.blockSize = index["blockSize"];
+    options.seconds = index["seconds"];
+
+    int numCases = 0;
+    int numFailures = 0;
+
+    for (const auto& unit : getPluginUnits()) {
+        if (!isSelected(unit))
+            continue;
+
+        std::cerr << unit.name << std::endl;
+        HeadlessProcessor parameters(unit);
+
+        for (const auto& setting : getSettings(parameters)) {
+            for (const auto& signal : getCorpus()) {
+                if (!setting.signals.isEmpty() && !setting.signals.contains(signal.name))
+                    continue;
+
+                auto path = getCasePath(unit, setting, signal);
+                juce::var entry;
+                if (auto* cases = index["cases"].getArray()) {
+                    for (const auto& candidate : *cases) {
+                        if (candidate["file"].toString() == path)
+                            entry = candidate;
+                    }
+                }
+
+                juce::StringArray failures;
+                Render reference;
+                ++numCases;
+
+                if (!entry.isObject() || !read(options.directory.getChildFile(path), entry["numSamples"], entry["numBlocks"], reference)) {
+                    failures.add("no reference, record it first");
+                }
+                else {
+                    reference.threshold = entry["thresholdDisplacement"];
+                    failures = check(reference, render(unit, setting, signal), signal);
+                }
+
+                if (failures.isEmpty()) {
+                    if (options.verbose)
+                        std::cerr << "  ok      " << path << std::endl;
+                    continue;
+                }
+
+                ++numFailures;
+                std::cerr << "  FAILED  " << path << std::endl;
+                for (const auto& failure : failures)
+                    std::cerr << "    " << failure << std::endl;
+            }
+        }
+    }
+
+    std::cerr << numCases - numFailures << " of " << numCases << " cases match their reference" << std::endl;
+    return numFailures;
+}
+
+// The reasons why the result does not match the reference, if any
+juce::StringArray Regression::check(const Render& reference, const Render& result, const Signal& signal) const
+{
+    juce::StringArray failures;
+
+    if (result.output.size() != reference.output.size() || result.displacement.size() != reference.displacement.size()) {
+        failures.add("the length differs from the reference");
+        return failures;
+    }
+
+    if (result.threshold != reference.threshold)
+        failures.add("thresholdDisplacement is " + juce::String(result.threshold) + " mm instead of " + juce::String(reference.threshold) + " mm");
+
+    //output, relative to the reference (or to full scale if the reference is silent)
+    double errorEnergy = 0.0, referenceEnergy = 0.0;
+    float peakError = 0.0f, referencePeak = 0.0f;
+    for (size_t i = 0; i < result.output.size(); ++i) {
+        float error = result.output[i] - reference.output[i];
+        errorEnergy += double(error) * double(error);
+        referenceEnergy += double(reference.output[i]) * double(reference.output[i]);
+        peakError = std::max(peakError, std::abs(error));
+        referencePeak = std::max(referencePeak, std::abs(reference.output[i]));
+    }
+
+    auto toDecibels = [](double error, double scale) {
+        return error > 0.0 ? 20.0 * std::log10(error / (scale > 0.0 ? scale : 1.0)) : -1000.0;
+    };
+    double rmsErrorDb = toDecibels(std::sqrt(errorEnergy), std::sqrt(referenceEnergy));
+    double peakErrorDb = toDecibels(peakError, referencePeak);
+
+    if (rmsErrorDb > signal.maxErrorDb || peakErrorDb > signal.maxErrorDb)
+        failures.add("output error " + juce::String(rmsErrorDb, 1) + " dB RMS, " + juce::String(peakErrorDb, 1)
+                     + " dB peak, above the tolerance of " + juce::String(signal.maxErrorDb, 1) + " dB");
+
+    //displacement: the peak may not grow, by more than the rounding of the meters
+    float peak = *std::max_element(result.displacement.begin(), result.displacement.end());
+    float referenceDisplacementPeak = *std::max_element(reference.displacement.begin(), reference.displacement.end());
+    if (peak > referenceDisplacementPeak * 1.0001f + 1e-6f)
+        failures.add("peak displacement " + juce::String(peak, 4) + " mm instead of " + juce::String(referenceDisplacementPeak, 4) + " mm");
+
+    //and the hard check, without any tolerance
+    double blockDuration = options.blockSize / options.sampleRate;
+    for (size_t block = 0; block < result.displacement.size(); ++block) {
+        if (result.displacement[block] > result.threshold && reference.displacement[block] <= reference.threshold) {
+            failures.add("displacement " + juce::String(result.displacement[block], 4) + " mm above the threshold of "
+                         + juce::String(result.threshold, 2) + " mm at " + juce::String(double(block) * blockDuration, 3)
+                         + " s, where the reference stayed below");
+            break;
+        }
+    }
+
+    return failures;
+}
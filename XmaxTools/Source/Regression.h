@@ -0,0 +1,96 @@
+/*
+  ==============================================================================
+
+    Regression.h
+    Created: 19 Oct 2026 10:06:44pm
+    Author:  eliot
+
+    Golden references of the protection behaviour, so that the DSP can be
+    optimised without changing it. Every plugin renders a fixed corpus of
+    test signals with a matrix of parameter settings, from a freshly
+    prepared processor. record() stores the outputs and the peak predicted
+    displacement of every block; compare() renders them again and checks
+    them against the stored ones:
+    - the output must match within the tolerance of the signal, as the RMS
+      and the peak of the difference relative to the reference;
+    - the peak displacement may not grow;
+    - a block whose displacement stayed below thresholdDisplacement in the
+      reference may never exceed it, whatever the tolerances.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <utility>
+#include <vector>
+#include "TestSignals.h"
+
+class HeadlessProcessor;
+struct PluginUnit;
+
+class Regression
+{
+public:
+    struct Options
+    {
+        juce::StringArray plugins; // every plugin if empty
+        juce::File directory;      // where the references are stored
+        double sampleRate = 48000.0;
+        int blockSize = 512;
+        double seconds = 2.0;      // length of each test signal
+        bool verbose = false;      // also print the cases that passed
+    };
+
+    // A test signal of the corpus, and how far a new build may deviate from its reference
+    struct Signal
+    {
+        const char* name;
+        TestSignals::FillFunction fill;
+        float maxErrorDb;
+    };
+
+    // Parameters set by ID in their own units (see HeadlessProcessor), over the defaults of the
+    // plugin and the displacement mode of the Limiter
+    struct Setting
+    {
+        juce::String name;
+        std::vector<std::pair<juce::String, float>> values;
+        juce::StringArray signals; // every signal of the corpus if empty
+    };
+
+    explicit Regression(const Options& options);
+
+    // Renders every case and stores it as the new reference; returns false if it could not be written
+    bool record();
+
+    // Renders every case again with the options of the references, and returns the number of failed cases
+    int compare();
+
+    static const std::vector<Signal>& getCorpus();
+
+    // The settings which apply to this plugin: one per speaker model, and the ones which set
+    // at least one of its parameters
+    static std::vector<Setting> getSettings(const HeadlessProcessor& processor);
+
+private:
+    struct Render
+    {
+        std::vector<float> output;       // interleaved stereo
+        std::vector<float> displacement; // peak of each block, mm
+        float threshold = 0.0f;          // thresholdDisplacement of the setting, mm
+    };
+
+    bool isSelected(const PluginUnit& unit) const;
+    juce::String getCasePath(const PluginUnit& unit, const Setting& setting, const Signal& signal) const;
+
+    Render render(const PluginUnit& unit, const Setting& setting, const Signal& signal) const;
+    bool write(const juce::File& file, const Render& result) const;
+    bool read(const juce::File& file, int numSamples, int numBlocks, Render& result) const;
+    juce::StringArray check(const Render& reference, const Render& result, const Signal& signal) const;
+
+    Options options;
+
+    JUCE_DECLARE_NON_COPYABLE(Regression)
+};
@@ -0,0 +1,268 @@
+/*
+  ==============================================================================
+
+    Simulation.cpp
+    Created: 19 Oct 2026 3:58:41pm
+    Author:  eliot
+
+  ==============================================================================
+*/
+
+#include "Simulation.h"
+#include "HeadlessProcessor.h"
+#include "PluginUnits.h"
+#include "SpeakerPlant.h"
+#include "TestSignals.h"
+#include <iostream>
+
+Simulation::Simulation(const Options& simulationOptions)
+    : options(simulationOptions)
+{
+}
+
+bool Simulation::isSelected(const PluginUnit& unit) const
+{
+    bool selected = options.plugins.isEmpty();
+    for (const auto& name : options.plugins)
+        selected = selected || findPluginUnit(name) == &unit;
+    return selected;
+}
+
+int Simulation::run()
+{
+    int numFailures = 0;
+
+    auto addResult = [&](const juce::var& result) {
+        bool failed = result["failed"];
+        numFailures += failed ? 1 : 0;
+        results.add(result);
+
+        if (failed || options.verbose) {
+            auto model = result["speakerModel"].toString();
+            if (result.getDynamicObject()->hasProperty("previousModel"))
+                model = result["previousModel"].toString() + " -> " + model;
+
+            std::cerr << (failed ? "  FAIL " : "  ok   ") << model << " / " << result["signal"].toString()
+                      << ": true excursion " << juce::String(double(result["trueDisplacement"]), 2)
+                      << " mm, predicted " << juce::String(double(result["predictedDisplacement"]), 2)
+                      << " mm, threshold " << juce::String(double(result["threshold"]), 2) << " mm" << std::endl;
+        }
+    };
+
+    for (const auto& unit : getPluginUnits()) {
+        if (!isSelected(unit))
+            continue;
+
+        std::cerr << unit.name << std::endl;
+        auto modelNames = unit.getSpeakerModelNames();
+
+        for (int model = 0; model < modelNames.size(); ++model) {
+            if (!options.models.isEmpty() && !options.models.contains(modelNames[model], true))
+                continue;
+
+            for (const auto& signal : options.signals)
+                addResult(simulate(unit, model, signal));
+        }
+
+        if (options.modelSwitch) {
+            auto switchModels = findSwitchModels(unit);
+            if (switchModels.first != switchModels.second)
+                addResult(simulateModelSwitch(unit, switchModels.first, switchModels.second));
+        }
+    }
+
+    std::cerr << results.size() - numFailures << " of " << results.size() << " cases within the threshold, driver simulated "
+              << juce::roundToInt(simulatedSeconds / std::max(plantSeconds, 1e-9)) << "x faster than real time" << std::endl;
+    return numFailures;
+}
+
+juce::var Simulation::simulate(const PluginUnit& unit, int model, const juce::String& signal)
+{
+    HeadlessProcessor processor(unit);
+
+    //the Limiter protects the displacement; set before prepare, as in the regression
+    processor.setParameter("limiterMode", 1.0f);
+    processor.setParameter(HeadlessProcessor::speakerModelID, float(model));
+    for (const auto& parameter : options.parameters)
+        processor.setParameterText(parameter.first, parameter.second);
+    if (options.threshold > 0.0)
+        processor.setParameter(HeadlessProcessor::thresholdDisplacementID, float(options.threshold));
+    processor.prepare(options.sampleRate, options.blockSize);
+
+    double threshold = processor.getParameter(HeadlessProcessor::thresholdDisplacementID);
+    auto speakerGain = juce::Decibels::decibelsToGain(processor.getParameter("speakerGain"));
+
+    int numSamples = std::max(1, int(options.seconds * options.sampleRate));
+    auto length = size_t(numSamples);
+    std::vector<float> dataL(length), dataR(length);
+    TestSignals::findGenerator(signal)->fill(dataL.data(), dataR.data(), numSamples, options.sampleRate);
+
+    //the prediction of the plugin, block by block
+    float predicted = 0.0f;
+    unit.takePeakDisplacement(processor.getProcessor());
+    for (int start = 0; start < numSamples; start += options.blockSize) {
+        int blockSize = std::min(options.blockSize, numSamples - start);
+        processor.processBlock(dataL.data() + start, dataR.data() + start, blockSize);
+        predicted = std::max(predicted, unit.takePeakDisplacement(processor.getProcessor()));
+    }
+
+    auto run = driveSpeaker(unit, model, threshold, speakerGain, dataL, dataR);
+    float excursion = run.excursion;
+
+    auto* result = new juce::DynamicObject();
+    result->setProperty("plugin", unit.name);
+    result->setProperty("speakerModel", unit.getSpeakerModelNames()[model]);
+    result->setProperty("signal", signal);
+    result->setProperty("threshold", threshold);
+    result->setProperty("predictedDisplacement", predicted);
+    result->setProperty("trueDisplacement", excursion);
+    result->setProperty("excess", threshold > 0.0 ? excursion / threshold - 1.0 : 0.0);
+    result->setProperty("stepsPerSample", run.stepsPerSample);
+    result->setProperty("realtimeFactor", options.seconds / std::max(run.seconds, 1e-9));
+    result->setProperty("failed", excursion > threshold * (1.0 + options.tolerance));
+    return juce::var(result);
+}
+
+// Drives the driver of this model with the output of a plugin, in place: the tension at the
+// terminals once amplified, then the displacement in mm
+Simulation::DriverRun Simulation::driveSpeaker(const PluginUnit& unit, int model, double threshold, double speakerGain,
+                                               std::vector<float>& dataL, std::vector<float>& dataR)
+{
+    for (size_t i = 0; i < dataL.size(); ++i) {
+        dataL[i] *= float(speakerGain);
+        dataR[i] *= float(speakerGain);
+    }
+
+    auto parameters = unit.getPlantParameters(model);
+    if (!options.linear)
+        parameters.setTypicalNonlinearity(options.xmax > 0.0 ? options.xmax : threshold);
+
+    SpeakerPlant<2> plant;
+    plant.prepare(parameters, options.sampleRate);
+    const float* tension[] = { dataL.data(), dataR.data() };
+    float* displacement[] = { dataL.data(), dataR.data() };
+
+    DriverRun run;
+    auto start = juce::Time::getHighResolutionTicks();
+    plant.process(tension, displacement, int(dataL.size()));
+    run.seconds = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - start);
+    run.stepsPerSample = plant.getStepsPerSample();
+    plantSeconds += run.seconds;
+    simulatedSeconds += double(dataL.size()) / options.sampleRate;
+
+    for (size_t i = 0; i < dataL.size(); ++i)
+        run.excursion = std::max({ run.excursion, std::abs(dataL[i]), std::abs(dataR[i]) });
+    return run;
+}
+
+// The selected models whose linear driver moves the least and the most under the bass tone
+// of the switch, at the same tension
+std::pair<int, int> Simulation::findSwitchModels(const PluginUnit& unit) const
+{
+    auto modelNames = unit.getSpeakerModelNames();
+    int numSamples = int(options.sampleRate); //one second, past the transient
+    auto length = size_t(numSamples);
+    std::vector<float> tone(length), excursion(length);
+    for (int i = 0; i < numSamples; ++i)
+        tone[size_t(i)] = float(std::sin(juce::MathConstants<double>::twoPi * switchFrequency * i / options.sampleRate));
+
+    std::pair<int, int> models{ -1, -1 };
+    float least = 0.0f, most = 0.0f;
+    for (int model = 0; model < modelNames.size(); ++model) {
+        if (!options.models.isEmpty() && !options.models.contains(modelNames[model], true))
+            continue;
+
+        SpeakerPlant<1> plant;
+        plant.prepare(unit.getPlantParameters(model), options.sampleRate);
+        const float* tension[] = { tone.data() };
+        float* displacement[] = { excursion.data() };
+        plant.process(tension, displacement, numSamples);
+
+        float peak = 0.0f;
+        for (auto x : excursion)
+            peak = std::max(peak, std::abs(x));
+
+        if (models.first < 0 || peak < least) {
+            models.first = model;
+            least = peak;
+        }
+        if (models.second < 0 || peak > most) {
+            models.second = model;
+            most = peak;
+        }
+    }
+    return models;
+}
+
+// Silence on the first model, then a full-scale bass tone that starts with the switch to the
+// second one, whose driver is simulated. The look-ahead samples judged early in the crossfade
+// are played later in it, so the envelope must see the new driver from the start of the switch.
+juce::var Simulation::simulateModelSwitch(const PluginUnit& unit, int fromModel, int toModel)
+{
+    HeadlessProcessor processor(unit);
+
+    processor.setParameter("limiterMode", 1.0f);
+    processor.setParameter(HeadlessProcessor::speakerModelID, float(fromModel));
+    for (const auto& parameter : options.parameters)
+        processor.setParameterText(parameter.first, parameter.second);
+    if (options.threshold > 0.0)
+        processor.setParameter(HeadlessProcessor::thresholdDisplacementID, float(options.threshold));
+    processor.prepare(options.sampleRate, options.blockSize);
+
+    double threshold = processor.getParameter(HeadlessProcessor::thresholdDisplacementID);
+    auto speakerGain = juce::Decibels::decibelsToGain(processor.getParameter("speakerGain"));
+
+    int numSamples = std::max(1, int(options.seconds * options.sampleRate));
+    int switchSample = (numSamples / 4) / options.blockSize * options.blockSize; //at the start of a block
+    auto length = size_t(numSamples);
+    std::vector<float> dataL(length), dataR(length);
+    for (int i = switchSample; i < numSamples; ++i) {
+        dataL[size_t(i)] = dataR[size_t(i)]
+            = float(std::sin(juce::MathConstants<double>::twoPi * switchFrequency * (i - switchSample) / options.sampleRate));
+    }
+
+    float predicted = 0.0f;
+    unit.takePeakDisplacement(processor.getProcessor());
+    for (int start = 0; start < numSamples; start += options.blockSize) {
+        if (start == switchSample)
+            processor.setParameter(HeadlessProcessor::speakerModelID, float(toModel));
+
+        int blockSize = std::min(options.blockSize, numSamples - start);
+        processor.processBlock(dataL.data() + start, dataR.data() + start, blockSize);
+        predicted = std::max(predicted, unit.takePeakDisplacement(processor.getProcessor()));
+    }
+
+    auto run = driveSpeaker(unit, toModel, threshold, speakerGain, dataL, dataR);
+    auto modelNames = unit.getSpeakerModelNames();
+
+    auto* result = new juce::DynamicObject();
+    result->setProperty("plugin", unit.name);
+    result->setProperty("speakerModel", modelNames[toModel]);
+    result->setProperty("previousModel", modelNames[fromModel]);
+    result->setProperty("signal", "modelSwitch");
+    result->setProperty("threshold", threshold);
+    result->setProperty("predictedDisplacement", predicted);
+    result->setProperty("trueDisplacement", run.excursion);
+    result->setProperty("excess", threshold > 0.0 ? run.excursion / threshold - 1.0 : 0.0);
+    result->setProperty("stepsPerSample", run.stepsPerSample);
+    result->setProperty("realtimeFactor", options.seconds / std::max(run.seconds, 1e-9));
+    result->setProperty("failed", run.excursion > threshold * (1.0 + options.tolerance));
+    return juce::var(result);
+}
+
+juce::var Simulation::getReport() const
+{
+    auto* report = new juce::DynamicObject();
+    report->setProperty("tool", "XmaxTools simulate");
+    report->setProperty("formatVersion", 1);
+    report->setProperty("date", juce::Time::getCurrentTime().toISO8601(true));
+    report->setProperty("sampleRate", options.sampleRate);
+    report->setProperty("blockSize", options.blockSize);
+    report->setProperty("seconds", options.seconds);
+    report->setProperty("driver", options.linear ? "linear" : "nonlinear");
+    report->setProperty("xmax", options.xmax);
+    report->setProperty("tolerance", options.tolerance);
+    report->setProperty("realtimeFactor", simulatedSeconds / std::max(plantSeconds, 1e-9));
+    report->setProperty("results", results);
+    return juce::var(report);
+}
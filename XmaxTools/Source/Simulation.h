@@ -0,0 +1,88 @@
+/*
+  ==============================================================================
+
+    Simulation.h
+    Created: 19 Oct 2026 3:58:41pm
+    Author:  eliot
+
+    Checks the protection of each plugin against a simulated driver rather
+    than against its own prediction: the output of the plugin, amplified by
+    speakerGain, drives a SpeakerPlant of the same speaker model, whose
+    true excursion must stay below the threshold. The driver is nonlinear
+    unless asked otherwise, with the typical nonlinearities of a driver of
+    this Xmax, so that the difference between the linear prediction of the
+    plugin and the excursion of a real driver shows.
+
+    Each plugin is also switched, under a full-scale bass tone that starts
+    with the switch, from the selected model that moves the least to the
+    one that moves the most, and the new driver is simulated: its peaks
+    must be seen by the envelope during the crossfade too.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <utility>
+#include <vector>
+
+struct PluginUnit;
+
+class Simulation
+{
+public:
+    struct Options
+    {
+        juce::StringArray plugins; // every plugin if empty
+        juce::StringArray models;  // every speaker model if empty
+        juce::StringArray signals{ "resonanceTones", "resonanceSweep", "thresholdBursts", "programme" };
+        double sampleRate = 48000.0;
+        int blockSize = 512;
+        double seconds = 4.0;      // length of each test signal
+
+        // Parameters set by ID in their own units, over the defaults of the plugin and the
+        // displacement mode of the Limiter
+        std::vector<std::pair<juce::String, juce::String>> parameters{ { "speakerGain", "20" } };
+        double threshold = 0.0;    // thresholdDisplacement in mm, the one of the plugin if 0
+        double xmax = 0.0;         // Xmax of the simulated driver in mm, the threshold if 0
+        bool linear = false;       // simulates the linear driver of the plugin instead
+        bool modelSwitch = true;   // also checks a switch to the model of the largest excursion
+        double tolerance = 0.1;    // how much the true excursion may exceed the threshold, relative
+        bool verbose = false;      // also print the cases that passed
+    };
+
+    explicit Simulation(const Options& options);
+
+    // Simulates every case, and returns the number of cases whose true excursion exceeds the
+    // threshold by more than the tolerance
+    int run();
+
+    juce::var getReport() const;
+
+private:
+    bool isSelected(const PluginUnit& unit) const;
+    juce::var simulate(const PluginUnit& unit, int model, const juce::String& signal);
+    std::pair<int, int> findSwitchModels(const PluginUnit& unit) const;
+    juce::var simulateModelSwitch(const PluginUnit& unit, int fromModel, int toModel);
+
+    // The simulated driver of one model, driven by the amplified output of a plugin
+    struct DriverRun
+    {
+        float excursion = 0.0f;  // mm, true peak
+        int stepsPerSample = 0;
+        double seconds = 0.0;    // of the integration
+    };
+
+    DriverRun driveSpeaker(const PluginUnit& unit, int model, double threshold, double speakerGain,
+                           std::vector<float>& dataL, std::vector<float>& dataR);
+
+    static constexpr double switchFrequency = 40.0; // Hz, of the bass tone of the model switch
+
+    Options options;
+    juce::Array<juce::var> results;
+    double plantSeconds = 0.0;
+    double simulatedSeconds = 0.0;
+
+    JUCE_DECLARE_NON_COPYABLE(Simulation)
+};
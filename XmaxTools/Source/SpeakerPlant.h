@@ -0,0 +1,230 @@
+/*
+  ==============================================================================
+
+    SpeakerPlant.h
+    Created: 19 Oct 2026 3:40:09pm
+    Author:  eliot
+
+    Simulated loudspeaker, to know the true cone excursion that a processed
+    signal produces. It solves the lumped electromechanical model, from the
+    tension at the terminals:
+
+        u = Re i + Le(x) di/dt + (Bl(x) + i dLe/dx) v
+        Mms dv/dt = Bl(x) i - Rms v - Kms(x) x - Kb (x + y) + i^2/2 dLe/dx
+        Mp dw/dt = -Rp w - Kp y - Kb (x + y)
+
+    where x and v are the displacement and the velocity of the cone, and y
+    and w those of the air in the port or of the passive radiator (in cone
+    equivalent units). With constant Bl, Kms and Le, this is the model of
+    the X/U filters of the plugins, plus the inductance. Bl(x), Kms(x) and
+    Le(x) are polynomials of the displacement.
+
+    The equations are integrated with a fixed-step fourth order Runge-Kutta,
+    with steps no longer than Le/Re, the tension being interpolated linearly
+    between the samples. All the channels are integrated together, one array
+    per state variable, so that the loops over the channels are vectorized,
+    and a linear driver skips the polynomials and the division by Le(x).
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+// Parameters of the simulated driver, in SI units. A box is seen by the cone as the
+// stiffness Kb; a port or a passive radiator is there when Mp is not zero.
+struct PlantParameters
+{
+    double Rec = 0.0, Lec = 0.0, Mms = 0.0, Kms = 0.0, Rms = 0.0, Bl = 0.0;
+    double Kb = 0.0, Mp = 0.0, Rp = 0.0, Kp = 0.0;
+
+    // Relative variation with the displacement x in mm, without the constant term:
+    // Bl(x) = Bl (1 + bl[0] x + bl[1] x^2 + bl[2] x^3 + bl[3] x^4), and so on. All zero: linear driver.
+    static constexpr int order = 4;
+    std::array<double, order> bl{}, kms{}, le{};
+
+    // Nonlinearities of a typical driver of this Xmax (mm), as defined by Klippel: Bl falls
+    // to 82 % and the compliance to 75 % at Xmax, a little more outwards than inwards, and
+    // Le falls by 10 % when the coil leaves the gap
+    void setTypicalNonlinearity(double xmax) noexcept
+    {
+        bl = { -0.02 / xmax, -0.18 / (xmax * xmax), 0.0, 0.0 };
+        kms = { 0.0, (1 / 0.75 - 1) / (xmax * xmax), 0.0, 0.0 };
+        le = { -0.1 / xmax, 0.0, 0.0, 0.0 };
+    }
+
+    bool isLinear() const noexcept
+    {
+        auto isZero = [](const std::array<double, order>& p) { return std::all_of(p.begin(), p.end(), [](double c) { return c == 0.0; }); };
+        return isZero(bl) && isZero(kms) && isZero(le);
+    }
+};
+
+template<int numChannels>
+class SpeakerPlant
+{
+public:
+    static_assert(numChannels > 0, "at least one channel");
+
+    // numSteps per sample, or as many as the electrical time constant Le/Re needs if 0
+    void prepare(const PlantParameters& newParameters, double sampleRate, int numSteps = 0)
+    {
+        parameters = newParameters;
+
+        //a driver without inductance is given 10 us of electrical time constant, not to divide by 0
+        parameters.Lec = std::max(parameters.Lec, parameters.Rec * 1e-5);
+
+        if (numSteps <= 0) {
+            double timeConstant = parameters.Lec / parameters.Rec;
+            numSteps = int(std::ceil(1.0 / (sampleRate * timeConstant)));
+        }
+        stepsPerSample = juce::jlimit(1, maxStepsPerSample, numSteps);
+        step = 1.0 / (sampleRate * stepsPerSample);
+
+        linear = parameters.isLinear();
+        invLe = 1.0 / parameters.Lec;
+        invMms = 1.0 / parameters.Mms;
+        invMp = parameters.Mp > 0.0 ? 1.0 / parameters.Mp : 0.0;
+        reset();
+    }
+
+    void reset() noexcept
+    {
+        state = State();
+        lastTension.fill(0.0);
+    }
+
+    int getStepsPerSample() const noexcept { return stepsPerSample; }
+
+    // Tension at the terminals of each channel in volts, to displacement in mm, and to the
+    // current in the coil in amperes if asked for. The outputs may be the input.
+    void process(const float* const* tension, float* const* displacement, int numSamples,
+                 float* const* current = nullptr) noexcept
+    {
+        for (int n = 0; n < numSamples; ++n) {
+            Lane nextTension;
+            for (int c = 0; c < numChannels; ++c)
+                nextTension[c] = tension[c][n];
+
+            for (int k = 0; k < stepsPerSample; ++k) {
+                double t = double(k) / stepsPerSample;
+                double dt = 1.0 / stepsPerSample;
+                if (linear)
+                    integrate<false>(lastTension, nextTension, t, t + 0.5 * dt, t + dt);
+                else
+                    integrate<true>(lastTension, nextTension, t, t + 0.5 * dt, t + dt);
+            }
+
+            for (int c = 0; c < numChannels; ++c)
+                displacement[c][n] = float(state.x[c] * 1e3);
+            if (current != nullptr) {
+                for (int c = 0; c < numChannels; ++c)
+                    current[c][n] = float(state.i[c]);
+            }
+            lastTension = nextTension;
+        }
+    }
+
+private:
+    using Lane = std::array<double, numChannels>;
+
+    struct State
+    {
+        Lane x{}, v{}, i{}, y{}, w{};
+    };
+
+    static constexpr int maxStepsPerSample = 64;
+
+    // 1 + p[0] x + p[1] x^2 + ..., kept positive far beyond the range of the polynomial
+    static double factor(const std::array<double, PlantParameters::order>& p, double x) noexcept
+    {
+        double value = 1.0 + x * (p[0] + x * (p[1] + x * (p[2] + x * p[3])));
+        return std::max(value, 0.05);
+    }
+
+    // Derivative of factor() with x
+    static double slope(const std::array<double, PlantParameters::order>& p, double x) noexcept
+    {
+        return p[0] + x * (2 * p[1] + x * (3 * p[2] + x * 4 * p[3]));
+    }
+
+    template<bool nonlinear>
+    void derive(const State& s, const Lane& u, State& d) const noexcept
+    {
+        const auto& m = parameters;
+
+        for (int c = 0; c < numChannels; ++c) {
+            double Bl = m.Bl, Kms = m.Kms, dLe = 0.0, invLex = invLe;
+            if (nonlinear) {
+                double mm = s.x[c] * 1e3;
+                Bl *= factor(m.bl, mm);
+                Kms *= factor(m.kms, mm);
+                invLex /= factor(m.le, mm);
+                dLe = m.Lec * 1e3 * slope(m.le, mm); // H/m
+            }
+            double boxForce = m.Kb * (s.x[c] + s.y[c]);
+
+            d.i[c] = (u[c] - m.Rec * s.i[c] - (Bl + dLe * s.i[c]) * s.v[c]) * invLex;
+            d.v[c] = (Bl * s.i[c] - m.Rms * s.v[c] - Kms * s.x[c] - boxForce + 0.5 * dLe * s.i[c] * s.i[c]) * invMms;
+            d.x[c] = s.v[c];
+            d.w[c] = (-m.Rp * s.w[c] - m.Kp * s.y[c] - boxForce) * invMp;
+            d.y[c] = s.w[c];
+        }
+    }
+
+    // out = s + h d
+    static void advance(const State& s, const State& d, double h, State& out) noexcept
+    {
+        for (int c = 0; c < numChannels; ++c) {
+            out.x[c] = s.x[c] + h * d.x[c];
+            out.v[c] = s.v[c] + h * d.v[c];
+            out.i[c] = s.i[c] + h * d.i[c];
+            out.y[c] = s.y[c] + h * d.y[c];
+            out.w[c] = s.w[c] + h * d.w[c];
+        }
+    }
+
+    // One Runge-Kutta step, the tension going from u0 to u1 over the sample (t from 0 to 1)
+    template<bool nonlinear>
+    void integrate(const Lane& u0, const Lane& u1, double tStart, double tMiddle, double tEnd) noexcept
+    {
+        Lane uStart, uMiddle, uEnd;
+        for (int c = 0; c < numChannels; ++c) {
+            uStart[c] = u0[c] + tStart * (u1[c] - u0[c]);
+            uMiddle[c] = u0[c] + tMiddle * (u1[c] - u0[c]);
+            uEnd[c] = u0[c] + tEnd * (u1[c] - u0[c]);
+        }
+
+        derive<nonlinear>(state, uStart, k1);
+        advance(state, k1, 0.5 * step, scratch);
+        derive<nonlinear>(scratch, uMiddle, k2);
+        advance(state, k2, 0.5 * step, scratch);
+        derive<nonlinear>(scratch, uMiddle, k3);
+        advance(state, k3, step, scratch);
+        derive<nonlinear>(scratch, uEnd, k4);
+
+        double h = step / 6;
+        for (int c = 0; c < numChannels; ++c) {
+            state.x[c] += h * (k1.x[c] + 2 * (k2.x[c] + k3.x[c]) + k4.x[c]);
+            state.v[c] += h * (k1.v[c] + 2 * (k2.v[c] + k3.v[c]) + k4.v[c]);
+            state.i[c] += h * (k1.i[c] + 2 * (k2.i[c] + k3.i[c]) + k4.i[c]);
+            state.y[c] += h * (k1.y[c] + 2 * (k2.y[c] + k3.y[c]) + k4.y[c]);
+            state.w[c] += h * (k1.w[c] + 2 * (k2.w[c] + k3.w[c]) + k4.w[c]);
+        }
+    }
+
+    PlantParameters parameters;
+    bool linear = true;
+    int stepsPerSample = 1;
+    double step = 0.0;
+    double invLe = 0.0;
+    double invMms = 0.0;
+    double invMp = 0.0;
+
+    State state, k1, k2, k3, k4, scratch;
+    Lane lastTension{};
+};
@@ -0,0 +1,176 @@
+/*
+  ==============================================================================
+
+    TestSignals.cpp
+    Created: 19 Oct 2026 6:20:14pm
+    Author:  eliot
+
+  ==============================================================================
+*/
+
+#include "TestSignals.h"
+#include <cmath>
+#include <iterator>
+#include <limits>
+
+namespace TestSignals
+{
+static const double twoPi = juce::MathConstants<double>::twoPi;
+
+void fillProgramme(float* dataL, float* dataR, int numSamples, double sampleRate)
+{
+    juce::Random random(0x5eed); //same signal for every run
+    int burstPeriod = std::max(1, int(0.5 * sampleRate));
+
+    for (int i = 0; i < numSamples; ++i) {
+        double t = i / sampleRate;
+        double burstTime = double(i % burstPeriod) / sampleRate;
+
+        //decaying 55 Hz kick, which drives the speakers well above their Xmax
+        double burst = 0.6 * std::exp(-burstTime * 12.0) * std::sin(twoPi * 55.0 * burstTime);
+        double tones = 0.15 * std::sin(twoPi * 41.0 * t) + 0.1 * std::sin(twoPi * 110.0 * t) + 0.05 * std::sin(twoPi * 1000.0 * t);
+        float noise = 0.05f * (random.nextFloat() * 2.0f - 1.0f);
+
+        dataL[i] = float(burst + tones) + noise;
+        dataR[i] = float(burst + 0.8 * tones) - noise;
+    }
+}
+
+void fillDecreasingPeaks(float* dataL, float* dataR, int numSamples, double sampleRate)
+{
+    int period = std::max(1, int(sampleRate));
+
+    for (int i = 0; i < numSamples; ++i) {
+        //slow enough for the displacement to follow the level, so it decreases monotonically too
+        double time = double(i % period) / sampleRate;
+        double polarity = (i / period) % 2 == 0 ? 1.0 : -1.0;
+        float peak = float(polarity * std::exp(-time * 3.0));
+
+        dataL[i] = peak;
+        dataR[i] = peak;
+    }
+}
+
+void fillThresholdBursts(float* dataL, float* dataR, int numSamples, double sampleRate)
+{
+    //two periods of 55 Hz on, the same time off
+    int burstLength = std::max(1, int(2.0 / 55.0 * sampleRate));
+    const int numSteps = 49;
+
+    for (int i = 0; i < numSamples; ++i) {
+        int burst = i / (2 * burstLength);
+        int position = i % (2 * burstLength);
+        float level = juce::Decibels::decibelsToGain(-24.0f + 0.5f * float(burst % numSteps));
+        float tone = position < burstLength ? level * float(std::sin(twoPi * 55.0 * position / sampleRate)) : 0.0f;
+
+        dataL[i] = tone;
+        dataR[i] = -tone;
+    }
+}
+
+void fillResonanceSweep(float* dataL, float* dataR, int numSamples, double sampleRate)
+{
+    const double startFrequency = 10.0, endFrequency = 400.0, sweepTime = 2.0;
+    const double rate = std::log(endFrequency / startFrequency) / sweepTime;
+    double phase = 0.0;
+
+    for (int i = 0; i < numSamples; ++i) {
+        //up then down, the phase is accumulated so that the direction changes without a click
+        double time = std::fmod(i / sampleRate, 2.0 * sweepTime);
+        double sweepPosition = time < sweepTime ? time : 2.0 * sweepTime - time;
+        double frequency = startFrequency * std::exp(rate * sweepPosition);
+
+        phase = std::fmod(phase + twoPi * frequency / sampleRate, twoPi);
+        float sample = float(std::sin(phase));
+
+        dataL[i] = sample;
+        dataR[i] = sample;
+    }
+}
+
+void fillDenormalTails(float* dataL, float* dataR, int numSamples, double sampleRate)
+{
+    juce::Random random(0x5eed);
+    int period = std::max(1, int(2.0 * sampleRate));
+    int burstLength = int(0.1 * sampleRate);
+    int silenceLength = int(1.0 * sampleRate);
+    const float denormal = std::numeric_limits<float>::denorm_min() * 1000.0f;
+
+    for (int i = 0; i < numSamples; ++i) {
+        int position = i % period;
+        float sample = 0.0f;
+
+        if (position < burstLength)
+            sample = float(std::sin(twoPi * 55.0 * position / sampleRate));
+        else if (position >= burstLength + silenceLength)
+            sample = denormal * (random.nextFloat() * 2.0f - 1.0f);
+
+        dataL[i] = sample;
+        dataR[i] = sample;
+    }
+}
+
+void fillResonanceTones(float* dataL, float* dataR, int numSamples, double sampleRate)
+{
+    static const double frequencies[] = { 20.0, 25.0, 31.5, 40.0, 50.0, 63.0, 80.0, 100.0, 125.0, 160.0 };
+    const int numTones = int(std::size(frequencies));
+    int toneLength = std::max(1, int(0.2 * sampleRate));
+    int fadeLength = std::max(1, int(0.01 * sampleRate));
+
+    for (int i = 0; i < numSamples; ++i) {
+        int tone = (i / toneLength) % numTones;
+        int position = i % toneLength;
+        int distanceToEdge = std::min(position, toneLength - 1 - position);
+        double fade = std::min(1.0, double(distanceToEdge) / double(fadeLength));
+        float sample = float(fade * std::sin(twoPi * frequencies[tone] * position / sampleRate));
+
+        dataL[i] = sample;
+        dataR[i] = sample;
+    }
+}
+
+void fillPinkNoise(float* dataL, float* dataR, int numSamples, double sampleRate)
+{
+    juce::ignoreUnused(sampleRate);
+
+    //three first-order filters whose sum approximates -3 dB per octave
+    auto fill = [numSamples](float* data, juce::int64 seed) {
+        juce::Random random(seed);
+        float b0 = 0.0f, b1 = 0.0f, b2 = 0.0f;
+
+        for (int i = 0; i < numSamples; ++i) {
+            float white = random.nextFloat() * 2.0f - 1.0f;
+            b0 = 0.99765f * b0 + white * 0.0990460f;
+            b1 = 0.96300f * b1 + white * 0.2965164f;
+            b2 = 0.57000f * b2 + white * 1.0526913f;
+            data[i] = 0.25f * (b0 + b1 + b2 + white * 0.1848f);
+        }
+    };
+
+    fill(dataL, 0x5eed);
+    fill(dataR, 0x5eed + 1);
+}
+
+const std::vector<Generator>& getGenerators()
+{
+    static const std::vector<Generator> generators = {
+        { "programme", "tones, kick bursts and noise, as in the benchmark", fillProgramme },
+        { "decreasingPeaks", "monotonically decreasing full-scale peaks, a minimum filter rescan per sample", fillDecreasingPeaks },
+        { "thresholdBursts", "55 Hz bursts stepping through the levels around the threshold", fillThresholdBursts },
+        { "resonanceSweep", "full-scale 10-400 Hz sweeps across the driver resonances", fillResonanceSweep },
+        { "denormalTails", "bursts followed by silence and denormal input", fillDenormalTails },
+        { "resonanceTones", "full-scale 20-160 Hz tones around the driver resonances", fillResonanceTones },
+        { "pinkNoise", "pink noise around -12 dBFS RMS", fillPinkNoise }
+    };
+    return generators;
+}
+
+const Generator* findGenerator(const juce::String& name)
+{
+    for (const auto& generator : getGenerators()) {
+        if (name.equalsIgnoreCase(generator.name))
+            return &generator;
+    }
+    return nullptr;
+}
+}
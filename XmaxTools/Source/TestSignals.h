@@ -0,0 +1,65 @@
+/*
+  ==============================================================================
+
+    TestSignals.h
+    Created: 19 Oct 2026 6:20:14pm
+    Author:  eliot
+
+    Deterministic stereo test signals for the tools: the programme used by
+    the benchmark, and adversarial signals that push the signal dependent
+    parts of the processors (the minimum filter rescans, the per-sample
+    coefficient design, the denormal tails) to their worst case.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <vector>
+
+namespace TestSignals
+{
+    using FillFunction = void (*)(float* dataL, float* dataR, int numSamples, double sampleRate);
+
+    struct Generator
+    {
+        const char* name;
+        const char* description;
+        FillFunction fill;
+    };
+
+    // Low-frequency tones around the driver resonances, a kick-like burst every 500 ms
+    // and some noise, peaking around 0 dBFS
+    void fillProgramme(float* dataL, float* dataR, int numSamples, double sampleRate);
+
+    // Full-scale peaks whose level decreases monotonically for one second, then starts again
+    // with the opposite polarity: the oldest gain of the window is always the minimum, so the
+    // minimum filter rescans its whole window for every sample
+    void fillDecreasingPeaks(float* dataL, float* dataR, int numSamples, double sampleRate);
+
+    // 55 Hz tone bursts stepping by 0.5 dB from -24 dBFS to 0 dBFS, so that the level
+    // keeps crossing the threshold and the knee, whatever their settings
+    void fillThresholdBursts(float* dataL, float* dataR, int numSamples, double sampleRate);
+
+    // Full-scale exponential sweeps from 10 Hz to 400 Hz and back, two seconds each way,
+    // across the resonance of every speaker model
+    void fillResonanceSweep(float* dataL, float* dataR, int numSamples, double sampleRate);
+
+    // A short full-scale burst every two seconds, followed by exact silence and then by
+    // denormal samples, while the filter states decay towards zero
+    void fillDenormalTails(float* dataL, float* dataR, int numSamples, double sampleRate);
+
+    // Full-scale tones of 200 ms with 10 ms fades, from 20 Hz to 160 Hz in third-octave steps,
+    // below, at and above the resonance of every speaker model
+    void fillResonanceTones(float* dataL, float* dataR, int numSamples, double sampleRate);
+
+    // Pink noise (Paul Kellet's filter on white noise) around -12 dBFS RMS, independent on each channel
+    void fillPinkNoise(float* dataL, float* dataR, int numSamples, double sampleRate);
+
+    // Every generator above, programme first
+    const std::vector<Generator>& getGenerators();
+
+    // nullptr if there is no generator with this name (case insensitive)
+    const Generator* findGenerator(const juce::String& name);
+}
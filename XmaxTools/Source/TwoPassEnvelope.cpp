@@ -0,0 +1,99 @@
+/*
+  ==============================================================================
+
+    TwoPassEnvelope.cpp
+    Created: 19 Oct 2026 11:58:06pm
+    Author:  eliot
+
+  ==============================================================================
+*/
+
+#include "TwoPassEnvelope.h"
+#include <algorithm>
+#include <cmath>
+#include <deque>
+#include <utility>
+#include <vector>
+
+namespace TwoPassEnvelope
+{
+    static float getCoefficient(double timeInMs, double sampleRate)
+    {
+        return timeInMs > 0.0 ? float(1.0 - std::exp(-2.2 / (sampleRate * timeInMs * 0.001))) : 1.0f;
+    }
+
+    Shape getShape(double attackTime, double holdTime, double releaseTime, double smoothingTime, double sampleRate)
+    {
+        Shape shape;
+        shape.attackCoeff = getCoefficient(attackTime, sampleRate);
+        shape.holdLength = int(std::ceil(std::max(0.0, holdTime) * 0.001 * sampleRate));
+        shape.releaseCoeff = getCoefficient(releaseTime, sampleRate);
+        shape.smoothingLength = std::max(1, int(std::ceil(smoothingTime * 0.001 * sampleRate)));
+        return shape;
+    }
+
+    void applyAttack(float* gains, juce::int64 length, float attackCoeff)
+    {
+        float c = 1.0f;
+        for (auto i = length - 1; i >= 0; --i) {
+            c = std::min(gains[i], (1.0f - attackCoeff) * c + attackCoeff * gains[i]);
+            gains[i] = c;
+        }
+    }
+
+    void applyHoldRelease(float* gains, juce::int64 length, int holdLength, float releaseCoeff)
+    {
+        //increasing gains of the hold window, so that its minimum is the oldest one
+        std::deque<std::pair<juce::int64, float>> window;
+        float c = 1.0f;
+
+        for (juce::int64 i = 0; i < length; ++i) {
+            while (!window.empty() && window.back().second >= gains[i])
+                window.pop_back();
+            window.emplace_back(i, gains[i]);
+            if (window.front().first < i - holdLength)
+                window.pop_front();
+
+            float minGain = window.front().second;
+            c = std::min(minGain, (1.0f - releaseCoeff) * c + releaseCoeff * minGain);
+
+            //as in the plugins, the one-pole release would never reach 1
+            if (c > 0.999f)
+                c = 1.0f;
+            gains[i] = c;
+        }
+    }
+
+    void smooth(const float* gains, juce::int64 length, juce::int64 start, int numSamples, int smoothingLength, float* output)
+    {
+        auto gainAt = [gains, length](juce::int64 i) { return i >= 0 && i < length ? gains[i] : 1.0f; };
+
+        //minimum of the smoothingLength samples up to each sample, from start to the end of the last mean
+        auto numMinima = size_t(numSamples + smoothingLength - 1);
+        std::vector<float> minima(numMinima);
+        std::deque<std::pair<juce::int64, float>> window;
+
+        for (auto i = start - smoothingLength + 1; i < start + juce::int64(numMinima); ++i) {
+            float gain = gainAt(i);
+            while (!window.empty() && window.back().second >= gain)
+                window.pop_back();
+            window.emplace_back(i, gain);
+            if (window.front().first <= i - smoothingLength)
+                window.pop_front();
+
+            if (i >= start)
+                minima[size_t(i - start)] = window.front().second;
+        }
+
+        //each of the minima from a sample on includes it, so their mean is not above it, but for rounding
+        double sum = 0.0;
+        for (int i = 0; i < smoothingLength - 1; ++i)
+            sum += minima[size_t(i)];
+
+        for (int i = 0; i < numSamples; ++i) {
+            sum += minima[size_t(i + smoothingLength - 1)];
+            output[i] = std::min(float(sum / smoothingLength), gainAt(start + i));
+            sum -= minima[size_t(i)];
+        }
+    }
+}
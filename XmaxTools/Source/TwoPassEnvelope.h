@@ -0,0 +1,46 @@
+/*
+  ==============================================================================
+
+    TwoPassEnvelope.h
+    Created: 19 Oct 2026 11:58:06pm
+    Author:  eliot
+
+    The gain envelope of the offline limiter, computed from the gain computer
+    output of the whole file instead of a look-ahead window. The attack runs
+    backwards from each peak, so it can be as long as wanted; the hold and the
+    release run forwards, as in the plugins. A last minimum and mean over a
+    short window round the corners without ever exceeding the gains it was
+    computed from, so the envelope is never above the gain computer.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+namespace TwoPassEnvelope
+{
+    // Envelope times in samples and one-pole coefficients at one sample rate
+    struct Shape
+    {
+        float attackCoeff = 1.0f;   // 1 for no attack
+        int holdLength = 0;
+        float releaseCoeff = 1.0f;  // 1 for no release
+        int smoothingLength = 1;    // 1 for no smoothing
+    };
+
+    // Times in ms, with the 10-90% convention of the release time of the plugins
+    Shape getShape(double attackTime, double holdTime, double releaseTime, double smoothingTime, double sampleRate);
+
+    // In place, from the end: the gain reduction of each sample decays exponentially before it
+    void applyAttack(float* gains, juce::int64 length, float attackCoeff);
+
+    // In place, from the start: minimum over the last holdLength samples, then exponential release
+    void applyHoldRelease(float* gains, juce::int64 length, int holdLength, float releaseCoeff);
+
+    // Minimum over smoothingLength samples then mean over as many, centred so that every output
+    // sample is at most the gain at its position. Reads the gains up to smoothingLength - 1
+    // samples around [start, start + numSamples), so that chunks can be smoothed at once.
+    void smooth(const float* gains, juce::int64 length, juce::int64 start, int numSamples, int smoothingLength, float* output);
+}